@@ -0,0 +1,146 @@
+#include "Frontend/Lex.h"
+#include "Frontend/LexScan.h"
+
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+using namespace sona;
+using namespace ckx;
+using namespace std;
+
+static string GenerateSource(size_t approxBytes) {
+  string ret;
+  for (size_t i = 0; ret.size() < approxBytes; i++) {
+    string n = to_string(i);
+    ret += "class GeneratedRecord_" + n + " {\n"
+           "    def someFairlyLongFieldName_" + n + " : int32;\n"
+           "    def another_field_" + n + " : uint64 const * const;\n"
+           "    def counter" + n + " : float;\n"
+           "}\n\n"
+           "def globalInstanceOfRecord_" + n + " : GeneratedRecord_" + n
+           + ";\n"
+           "func compute_" + n + "(lhs : int64, rhs : int64) : int64;\n"
+           "\t\t\t\t\t\t\t\t\n\n";
+  }
+  return ret;
+}
+
+static string GenerateExprSource(size_t approxBytes) {
+  string ret;
+  for (size_t i = 0; ret.size() < approxBytes; i++) {
+    string n = to_string(i % 97);
+    ret += "x" + n + " = (a+b)*c-d/e%f<<2>>g&&h||!i^^j!=k<=l>=m;\n"
+           "y" + n + " = ~p&q|r^s==t<u>v::w.z[++i]--;\n";
+  }
+  return ret;
+}
+
+static double MeasureMBPerSec(SourceBuffer const& buffer, size_t rounds) {
+  vector<string> lines;
+  double best = 0.0;
+  for (size_t i = 0; i < rounds; i++) {
+    Diag::DiagnosticEngine diag("<bench>", lines);
+    auto start = chrono::steady_clock::now();
+    Frontend::Lexer lexer(buffer, diag);
+    Frontend::TokenBuffer tokens = lexer.GetAndReset();
+    auto finish = chrono::steady_clock::now();
+
+    double seconds = chrono::duration<double>(finish - start).count();
+    double mbPerSec = buffer.GetBufferSize() / seconds / (1024.0 * 1024.0);
+    if (mbPerSec > best) {
+      best = mbPerSec;
+    }
+  }
+  return best;
+}
+
+static void RunKernels(SourceBuffer const& buffer) {
+  struct {
+    Frontend::ScanKernel kernel;
+    char const *name;
+  } kernels[] = {
+    { Frontend::ScanKernel::SK_Scalar, "scalar" },
+    { Frontend::ScanKernel::SK_SSE2, "sse2" },
+    { Frontend::ScanKernel::SK_AVX2, "avx2" }
+  };
+
+  for (auto const& k : kernels) {
+    if (!Frontend::IsScanKernelSupported(k.kernel)) {
+      fprintf(stderr, "  %-8s unsupported\n", k.name);
+      continue;
+    }
+    Frontend::SetScanKernel(k.kernel);
+    fprintf(stderr, "  %-8s %10.2f MB/s\n", k.name,
+            MeasureMBPerSec(buffer, 5));
+  }
+}
+
+static void MeasureThreads(SourceBuffer const& buffer) {
+  vector<string> lines;
+  for (unsigned numThreads = 1; numThreads <= 8; numThreads *= 2) {
+    double best = 0.0;
+    for (int i = 0; i < 5; i++) {
+      Diag::DiagnosticEngine diag("<bench>", lines);
+      auto start = chrono::steady_clock::now();
+      Frontend::Lexer lexer(buffer, diag);
+      Frontend::TokenBuffer tokens = lexer.LexInParallel(numThreads);
+      auto finish = chrono::steady_clock::now();
+
+      double seconds = chrono::duration<double>(finish - start).count();
+      best = max(best, buffer.GetBufferSize() / seconds / (1024.0 * 1024.0));
+    }
+    fprintf(stderr, "  %u thread(s) %8.2f MB/s\n", numThreads, best);
+  }
+}
+
+/// Alternately types and deletes one character all over the buffer
+static void MeasureEdits(string const& source, size_t numEdits) {
+  vector<string> lines;
+  Diag::DiagnosticEngine diag("<bench>", lines);
+  Frontend::IncrementalLexer lexer(string(source), diag);
+
+  size_t relexed = 0;
+  auto start = chrono::steady_clock::now();
+  for (size_t i = 0; i < numEdits; i++) {
+    uint32_t offset = static_cast<uint32_t>(
+        (i / 2 * 7919) % lexer.GetSource().size());
+    relexed += (i % 2 == 0) ? lexer.ApplyEdit(offset, 0, "q")
+                            : lexer.ApplyEdit(offset, 1, "");
+  }
+  auto finish = chrono::steady_clock::now();
+
+  auto fullStart = chrono::steady_clock::now();
+  Frontend::Lexer fullLexer(string(source), diag);
+  Frontend::TokenBuffer tokens = fullLexer.GetAndReset();
+  auto fullFinish = chrono::steady_clock::now();
+
+  fprintf(stderr, "Editing %zu bytes, %zu tokens: %.2f us/edit, "
+                  "%.1f tokens relexed/edit, full pass %.2f us\n",
+          source.size(), tokens.size(),
+          chrono::duration<double, micro>(finish - start).count() / numEdits,
+          static_cast<double>(relexed) / numEdits,
+          chrono::duration<double, micro>(fullFinish - fullStart).count());
+}
+
+int main(int argc, const char *argv[]) {
+  size_t megaBytes = argc > 1 ? stoul(argv[1]) : 32;
+  owner<SourceBuffer> buffer =
+      SourceBuffer::FromString(GenerateSource(megaBytes * 1024 * 1024));
+  fprintf(stderr, "Lexing %u bytes of generated declarations\n",
+          buffer.borrow()->GetBufferSize());
+  RunKernels(buffer.borrow().get());
+
+  owner<SourceBuffer> exprBuffer =
+      SourceBuffer::FromString(GenerateExprSource(megaBytes * 1024 * 1024));
+  fprintf(stderr, "Lexing %u bytes of operator-dense expressions\n",
+          exprBuffer.borrow()->GetBufferSize());
+  RunKernels(exprBuffer.borrow().get());
+
+  fprintf(stderr, "Lexing generated declarations in parallel\n");
+  MeasureThreads(buffer.borrow().get());
+
+  MeasureEdits(GenerateSource(64 * 1024), 2000);
+  MeasureEdits(GenerateSource(1024 * 1024), 200);
+}
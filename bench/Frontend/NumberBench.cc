@@ -0,0 +1,121 @@
+#include "Frontend/Lex.h"
+#include "Frontend/LexNumber.h"
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+using namespace sona;
+using namespace ckx;
+using namespace std;
+
+namespace {
+
+struct FloatLiteral {
+  string intPart, fracPart;
+  int64_t exponent;
+  string text;
+};
+
+uint64_t NextRandom(uint64_t &seed) {
+  seed ^= seed << 13;
+  seed ^= seed >> 7;
+  seed ^= seed << 17;
+  return seed;
+}
+
+vector<FloatLiteral> GenerateFloats(size_t count) {
+  vector<FloatLiteral> ret;
+  uint64_t seed = 0x9E3779B97F4A7C15ULL;
+  for (size_t i = 0; i < count; i++) {
+    FloatLiteral lit;
+    lit.intPart = to_string(NextRandom(seed) % 100000);
+    lit.fracPart = to_string(NextRandom(seed));
+    lit.fracPart.resize(1 + NextRandom(seed) % 14);
+    lit.exponent = static_cast<int64_t>(NextRandom(seed) % 80) - 40;
+    lit.text = lit.intPart + "." + lit.fracPart + "e"
+               + to_string(lit.exponent);
+    ret.push_back(lit);
+  }
+  return ret;
+}
+
+/// A data table like the ones generated for lookup-heavy programs: rows of
+/// integers, hex masks and floating coefficients
+string GenerateTable(size_t approxBytes) {
+  string ret;
+  uint64_t seed = 0xD1B54A32D192ED03ULL;
+  while (ret.size() < approxBytes) {
+    ret += "{ ";
+    for (int i = 0; i < 4; i++) {
+      ret += to_string(NextRandom(seed) % 100000000) + ", ";
+      ret += "0x" + to_string(NextRandom(seed) % 0xFFFFFFF) + "u, ";
+      ret += to_string(NextRandom(seed) % 1000) + "."
+             + to_string(NextRandom(seed) % 10000000000ULL) + "e-"
+             + to_string(NextRandom(seed) % 30) + ", ";
+    }
+    ret += "}\n";
+  }
+  return ret;
+}
+
+template <typename Fn> double BestSeconds(Fn fn, size_t rounds) {
+  double best = 1e30;
+  for (size_t i = 0; i < rounds; i++) {
+    auto start = chrono::steady_clock::now();
+    fn();
+    auto finish = chrono::steady_clock::now();
+    double seconds = chrono::duration<double>(finish - start).count();
+    best = seconds < best ? seconds : best;
+  }
+  return best;
+}
+
+} // namespace
+
+int main(int argc, const char *argv[]) {
+  size_t megaBytes = argc > 1 ? stoul(argv[1]) : 16;
+
+  vector<FloatLiteral> floats = GenerateFloats(1000000);
+  volatile double sink = 0.0;
+  double decodeSeconds = BestSeconds([&] {
+    for (FloatLiteral const& lit : floats) {
+      double value;
+      Frontend::DecodeFloat(lit.intPart.data(),
+                            lit.intPart.data() + lit.intPart.size(),
+                            lit.fracPart.data(),
+                            lit.fracPart.data() + lit.fracPart.size(),
+                            lit.exponent, value);
+      sink += value;
+    }
+  }, 5);
+  double strtodSeconds = BestSeconds([&] {
+    for (FloatLiteral const& lit : floats) {
+      sink += strtod(lit.text.c_str(), nullptr);
+    }
+  }, 5);
+
+  fprintf(stderr, "Decoding %zu floating literals\n", floats.size());
+  fprintf(stderr, "  DecodeFloat %10.2f Mlit/s\n",
+          floats.size() / decodeSeconds / 1e6);
+  fprintf(stderr, "  strtod      %10.2f Mlit/s\n",
+          floats.size() / strtodSeconds / 1e6);
+
+  owner<SourceBuffer> buffer =
+      SourceBuffer::FromString(GenerateTable(megaBytes * 1024 * 1024));
+  vector<string> lines;
+  double lexSeconds = BestSeconds([&] {
+    Diag::DiagnosticEngine diag("<bench>", lines);
+    Frontend::Lexer lexer(buffer.borrow(), diag);
+    Frontend::TokenBuffer tokens = lexer.GetAndReset();
+    sink += tokens.size();
+  }, 5);
+
+  fprintf(stderr, "Lexing %u bytes of numeric tables\n",
+          buffer.borrow()->GetBufferSize());
+  fprintf(stderr, "  %10.2f MB/s\n",
+          buffer.borrow()->GetBufferSize() / lexSeconds / (1024.0 * 1024.0));
+}
@@ -0,0 +1,118 @@
+#include "Frontend/Lex.h"
+#include "Frontend/Parser.h"
+#include "Syntax/Serialize.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+using namespace sona;
+using namespace ckx;
+using namespace std;
+
+static string GenerateSource(size_t approxBytes) {
+  string ret;
+  for (size_t i = 0; ret.size() < approxBytes; i++) {
+    string n = to_string(i);
+    ret += "class Record_" + n + " {\n"
+           "  def field_" + n + " : int32;\n"
+           "  def next : Outer.Inner.Record_" + n + " const * const;\n"
+           "  class Nested {\n"
+           "    def weight : float;\n"
+           "    def tags : vec.str & ;\n"
+           "  }\n"
+           "}\n\n"
+           "enum Color_" + n + " { Red = 1; Green; Blue = 4; }\n"
+           "enum class Shape_" + n + " { Circle(float); Square(int64); }\n"
+           "using Alias_" + n + " = Record_" + n + " * * const;\n"
+           "func compute_" + n + "(lhs : int64, rhs : a.b.c &&) : int64;\n"
+           "def global_" + n + " : Record_" + n + ";\n"
+           "func step_" + n + "(x : int64, y : int64) : int64 {\n"
+           "  x = x + y * 3;\n"
+           "  { y = y - x / 2; x = -y; ; }\n"
+           "  return x * y + 1;\n"
+           "}\n\n";
+  }
+  return ret;
+}
+
+int main(int argc, const char *argv[]) {
+  size_t megaBytes = argc > 1 ? stoul(argv[1]) : 8;
+  string source = GenerateSource(megaBytes * 1024 * 1024);
+  vector<string> lines;
+  Diag::DiagnosticEngine diag("<bench>", lines);
+  Frontend::Lexer lexer(string(source), diag);
+  Frontend::TokenBuffer tokens = lexer.GetAndReset();
+  fprintf(stderr, "Parsing %zu bytes, %zu tokens of generated "
+                  "declarations\n", source.size(), tokens.size());
+
+  for (bool skipBodies : { false, true }) {
+    double bestParse = 1e300, bestFree = 1e300;
+    size_t numDecls = 0;
+    for (int i = 0; i < 5; i++) {
+      Frontend::Parser parser(diag);
+      parser.SetSkipFuncBodies(skipBodies);
+      chrono::steady_clock::time_point start, parsed;
+      {
+        start = chrono::steady_clock::now();
+        auto unit = parser.ParseTransUnit(tokens);
+        parsed = chrono::steady_clock::now();
+        numDecls = unit.borrow()->GetDecls().size();
+      }
+      auto freed = chrono::steady_clock::now();
+
+      bestParse = min(bestParse,
+                      chrono::duration<double, milli>(parsed - start).count());
+      bestFree = min(bestFree,
+                     chrono::duration<double, milli>(freed - parsed).count());
+    }
+
+    fprintf(stderr, "  %zu decls%s: parse %.2f ms (%.2f MB/s), "
+                    "free %.2f ms\n",
+            numDecls, skipBodies ? ", bodies skipped" : "", bestParse,
+            source.size() / (bestParse / 1000.0) / (1024.0 * 1024.0),
+            bestFree);
+  }
+
+  for (unsigned numThreads = 1; numThreads <= 8; numThreads *= 2) {
+    double best = 1e300;
+    for (int i = 0; i < 5; i++) {
+      Frontend::Parser parser(diag);
+      auto start = chrono::steady_clock::now();
+      auto unit = parser.ParseTransUnitInParallel(tokens, numThreads);
+      auto finish = chrono::steady_clock::now();
+      best = min(best,
+                 chrono::duration<double, milli>(finish - start).count());
+    }
+    fprintf(stderr, "  %u thread(s) parse %.2f ms (%.2f MB/s)\n",
+            numThreads, best,
+            source.size() / (best / 1000.0) / (1024.0 * 1024.0));
+  }
+
+  /// What a hit in the CST cache costs once the image is mapped
+  string image;
+  {
+    Frontend::Parser parser(diag);
+    auto unit = parser.ParseTransUnit(tokens);
+    Syntax::SerializeTransUnit(
+        unit.borrow().get(),
+        SourceLocation::FromRawEncoding(SourceManager::FirstFileStart),
+        image);
+  }
+  double bestLoad = 1e300;
+  for (int i = 0; i < 5; i++) {
+    auto start = chrono::steady_clock::now();
+    auto unit = Syntax::DeserializeTransUnit(
+        image.data(), image.size(),
+        SourceLocation::FromRawEncoding(SourceManager::FirstFileStart));
+    auto finish = chrono::steady_clock::now();
+    sona_assert(unit.borrow() != nullptr);
+    bestLoad = min(bestLoad,
+                   chrono::duration<double, milli>(finish - start).count());
+  }
+  fprintf(stderr, "  load %.2f MB image %.2f ms\n",
+          image.size() / (1024.0 * 1024.0), bestLoad);
+  sona_assert(!diag.HasPendingDiags());
+}
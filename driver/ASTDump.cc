@@ -1,11 +1,12 @@
+#include "Basic/SourceManager.h"
 #include "Frontend/Lex.h"
 #include "Frontend/Parser.h"
+#include "Syntax/CSTCache.h"
 #include "Sema/SemaPhase0.h"
 #include "Sema/SemaPhase1.h"
 #include "Backend/ASTPrinter.h"
 
 #include "sona/strutil.h"
-#include <fstream>
 #include <iostream>
 
 using namespace sona;
@@ -13,41 +14,59 @@ using namespace ckx;
 using namespace std;
 
 int main(int argc, const char* argv[]) {
-  if (argc != 2) {
-    cerr << "usage ckx-ast filename" << endl;
+  Diag::DiagnosticFormat diagFormat = Diag::DF_Text;
+  std::size_t errorLimit = 20;
+  CompileBudget budget;
+  char const *fileName = nullptr;
+  std::string cacheDirectory;
+  bool badUsage = false;
+  for (int i = 1; i < argc; i++) {
+    if (!Diag::ParseFormatOption(argv[i], diagFormat)
+        && !Diag::ParseErrorLimitOption(argv[i], errorLimit)
+        && !ParseBudgetOption(argv[i], budget)
+        && !Syntax::ParseCSTCacheOption(argv[i], cacheDirectory)) {
+      badUsage = badUsage || fileName != nullptr;
+      fileName = argv[i];
+    }
+  }
+  if (badUsage || fileName == nullptr) {
+    cerr << "usage ckx-ast [--diagnostics-format=text|json] "
+            "[--error-limit=N] [--max-tokens=N] [--max-depth=N] "
+            "[--max-time=MS] [--cst-cache=DIRECTORY] filename" << endl;
     return -1;
   }
 
-  std::ifstream ifs (argv[1]);
-  if (!ifs.is_open()) {
+  SourceManager sourceManager;
+  FileID mainFile = sourceManager.OpenFile(fileName);
+  if (mainFile.IsInvalid()) {
     cerr << "unable to open file" << endl;
     return -1;
   }
 
-  vector<string> lines;
-  string wholeSource;
-  while (!ifs.eof()) {
-    string line;
-    getline(ifs, line);
-    wholeSource += (line + '\n');
-    lines.push_back(std::move(line));
+  Diag::DiagnosticEngine diag(sourceManager, mainFile);
+  diag.SetFormat(diagFormat);
+  diag.SetErrorLimit(errorLimit);
+  diag.GetBudget().SetMaxTokens(budget.GetMaxTokens());
+  diag.GetBudget().SetMaxDepth(budget.GetMaxDepth());
+  diag.GetBudget().SetMaxTime(budget.GetMaxTime());
+  Syntax::CSTCache cache(cacheDirectory);
+  SourceBuffer const& source = sourceManager.GetBuffer(mainFile).get();
+  SourceLocation fileStart = sourceManager.GetLocForStartOfFile(mainFile);
+  owner<Syntax::TransUnit> unit = nullptr;
+  /// Loading a cached tree would skip the checks of the budget
+  if (!cacheDirectory.empty() && !budget.HasLimits()) {
+    unit = cache.Load(source, fileStart);
   }
 
-  Diag::DiagnosticEngine diag(argv[1], lines);
-  Frontend::Lexer lexer(std::move(wholeSource), diag);
-  if (diag.HasPendingDiags()) {
-    if (diag.HasPendingError()) {
-      diag.EmitDiags();
-      return -1;
+  if (unit.borrow() == nullptr) {
+    Frontend::Lexer lexer(sourceManager, mainFile, diag);
+    Frontend::Parser parser(diag);
+    unit = parser.ParseTransUnit(lexer);
+    if (!cacheDirectory.empty() && !diag.HasPendingDiags()) {
+      cache.Store(source, fileStart, unit.borrow().get());
     }
-    diag.EmitDiags();
   }
 
-  std::vector<Frontend::Token> tokens = lexer.GetAndReset();
-
-  Frontend::Parser parser(diag);
-  owner<Syntax::TransUnit> unit = parser.ParseTransUnit(tokens);
-
   if (diag.HasPendingDiags()) {
     if (diag.HasPendingError()) {
       diag.EmitDiags();
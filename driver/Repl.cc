@@ -130,53 +130,52 @@ int main() {
 
   Backend::ReplInterpreter replInterp;
 
+  /// Entries may span lines, the parser keeps what was read so far until
+  /// they are complete
+  vector<string> lines;
+  Diag::DiagnosticEngine diag("<repl-input>", lines);
+  Frontend::IncrementalParser parser(diag, lines);
+
   for(;;) {
-    vector<string> lines;
     string line;
+    bool pending = parser.IsPending();
 
-    cerr << "[ckxc-v2-repl *Basic] λ ";
-    getline(cin, line);
-    if (line == "" || line == "quit" || line == "exit") {
+    cerr << "[ckxc-v2-repl *Basic] " << (pending ? ". " : "λ ");
+    bool gotLine = static_cast<bool>(getline(cin, line));
+    if (!pending
+        && (!gotLine || line == "" || line == "quit" || line == "exit")) {
       cerr << endl << "  Moriturus te saluto." << endl;
       return 0;
     }
 
-    lines.push_back(line);
-
-    Diag::DiagnosticEngine diag("<repl-input>", lines);
-    Frontend::Lexer lexer(std::move(line), diag);
+    /// An empty line, or the end of input, ends an entry as it is
+    Frontend::IncrementalParser::Status status =
+        (!gotLine || line == "") ? parser.Finish() : parser.PushLine(line);
+    if (status == Frontend::IncrementalParser::IPS_NeedMoreInput) {
+      continue;
+    }
     if (diag.HasPendingDiags()) {
-      if (diag.HasPendingError()) {
-        diag.EmitDiags();
-        return -1;
-      }
       diag.EmitDiags();
     }
+    if (status == Frontend::IncrementalParser::IPS_Error) {
+      continue;
+    }
 
-    vector<Frontend::Token> tokens = lexer.GetAndReset();
-    Frontend::Parser parser(diag);
     SemaPhase0ForRepl sp0(astContext, declContexts, diag);
     SemaPhase1ForRepl sp1(astContext, declContexts, diag);
 
-    if (tokens.front().GetTokenKind() == Frontend::Token::TK_KW_def) {
-      owner<Syntax::VarDecl> decl = parser.ParseVarDecl(tokens);
+    sona::ref_ptr<Syntax::Node const> entry = parser.GetEntry();
+    if (entry->GetNodeKind() == Syntax::Node::CNK_VarDecl) {
       // owner<AST::VarDecl> decl1 =
-      //    sp0.ActOnVarDecl(decl.borrow()).first.cast_unsafe<AST::VarDecl>();
+      //    sp0.ActOnVarDecl(entry.cast_unsafe<Syntax::VarDecl const>())
+      //       .first.cast_unsafe<AST::VarDecl>();
       // replInterp.DefineVar(decl1.borrow());
-      if (diag.HasPendingDiags()) {
-        diag.EmitDiags();
-        continue;
-      }
       cerr << "  Sorry, variable decalrations are not supported yet." << endl;
     }
     else {
-      owner<Syntax::Expr> expr = parser.ParseExpr(tokens);
-      if (diag.HasPendingDiags()) {
-        diag.EmitDiags();
-        continue;
-      }
-      owner<AST::Expr> expr1 = sp1.ActOnExpr(sp1.GetCurrentScope(),
-                                             expr.borrow());
+      owner<AST::Expr> expr1 =
+          sp1.ActOnExpr(sp1.GetCurrentScope(),
+                        entry.cast_unsafe<Syntax::Expr const>());
       if (diag.HasPendingDiags()) {
         diag.EmitDiags();
         continue;
@@ -1,7 +1,8 @@
+#include "Basic/SourceManager.h"
 #include "Frontend/Lex.h"
 #include "Frontend/Parser.h"
+#include "Syntax/CSTCache.h"
 #include "sona/strutil.h"
-#include <fstream>
 #include <iostream>
 
 using namespace sona;
@@ -9,40 +10,70 @@ using namespace ckx;
 using namespace std;
 
 int main(int argc, const char *argv[]) {
-  if (argc != 2) {
-    cerr << "usage ckx-syntax filename" << endl;
+  Diag::DiagnosticFormat diagFormat = Diag::DF_Text;
+  std::size_t errorLimit = 20;
+  CompileBudget budget;
+  char const *fileName = nullptr;
+  std::string cacheDirectory;
+  bool skipFuncBodies = false;
+  bool badUsage = false;
+  for (int i = 1; i < argc; i++) {
+    if (string(argv[i]) == "--skip-function-bodies") {
+      skipFuncBodies = true;
+    }
+    else if (!Diag::ParseFormatOption(argv[i], diagFormat)
+             && !Diag::ParseErrorLimitOption(argv[i], errorLimit)
+             && !ParseBudgetOption(argv[i], budget)
+             && !Syntax::ParseCSTCacheOption(argv[i], cacheDirectory)) {
+      badUsage = badUsage || fileName != nullptr;
+      fileName = argv[i];
+    }
+  }
+  if (badUsage || fileName == nullptr) {
+    cerr << "usage ckx-syntax [--diagnostics-format=text|json] "
+            "[--error-limit=N] [--max-tokens=N] [--max-depth=N] "
+            "[--max-time=MS] [--skip-function-bodies] "
+            "[--cst-cache=DIRECTORY] filename" << endl;
     return -1;
   }
 
-  std::ifstream ifs (argv[1]);
-  if (!ifs.is_open()) {
+  SourceManager sourceManager;
+  FileID mainFile = sourceManager.OpenFile(fileName);
+  if (mainFile.IsInvalid()) {
     cerr << "unable to open file" << endl;
     return -1;
   }
 
-  vector<string> lines;
-  string wholeSource;
-  while (!ifs.eof()) {
-    string line;
-    getline(ifs, line);
-    wholeSource += (line + '\n');
-    lines.push_back(std::move(line));
-  }
+  Diag::DiagnosticEngine diag(sourceManager, mainFile);
+  diag.SetFormat(diagFormat);
+  diag.SetErrorLimit(errorLimit);
+  diag.GetBudget().SetMaxTokens(budget.GetMaxTokens());
+  diag.GetBudget().SetMaxDepth(budget.GetMaxDepth());
+  diag.GetBudget().SetMaxTime(budget.GetMaxTime());
 
-  Diag::DiagnosticEngine diag(argv[1], lines);
-  Frontend::Lexer lexer(std::move(wholeSource), diag);
-  if (diag.HasPendingDiags()) {
-    if (diag.HasPendingError()) {
-      diag.EmitDiags();
-      return -1;
+  /// A cached tree has all its bodies, so it does with or without skipping
+  /// them, but only complete trees parsed without a diagnostic are cached.
+  /// Loading one would skip the checks of the budget, so a compile with
+  /// limits always parses.
+  Syntax::CSTCache cache(cacheDirectory);
+  SourceBuffer const& source = sourceManager.GetBuffer(mainFile).get();
+  SourceLocation fileStart = sourceManager.GetLocForStartOfFile(mainFile);
+  if (!cacheDirectory.empty() && !budget.HasLimits()) {
+    owner<Syntax::TransUnit> cached = cache.Load(source, fileStart);
+    if (cached.borrow() != nullptr) {
+      cerr << "Parsing success, no syntactical issue" << endl;
+      return 0;
     }
-    diag.EmitDiags();
   }
 
-  std::vector<Frontend::Token> tokens = lexer.GetAndReset();
-
+  Frontend::Lexer lexer(sourceManager, mainFile, diag);
   Frontend::Parser parser(diag);
-  owner<Syntax::TransUnit> unit = parser.ParseTransUnit(tokens);
+  parser.SetSkipFuncBodies(skipFuncBodies);
+  owner<Syntax::TransUnit> unit = parser.ParseTransUnit(lexer);
+  if (!cacheDirectory.empty() && !skipFuncBodies
+      && !diag.HasPendingDiags()) {
+    cache.Store(source, fileStart, unit.borrow().get());
+  }
 
   if (diag.HasPendingDiags()) {
     if (diag.HasPendingError()) {
@@ -13,12 +13,19 @@ int main() {
   };
 
   Diag::DiagnosticEngine engine("main.cpp", codeLines);
+  /// Offsets into the lines joined by line breaks
+  auto LineRange = [](uint32_t begin, uint32_t end) {
+    SourceLocation start =
+        SourceLocation::FromRawEncoding(SourceManager::FirstFileStart);
+    return SourceRange(start.GetLocWithOffset(begin),
+                       start.GetLocWithOffset(end));
+  };
 
   engine.Diag(Diag::DIR_Error,
-              Diag::Format(Diag::DMT_Example, {"add"}),
-              SourceRange(2, 5, 8)).
-      AddNote(Diag::Format(Diag::DMT_Example2, {"add"}),
-              SourceRange(1, 5, 8));
+              Diag::DMT_Example, {"add"},
+              LineRange(44, 47)).
+      AddNote(Diag::DMT_Example2, {"add"},
+              LineRange(4, 7));
   engine.EmitDiags();
 
   return 0;
@@ -0,0 +1,88 @@
+#ifndef COMPILEBUDGET_H
+#define COMPILEBUDGET_H
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace ckx {
+
+/// Caps on the work one compile may do, so that a pathological input,
+/// fuzzed or machine generated, cannot tie up a build worker. 0 stands for
+/// no limit. The checks are meant for the hot loops of every phase: token
+/// and depth checks compare two integers, and the clock is only read every
+/// TimeCheckInterval checks. Once a limit is hit the budget stays
+/// exhausted and every phase winds down.
+///
+/// The number of errors is capped by the error limit of the
+/// DiagnosticEngine owning the budget.
+class CompileBudget {
+public:
+  enum Resource { R_None, R_Errors, R_Tokens, R_Depth, R_Time };
+
+  static constexpr std::uint32_t TimeCheckInterval = 1024;
+
+  void SetMaxTokens(std::size_t maxTokens) noexcept {
+    m_MaxTokens = maxTokens;
+  }
+
+  void SetMaxDepth(std::size_t maxDepth) noexcept { m_MaxDepth = maxDepth; }
+
+  /// The clock starts now
+  void SetMaxTime(std::chrono::milliseconds maxTime) noexcept;
+
+  std::size_t GetMaxTokens() const noexcept { return m_MaxTokens; }
+  std::size_t GetMaxDepth() const noexcept { return m_MaxDepth; }
+  std::chrono::milliseconds GetMaxTime() const noexcept { return m_MaxTime; }
+
+  /// @return true if any limit is set, the error limit aside
+  bool HasLimits() const noexcept {
+    return m_MaxTokens != 0 || m_MaxDepth != 0 || m_MaxTime.count() != 0;
+  }
+
+  bool TokensExceeded(std::size_t numTokens) const noexcept {
+    return m_MaxTokens != 0 && numTokens > m_MaxTokens;
+  }
+
+  bool DepthExceeded(std::size_t depth) const noexcept {
+    return m_MaxDepth != 0 && depth > m_MaxDepth;
+  }
+
+  /// Reads the clock once every TimeCheckInterval calls, counted over all
+  /// threads checking this budget
+  bool TimeExceeded() const noexcept;
+
+  bool IsExhausted() const noexcept {
+    return m_ExhaustedBy.load(std::memory_order_relaxed) != R_None;
+  }
+
+  Resource GetExhaustedBy() const noexcept {
+    return m_ExhaustedBy.load(std::memory_order_relaxed);
+  }
+
+  /// @return true for the first resource to run out only, the caller then
+  /// reports it
+  bool Exhaust(Resource resource) noexcept;
+
+  /// @return what the limit of resource counts, in plural
+  static char const* GetResourceName(Resource resource) noexcept;
+  std::uint64_t GetLimit(Resource resource) const noexcept;
+
+private:
+  std::size_t m_MaxTokens = 0;
+  std::size_t m_MaxDepth = 0;
+  std::chrono::milliseconds m_MaxTime { 0 };
+  std::chrono::steady_clock::time_point m_Deadline;
+  mutable std::atomic<std::uint32_t> m_TimeChecks { 0 };
+  std::atomic<Resource> m_ExhaustedBy { R_None };
+};
+
+/// Recognizes --max-tokens=N, --max-depth=N and --max-time=MILLISECONDS
+/// @return false if arg is none of them
+bool ParseBudgetOption(std::string const& arg, CompileBudget &budget);
+
+} // namespace ckx
+
+#endif // COMPILEBUDGET_H
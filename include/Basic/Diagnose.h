@@ -1,14 +1,25 @@
 #ifndef DIAGNOSE_H
 #define DIAGNOSE_H
 
+#include "Basic/CompileBudget.h"
+#include "Basic/SourceManager.h"
 #include "Basic/SourceRange.h"
 
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <thread>
 #include <vector>
 #include <string>
 #include <initializer_list>
+#include "sona/pointer_plus.h"
+#include "sona/string_view.h"
 #include "sona/stringref.h"
 
 namespace ckx {
+
 namespace Diag {
 
 enum DiagMessageTemplate {
@@ -21,25 +32,169 @@ enum DiagnosticInfoRank {
   DIR_Error, DIR_Warning0, DIR_Warning1, DIR_Warning2, DIR_Note
 };
 
+/// An argument of a message template. Only viewed while the diagnostic is
+/// recorded, kept diagnostics copy it, dropped ones never do.
+class DiagParam {
+public:
+  DiagParam(char const* cstr) noexcept : m_View(cstr) {}
+  DiagParam(std::string const& str) noexcept : m_View(str) {}
+  DiagParam(sona::string_view view) noexcept : m_View(view) {}
+  DiagParam(sona::strhdl_t str) noexcept : m_View(str.get()) {}
+
+  sona::string_view GetView() const noexcept { return m_View; }
+
+private:
+  sona::string_view m_View;
+};
+
 std::string
 Format(DiagMessageTemplate messageTemplate,
-       const std::vector<sona::strhdl_t>& paramStrings);
+       std::initializer_list<DiagParam> params);
+
+enum DiagnosticFormat {
+  /// For humans: location, message, source line and carets
+  DF_Text,
+  /// For tools: one JSON object per diagnostic and line
+  DF_JSON
+};
 
+/// Recognizes --diagnostics-format=text and --diagnostics-format=json
+/// @return false if arg is not one of them
+bool ParseFormatOption(std::string const& arg, DiagnosticFormat &format);
+
+/// Recognizes --error-limit=N, N being 0 for no limit
+/// @return false if arg is not of that form
+bool ParseErrorLimitOption(std::string const& arg, std::size_t &limit);
+
+/// Collects diagnostics and prints them. Any number of threads may record
+/// diagnostics at the same time: every thread gets a buffer of its own,
+/// so recording takes no lock but the first time. The buffers are merged
+/// by source location when rendered, diagnostics at the same location by
+/// their message, while those of one thread keep the order it recorded
+/// them in. A single thread gets its diagnostics back as recorded.
+///
+/// The merge only looks at the next diagnostic of every buffer, so threads
+/// splitting up a source must each work through their share front to back
+/// and detach once done: a buffer that goes back to an earlier place holds
+/// up everything behind it. Threads doing so, working on places of their
+/// own, get the output of a single thread working through the source in
+/// order, whatever the order they ran in. Diagnostics of work that may turn
+/// out wasted are recorded under a tag, and discarded or kept once it is
+/// known which.
+///
+/// @note the error limit is shared, which diagnostics it cuts off depends
+/// on timing, and tagged errors count until discarded. Rendering, emitting,
+/// clearing and discarding must not overlap with threads still recording.
 class DiagnosticEngine {
 private:
   class DiagnosticInfo;
 
 public:
+  /// Diagnostics are about files of sourceManager, which decodes their
+  /// locations when they are rendered. Diagnostics without a location are
+  /// about fileID. The manager must outlive the engine.
+  DiagnosticEngine(SourceManager const& sourceManager, FileID fileID);
+
+  /// For sources already split into lines, such as REPL input, lexed on
+  /// their own: locations are those of the lines joined by line breaks,
+  /// laid out as the first file of a SourceManager
   DiagnosticEngine(std::string const& fileName,
-                   std::vector<std::string> const& codeLines)
-    : m_FileName(fileName), m_CodeLines(codeLines) {}
+                   std::vector<std::string> const& codeLines);
+
+  DiagnosticEngine(DiagnosticEngine const&) = delete;
+  DiagnosticEngine& operator=(DiagnosticEngine const&) = delete;
 
   DiagnosticInfo& Diag(DiagnosticInfoRank rank,
                        std::string &&message,
                        SourceRange const& range);
 
+  /// Records the template and its arguments only, the message is formatted
+  /// when the diagnostic is rendered and never if it gets dropped
+  DiagnosticInfo& Diag(DiagnosticInfoRank rank,
+                       DiagMessageTemplate messageTemplate,
+                       std::initializer_list<DiagParam> params,
+                       SourceRange const& range);
+
   bool HasPendingError() const noexcept;
   bool HasPendingDiags() const noexcept;
+
+  /// Diagnostics the calling thread records from now on carry tag, 0 for
+  /// none. The note of an exhausted budget is never tagged.
+  void SetThreadTag(std::uint64_t tag) { GetThreadBuffer().Tag = tag; }
+
+  /// Ends the buffer of the calling thread, what it records next goes into
+  /// a new one. For threads done with their share of parallel work, whose
+  /// id a later thread may get.
+  void DetachThread();
+
+  /// Drops the tagged diagnostics whose tag discard holds for and clears
+  /// the tag of all others
+  template <typename Pred> void DiscardTagged(Pred const& discard) {
+    std::lock_guard<std::mutex> guard(m_BuffersLock);
+    for (ThreadBuffer &buffer : m_Buffers) {
+      std::size_t kept = 0;
+      for (DiagnosticInfo &info : buffer.Diags) {
+        if (info.m_Tag != 0 && discard(info.m_Tag)) {
+          ForgetDiag(info);
+          continue;
+        }
+        info.m_Tag = 0;
+        if (&buffer.Diags[kept] != &info) {
+          buffer.Diags[kept] = std::move(info);
+        }
+        ++kept;
+      }
+      buffer.Diags.erase(buffer.Diags.begin()
+                           + static_cast<std::ptrdiff_t>(kept),
+                         buffer.Diags.end());
+    }
+  }
+
+  /// Once limit errors have been recorded, a note says so, the budget is
+  /// exhausted and all further diagnostics are dropped. 0, the default,
+  /// sets no limit.
+  void SetErrorLimit(std::size_t limit) noexcept { m_ErrorLimit = limit; }
+  std::size_t GetErrorLimit() const noexcept { return m_ErrorLimit; }
+  bool ErrorLimitReached() const noexcept {
+    return m_ErrorLimit != 0
+           && m_NumErrors.load(std::memory_order_relaxed) >= m_ErrorLimit;
+  }
+  /// Number of diagnostics dropped because of the error limit
+  std::size_t GetNumDroppedDiags() const noexcept {
+    return m_NumDropped.load(std::memory_order_relaxed);
+  }
+
+  /// The budget of the compile reporting here, which every phase checks
+  CompileBudget& GetBudget() noexcept { return m_Budget; }
+  CompileBudget const& GetBudget() const noexcept { return m_Budget; }
+
+  /// Marks the budget exhausted by resource. The first call of a compile
+  /// records the one error saying so, at range, all diagnostics after it
+  /// are dropped.
+  void ExhaustBudget(CompileBudget::Resource resource,
+                     SourceRange const& range);
+
+  /// The cheap check for the loops of all phases: reads the clock now and
+  /// then, and reports running out of time at range
+  /// @return true if the compile should stop
+  bool CheckBudget(SourceRange const& range) {
+    if (m_Budget.IsExhausted()) {
+      return true;
+    }
+    if (m_Budget.TimeExceeded()) {
+      ExhaustBudget(CompileBudget::R_Time, range);
+      return true;
+    }
+    return false;
+  }
+
+  DiagnosticFormat GetFormat() const noexcept { return m_Format; }
+  void SetFormat(DiagnosticFormat format) noexcept { m_Format = format; }
+
+  /// Appends all pending diagnostics, rendered in the current format
+  void RenderDiags(std::string &out) const;
+  /// Renders all pending diagnostics into one buffer, reused from batch to
+  /// batch, and writes it to stderr at once
   void EmitDiags();
   void ClearDiags() noexcept;
 
@@ -59,24 +214,122 @@ private:
     DiagnosticInfo& AddFixit(std::string &&desc,
                              SourceRange const& range);
 
+    DiagnosticInfo& AddDesc(DiagMessageTemplate messageTemplate,
+                            std::initializer_list<DiagParam> params,
+                            SourceRange const& range);
+
+    DiagnosticInfo& AddNote(DiagMessageTemplate messageTemplate,
+                            std::initializer_list<DiagParam> params,
+                            SourceRange const& range);
+
+    DiagnosticInfo& AddFixit(DiagMessageTemplate messageTemplate,
+                             std::initializer_list<DiagParam> params,
+                             SourceRange const& range);
+
   private:
-    DiagnosticInfo(DiagnosticInfoRank rank) : m_Rank(rank) {}
+    /// Either a template with its arguments, or text formatted by the
+    /// caller, in which case Template is DMT_End
+    struct Message {
+      DiagMessageTemplate Template;
+      std::vector<std::string> Params;
+      std::string Text;
+
+      void AppendTo(std::string &out) const;
+    };
 
-    void AddSubDiagnose(SubDiagnoseKind sdk, std::string &&desc,
+    DiagnosticInfo(DiagnosticInfoRank rank, bool dropped = false)
+      : m_Rank(rank), m_Dropped(dropped) {}
+
+    void AddSubDiagnose(SubDiagnoseKind sdk, Message &&message,
+                        SourceRange const& range);
+    void AddSubDiagnose(SubDiagnoseKind sdk,
+                        DiagMessageTemplate messageTemplate,
+                        std::initializer_list<DiagParam> params,
                         SourceRange const& range);
 
-    void Dump(std::string const& fileName,
-              std::vector<std::string> const& codeLines) const noexcept;
+    void RenderText(DiagnosticEngine const& engine,
+                    SourceManager const& sourceManager,
+                    std::string &out) const;
+    void RenderJSON(DiagnosticEngine const& engine,
+                    SourceManager const& sourceManager,
+                    std::string &out) const;
+
+    /// The order diagnostics of different threads are merged in: by
+    /// location, which orders files as they were added and places within
+    /// a file by offset, and for those at the same place by message
+    /// template, arguments and rank, never formatting the messages
+    bool RendersBefore(DiagnosticInfo const& other) const;
 
     DiagnosticInfoRank m_Rank;
+    /// The scratch info of dropped diagnostics, which records nothing
+    bool m_Dropped;
+    std::uint64_t m_Tag = 0;
     std::vector<SubDiagnoseKind> m_SDKs;
-    std::vector<std::string> m_Messages;
+    std::vector<Message> m_Messages;
     std::vector<SourceRange> m_SourceRanges;
   };
 
+  /// The diagnostics recorded by one thread
+  struct ThreadBuffer {
+    explicit ThreadBuffer(std::thread::id owner)
+      : Owner(owner), DroppedDiag(DIR_Error, true) {}
+
+    /// No thread once detached
+    std::thread::id Owner;
+    std::vector<DiagnosticInfo> Diags;
+    /// Given to every diagnostic recorded here
+    std::uint64_t Tag = 0;
+    /// Where diagnostics past the error limit go, never rendered
+    DiagnosticInfo DroppedDiag;
+  };
+
+  /// The buffer a thread used last, and the engine it belongs to
+  struct BufferCache {
+    std::uint64_t EngineID;
+    ThreadBuffer *Buffer;
+  };
+
+  ThreadBuffer& GetThreadBuffer();
+
+  /// @return the info to record a new diagnostic of rank into, a scratch
+  /// one that is never rendered if the error limit has been reached
+  DiagnosticInfo& NewDiag(DiagnosticInfoRank rank, SourceRange const& range);
+  /// Takes a discarded diagnostic back from the error count
+  void ForgetDiag(DiagnosticInfo const& info) noexcept;
+
+  void RenderDiags(SourceManager const& sourceManager,
+                   std::string &out) const;
+  void RenderDiag(DiagnosticInfo const& info,
+                  SourceManager const& sourceManager,
+                  std::string &out) const;
+
+  /// The file name rendered for a diagnostic at loc
+  std::string const& GetFileName(SourceManager const& sourceManager,
+                                 SourceLocation loc) const noexcept;
+
   std::string m_FileName;
-  std::vector<std::string> const& m_CodeLines;
-  std::vector<DiagnosticInfo> m_PendingDiags;
+  std::vector<std::string> const* m_CodeLines = nullptr;
+  sona::ref_ptr<SourceManager const> m_SourceManager = nullptr;
+  DiagnosticFormat m_Format = DF_Text;
+  std::string m_RenderBuffer;
+
+  /// Engines are told apart by an id of their own rather than by address,
+  /// which a later engine may reuse
+  std::uint64_t const m_EngineID;
+  static thread_local BufferCache t_LastBuffer;
+  mutable std::mutex m_BuffersLock;
+  /// A deque, for buffers to stay put while other threads add theirs
+  std::deque<ThreadBuffer> m_Buffers;
+
+  /// Errors recorded so far, those already emitted included
+  std::atomic<std::size_t> m_NumErrors { 0 };
+  std::size_t m_ErrorLimit = 0;
+  std::atomic<std::size_t> m_NumDropped { 0 };
+  /// Recorded by the thread whose error reaches the limit, and rendered
+  /// after all other diagnostics. Guarded by m_BuffersLock.
+  DiagnosticInfo m_LimitNote = DiagnosticInfo(DIR_Note);
+  bool m_LimitNotePending = false;
+  CompileBudget m_Budget;
 };
 
 } // namespace Diag
@@ -0,0 +1,42 @@
+#ifndef SOURCEBUFFER_H
+#define SOURCEBUFFER_H
+
+#include <cstdint>
+#include <string>
+
+#include "sona/pointer_plus.h"
+
+namespace ckx {
+
+/// A read-only, contiguous view of a whole source file. Files are mapped
+/// with mmap so that large generated sources are lexed in place without
+/// being copied, while in-memory sources (REPL lines, tests) are owned by
+/// the buffer itself. Offsets into the buffer are 32-bit.
+class SourceBuffer {
+public:
+  /// @return nullptr if the file cannot be opened or exceeds 4GiB
+  static sona::owner<SourceBuffer> MapFile(std::string const& fileName);
+  static sona::owner<SourceBuffer> FromString(std::string &&source);
+
+  SourceBuffer(SourceBuffer const&) = delete;
+  SourceBuffer& operator=(SourceBuffer const&) = delete;
+  ~SourceBuffer();
+
+  char const* GetBufferStart() const noexcept { return m_BufferStart; }
+  char const* GetBufferEnd() const noexcept {
+    return m_BufferStart + m_BufferSize;
+  }
+  std::uint32_t GetBufferSize() const noexcept { return m_BufferSize; }
+
+private:
+  SourceBuffer() = default;
+
+  char const *m_BufferStart = nullptr;
+  std::uint32_t m_BufferSize = 0;
+  bool m_IsMapped = false;
+  std::string m_OwnedSource;
+};
+
+} // namespace ckx
+
+#endif // SOURCEBUFFER_H
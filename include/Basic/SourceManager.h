@@ -0,0 +1,133 @@
+#ifndef SOURCEMANAGER_H
+#define SOURCEMANAGER_H
+
+#include "Basic/SourceBuffer.h"
+#include "Basic/SourceRange.h"
+
+#include "sona/pointer_plus.h"
+#include "sona/string_view.h"
+
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace ckx {
+
+/// Identifies a file added to a SourceManager, 0 for none
+class FileID {
+public:
+  constexpr FileID() noexcept : m_ID(0) {}
+
+  constexpr bool IsValid() const noexcept { return m_ID != 0; }
+  constexpr bool IsInvalid() const noexcept { return m_ID == 0; }
+
+  friend constexpr bool operator==(FileID lhs, FileID rhs) noexcept {
+    return lhs.m_ID == rhs.m_ID;
+  }
+
+  friend constexpr bool operator!=(FileID lhs, FileID rhs) noexcept {
+    return lhs.m_ID != rhs.m_ID;
+  }
+
+  /// Files added earlier come first
+  friend constexpr bool operator<(FileID lhs, FileID rhs) noexcept {
+    return lhs.m_ID < rhs.m_ID;
+  }
+
+private:
+  friend class SourceManager;
+  constexpr explicit FileID(std::uint32_t id) noexcept : m_ID(id) {}
+
+  std::uint32_t m_ID;
+};
+
+/// A SourceLocation decoded for humans, lines and columns counted from 1
+struct PresumedLoc {
+  std::string const* FileName;
+  std::uint32_t Line;
+  std::uint32_t Col;
+};
+
+/// The source files of a run, laid out one after another in a single 32-bit
+/// address space so that a SourceLocation alone tells file and position.
+/// A file of n bytes spans n + 1 offsets, the last one standing for its
+/// end. The offsets at which lines start are only collected the first time
+/// a file's lines are asked for, which for most runs, those without
+/// diagnostics, is never.
+///
+/// @note files must all be added before other threads use the manager,
+/// decoding locations is safe from any number of threads afterwards
+class SourceManager {
+public:
+  /// Where the first file added starts. A source lexed on its own, outside
+  /// of any manager, is laid out as that file would be.
+  static constexpr std::uint32_t FirstFileStart = 1;
+
+  SourceManager() = default;
+  SourceManager(SourceManager const&) = delete;
+  SourceManager& operator=(SourceManager const&) = delete;
+
+  /// @return an invalid FileID if the file cannot be mapped, see
+  /// SourceBuffer, or the address space is full
+  FileID OpenFile(std::string const& fileName);
+  FileID AddFile(std::string const& fileName,
+                 sona::owner<SourceBuffer> &&buffer);
+
+  std::string const& GetFileName(FileID fileID) const noexcept {
+    return GetEntry(fileID).FileName;
+  }
+
+  sona::ref_ptr<SourceBuffer const> GetBuffer(FileID fileID) const noexcept {
+    return GetEntry(fileID).Buffer.borrow();
+  }
+
+  SourceLocation GetLocForStartOfFile(FileID fileID) const noexcept {
+    return SourceLocation::FromRawEncoding(GetEntry(fileID).Start);
+  }
+
+  /// The file loc falls into, found by binary search over file starts
+  FileID GetFileID(SourceLocation loc) const noexcept;
+
+  /// Offset of loc from the start of its file
+  std::uint32_t GetFileOffset(SourceLocation loc) const noexcept;
+
+  /// A buffer with n line breaks has n + 1 lines, the last one possibly
+  /// empty
+  std::uint32_t GetNumLines(FileID fileID) const;
+
+  /// @param line counted from 1, like PresumedLoc
+  /// @return the text of the line without its line break
+  sona::string_view GetLine(FileID fileID, std::uint32_t line) const;
+
+  /// Line and column of loc as diagnostics show them, columns counting a
+  /// tab as eight
+  PresumedLoc GetPresumedLoc(SourceLocation loc) const;
+
+private:
+  struct FileEntry {
+    FileEntry(std::string const& fileName, sona::owner<SourceBuffer> &&buffer,
+              std::uint32_t start)
+      : FileName(fileName), Buffer(std::move(buffer)), Start(start) {}
+
+    std::string FileName;
+    sona::owner<SourceBuffer> Buffer;
+    std::uint32_t Start;
+    mutable std::once_flag LineTableOnce;
+    mutable std::vector<std::uint32_t> LineStarts;
+  };
+
+  FileEntry const& GetEntry(FileID fileID) const noexcept;
+  std::vector<std::uint32_t> const& GetLineStarts(FileEntry const& entry) const;
+
+  /// A deque so that entries, once-flags included, never move
+  std::deque<FileEntry> m_Files;
+  /// Start offsets of m_Files in order, for the binary search
+  std::vector<std::uint32_t> m_FileStarts;
+  std::uint32_t m_NextFileStart = FirstFileStart;
+};
+
+} // namespace ckx
+
+#endif // SOURCEMANAGER_H
@@ -9,35 +9,86 @@
 
 namespace ckx {
 
-using Coord = std::uint16_t;
-
+/// A position in the address space of a SourceManager, where every file
+/// gets a run of offsets of its own. Four bytes, compared and copied as an
+/// integer; the SourceManager turns it back into a file, line and column.
+/// Offset 0 is never handed out and stands for "no location".
 class SourceLocation {
 public:
-  SourceLocation(Coord line, Coord col)
-      : m_Line(line), m_Col(col) {}
-  Coord GetLine() const { return m_Line; }
-  Coord GetCol() const { return m_Col; }
+  constexpr SourceLocation() noexcept : m_Raw(0) {}
+
+  static constexpr SourceLocation
+  FromRawEncoding(std::uint32_t raw) noexcept {
+    return SourceLocation(raw);
+  }
+
+  constexpr std::uint32_t GetRawEncoding() const noexcept { return m_Raw; }
+
+  constexpr bool IsValid() const noexcept { return m_Raw != 0; }
+  constexpr bool IsInvalid() const noexcept { return m_Raw == 0; }
+
+  constexpr SourceLocation GetLocWithOffset(std::int64_t offset) const {
+    return SourceLocation(static_cast<std::uint32_t>(m_Raw + offset));
+  }
+
+  friend constexpr bool operator==(SourceLocation lhs,
+                                   SourceLocation rhs) noexcept {
+    return lhs.m_Raw == rhs.m_Raw;
+  }
+
+  friend constexpr bool operator!=(SourceLocation lhs,
+                                   SourceLocation rhs) noexcept {
+    return lhs.m_Raw != rhs.m_Raw;
+  }
+
+  friend constexpr bool operator<(SourceLocation lhs,
+                                  SourceLocation rhs) noexcept {
+    return lhs.m_Raw < rhs.m_Raw;
+  }
 
 private:
-  Coord m_Line, m_Col;
+  constexpr explicit SourceLocation(std::uint32_t raw) noexcept
+    : m_Raw(raw) {}
+
+  std::uint32_t m_Raw;
 };
 
-class SingleSourceRange {
+/// A run of source, from the location of its first character to the one
+/// past its last, so that an empty range still has a place. Both ends are
+/// SourceLocations: a range may span lines, and the SourceManager decodes
+/// either end into a line and column only when a diagnostic is rendered.
+/// A default-constructed range is invalid and stands for "no source".
+class SourceRange {
 public:
-  SingleSourceRange(Coord startLine, Coord startCol, Coord endCol)
-    : m_StartLine(startLine), m_StartCol(startCol), m_EndCol(endCol) {}
+  constexpr SourceRange() noexcept = default;
+  constexpr SourceRange(SourceLocation begin, SourceLocation end) noexcept
+    : m_Begin(begin), m_End(end) {}
+
+  constexpr SourceLocation GetBegin() const noexcept { return m_Begin; }
+  constexpr SourceLocation GetEnd() const noexcept { return m_End; }
 
+  constexpr bool IsValid() const noexcept { return m_Begin.IsValid(); }
+  constexpr bool IsInvalid() const noexcept { return m_Begin.IsInvalid(); }
 
-  Coord GetStartLine() const { return m_StartLine; }
-  Coord GetStartCol() const { return m_StartCol; }
-  Coord GetEndCol() const { return m_EndCol; }
+  /// From the begin of this range to the end of other
+  constexpr SourceRange Join(SourceRange other) const noexcept {
+    return SourceRange(m_Begin, other.m_End);
+  }
+
+  friend constexpr bool operator==(SourceRange lhs,
+                                   SourceRange rhs) noexcept {
+    return lhs.m_Begin == rhs.m_Begin && lhs.m_End == rhs.m_End;
+  }
+
+  friend constexpr bool operator!=(SourceRange lhs,
+                                   SourceRange rhs) noexcept {
+    return !(lhs == rhs);
+  }
 
 private:
-  Coord m_StartLine, m_StartCol, m_EndCol;
+  SourceLocation m_Begin, m_End;
 };
 
-using SourceRange = SingleSourceRange;
-
 } // namespace ckx
 
 #endif // SOURCERANGE_H
@@ -0,0 +1,12 @@
+#ifndef VERSION_H
+#define VERSION_H
+
+namespace ckx {
+
+/// Results the compiler caches on disk are keyed by this, bump it along
+/// with anything that changes what the compiler produces
+constexpr char const CompilerVersion[] = "ckxc-v2 0.1.0";
+
+} // namespace ckx
+
+#endif // VERSION_H
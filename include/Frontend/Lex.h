@@ -1,8 +1,9 @@
 #ifndef LEX_H
 #define LEX_H
 
-#include "Frontend/Token.h"
+#include "Frontend/TokenSource.h"
 #include "Basic/Diagnose.h"
+#include "Basic/SourceBuffer.h"
 #include "sona/pointer_plus.h"
 
 #include <memory>
@@ -14,10 +15,30 @@ namespace Frontend {
 
 class LexerImpl;
 
-class Lexer {
+/// Tokens are lexed on demand, either pulled one by one through the
+/// TokenSource interface or all at once with GetAndReset
+class Lexer : public TokenSource {
 public:
   Lexer(std::string &&sourceCode, Diag::DiagnosticEngine &diag);
-  std::vector<Token> GetAndReset() noexcept;
+  /// Lexes a (usually memory-mapped) buffer in place without copying it,
+  /// the buffer must outlive the lexer
+  Lexer(sona::ref_ptr<SourceBuffer const> buffer,
+        Diag::DiagnosticEngine &diag);
+  /// Same, and TokenBuffer::GetLocation gives token locations in
+  /// sourceManager
+  Lexer(SourceManager const& sourceManager, FileID fileID,
+        Diag::DiagnosticEngine &diag);
+
+  /// @note identifier and string tokens slice memory held by the lexer,
+  /// keep the lexer alive as long as the tokens are in use
+  TokenBuffer GetAndReset() noexcept;
+
+  /// Same as GetAndReset on a fresh lexer, but large inputs are cut into
+  /// chunks at line starts and lexed by numThreads threads. The tokens and
+  /// diagnostics are exactly those of the serial lexer.
+  TokenBuffer LexInParallel(unsigned numThreads);
+
+  Token NextToken() override;
 
   ~Lexer();
 
@@ -25,6 +46,30 @@ private:
   sona::owner<LexerImpl> m_LexerImpl;
 };
 
+/// Keeps a source and its tokens in sync while the source is being edited,
+/// lexing again only the tokens around each edit
+class IncrementalLexer {
+public:
+  IncrementalLexer(std::string &&sourceCode, Diag::DiagnosticEngine &diag);
+
+  sona::string_view GetSource() const noexcept;
+  TokenBuffer const& GetTokens() const noexcept;
+
+  /// Replaces removedLength bytes at offset with insertedText
+  /// @return the number of tokens lexed again
+  std::size_t ApplyEdit(std::uint32_t offset, std::uint32_t removedLength,
+                        sona::string_view insertedText);
+
+  ~IncrementalLexer();
+
+private:
+  /// Edited in place, so that tokens in front of an edit keep pointing at
+  /// the right text
+  std::string m_Source;
+  sona::owner<LexerImpl> m_LexerImpl;
+  TokenBuffer m_Tokens;
+};
+
 } // namespace Frontend
 } // namespace ckx
 
@@ -1,11 +1,14 @@
 #ifndef LEXIMPL_H
 #define LEXIMPL_H
 
-#include "Frontend/Token.h"
+#include "Frontend/TokenBuffer.h"
 #include "Basic/Diagnose.h"
+#include "Basic/SourceBuffer.h"
 
+#include <deque>
 #include <memory>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 namespace ckx {
@@ -14,44 +17,134 @@ namespace Frontend {
 class LexerImpl {
 public:
   LexerImpl(std::string &&sourceCode, Diag::DiagnosticEngine &diag)
-    : m_SourceCode(std::move(sourceCode)), m_Diag(diag) {
-    LexAllTokens();
+    : m_OwnedBuffer(SourceBuffer::FromString(std::move(sourceCode))),
+      m_Source(m_OwnedBuffer.borrow()->GetBufferStart()),
+      m_SourceSize(m_OwnedBuffer.borrow()->GetBufferSize()),
+      m_Diag(diag) {
+    m_TokenStream.SetSource(sona::string_view(m_Source, m_SourceSize));
   }
 
-  std::vector<Token> GetAndReset() noexcept;
+  /// @note the buffer is lexed in place and must outlive the lexer
+  LexerImpl(sona::ref_ptr<SourceBuffer const> buffer,
+            Diag::DiagnosticEngine &diag)
+    : m_Source(buffer->GetBufferStart()),
+      m_SourceSize(buffer->GetBufferSize()),
+      m_Diag(diag) {
+    m_TokenStream.SetSource(sona::string_view(m_Source, m_SourceSize));
+  }
+
+  /// @note the source is lexed in place and must outlive the lexer
+  LexerImpl(sona::string_view source, Diag::DiagnosticEngine &diag)
+    : m_Source(source.data()),
+      m_SourceSize(static_cast<std::uint32_t>(source.size())),
+      m_Diag(diag) {
+    m_TokenStream.SetSource(source);
+  }
+
+  /// Tokens then carry locations in the file starting at fileStart
+  void SetFileStart(SourceLocation fileStart) noexcept {
+    m_TokenStream.SetFileStart(fileStart);
+  }
+
+  /// Lexes whatever has not been pulled yet
+  TokenBuffer GetAndReset() noexcept;
+  Token NextToken();
+
+  TokenBuffer LexInParallel(unsigned numThreads);
+
+  /// Brings tokens, lexed from oldSource, up to date after the bytes
+  /// [offset, offset + removedLength) were replaced, yielding newSource.
+  /// Only tokens near the edit are lexed again, the rest are moved. Of
+  /// oldSource only the size is used, the edit may well have been made in
+  /// place.
+  /// @return the number of tokens lexed again
+  std::size_t Relex(TokenBuffer &tokens,
+                    sona::string_view oldSource, sona::string_view newSource,
+                    std::uint32_t offset, std::uint32_t removedLength);
 
 private:
   void LexAllTokens();
+  /// Lexes until a token starting at or behind offset end is appended
+  void LexUntil(std::uint32_t end);
+  /// Appends exactly one token to m_TokenStream, skipping whitespace and
+  /// garbage characters on the way
+  void LexNextToken();
+  /// Checks the token count and the clock against the compile budget
+  /// @return true if lexing should end here
+  bool OutOfBudget();
 
-  void LexIdentifier();
   void LexIdOrKeyword();
   void LexNumber();
   void LexBinNumber();
   void LexHexNumber();
   void LexChar();
   void LexString();
-  void LexSymbol();
+  /// Lexes the longest operator at the current position
+  /// @return false if no operator starts here
+  bool LexSymbol();
   void SkipWhitespace();
 
-  std::string ScanIdString();
-
-  std::uint64_t ScanInt();
+  void SkipIdString();
+  /// Skips an unknown escape sequence, which a truncated source may cut
+  /// short after the backslash
+  void SkipEscape() noexcept;
+
+  /// @return the text, stored for as long as a token refers to it
+  sona::string_view KeepDecoded(std::string &&str);
+  /// Frees the decoded text of a token edited away, text slicing the
+  /// source is left alone
+  void ReleaseDecoded(char const* text);
+
+  /// Reports digits missing after a base prefix, and letters trailing the
+  /// digits other than an 'u' suffix
+  void SkipJunkAfterNumber(bool noDigits, char const* context);
+  /// Eats an optional 'u' suffix, checks the range and emits the literal
+  void FinishIntLiteral(char const* litStart, bool fits,
+                        std::uint64_t value);
+  void FinishFloatLiteral(char const* litStart, char const* intEnd,
+                          char const* fracBegin, char const* fracEnd,
+                          std::int64_t exponent);
 
   char CurChar() const noexcept;
   void NextChar() noexcept;
   char PeekOneChar() const noexcept;
 
-  SourceRange CurCharRange() const noexcept;
+  char const* CurCharPtr() const noexcept { return m_Source + m_Index; }
+  char const* SourceEnd() const noexcept { return m_Source + m_SourceSize; }
+  /// Skips to runEnd, a position ahead in the source
+  void SkipTo(char const* runEnd) noexcept;
 
-  std::uint16_t GetLine() const noexcept;
-  std::uint16_t GetCol() const noexcept;
+  SourceLocation GetLoc(std::uint32_t offset) const noexcept;
+  SourceRange RangeAt(std::uint32_t begin, std::uint32_t end) const noexcept;
+  /// From the start of the token being lexed to the current position
+  SourceRange TokenRange() const noexcept;
+  SourceRange CurCharRange() const noexcept;
 
-  std::string m_SourceCode;
+  sona::owner<SourceBuffer> m_OwnedBuffer = nullptr;
+  char const *m_Source;
+  std::uint32_t m_SourceSize;
   Diag::DiagnosticEngine &m_Diag;
 
-  std::uint16_t m_Index = 0;
-  std::uint16_t m_Line = 1, m_Col = 1;
-  std::vector<Token> m_TokenStream;
+  std::uint32_t m_Index = 0;
+  /// Byte offset of the token being lexed
+  std::uint32_t m_TokenStart = 0;
+  bool m_ReachedEOI = false;
+  /// Tokens lexed so far, EOI included
+  std::size_t m_NumTokens = 0;
+  /// Set for the lexer of a chunk, whose diagnostics are tagged with this
+  /// and the offset of the token they come from. Such a lexer leaves the
+  /// token limit to the whole file.
+  std::uint64_t m_DiagTag = 0;
+  TokenBuffer m_TokenStream;
+  /// String literals with escapes cannot slice the source, their decoded
+  /// text lives here. A deque never relocates what it already holds, and
+  /// the slots of tokens an edit removes are reused.
+  std::deque<std::string> m_DecodedStrings;
+  std::vector<std::size_t> m_FreeDecoded;
+  std::unordered_map<char const*, std::size_t> m_DecodedSlots;
+  /// Those of the chunk lexers after a parallel run, taken over deque by
+  /// deque so that nothing relocates
+  std::vector<std::deque<std::string>> m_ChunkDecodedStrings;
 };
 
 } // namespace Frontend
@@ -0,0 +1,31 @@
+#ifndef LEXNUMBER_H
+#define LEXNUMBER_H
+
+#include <cstdint>
+
+namespace ckx {
+namespace Frontend {
+
+/// Numeric literal decoding used by the lexer. Digit spans are given as
+/// [begin, end) and must consist of digits of the right base only, the
+/// lexer has already delimited them.
+
+/// @return false if the value does not fit in 64 bits
+bool DecodeDecimal(char const* begin, char const* end,
+                   std::uint64_t &value) noexcept;
+bool DecodeHex(char const* begin, char const* end,
+               std::uint64_t &value) noexcept;
+bool DecodeBinary(char const* begin, char const* end,
+                  std::uint64_t &value) noexcept;
+
+/// Decodes intPart.fracPart * 10^exponent to the nearest double, ties to
+/// even. Either part may be empty.
+/// @return false if the value is too large and decodes to infinity
+bool DecodeFloat(char const* intBegin, char const* intEnd,
+                 char const* fracBegin, char const* fracEnd,
+                 std::int64_t exponent, double &value) noexcept;
+
+} // namespace Frontend
+} // namespace ckx
+
+#endif // LEXNUMBER_H
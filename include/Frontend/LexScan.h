@@ -0,0 +1,79 @@
+#ifndef LEXSCAN_H
+#define LEXSCAN_H
+
+namespace ckx {
+namespace Frontend {
+
+/// Character-class scanning kernels used by the lexer hot loops. Each one
+/// returns the first position in [begin, end) whose character falls out of
+/// the class, or end. The vector kernels never read past end.
+enum class ScanKernel { SK_Scalar, SK_SSE2, SK_AVX2 };
+
+/// ' ', '\t', '\n', '\v', '\f' and '\r'
+char const* ScanWhitespaceRun(char const* begin, char const* end) noexcept;
+/// [0-9A-Za-z_$]
+char const* ScanIdContinueRun(char const* begin, char const* end) noexcept;
+/// [0-9]
+char const* ScanDigitRun(char const* begin, char const* end) noexcept;
+
+/// The character classes of the kernels, one character at a time
+inline bool IsWhitespaceChar(unsigned char ch) noexcept {
+  return ch == ' ' || static_cast<unsigned char>(ch - '\t') <= 4;
+}
+
+inline bool IsDigitChar(unsigned char ch) noexcept {
+  return static_cast<unsigned char>(ch - '0') <= 9;
+}
+
+inline bool IsIdContinueChar(unsigned char ch) noexcept {
+  return IsDigitChar(ch)
+         || static_cast<unsigned char>((ch | 0x20) - 'a') < 26
+         || ch == '_' || ch == '$';
+}
+
+/// How many characters the Scan*RunInline functions look at before they
+/// call the kernel
+constexpr int InlineScanLength = 8;
+
+/// Most runs in operator-dense code end within a few characters, where
+/// the call through the kernel table costs more than a vector kernel
+/// saves. Scans the first InlineScanLength characters in place and only
+/// hands longer runs to the kernel.
+template <bool (*InClass)(unsigned char),
+          char const* (*Kernel)(char const*, char const*)>
+inline char const* ScanRunInline(char const* begin, char const* end) noexcept {
+  char const *limit =
+      end - begin > InlineScanLength ? begin + InlineScanLength : end;
+  for (; begin != limit; ++begin) {
+    if (!InClass(static_cast<unsigned char>(*begin))) {
+      return begin;
+    }
+  }
+  return begin == end ? end : Kernel(begin, end);
+}
+
+inline char const* ScanWhitespaceRunInline(char const* begin,
+                                           char const* end) noexcept {
+  return ScanRunInline<&IsWhitespaceChar, &ScanWhitespaceRun>(begin, end);
+}
+
+inline char const* ScanIdContinueRunInline(char const* begin,
+                                           char const* end) noexcept {
+  return ScanRunInline<&IsIdContinueChar, &ScanIdContinueRun>(begin, end);
+}
+
+inline char const* ScanDigitRunInline(char const* begin,
+                                      char const* end) noexcept {
+  return ScanRunInline<&IsDigitChar, &ScanDigitRun>(begin, end);
+}
+
+/// The best kernel supported by the running CPU is selected on first use,
+/// benchmarks may force a different one, even while other threads lex.
+ScanKernel GetScanKernel() noexcept;
+bool IsScanKernelSupported(ScanKernel kernel) noexcept;
+void SetScanKernel(ScanKernel kernel) noexcept;
+
+} // namespace Frontend
+} // namespace ckx
+
+#endif // LEXSCAN_H
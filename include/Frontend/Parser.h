@@ -4,6 +4,10 @@
 #include "Frontend/Lex.h"
 #include "Syntax/Concrete.h"
 
+#include <cstddef>
+#include <string>
+#include <vector>
+
 namespace ckx {
 namespace Frontend {
 
@@ -14,13 +18,37 @@ public:
   Parser(Diag::DiagnosticEngine &diag);
 
   sona::owner<Syntax::TransUnit>
-  ParseTransUnit(sona::ref_ptr<std::vector<Token> const> tokenStream);
+  ParseTransUnit(sona::ref_ptr<TokenBuffer const> tokenStream);
+
+  /// Parses while pulling tokens, lexing and parsing then overlap and only
+  /// a handful of tokens are alive at any time
+  sona::owner<Syntax::TransUnit>
+  ParseTransUnit(sona::ref_ptr<TokenSource> tokenSource);
+
+  /// Parses the declarations of a large file with numThreads threads. The
+  /// tree and the diagnostics are exactly those of ParseTransUnit.
+  sona::owner<Syntax::TransUnit>
+  ParseTransUnitInParallel(sona::ref_ptr<TokenBuffer const> tokenStream,
+                           unsigned numThreads);
 
-  sona::owner<Syntax::Expr>
-  ParseExpr(sona::ref_ptr<std::vector<Token> const> tokenStream);
+  /// Nodes parsed outside a TransUnit belong to the parser, they live as
+  /// long as it does
+  Syntax::NodePtr<Syntax::Expr>
+  ParseExpr(sona::ref_ptr<TokenBuffer const> tokenStream);
 
-  sona::owner<Syntax::VarDecl>
-  ParseVarDecl(sona::ref_ptr<std::vector<Token> const> tokenStream);
+  Syntax::NodePtr<Syntax::VarDecl>
+  ParseVarDecl(sona::ref_ptr<TokenBuffer const> tokenStream);
+
+  /// Records the token range of function bodies instead of parsing them,
+  /// ParseFuncBody parses one when it is needed
+  void SetSkipFuncBodies(bool skip) noexcept;
+
+  /// @note tokenStream must hold the tokens of the whole file unit was
+  /// parsed from, the body nodes are allocated from the arena of unit
+  Syntax::NodePtr<Syntax::Stmt>
+  ParseFuncBody(sona::ref_ptr<TokenBuffer const> tokenStream,
+                sona::ref_ptr<Syntax::TransUnit> unit,
+                sona::ref_ptr<Syntax::FuncDecl const> funcDecl);
 
   ~Parser();
 
@@ -28,6 +56,61 @@ private:
   sona::owner<ParserImpl> m_ParserImpl;
 };
 
+/// Parses REPL and piped input as it arrives, a line at a time. Every line
+/// is lexed once, onto the tokens of the lines before it, and an entry (a
+/// variable declaration or an expression) is parsed once its brackets are
+/// balanced. Input stopping early, after an operator or inside brackets,
+/// asks for more lines instead of failing.
+class IncrementalParser {
+public:
+  enum Status {
+    /// The entry goes on, push another line
+    IPS_NeedMoreInput,
+    /// GetEntry() gives the entry parsed
+    IPS_Complete,
+    /// The errors went to the diagnostic engine, the entry is dropped
+    IPS_Error
+  };
+
+  /// Errors are reported to diag, which must have been created on lines.
+  /// The parser keeps the lines of the current entry there, from the
+  /// first line pushed after the last entry ended.
+  IncrementalParser(Diag::DiagnosticEngine &diag,
+                    std::vector<std::string> &lines);
+
+  Status PushLine(sona::string_view line);
+
+  /// The input ended, the pending entry is parsed as it is
+  Status Finish();
+
+  /// @return true if lines of an unfinished entry were pushed
+  bool IsPending() const noexcept;
+
+  /// The entry of the last IPS_Complete, a VarDecl or an Expr. It lives
+  /// until the next line is pushed.
+  sona::ref_ptr<Syntax::Node const> GetEntry() const noexcept;
+
+  ~IncrementalParser();
+
+private:
+  void StartEntry();
+  Status TryParse(bool atEnd);
+
+  Diag::DiagnosticEngine &m_Diag;
+  std::vector<std::string> &m_Lines;
+  /// Parse attempts report here, only the last one of a failing entry is
+  /// reported to m_Diag
+  std::vector<std::string> m_NoLines;
+  Diag::DiagnosticEngine m_TryDiag;
+  sona::owner<ParserImpl> m_ParserImpl;
+  IncrementalLexer m_Lexer;
+  Syntax::NodePtr<Syntax::Node> m_Entry;
+  /// Tokens of the entry already counted into m_Depth
+  std::size_t m_ScannedTokens = 0;
+  std::ptrdiff_t m_Depth = 0;
+  bool m_EntryDone = false;
+};
+
 } // namespace Frontend
 } // namespace ckx
 
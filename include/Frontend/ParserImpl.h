@@ -4,70 +4,108 @@
 #include "Frontend/Lex.h"
 #include "Syntax/Concrete.h"
 
+#include <array>
+
 namespace ckx {
 namespace Frontend {
 
 class ParserImpl {
 public:
-  ParserImpl(Diag::DiagnosticEngine &diag) : m_Diag(diag) {}
+  ParserImpl(Diag::DiagnosticEngine &diag)
+    : m_Diag(diag), m_Arena(m_OwnArena) {}
+
+  sona::owner<Syntax::TransUnit>
+  ParseTransUnit(sona::ref_ptr<TokenBuffer const> tokenStream);
+
+  sona::owner<Syntax::TransUnit>
+  ParseTransUnit(sona::ref_ptr<TokenSource> tokenSource);
 
   sona::owner<Syntax::TransUnit>
-  ParseTransUnit(sona::ref_ptr<std::vector<Token> const> tokenStream);
+  ParseTransUnitInParallel(sona::ref_ptr<TokenBuffer const> tokenStream,
+                           unsigned numThreads);
+
+  Syntax::NodePtr<Syntax::Stmt>
+  ParseLine(sona::ref_ptr<TokenBuffer const> tokenStream);
+
+  Syntax::NodePtr<Syntax::Expr>
+  ParseReplExpr(sona::ref_ptr<TokenBuffer const> tokenStream);
+
+  Syntax::NodePtr<Syntax::VarDecl>
+  ParseReplVarDecl(sona::ref_ptr<TokenBuffer const> tokenStream);
 
-  sona::owner<Syntax::Stmt>
-  ParseLine(sona::ref_ptr<std::vector<Token> const> tokenStream);
+  /// Parses one REPL entry, a variable declaration if it starts with def
+  /// and an expression otherwise. An optional ';' may end it, anything
+  /// else left before the end of input is an error.
+  Syntax::NodePtr<Syntax::Node>
+  ParseReplEntry(sona::ref_ptr<TokenSource> tokenSource);
 
-  sona::owner<Syntax::Expr>
-  ParseReplExpr(sona::ref_ptr<std::vector<Token> const> tokenStream);
+  /// Records where function bodies start and end instead of parsing them,
+  /// which leaves little more than brace matching for their tokens
+  void SetSkipFuncBodies(bool skip) noexcept { m_SkipFuncBodies = skip; }
 
-  sona::owner<Syntax::VarDecl>
-  ParseReplVarDecl(sona::ref_ptr<std::vector<Token> const> tokenStream);
+  /// Parses the body of funcDecl skipped by ParseTransUnit into the arena
+  /// of unit. tokenStream holds the tokens of the whole file.
+  Syntax::NodePtr<Syntax::Stmt>
+  ParseFuncBody(sona::ref_ptr<TokenBuffer const> tokenStream,
+                sona::ref_ptr<Syntax::TransUnit> unit,
+                sona::ref_ptr<Syntax::FuncDecl const> funcDecl);
 
 protected:
   /// @note Opening access to subclasses for test
-  sona::owner<Syntax::Decl> ParseDeclOrFndef();
-  sona::owner<Syntax::Decl> ParseVarDecl();
-  sona::owner<Syntax::Decl> ParseClassDecl();
-  sona::owner<Syntax::Decl> ParseEnumDecl();
-  sona::owner<Syntax::Decl> ParseADTDecl();
-  sona::owner<Syntax::Decl> ParseFuncDecl();
-  sona::owner<Syntax::Decl> ParseUsingDecl();
-  sona::owner<Syntax::Type> ParseType();
-
-  sona::owner<Syntax::Expr> ParseExpr();
-  sona::owner<Syntax::Expr> ParseAssignExpr();
-  sona::owner<Syntax::Expr> ParseLiteralExpr();
-  sona::owner<Syntax::Expr> ParseIdRefExpr();
-
-  sona::owner<Syntax::Expr> ParseUnaryExpr();
-  sona::owner<Syntax::Expr> ParseUnaryAlgebraicExpr();
-  sona::owner<Syntax::Expr> ParseSizeofExpr();
-  sona::owner<Syntax::Expr> ParseAlignofExpr();
-  sona::owner<Syntax::Expr> ParseCastExpr();
-  sona::owner<Syntax::Expr> ParsePostfixExpr();
-
-  sona::owner<Syntax::Expr>
-  ParseFuncCallExpr(sona::owner<Syntax::Expr> &&parsedCallee);
-  sona::owner<Syntax::Expr>
-  ParseArraySubscriptExpr(sona::owner<Syntax::Expr> &&arr);
-  sona::owner<Syntax::Expr>
-  ParseMemberAccessExpr(sona::owner<Syntax::Expr> &&base);
-
-  sona::owner<Syntax::Expr> ParseBinaryExpr(std::uint16_t prevPrec);
+  Syntax::NodePtr<Syntax::Decl> ParseTopLevelDecl();
+  Syntax::NodePtr<Syntax::Decl> ParseDeclOrFndef();
+  Syntax::NodePtr<Syntax::Decl> ParseVarDecl();
+  Syntax::NodePtr<Syntax::Decl> ParseClassDecl();
+  Syntax::NodePtr<Syntax::Decl> ParseEnumDecl();
+  Syntax::NodePtr<Syntax::Decl> ParseADTDecl();
+  Syntax::NodePtr<Syntax::Decl> ParseFuncDecl();
+  /// Parses one `name : type` of a parameter list
+  /// @return false, having reported it, if it is malformed
+  bool ParseFuncParam(std::vector<sona::strhdl_t> &paramNames,
+                      std::vector<Syntax::NodePtr<Syntax::Type>> &paramTypes);
+  Syntax::NodePtr<Syntax::Decl> ParseUsingDecl();
+  Syntax::NodePtr<Syntax::Type> ParseType();
+
+  Syntax::NodePtr<Syntax::Stmt> ParseStmt();
+  Syntax::NodePtr<Syntax::Stmt> ParseCompoundStmt();
+  Syntax::NodePtr<Syntax::Stmt> ParseExprStmt();
+  Syntax::NodePtr<Syntax::Stmt> ParseReturnStmt();
+
+  Syntax::NodePtr<Syntax::Expr> ParseExpr();
+  Syntax::NodePtr<Syntax::Expr> ParseAssignExpr();
+  Syntax::NodePtr<Syntax::Expr> ParseLiteralExpr();
+  Syntax::NodePtr<Syntax::Expr> ParseIdRefExpr();
+
+  Syntax::NodePtr<Syntax::Expr> ParseUnaryExpr();
+  Syntax::NodePtr<Syntax::Expr> ParseUnaryAlgebraicExpr();
+  Syntax::NodePtr<Syntax::Expr> ParseSizeofExpr();
+  Syntax::NodePtr<Syntax::Expr> ParseAlignofExpr();
+  Syntax::NodePtr<Syntax::Expr> ParseCastExpr();
+  Syntax::NodePtr<Syntax::Expr> ParsePostfixExpr();
+
+  Syntax::NodePtr<Syntax::Expr>
+  ParseFuncCallExpr(Syntax::NodePtr<Syntax::Expr> &&parsedCallee);
+  Syntax::NodePtr<Syntax::Expr>
+  ParseArraySubscriptExpr(Syntax::NodePtr<Syntax::Expr> &&arr);
+  Syntax::NodePtr<Syntax::Expr>
+  ParseMemberAccessExpr(Syntax::NodePtr<Syntax::Expr> &&base);
+
+  Syntax::NodePtr<Syntax::Expr> ParseBinaryExpr(std::uint16_t prevPrec);
 
   void ParseEnumerator(std::vector<Syntax::EnumDecl::Enumerator> &enumerators);
   void ParseDataConstructor(
       std::vector<Syntax::ADTDecl::ValueConstructor>& dataConstructors);
 
-  sona::owner<Syntax::Type> ParseBuiltinType();
-  sona::owner<Syntax::Type> ParseUserDefinedType();
+  Syntax::NodePtr<Syntax::Type> ParseBuiltinType();
+  Syntax::NodePtr<Syntax::Type> ParseUserDefinedType();
   Syntax::Identifier ParseIdentifier();
 
   void
-  SetParsingTokenStream(sona::ref_ptr<std::vector<Token> const> tokenStream);
+  SetParsingTokenStream(sona::ref_ptr<TokenBuffer const> tokenStream);
+  void SetTokenSource(sona::ref_ptr<TokenSource> tokenSource);
 
-  Token const& CurrentToken() const noexcept;
-  Token const& PeekToken(size_t peekCount = 1) const noexcept;
+  Token CurrentToken() const noexcept;
+  Token PeekToken(size_t peekCount = 1) const noexcept;
   void ConsumeToken() noexcept;
 
   bool Expect(Token::TokenKind tokenKind) const noexcept;
@@ -76,16 +114,73 @@ protected:
 private:
   sona::optional<std::pair<sona::strhdl_t, SourceRange>> ExpectTagId();
 
+  /// Parses the top-level declarations starting at token first into arena
+  /// until reaching token last
+  /// @return the index of the token it stopped at, past last if the last
+  /// of them ran past it, before if the input or the budget ran out
+  std::size_t
+  ParseDeclRange(sona::ref_ptr<TokenBuffer const> tokenStream,
+                 std::size_t first, std::size_t last,
+                 sona::ref_ptr<Syntax::SyntaxArena> arena,
+                 std::vector<Syntax::NodePtr<Syntax::Decl>> &decls);
+
   void SkipTo(Token::TokenKind tokenKind);
   void SkipToAnyOf(std::initializer_list<Token::TokenKind> const& tokenKinds);
 
   template <typename Cond> void SkipUntil(Cond cond);
 
-  sona::strhdl_t PrettyPrintToken(Token const &token) const;
+  /// Consumes a braced function body, nested braces included
+  /// @return false, having reported it, if the input ends first
+  bool SkipFuncBody(std::size_t &rbraceIndex);
+
+  std::string PrettyPrintToken(Token const &token) const;
+
+  /// Pulls tokens until at least count of them are buffered
+  void FillLookahead(size_t count) const noexcept;
+
+  /// Checks the compile budget. Once it is exhausted the parser only sees
+  /// the end of input, which every loop of the grammar stops at.
+  /// @return true if the budget is exhausted
+  bool OutOfBudget() const;
+
+  /// Counts one level of recursion of the grammar for as long as it lives
+  class NestingScope {
+  public:
+    NestingScope(ParserImpl const& parser) noexcept
+      : m_Depth(parser.m_Depth) { ++m_Depth; }
+    ~NestingScope() { --m_Depth; }
+
+  private:
+    size_t &m_Depth;
+  };
+
+  /// @return true, having reported it, if nesting went too deep
+  bool TooDeep() const;
+
+  /// Enough for the deepest PeekToken the grammar needs
+  static constexpr size_t LookaheadCapacity = 4;
 
   Diag::DiagnosticEngine &m_Diag;
-  sona::ref_ptr<std::vector<Token> const> m_ParsingTokenStream = nullptr;
-  size_t m_Index;
+  /// Nodes are allocated from the arena of the TransUnit being parsed, or
+  /// from m_OwnArena for the entry points parsing a lone expression or
+  /// declaration, which then live as long as the parser
+  Syntax::SyntaxArena m_OwnArena;
+  sona::ref_ptr<Syntax::SyntaxArena> m_Arena;
+  sona::owner<TokenSource> m_OwnedTokenSource = nullptr;
+  /// The source and the ring buffer of tokens pulled but not yet consumed
+  /// are advanced lazily by the otherwise const CurrentToken() and
+  /// PeekToken()
+  mutable sona::ref_ptr<TokenSource> m_TokenSource = nullptr;
+  mutable std::array<Token, LookaheadCapacity> m_Lookahead;
+  mutable size_t m_LookaheadStart = 0;
+  mutable size_t m_LookaheadCount = 0;
+  /// Index of the current token in the stream
+  size_t m_TokenIndex = 0;
+  bool m_SkipFuncBodies = false;
+  mutable size_t m_Depth = 0;
+  mutable bool m_OutOfBudget = false;
+  /// Handed out in place of the rest of the input once out of budget
+  mutable Token m_BudgetEOI;
 };
 
 Syntax::UnaryOperator TokenToUnary(Frontend::Token::TokenKind token) noexcept;
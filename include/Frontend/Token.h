@@ -3,7 +3,8 @@
 
 #include "Basic/SourceRange.h"
 #include "sona/stringref.h"
-#include "sona/optional.h"
+#include "sona/string_view.h"
+#include "sona/util.h"
 #include <cstdint>
 
 namespace ckx {
@@ -20,9 +21,10 @@ public:
     TK_INVALID
   };
 
+  Token() : Token(TK_INVALID, SourceRange()) {}
+
   Token(TokenKind tokenKind, SourceRange const& sourceRange) :
-    m_TokenKind(tokenKind), m_SourceRange(sourceRange),
-    m_StrValue(sona::empty_optional()) {}
+    m_TokenKind(tokenKind), m_SourceRange(sourceRange) {}
 
   Token(TokenKind tokenKind, SourceRange const& sourceRange,
         std::int64_t intValue)
@@ -48,19 +50,31 @@ public:
     m_Value.CharValue = charValue;
   }
 
+  /// @note text slices the lexer's source buffer (or its own storage for
+  /// decoded string literals), so the lexer must outlive the token
   Token(TokenKind tokenKind, SourceRange const& sourceRange,
-        sona::strhdl_t const& strValue)
-    : m_TokenKind(tokenKind), m_SourceRange(sourceRange),
-      m_StrValue(strValue) {}
+        sona::string_view text)
+    : Token(tokenKind, sourceRange) {
+    m_Value.Text.Ptr = text.data();
+    m_Value.Text.Length = static_cast<std::uint32_t>(text.size());
+    m_Value.Text.Skip = 0;
+  }
 
-  TokenKind const& GetTokenKind() const noexcept {
+  TokenKind GetTokenKind() const noexcept {
     return m_TokenKind;
   }
 
-  SourceRange const& GetSourceRange() const noexcept {
+  SourceRange GetSourceRange() const noexcept {
     return m_SourceRange;
   }
 
+  /// Identifiers and literals carry a value, keywords and symbols don't
+  static constexpr bool HasPayload(TokenKind tokenKind) noexcept {
+    return tokenKind == TK_ID || tokenKind == TK_LIT_INT
+           || tokenKind == TK_LIT_UINT || tokenKind == TK_LIT_FLOAT
+           || tokenKind == TK_LIT_CHAR || tokenKind == TK_LIT_STR;
+  }
+
   std::int64_t GetIntValueUnsafe() const noexcept {
     sona_assert(GetTokenKind() == TK_LIT_INT);
     return m_Value.IntValue;
@@ -81,24 +95,41 @@ public:
     return m_Value.CharValue;
   }
 
-  sona::strhdl_t const& GetStrValueUnsafe() const noexcept {
+  sona::string_view GetStrViewUnsafe() const noexcept {
     sona_assert(GetTokenKind() == TK_LIT_STR || GetTokenKind() == TK_ID);
-    sona_assert(m_StrValue.has_value());
-    return m_StrValue.value();
+    return sona::string_view(m_Value.Text.Ptr, m_Value.Text.Length);
+  }
+
+  /// Interns the text on demand, tokens the parser skips never pay for it
+  sona::strhdl_t GetStrValueUnsafe() const {
+    return sona::strhdl_t(GetStrViewUnsafe());
   }
 
 private:
-  TokenKind const m_TokenKind;
-  SourceRange const m_SourceRange;
+  friend class TokenBuffer;
 
-  union {
+  union Payload {
     std::int64_t IntValue;
     std::uint64_t UIntValue;
     double FloatValue;
     char CharValue;
-  } m_Value;
+    struct {
+      char const *Ptr;
+      std::uint32_t Length;
+      /// Only used by TokenBuffer, which keeps text slicing the source as
+      /// a null Ptr and the distance from the start of the token to the
+      /// text, so that the text moves along with the token
+      std::uint32_t Skip;
+    } Text;
+  };
+
+  Token(TokenKind tokenKind, SourceRange const& sourceRange,
+        Payload const& value)
+    : m_TokenKind(tokenKind), m_SourceRange(sourceRange), m_Value(value) {}
 
-  sona::optional<sona::strhdl_t> m_StrValue;
+  TokenKind m_TokenKind;
+  SourceRange m_SourceRange;
+  Payload m_Value;
 };
 
 sona::strhdl_t PrettyPrintTokenKind(Token::TokenKind tokenKind);
@@ -0,0 +1,190 @@
+#ifndef TOKENBUFFER_H
+#define TOKENBUFFER_H
+
+#include "Basic/SourceManager.h"
+#include "Frontend/Token.h"
+
+#include <cstdint>
+#include <limits>
+#include <utility>
+#include <vector>
+
+namespace ckx {
+namespace Frontend {
+
+/// Lexed tokens stored as a struct of arrays. Most tokens are keywords and
+/// symbols without a value, so kinds and ranges are kept dense and only
+/// identifiers and literals occupy a slot in the payload table. The range
+/// of a token is a pair of SourceLocations in the file the buffer starts
+/// at, the byte offset of a token in its source is where its range begins
+/// less the file start.
+///
+/// Edited buffers keep a gap in the arrays where they were last edited,
+/// and the tokens behind the gap are stored unshifted, with the shift of
+/// all of them pending. An edit then costs the tokens it replaces plus
+/// those the gap moves over, not every token behind it. Text slicing the
+/// source is kept relative to its token, so it moves along for free.
+class TokenBuffer {
+public:
+  TokenBuffer() = default;
+  TokenBuffer(TokenBuffer&&) = default;
+  TokenBuffer& operator=(TokenBuffer&&) = default;
+
+  template <typename ...Args>
+  void EmplaceToken(Args&& ...args) {
+    AddToken(Token(std::forward<Args>(args)...));
+  }
+
+  /// Keywords and symbols, the bulk of any token stream, skip the payload
+  /// table altogether
+  void EmplaceToken(Token::TokenKind tokenKind, SourceRange sourceRange) {
+    sona_assert(!Token::HasPayload(tokenKind));
+    if (m_GapBegin != NoGap) {
+      CloseGap();
+    }
+    m_Kinds.push_back(static_cast<std::uint8_t>(tokenKind));
+    m_Ranges.push_back(sourceRange);
+    m_PayloadIndices.push_back(NoPayload);
+  }
+
+  void AddToken(Token const& token) {
+    if (m_GapBegin != NoGap) {
+      CloseGap();
+    }
+    m_Kinds.push_back(static_cast<std::uint8_t>(token.GetTokenKind()));
+    m_Ranges.push_back(token.GetSourceRange());
+    m_PayloadIndices.push_back(
+        Token::HasPayload(token.GetTokenKind())
+          ? NewPayload(PackPayload(token.GetTokenKind(),
+                                   token.GetSourceRange(), token.m_Value))
+          : NoPayload);
+  }
+
+  std::size_t size() const noexcept { return m_Kinds.size() - m_GapSize; }
+  bool empty() const noexcept { return size() == 0; }
+
+  /// Drops all tokens but keeps the storage for reuse
+  void clear() noexcept {
+    m_Kinds.clear();
+    m_Ranges.clear();
+    m_PayloadIndices.clear();
+    m_Payloads.clear();
+    m_FreePayloads.clear();
+    m_GapBegin = NoGap;
+    m_GapSize = 0;
+    m_TailShift = 0;
+  }
+
+  Token::TokenKind GetTokenKind(std::size_t idx) const noexcept {
+    return static_cast<Token::TokenKind>(m_Kinds[Phys(idx)]);
+  }
+
+  SourceRange GetSourceRange(std::size_t idx) const noexcept {
+    if (idx < m_GapBegin) {
+      return m_Ranges[idx];
+    }
+    return Shift(m_Ranges[idx + m_GapSize], m_TailShift);
+  }
+
+  std::uint32_t GetOffset(std::size_t idx) const noexcept {
+    return GetSourceRange(idx).GetBegin().GetRawEncoding()
+           - m_FileStart.GetRawEncoding();
+  }
+
+  /// Where offset 0 of the source lies, by default where a SourceManager
+  /// puts its first file
+  SourceLocation GetFileStart() const noexcept { return m_FileStart; }
+  void SetFileStart(SourceLocation fileStart) noexcept {
+    m_FileStart = fileStart;
+  }
+
+  /// The source identifiers and string literals slice. Set before adding
+  /// tokens, and again whenever the source moves.
+  void SetSource(sona::string_view source) noexcept {
+    m_Source = source;
+  }
+
+  /// Index of the first token starting at or after offset
+  std::size_t LowerBound(std::uint32_t offset) const noexcept;
+
+  Token operator[](std::size_t idx) const noexcept {
+    std::uint32_t payloadIdx = m_PayloadIndices[Phys(idx)];
+    if (payloadIdx == NoPayload) {
+      return Token(GetTokenKind(idx), GetSourceRange(idx));
+    }
+    return Token(GetTokenKind(idx), GetSourceRange(idx),
+                 UnpackPayload(idx, m_Payloads[payloadIdx]));
+  }
+
+  /// Appends tokens [first, last) of other, which must slice the same
+  /// source
+  void Append(TokenBuffer const& other, std::size_t first, std::size_t last);
+
+  /// Replaces tokens [first, last) with all tokens of replacement, which
+  /// must slice the same source. Moves the gap to behind the new tokens.
+  void Splice(std::size_t first, std::size_t last,
+              TokenBuffer const& replacement);
+
+  /// Moves tokens [first, size()) by offsetDelta bytes. Right behind a
+  /// Splice this only adds to the pending shift.
+  void ShiftTokens(std::size_t first, std::int64_t offsetDelta);
+
+private:
+  static_assert(Token::TK_INVALID <= std::numeric_limits<std::uint8_t>::max(),
+                "token kinds no longer fit in a byte");
+
+  static constexpr std::uint32_t NoPayload =
+      std::numeric_limits<std::uint32_t>::max();
+  static constexpr std::size_t NoGap =
+      std::numeric_limits<std::size_t>::max();
+
+  static SourceRange Shift(SourceRange range, std::int64_t delta) noexcept {
+    return SourceRange(range.GetBegin().GetLocWithOffset(delta),
+                       range.GetEnd().GetLocWithOffset(delta));
+  }
+
+  /// Where token idx is stored in the arrays
+  std::size_t Phys(std::size_t idx) const noexcept {
+    return idx < m_GapBegin ? idx : idx + m_GapSize;
+  }
+
+  /// Text slicing m_Source is turned into the relative form
+  Token::Payload PackPayload(Token::TokenKind kind, SourceRange range,
+                             Token::Payload payload) const noexcept;
+  Token::Payload UnpackPayload(std::size_t idx,
+                               Token::Payload payload) const noexcept;
+
+  std::uint32_t NewPayload(Token::Payload const& payload);
+
+  /// Moves the gap, opening an empty one if there is none, to right in
+  /// front of token idx
+  void MoveGap(std::size_t idx);
+  /// Makes room for at least size tokens in the gap
+  void GrowGap(std::size_t size);
+  /// Drops the gap and applies the pending shift, for tokens to be
+  /// appended again
+  void CloseGap();
+
+  std::vector<std::uint8_t> m_Kinds;
+  std::vector<SourceRange> m_Ranges;
+  std::vector<std::uint32_t> m_PayloadIndices;
+  /// Slots of tokens spliced out are reused, the others never move
+  std::vector<Token::Payload> m_Payloads;
+  std::vector<std::uint32_t> m_FreePayloads;
+
+  /// Tokens [m_GapBegin, size()) are stored m_GapSize slots further in
+  /// the arrays, with their ranges m_TailShift bytes off. NoGap until the
+  /// buffer is first edited.
+  std::size_t m_GapBegin = NoGap;
+  std::size_t m_GapSize = 0;
+  std::int64_t m_TailShift = 0;
+
+  sona::string_view m_Source;
+  SourceLocation m_FileStart =
+      SourceLocation::FromRawEncoding(SourceManager::FirstFileStart);
+};
+
+} // namespace Frontend
+} // namespace ckx
+
+#endif // TOKENBUFFER_H
@@ -0,0 +1,39 @@
+#ifndef TOKENSOURCE_H
+#define TOKENSOURCE_H
+
+#include "Frontend/TokenBuffer.h"
+#include "sona/pointer_plus.h"
+
+#include <cstddef>
+
+namespace ckx {
+namespace Frontend {
+
+/// A stream of tokens pulled by the parser on demand
+class TokenSource {
+public:
+  virtual ~TokenSource() = default;
+
+  /// @return the next token, TK_EOI once and forever after the input ends
+  virtual Token NextToken() = 0;
+};
+
+/// Replays an already lexed TokenBuffer, which must end with TK_EOI,
+/// starting from token first
+class TokenBufferSource final : public TokenSource {
+public:
+  TokenBufferSource(sona::ref_ptr<TokenBuffer const> tokens,
+                    std::size_t first = 0)
+    : m_Tokens(tokens), m_Index(first) {}
+
+  Token NextToken() override;
+
+private:
+  sona::ref_ptr<TokenBuffer const> m_Tokens;
+  std::size_t m_Index;
+};
+
+} // namespace Frontend
+} // namespace ckx
+
+#endif // TOKENSOURCE_H
@@ -0,0 +1,243 @@
+#ifndef TOKENTABLES_H
+#define TOKENTABLES_H
+
+#include "Frontend/Token.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace ckx {
+namespace Frontend {
+
+/// Lexer tables generated at compile time from Frontend/Tokens.def, adding
+/// a keyword or an operator there is all it takes to have it recognized.
+
+struct KeywordEntry {
+  char const *Rep;
+  std::size_t Length;
+  Token::TokenKind Kind;
+};
+
+constexpr KeywordEntry Keywords[] = {
+#define TOKEN_KWD(name, rep) { rep, sizeof(rep) - 1, Token::TK_KW_##name },
+#include "Frontend/Tokens.def"
+};
+
+constexpr std::size_t KeywordCount = sizeof(Keywords) / sizeof(Keywords[0]);
+
+/// Perfect hash over the keyword set: a seeded mix of the length, the first,
+/// middle and last characters. The seed is searched at compile time.
+class KeywordHashTable {
+public:
+  static constexpr std::size_t TableSize = 128;
+  static constexpr std::uint32_t MaxSeed = 4096;
+
+  static_assert(KeywordCount < TableSize / 2, "keyword table too crowded");
+
+  static constexpr std::uint32_t
+  Hash(std::uint32_t seed, char const* str, std::size_t length) noexcept {
+    std::uint32_t h = seed ^ static_cast<std::uint32_t>(length);
+    h = (h * 0x01000193u) ^ static_cast<unsigned char>(str[0]);
+    h = (h * 0x01000193u) ^ static_cast<unsigned char>(str[length / 2]);
+    h = (h * 0x01000193u) ^ static_cast<unsigned char>(str[length - 1]);
+    return (h ^ (h >> 15)) & (TableSize - 1);
+  }
+
+  static constexpr KeywordHashTable Build() noexcept {
+    for (std::uint32_t seed = 0; seed < MaxSeed; seed++) {
+      KeywordHashTable table(seed);
+      if (table.TryFill()) {
+        return table;
+      }
+    }
+    return KeywordHashTable(MaxSeed);
+  }
+
+  constexpr bool IsPerfect() const noexcept { return m_Seed != MaxSeed; }
+
+  /// @return the keyword kind, or TK_INVALID for a plain identifier
+  Token::TokenKind
+  Classify(char const* str, std::size_t length) const noexcept {
+    if (length < m_MinLength || length > m_MaxLength) {
+      return Token::TK_INVALID;
+    }
+
+    std::int8_t slot = m_Slots[Hash(m_Seed, str, length)];
+    if (slot < 0) {
+      return Token::TK_INVALID;
+    }
+
+    KeywordEntry const& entry = Keywords[slot];
+    if (entry.Length != length || std::memcmp(entry.Rep, str, length) != 0) {
+      return Token::TK_INVALID;
+    }
+    return entry.Kind;
+  }
+
+private:
+  constexpr explicit KeywordHashTable(std::uint32_t seed) noexcept
+    : m_Seed(seed), m_MinLength(0), m_MaxLength(0), m_Slots() {}
+
+  constexpr bool TryFill() noexcept {
+    for (std::size_t i = 0; i < TableSize; i++) {
+      m_Slots[i] = -1;
+    }
+
+    m_MinLength = Keywords[0].Length;
+    m_MaxLength = Keywords[0].Length;
+    for (std::size_t i = 0; i < KeywordCount; i++) {
+      std::uint32_t h = Hash(m_Seed, Keywords[i].Rep, Keywords[i].Length);
+      if (m_Slots[h] >= 0) {
+        return false;
+      }
+      m_Slots[h] = static_cast<std::int8_t>(i);
+      m_MinLength = Keywords[i].Length < m_MinLength ? Keywords[i].Length
+                                                     : m_MinLength;
+      m_MaxLength = Keywords[i].Length > m_MaxLength ? Keywords[i].Length
+                                                     : m_MaxLength;
+    }
+    return true;
+  }
+
+  std::uint32_t m_Seed;
+  std::size_t m_MinLength, m_MaxLength;
+  std::int8_t m_Slots[TableSize];
+};
+
+constexpr KeywordHashTable KeywordTable = KeywordHashTable::Build();
+static_assert(KeywordTable.IsPerfect(),
+              "no perfect hash seed found for Tokens.def keywords, "
+              "raise KeywordHashTable::MaxSeed or TableSize");
+
+struct SymbolEntry {
+  char const *Rep;
+  std::size_t Length;
+  Token::TokenKind Kind;
+};
+
+constexpr SymbolEntry Symbols[] = {
+#define TOKEN_SYM(name, rep) { rep, sizeof(rep) - 1, Token::TK_SYM_##name },
+#include "Frontend/Tokens.def"
+};
+
+constexpr std::size_t SymbolCount = sizeof(Symbols) / sizeof(Symbols[0]);
+
+constexpr std::size_t SymbolCharsTotal() noexcept {
+  std::size_t ret = 0;
+  for (std::size_t i = 0; i < SymbolCount; i++) {
+    ret += Symbols[i].Length;
+  }
+  return ret;
+}
+
+/// The trie of all operators as a DFA over character classes: every byte
+/// maps to a class (0 for bytes in no operator), every state has one
+/// transition per class. Matching walks until the dead state and returns
+/// the last accepting state seen, which is maximal munch in one pass.
+class SymbolDFA {
+public:
+  static constexpr std::size_t MaxStates = SymbolCharsTotal() + 2;
+  static constexpr std::size_t MaxClasses = SymbolCharsTotal() + 1;
+  static constexpr std::uint8_t DeadState = 0;
+  static constexpr std::uint8_t StartState = 1;
+
+  static_assert(MaxStates <= 256, "too many operator states for uint8_t");
+
+  constexpr SymbolDFA() noexcept
+    : m_CharClass(), m_Next(), m_Accept(), m_IsLeaf(),
+      m_NumStates(2), m_NumClasses(1) {
+    for (std::size_t i = 0; i < MaxStates; i++) {
+      m_Accept[i] = Token::TK_INVALID;
+    }
+
+    for (std::size_t i = 0; i < SymbolCount; i++) {
+      std::uint8_t state = StartState;
+      for (std::size_t j = 0; j < Symbols[i].Length; j++) {
+        unsigned char ch = static_cast<unsigned char>(Symbols[i].Rep[j]);
+        if (m_CharClass[ch] == 0) {
+          m_CharClass[ch] = m_NumClasses++;
+        }
+        std::uint8_t &next = m_Next[state][m_CharClass[ch]];
+        if (next == DeadState) {
+          next = m_NumStates++;
+        }
+        state = next;
+      }
+      m_Accept[state] = Symbols[i].Kind;
+    }
+
+    for (std::size_t i = 0; i < MaxStates; i++) {
+      m_IsLeaf[i] = true;
+      for (std::size_t j = 0; j < MaxClasses; j++) {
+        m_IsLeaf[i] = m_IsLeaf[i] && m_Next[i][j] == DeadState;
+      }
+    }
+  }
+
+  /// @return length of the longest operator at the head of [begin, end),
+  /// 0 if there is none
+  std::size_t Match(char const* begin, char const* end,
+                    Token::TokenKind &kind) const noexcept {
+    std::uint8_t state = StartState;
+    std::size_t accepted = 0;
+    for (char const* iter = begin; iter != end; ++iter) {
+      state = m_Next[state][m_CharClass[static_cast<unsigned char>(*iter)]];
+      if (state == DeadState) {
+        break;
+      }
+      if (m_Accept[state] != Token::TK_INVALID) {
+        kind = m_Accept[state];
+        accepted = static_cast<std::size_t>(iter - begin) + 1;
+        if (m_IsLeaf[state]) {
+          break;
+        }
+      }
+    }
+    return accepted;
+  }
+
+  constexpr std::size_t GetNumStates() const noexcept { return m_NumStates; }
+
+  /// @return how many characters past the end of a matched operator Match
+  /// may read. Walking on from an accepting state reads one character to
+  /// find the dead state, and one more per state in a row that accepts
+  /// nothing, as after the '.' of "..." if ".." were no operator.
+  constexpr std::size_t GetMaxLookahead() const noexcept {
+    /// States only ever lead to later states, so one backward pass sees
+    /// every successor before its predecessors
+    std::size_t run[MaxStates] = {};
+    std::size_t ret = 0;
+    for (std::size_t i = m_NumStates; i-- > StartState;) {
+      for (std::size_t j = 0; j < MaxClasses; j++) {
+        std::uint8_t next = m_Next[i][j];
+        std::size_t read = next == DeadState ? 1
+                           : m_Accept[next] != Token::TK_INVALID ? 0
+                           : 1 + run[next];
+        run[i] = run[i] < read ? read : run[i];
+      }
+      if (m_Accept[i] != Token::TK_INVALID && !m_IsLeaf[i] && ret < run[i]) {
+        ret = run[i];
+      }
+    }
+    return ret;
+  }
+
+private:
+  std::uint8_t m_CharClass[256];
+  std::uint8_t m_Next[MaxStates][MaxClasses];
+  Token::TokenKind m_Accept[MaxStates];
+  /// No operator extends this one, matching stops without a lookahead
+  bool m_IsLeaf[MaxStates];
+  std::uint8_t m_NumStates;
+  std::uint8_t m_NumClasses;
+};
+
+constexpr SymbolDFA SymbolTable;
+static_assert(SymbolTable.GetNumStates() <= SymbolDFA::MaxStates,
+              "symbol DFA overflowed its state table");
+
+} // namespace Frontend
+} // namespace ckx
+
+#endif // TOKENTABLES_H
@@ -3,18 +3,19 @@
 
 #include "AST/Decl.h"
 #include "AST/Type.h"
+#include "Sema/SymbolMap.h"
 #include "Sema/UnresolvedDecl.h"
 
-#include <map>
 #include <cstdint>
+#include <vector>
 
 namespace ckx {
 namespace Sema {
 
 class Scope {
 public:
-  using FunctionSet =
-  std::map<sona::strhdl_t, sona::ref_ptr<AST::FuncDecl const>>;
+  /// All overloads declared under one name, in declaration order
+  using FunctionSet = std::vector<sona::ref_ptr<AST::FuncDecl const>>;
 
   enum ScopeFlags {
     SF_None          = 0x0000,
@@ -101,13 +102,10 @@ private:
   sona::ref_ptr<Scope> m_EnclosingLoopScope;
   ScopeFlags m_ScopeFlags;
 
-  std::unordered_map<sona::strhdl_t, sona::ref_ptr<AST::Decl const>>
-  m_Tags;
-  std::unordered_map<sona::strhdl_t, sona::ref_ptr<AST::VarDecl const>>
-  m_Variables;
-  std::unordered_map<sona::strhdl_t, AST::QualType> m_Types;
-
-  FunctionSet m_Functions;
+  SymbolMap<sona::ref_ptr<AST::Decl const>> m_Tags;
+  SymbolMap<sona::ref_ptr<AST::VarDecl const>> m_Variables;
+  SymbolMap<AST::QualType> m_Types;
+  SymbolMap<FunctionSet> m_Functions;
 
   /// @todo I'm also not sure if this will be used, letus keep it for sometime
   sona::ref_ptr<AST::DeclContext> m_UnderlyingDeclContext = nullptr;
@@ -52,8 +52,8 @@ protected:
 
   sona::ref_ptr<const AST::DeclContext>
   ChooseDeclContext(std::shared_ptr<Scope> scope,
-                    const std::vector<sona::strhdl_t>& nns, bool shouldDiag,
-                    const std::vector<SingleSourceRange>& nnsRanges);
+                    sona::array_ref<sona::strhdl_t> nns, bool shouldDiag,
+                    sona::array_ref<SourceRange> nnsRanges);
 
   AST::QualType LookupType(std::shared_ptr<Scope> scope, Syntax::Identifier const& identifier,
              bool shouldDiag);
@@ -4,6 +4,8 @@
 #include "Sema/SemaCommon.h"
 #include "sona/either.h"
 
+#include <unordered_map>
+
 namespace ckx {
 namespace Sema {
 
@@ -0,0 +1,122 @@
+#ifndef SYMBOLMAP_H
+#define SYMBOLMAP_H
+
+#include "sona/stringref.h"
+#include "sona/util.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace ckx {
+namespace Sema {
+
+/// A map from interned names to T without a heap node per binding. Entries
+/// are kept densely in insertion order, and an open addressing table of
+/// entry indices, probed linearly, finds them by symbol id. Bindings are
+/// never removed, which is all a scope needs. Empty maps allocate nothing.
+template <typename T>
+class SymbolMap {
+public:
+  using value_type = std::pair<sona::strhdl_t, T>;
+  using iterator = typename std::vector<value_type>::iterator;
+  using const_iterator = typename std::vector<value_type>::const_iterator;
+
+  T* Find(sona::strhdl_t name) noexcept {
+    std::uint32_t idx = FindIndex(name);
+    return idx == NoEntry ? nullptr : &m_Entries[idx].second;
+  }
+
+  T const* Find(sona::strhdl_t name) const noexcept {
+    std::uint32_t idx = FindIndex(name);
+    return idx == NoEntry ? nullptr : &m_Entries[idx].second;
+  }
+
+  /// Binds name to T(args...) unless it is bound already
+  /// @return the value bound to name, and whether it was inserted
+  template <typename ...Args>
+  std::pair<T*, bool> TryEmplace(sona::strhdl_t name, Args&& ...args) {
+    if (m_Entries.size() * 2 >= m_Slots.size()) {
+      Rehash(m_Slots.empty() ? InitialSlots : m_Slots.size() * 2);
+    }
+
+    std::size_t slot = Probe(name);
+    if (m_Slots[slot] != EmptySlot) {
+      return std::make_pair(&m_Entries[m_Slots[slot] - 1].second, false);
+    }
+
+    m_Entries.emplace_back(std::piecewise_construct,
+                           std::forward_as_tuple(name),
+                           std::forward_as_tuple(std::forward<Args>(args)...));
+    m_Slots[slot] = static_cast<std::uint32_t>(m_Entries.size());
+    return std::make_pair(&m_Entries.back().second, true);
+  }
+
+  std::size_t size() const noexcept { return m_Entries.size(); }
+  bool empty() const noexcept { return m_Entries.empty(); }
+
+  iterator begin() noexcept { return m_Entries.begin(); }
+  iterator end() noexcept { return m_Entries.end(); }
+  const_iterator begin() const noexcept { return m_Entries.cbegin(); }
+  const_iterator end() const noexcept { return m_Entries.cend(); }
+
+private:
+  static constexpr std::uint32_t EmptySlot = 0;
+  static constexpr std::uint32_t NoEntry = ~std::uint32_t(0);
+  static constexpr std::size_t InitialSlots = 8;
+
+  /// Symbol ids are dense and sequential, Fibonacci hashing spreads them
+  /// over the table
+  std::size_t SlotOf(sona::strhdl_t name) const noexcept {
+    return static_cast<std::size_t>(
+             (std::uint64_t(name.id()) * 0x9E3779B97F4A7C15ULL) >> 32)
+           & (m_Slots.size() - 1);
+  }
+
+  /// @return the slot holding name, or the empty slot it would go to
+  std::size_t Probe(sona::strhdl_t name) const noexcept {
+    std::size_t mask = m_Slots.size() - 1;
+    std::size_t slot = SlotOf(name);
+    while (m_Slots[slot] != EmptySlot
+           && m_Entries[m_Slots[slot] - 1].first != name) {
+      slot = (slot + 1) & mask;
+    }
+    return slot;
+  }
+
+  std::uint32_t FindIndex(sona::strhdl_t name) const noexcept {
+    if (m_Slots.empty()) {
+      return NoEntry;
+    }
+    std::uint32_t entry = m_Slots[Probe(name)];
+    return entry == EmptySlot ? NoEntry : entry - 1;
+  }
+
+  void Rehash(std::size_t numSlots) {
+    sona_assert((numSlots & (numSlots - 1)) == 0);
+    m_Slots.assign(numSlots, EmptySlot);
+    std::size_t mask = numSlots - 1;
+    for (std::size_t i = 0; i < m_Entries.size(); i++) {
+      std::size_t slot = SlotOf(m_Entries[i].first);
+      while (m_Slots[slot] != EmptySlot) {
+        slot = (slot + 1) & mask;
+      }
+      m_Slots[slot] = static_cast<std::uint32_t>(i + 1);
+    }
+  }
+
+  std::vector<value_type> m_Entries;
+  /// Entry index + 1 per slot, EmptySlot for none
+  std::vector<std::uint32_t> m_Slots;
+};
+
+template <typename T> constexpr std::uint32_t SymbolMap<T>::EmptySlot;
+template <typename T> constexpr std::uint32_t SymbolMap<T>::NoEntry;
+template <typename T> constexpr std::size_t SymbolMap<T>::InitialSlots;
+
+} // namespace Sema
+} // namespace ckx
+
+#endif // SYMBOLMAP_H
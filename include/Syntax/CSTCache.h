@@ -0,0 +1,53 @@
+#ifndef CSTCACHE_H
+#define CSTCACHE_H
+
+#include "Basic/SourceBuffer.h"
+#include "Basic/SourceRange.h"
+#include "Syntax/Concrete.h"
+
+#include <cstdint>
+#include <string>
+
+namespace ckx {
+namespace Syntax {
+
+/// Serialized trees on disk, one file per source text in a directory of
+/// their own. A tree is keyed by a hash of the text it was parsed from,
+/// the compiler version and the format version, so an edited file or a
+/// new compiler simply misses. The key is only 64 bits, every entry also
+/// holds the SHA-256 of its text, which a load checks. Loading maps the
+/// file once and rebuilds the tree from it, with no lexing or parsing.
+///
+/// Writers go through a temporary file renamed into place, so concurrent
+/// builds sharing a directory never see half a tree.
+class CSTCache {
+public:
+  explicit CSTCache(std::string const& directory);
+
+  /// @return the tree cached for source, its ranges placed in the file
+  /// starting at fileStart, nullptr if there is none or it cannot be read
+  sona::owner<TransUnit> Load(SourceBuffer const& source,
+                              SourceLocation fileStart) const;
+
+  /// Caches unit as the tree of source, the file starting at fileStart,
+  /// creating the directory if need be
+  /// @return false if the tree could not be written
+  bool Store(SourceBuffer const& source, SourceLocation fileStart,
+             TransUnit const& unit) const;
+
+  std::string GetCachePath(SourceBuffer const& source) const;
+
+private:
+  static std::uint64_t ComputeKey(SourceBuffer const& source) noexcept;
+
+  std::string m_Directory;
+};
+
+/// Recognizes --cst-cache=DIRECTORY
+/// @return false if arg is not of that form
+bool ParseCSTCacheOption(std::string const& arg, std::string &directory);
+
+} // namespace Syntax
+} // namespace ckx
+
+#endif // CSTCACHE_H
@@ -1,12 +1,15 @@
 #ifndef CONCRETE_H
 #define CONCRETE_H
 
+#include <deque>
 #include <vector>
 #include <string>
 
 #include <Basic/SourceRange.h>
 #include <Syntax/Operator.h>
+#include <Syntax/SyntaxArena.h>
 
+#include <sona/array_ref.h>
 #include <sona/range.h>
 #include <sona/linq.h>
 #include <sona/pointer_plus.h>
@@ -15,61 +18,60 @@
 namespace ckx {
 namespace Syntax {
 
+/// The nested name specifiers of an identifier are arrays of the
+/// SyntaxArena of its tree, or of any storage outliving the identifier.
 class Identifier {
 public:
   Identifier(sona::strhdl_t const& identifier,
-             SingleSourceRange const& idRange)
+             SourceRange const& idRange)
     : m_Identifier(identifier), m_IdRange(idRange) {}
 
-  Identifier(std::vector<sona::strhdl_t> &&nestedNameSpecifiers,
+  Identifier(sona::array_ref<sona::strhdl_t> nestedNameSpecifiers,
              sona::strhdl_t identifier,
-             std::vector<SingleSourceRange> &&nnsRanges,
-             SingleSourceRange idRange)
-    : m_NestedNameSpecifiers(std::move(nestedNameSpecifiers)),
+             sona::array_ref<SourceRange> nnsRanges,
+             SourceRange idRange)
+    : m_NestedNameSpecifiers(nestedNameSpecifiers),
       m_Identifier(identifier),
-      m_NNSRanges(std::move(nnsRanges)),
+      m_NNSRanges(nnsRanges),
       m_IdRange(idRange) {}
 
   Identifier(Identifier &&that)
-    : m_NestedNameSpecifiers(std::move(that.m_NestedNameSpecifiers)),
+    : m_NestedNameSpecifiers(that.m_NestedNameSpecifiers),
       m_Identifier(that.m_Identifier),
-      m_NNSRanges(std::move(that.m_NNSRanges)),
+      m_NNSRanges(that.m_NNSRanges),
       m_IdRange(that.m_IdRange) {}
 
   Identifier(Identifier const&) = delete;
   Identifier& operator=(Identifier const&) = delete;
 
+  /// The copy shares the nested name specifiers with this identifier
   Identifier ExplicitlyClone() const {
-    std::vector<sona::strhdl_t> copyOfNNS = m_NestedNameSpecifiers;
-    sona::strhdl_t copyOfIdentifier = m_Identifier;
-    std::vector<SingleSourceRange> copyOfNNSRanges = m_NNSRanges;
-    SingleSourceRange copyOfIdRange = m_IdRange;
-    return Identifier(std::move(copyOfNNS), std::move(copyOfIdentifier),
-                      std::move(copyOfNNSRanges), std::move(copyOfIdRange));
+    return Identifier(m_NestedNameSpecifiers, m_Identifier,
+                      m_NNSRanges, m_IdRange);
   }
 
   sona::strhdl_t const& GetIdentifier() const noexcept {
     return m_Identifier;
   }
 
-  SingleSourceRange const& GetIdSourceRange() const noexcept {
+  SourceRange const& GetIdSourceRange() const noexcept {
     return m_IdRange;
   }
 
-  std::vector<sona::strhdl_t> const&
+  sona::array_ref<sona::strhdl_t>
   GetNestedNameSpecifiers() const noexcept {
     return m_NestedNameSpecifiers;
   }
 
-  std::vector<SingleSourceRange> const& GetNNSSourceRanges() const noexcept {
+  sona::array_ref<SourceRange> GetNNSSourceRanges() const noexcept {
     return m_NNSRanges;
   }
 
 private:
-  std::vector<sona::strhdl_t> m_NestedNameSpecifiers;
+  sona::array_ref<sona::strhdl_t> m_NestedNameSpecifiers;
   sona::strhdl_t m_Identifier;
-  std::vector<SingleSourceRange> m_NNSRanges;
-  SingleSourceRange m_IdRange;
+  sona::array_ref<SourceRange> m_NNSRanges;
+  SourceRange m_IdRange;
 };
 
 class Node {
@@ -102,16 +104,16 @@ public:
   public:
     Attribute(sona::strhdl_t const& attributeName,
               sona::strhdl_t const& attributeValue,
-              SingleSourceRange nameRange,
-              SingleSourceRange valueRange)
+              SourceRange nameRange,
+              SourceRange valueRange)
       : m_AttributeName(attributeName),
         m_AttributeValue(attributeValue),
         m_NameRange(nameRange),
         m_ValueRange(valueRange) {}
 
     Attribute(sona::strhdl_t const& attributeName,
-              SingleSourceRange nameRange,
-              SingleSourceRange valueRange)
+              SourceRange nameRange,
+              SourceRange valueRange)
       : m_AttributeName(attributeName),
         m_AttributeValue(sona::empty_optional()),
         m_NameRange(nameRange),
@@ -129,41 +131,49 @@ public:
       return m_AttributeValue.value();
     }
 
-    SingleSourceRange const& GetNameRange() const noexcept {
+    SourceRange const& GetNameRange() const noexcept {
       return m_NameRange;
     }
 
-    SingleSourceRange const& GetValueRange() const noexcept {
+    SourceRange const& GetValueRange() const noexcept {
       return m_ValueRange;
     }
 
   private:
     sona::strhdl_t m_AttributeName;
     sona::optional<sona::strhdl_t> m_AttributeValue;
-    SingleSourceRange m_NameRange;
-    SingleSourceRange m_ValueRange;
+    SourceRange m_NameRange;
+    SourceRange m_ValueRange;
   };
 
-  AttributeList(std::vector<AttributeList> &attributes)
+  AttributeList(sona::array_ref<Attribute> attributes)
     : Node(Node::CNK_AttributeList),
-      m_Attributes(std::move(attributes)) {}
+      m_Attributes(attributes) {}
 
-  std::vector<AttributeList> const& GetAttributes() const noexcept {
+  sona::array_ref<Attribute> GetAttributes() const noexcept {
     return m_Attributes;
   }
 
 private:
-  std::vector<AttributeList> m_Attributes;
+  sona::array_ref<Attribute> m_Attributes;
 };
 
 class Type : public Node {
 public:
   Type(NodeKind nodeKind) : Node(nodeKind) {}
+
+  /// The range diagnostics about the type as a whole point at: the name
+  /// it is built around
+  SourceRange GetRepresentingRange() const noexcept;
 };
 
 class Decl : public Node {
 public:
   Decl(NodeKind nodeKind) : Node(nodeKind) {}
+
+  /// The range diagnostics about the declaration as a whole point at: its
+  /// name, or the template keyword of a template
+  SourceRange GetRepresentingRange() const noexcept;
 };
 
 class Stmt : public Node {
@@ -171,7 +181,12 @@ public: Stmt(NodeKind nodeKind) : Node(nodeKind) {}
 };
 
 class Expr : public Node {
-public: Expr(NodeKind nodeKind) : Node(nodeKind) {}
+public:
+  Expr(NodeKind nodeKind) : Node(nodeKind) {}
+
+  /// The range diagnostics about the expression as a whole point at: its
+  /// operator, or the leftmost part having a range of its own
+  SourceRange GetRepresentingRange() const noexcept;
 };
 
 class BuiltinType : public Type {
@@ -183,56 +198,56 @@ public:
     #include "Syntax/BuiltinTypes.def"
   };
 
-  BuiltinType(BuiltinTypeId btid, SingleSourceRange const& range)
+  BuiltinType(BuiltinTypeId btid, SourceRange const& range)
     : Type(NodeKind::CNK_BuiltinType),
       m_BuiltinTypeId(btid), m_Range(range) {}
 
   BuiltinTypeId GetBuiltinTypeId() const noexcept { return m_BuiltinTypeId; }
 
-  SingleSourceRange const& GetSourceRange() const noexcept { return m_Range; }
+  SourceRange const& GetSourceRange() const noexcept { return m_Range; }
 
 private:
   BuiltinTypeId m_BuiltinTypeId;
-  SingleSourceRange m_Range;
+  SourceRange m_Range;
 };
 
 class UserDefinedType : public Type {
 public:
-  UserDefinedType(Identifier&& name, SingleSourceRange const& range)
+  UserDefinedType(Identifier&& name, SourceRange const& range)
     : Type(NodeKind::CNK_UserDefinedType),
       m_Name(std::move(name)), m_Range(range) {}
 
   Identifier const& GetName() const noexcept { return m_Name; }
 
-  SingleSourceRange const& GetSourceRange() const noexcept { return m_Range; }
+  SourceRange const& GetSourceRange() const noexcept { return m_Range; }
 
 private:
   Identifier m_Name;
-  SingleSourceRange m_Range;
+  SourceRange m_Range;
 };
 
 class TemplatedType : public Type {
 public:
-  using TemplateArg = sona::either<sona::owner<Type>,
-                                      sona::owner<Expr>>;
+  using TemplateArg = sona::either<NodePtr<Type>,
+                                      NodePtr<Expr>>;
 
-  TemplatedType(sona::owner<UserDefinedType> &&rootType,
-                   std::vector<TemplateArg> &&templateArgs)
+  TemplatedType(NodePtr<UserDefinedType> &&rootType,
+                   sona::array_ref<TemplateArg> templateArgs)
     : Type(NodeKind::CNK_TemplatedType),
       m_RootType(std::move(rootType)),
-      m_TemplateArgs(std::move(templateArgs)) {}
+      m_TemplateArgs(templateArgs) {}
 
   sona::ref_ptr<UserDefinedType const> GetRootType() const noexcept {
     return m_RootType.borrow();
   }
 
-  std::vector<TemplateArg> const& GetTemplateArgs() const noexcept {
+  sona::array_ref<TemplateArg> GetTemplateArgs() const noexcept {
     return m_TemplateArgs;
   }
 
 private:
-  sona::owner<UserDefinedType> m_RootType;
-  std::vector<TemplateArg> m_TemplateArgs;
+  NodePtr<UserDefinedType> m_RootType;
+  sona::array_ref<TemplateArg> m_TemplateArgs;
 };
 
 class ComposedType : public Type {
@@ -241,47 +256,46 @@ public:
     CTS_Const, CTS_Volatile, CTS_Restrict, CTS_Pointer, CTS_Ref, CTS_RvRef
   };
 
-  ComposedType(sona::owner<Type> rootType,
-               std::vector<TypeSpecifier> &&typeSpecifiers,
-               std::vector<SingleSourceRange> &&typeSpecRanges)
+  ComposedType(NodePtr<Type> rootType,
+               sona::array_ref<TypeSpecifier> typeSpecifiers,
+               sona::array_ref<SourceRange> typeSpecRanges)
     : Type(NodeKind::CNK_ComposedType),
       m_RootType(std::move(rootType)),
       m_TypeSpecifiers(typeSpecifiers),
-      m_TypeSpecifierRanges(std::move(typeSpecRanges)) {}
+      m_TypeSpecifierRanges(typeSpecRanges) {}
 
   sona::ref_ptr<Type const> GetRootType() const noexcept {
     return m_RootType.borrow();
   }
 
-  std::vector<TypeSpecifier> const& GetTypeSpecifiers() const noexcept {
+  sona::array_ref<TypeSpecifier> GetTypeSpecifiers() const noexcept {
     return m_TypeSpecifiers;
   }
 
-  std::vector<SingleSourceRange> const&
-  GetTypeSpecRanges() const noexcept {
+  sona::array_ref<SourceRange> GetTypeSpecRanges() const noexcept {
     return m_TypeSpecifierRanges;
   }
 
 private:
-  sona::owner<Type> m_RootType;
-  std::vector<TypeSpecifier> m_TypeSpecifiers;
-  std::vector<SingleSourceRange> m_TypeSpecifierRanges;
+  NodePtr<Type> m_RootType;
+  sona::array_ref<TypeSpecifier> m_TypeSpecifiers;
+  sona::array_ref<SourceRange> m_TypeSpecifierRanges;
 };
 
 class Import : public Node {
 public:
   Import(Identifier &&importedIdentifier,
-         SingleSourceRange const& importRange)
+         SourceRange const& importRange)
     : Node(NodeKind::CNK_Import),
       m_ImportedIdentifier(std::move(importedIdentifier)),
       m_ImportRange(importRange),
       m_IsWeak(false),
-      m_WeakRange(0, 0, 0) {}
+      m_WeakRange() {}
 
   Import(Identifier &&importedIdentifier,
-         SingleSourceRange const& importRange,
+         SourceRange const& importRange,
          std::true_type /* isWeakImport */,
-         SingleSourceRange const& weakRange)
+         SourceRange const& weakRange)
     : Node(NodeKind::CNK_Import),
       m_ImportedIdentifier(std::move(importedIdentifier)),
       m_ImportRange(importRange),
@@ -292,7 +306,7 @@ public:
     return m_ImportedIdentifier;
   }
 
-  SingleSourceRange const& GetImportSourceRange() const noexcept {
+  SourceRange const& GetImportSourceRange() const noexcept {
     return m_ImportRange;
   }
 
@@ -300,21 +314,21 @@ public:
     return m_IsWeak;
   }
 
-  SingleSourceRange const& GetWeakSourceRangeUnsafe() const noexcept {
+  SourceRange const& GetWeakSourceRangeUnsafe() const noexcept {
     sona_assert(IsWeak());
     return m_WeakRange;
   }
 
 private:
   Identifier m_ImportedIdentifier;
-  SingleSourceRange m_ImportRange;
+  SourceRange m_ImportRange;
   bool m_IsWeak;
-  SingleSourceRange m_WeakRange;
+  SourceRange m_WeakRange;
 };
 
 class Export : public Node {
 public:
-  Export(sona::owner<Decl> &&node, SingleSourceRange exportRange)
+  Export(NodePtr<Decl> &&node, SourceRange exportRange)
     : Node(NodeKind::CNK_Export), m_Node(std::move(node)),
       m_ExportRange(exportRange) {}
 
@@ -322,21 +336,21 @@ public:
     return m_Node.borrow();
   }
 
-  SingleSourceRange const& GetExportSourceRange() const noexcept {
+  SourceRange const& GetExportSourceRange() const noexcept {
     return m_ExportRange;
   }
 
 private:
-  sona::owner<Decl> m_Node;
-  SingleSourceRange m_ExportRange;
+  NodePtr<Decl> m_Node;
+  SourceRange m_ExportRange;
 };
 
 class ForwardDecl : public Decl {
 public:
   enum class ForwardDeclKind { FDK_Class, FDK_Enum, FDK_ADT };
   ForwardDecl(ForwardDeclKind fdk, sona::strhdl_t const& name,
-                 SingleSourceRange const& keywordRange,
-                 SingleSourceRange const& nameRange)
+                 SourceRange const& keywordRange,
+                 SourceRange const& nameRange)
     : Decl(NodeKind::CNK_ForwardDecl),
       m_ForwardDeclKind(fdk), m_Name(name),
       m_KeywordRange(keywordRange),
@@ -350,34 +364,34 @@ public:
     return m_Name;
   }
 
-  SingleSourceRange const& GetKeywordSourceRange() const noexcept {
+  SourceRange const& GetKeywordSourceRange() const noexcept {
     return m_KeywordRange;
   }
 
-  SingleSourceRange const& GetNameSourceRange() const noexcept {
+  SourceRange const& GetNameSourceRange() const noexcept {
     return m_NameRange;
   }
 
 private:
   ForwardDeclKind m_ForwardDeclKind;
   sona::strhdl_t m_Name;
-  SingleSourceRange m_KeywordRange;
-  SingleSourceRange m_NameRange;
+  SourceRange m_KeywordRange;
+  SourceRange m_NameRange;
 };
 
 class TemplatedDecl : public Decl {
 public:
-  TemplatedDecl(
-      std::vector<sona::either<sona::strhdl_t, sona::owner<Expr>>> tparams,
-      sona::owner<Decl> underlyingDecl,
-      SingleSourceRange templateRange)
+  using TemplateParam = sona::either<sona::strhdl_t, NodePtr<Expr>>;
+
+  TemplatedDecl(sona::array_ref<TemplateParam> tparams,
+                NodePtr<Decl> underlyingDecl,
+                SourceRange templateRange)
     : Decl(NodeKind::CNK_TemplatedDecl),
-      m_TParams(std::move(tparams)),
+      m_TParams(tparams),
       m_UnderlyingDecl(std::move(underlyingDecl)),
       m_TemplateRange(templateRange) {}
 
-  std::vector<sona::either<sona::strhdl_t, sona::owner<Expr>>> const&
-  GetTemplateParams() const noexcept {
+  sona::array_ref<TemplateParam> GetTemplateParams() const noexcept {
     return m_TParams;
   }
 
@@ -385,14 +399,14 @@ public:
     return m_UnderlyingDecl.borrow();
   }
 
-  SingleSourceRange const& GetTemplateSourceRange() const noexcept {
+  SourceRange const& GetTemplateSourceRange() const noexcept {
     return m_TemplateRange;
   }
 
 private:
-  std::vector<sona::either<sona::strhdl_t, sona::owner<Expr>>> m_TParams;
-  sona::owner<Decl> m_UnderlyingDecl;
-  SingleSourceRange m_TemplateRange;
+  sona::array_ref<TemplateParam> m_TParams;
+  NodePtr<Decl> m_UnderlyingDecl;
+  SourceRange m_TemplateRange;
 };
 
 class TagDecl : public Decl {
@@ -417,16 +431,16 @@ private:
 class ClassDecl : public TagDecl {
 public:
   ClassDecl(sona::strhdl_t const& className,
-            std::vector<sona::owner<Decl>> &&subDecls,
-            SingleSourceRange const& classKwdRange,
-            SingleSourceRange const& classNameRange)
+            sona::array_ref<NodePtr<Decl>> subDecls,
+            SourceRange const& classKwdRange,
+            SourceRange const& classNameRange)
     : TagDecl(NodeKind::CNK_ClassDecl, className, classNameRange),
-      m_SubDecls(std::move(subDecls)),
+      m_SubDecls(subDecls),
       m_ClassKwdRange(classKwdRange) {}
 
   auto GetSubDecls() const noexcept {
     return sona::linq::from_container(m_SubDecls).
-             transform([](sona::owner<Decl> const& it)
+             transform([](NodePtr<Decl> const& it)
                        { return it.borrow(); });
   }
 
@@ -435,7 +449,7 @@ public:
   }
 
 private:
-  std::vector<sona::owner<Decl>> m_SubDecls;
+  sona::array_ref<NodePtr<Decl>> m_SubDecls;
   SourceRange m_ClassKwdRange;
 };
 
@@ -445,21 +459,21 @@ public:
   public:
     Enumerator(sona::strhdl_t const& name,
                int64_t value,
-               SingleSourceRange nameRange,
-               SingleSourceRange eqLoc,
-               SingleSourceRange valueRange)
+               SourceRange nameRange,
+               SourceRange eqLoc,
+               SourceRange valueRange)
       : m_Name(name), m_Value(value),
         m_NameRange(nameRange), m_EqLoc(eqLoc), m_ValueRange(valueRange) {}
 
-    Enumerator(const sona::strhdl_t &name, SingleSourceRange nameRange)
+    Enumerator(const sona::strhdl_t &name, SourceRange nameRange)
       : m_Name(name), m_Value(sona::empty_optional()),
-        m_NameRange(nameRange), m_EqLoc(0, 0, 0), m_ValueRange(0, 0, 0) {}
+        m_NameRange(nameRange), m_EqLoc(), m_ValueRange() {}
 
     sona::strhdl_t const& GetName() const noexcept {
       return m_Name;
     }
 
-    SingleSourceRange const& GetNameRange() const noexcept {
+    SourceRange const& GetNameRange() const noexcept {
       return m_NameRange;
     }
 
@@ -472,12 +486,12 @@ public:
       return m_Value.value();
     }
 
-    SingleSourceRange const& GetEqRangeUnsafe() const noexcept {
+    SourceRange const& GetEqRangeUnsafe() const noexcept {
       sona_assert(HasValue());
       return m_EqLoc;
     }
 
-    SingleSourceRange const& GetValueRangeUnsafe() const noexcept {
+    SourceRange const& GetValueRangeUnsafe() const noexcept {
       sona_assert(HasValue());
       return m_ValueRange;
     }
@@ -485,29 +499,29 @@ public:
   private:
     sona::strhdl_t m_Name;
     sona::optional<int64_t> m_Value;
-    SingleSourceRange m_NameRange;
-    SingleSourceRange m_EqLoc;
-    SingleSourceRange m_ValueRange;
+    SourceRange m_NameRange;
+    SourceRange m_EqLoc;
+    SourceRange m_ValueRange;
   };
 
   EnumDecl(sona::strhdl_t const& name,
-           std::vector<Enumerator> &&enumerators,
-           SingleSourceRange const& enumRange,
-           SingleSourceRange const& nameRange)
+           sona::array_ref<Enumerator> enumerators,
+           SourceRange const& enumRange,
+           SourceRange const& nameRange)
     : TagDecl(NodeKind::CNK_EnumDecl, name, nameRange),
-      m_Enumerators(std::move(enumerators)), m_EnumRange(enumRange) {}
+      m_Enumerators(enumerators), m_EnumRange(enumRange) {}
 
-  std::vector<Enumerator> const& GetEnumerators() const noexcept {
+  sona::array_ref<Enumerator> GetEnumerators() const noexcept {
     return m_Enumerators;
   }
 
-  SingleSourceRange const& GetEnumRange() const noexcept {
+  SourceRange const& GetEnumRange() const noexcept {
     return m_EnumRange;
   }
 
 private:
-  std::vector<Enumerator> m_Enumerators;
-  SingleSourceRange m_EnumRange;
+  sona::array_ref<Enumerator> m_Enumerators;
+  SourceRange m_EnumRange;
 };
 
 class ADTDecl : public TagDecl {
@@ -515,13 +529,13 @@ public:
   class ValueConstructor {
   public:
     ValueConstructor(sona::strhdl_t const& name,
-                    sona::owner<Type> &&underlyingType,
-                    SingleSourceRange const& nameRange)
+                    NodePtr<Type> &&underlyingType,
+                    SourceRange const& nameRange)
       : m_Name(name), m_UnderlyingType(std::move(underlyingType)),
         m_NameRange(nameRange) {}
 
     ValueConstructor(sona::strhdl_t const& name,
-                    SingleSourceRange const& nameRange)
+                    SourceRange const& nameRange)
       : m_Name(name), m_UnderlyingType(nullptr), m_NameRange(nameRange) {}
 
     sona::strhdl_t const& GetName() const noexcept {
@@ -532,57 +546,57 @@ public:
       return m_UnderlyingType.borrow();
     }
 
-    SingleSourceRange const& GetNameRange() const noexcept {
+    SourceRange const& GetNameRange() const noexcept {
       return m_NameRange;
     }
 
   private:
     sona::strhdl_t m_Name;
-    sona::owner<Type> m_UnderlyingType;
-    SingleSourceRange m_NameRange;
+    NodePtr<Type> m_UnderlyingType;
+    SourceRange m_NameRange;
   };
 
   ADTDecl(sona::strhdl_t const& name,
-          std::vector<ValueConstructor> &&constructors,
-          SingleSourceRange const& enumRange,
-          SingleSourceRange const& classRange,
-          SingleSourceRange const& nameRange)
+          sona::array_ref<ValueConstructor> constructors,
+          SourceRange const& enumRange,
+          SourceRange const& classRange,
+          SourceRange const& nameRange)
     : TagDecl(NodeKind::CNK_ADTDecl, name, nameRange),
-      m_Constructors(std::move(constructors)),
+      m_Constructors(constructors),
       m_EnumRange(enumRange),
       m_ClassRange(classRange) {}
 
-  std::vector<ValueConstructor> const& GetConstructors() const noexcept {
+  sona::array_ref<ValueConstructor> GetConstructors() const noexcept {
     return m_Constructors;
   }
 
-  SingleSourceRange const& GetEnumRange() const noexcept {
+  SourceRange const& GetEnumRange() const noexcept {
     return m_EnumRange;
   }
 
-  SingleSourceRange const& GetClassRange() const noexcept {
+  SourceRange const& GetClassRange() const noexcept {
     return m_ClassRange;
   }
 
 private:
-  std::vector<ValueConstructor> m_Constructors;
-  SingleSourceRange m_EnumRange;
-  SingleSourceRange m_ClassRange;
+  sona::array_ref<ValueConstructor> m_Constructors;
+  SourceRange m_EnumRange;
+  SourceRange m_ClassRange;
 };
 
 class UsingDecl : public Decl {
 public:
   UsingDecl(sona::strhdl_t const& name,
-            sona::owner<Type> &&aliasee,
-            SingleSourceRange usingRange,
-            SingleSourceRange nameRange,
-            SourceLocation eqLoc)
+            NodePtr<Type> &&aliasee,
+            SourceRange usingRange,
+            SourceRange nameRange,
+            SourceRange eqRange)
     : Decl(Node::CNK_UsingDecl),
       m_Name(name),
       m_Aliasee(std::move(aliasee)),
       m_UsingRange(usingRange),
       m_NameRange(nameRange),
-      m_EqLoc(eqLoc) {}
+      m_EqRange(eqRange) {}
 
   sona::strhdl_t const& GetName() const noexcept {
     return m_Name;
@@ -592,39 +606,39 @@ public:
     return m_Aliasee.borrow();
   }
 
-  SingleSourceRange const& GetUsingRange() const noexcept {
+  SourceRange const& GetUsingRange() const noexcept {
     return m_UsingRange;
   }
 
-  SingleSourceRange const& GetNameRange() const noexcept {
+  SourceRange const& GetNameRange() const noexcept {
     return m_NameRange;
   }
 
-  SourceLocation const& GetEqLoc() const noexcept {
-    return m_EqLoc;
+  SourceRange const& GetEqRange() const noexcept {
+    return m_EqRange;
   }
 
 private:
   sona::strhdl_t m_Name;
-  sona::owner<Type> m_Aliasee;
-  SingleSourceRange m_UsingRange;
-  SingleSourceRange m_NameRange;
-  SourceLocation m_EqLoc;
+  NodePtr<Type> m_Aliasee;
+  SourceRange m_UsingRange;
+  SourceRange m_NameRange;
+  SourceRange m_EqRange;
 };
 
 class FuncDecl : public Decl {
 public:
   FuncDecl(sona::strhdl_t const& name,
-           std::vector<sona::owner<Type>> &&paramTypes,
-           std::vector<sona::strhdl_t> &&paramNames,
-           sona::owner<Type> &&retType,
-           sona::optional<sona::owner<Stmt>> &&funcBody,
-           SingleSourceRange funcRange,
-           SingleSourceRange nameRange) :
+           sona::array_ref<NodePtr<Type>> paramTypes,
+           sona::array_ref<sona::strhdl_t> paramNames,
+           NodePtr<Type> &&retType,
+           sona::optional<NodePtr<Stmt>> &&funcBody,
+           SourceRange funcRange,
+           SourceRange nameRange) :
     Decl(NodeKind::CNK_FuncDecl),
     m_Name(name),
-    m_ParamTypes(std::move(paramTypes)),
-    m_ParamNames(std::move(paramNames)),
+    m_ParamTypes(paramTypes),
+    m_ParamNames(paramNames),
     m_RetType(std::move(retType)),
     m_FuncBody(std::move(funcBody)),
     m_FuncRange(funcRange), m_NameRange(nameRange) {}
@@ -633,10 +647,10 @@ public:
 
   auto GetParamTypes() const noexcept {
     return sona::linq::from_container(m_ParamTypes).transform(
-          [](sona::owner<Type> const& it) { return it.borrow(); });
+          [](NodePtr<Type> const& it) { return it.borrow(); });
   }
 
-  std::vector<sona::strhdl_t> const& GetParamNames() const noexcept {
+  sona::array_ref<sona::strhdl_t> GetParamNames() const noexcept {
     return m_ParamNames;
   }
 
@@ -645,35 +659,61 @@ public:
   }
 
   bool IsDefinition() const noexcept {
-    return m_FuncBody.has_value();
+    return m_FuncBody.has_value() || HasSkippedBody();
   }
 
   sona::ref_ptr<Stmt const> GetFuncBodyUnsafe() const noexcept {
+    sona_assert(!HasSkippedBody());
     return m_FuncBody.value().borrow();
   }
 
-  SingleSourceRange const& GetKeywordRange() const noexcept {
+  /// The body was not parsed, only the indices of its braces in the token
+  /// stream of the file were recorded
+  bool HasSkippedBody() const noexcept {
+    return m_SkippedBodyEnd != 0;
+  }
+
+  void SetSkippedBody(std::uint32_t lbraceIndex,
+                      std::uint32_t rbraceIndex) noexcept {
+    sona_assert(!m_FuncBody.has_value() && lbraceIndex < rbraceIndex);
+    m_SkippedBodyBegin = lbraceIndex;
+    m_SkippedBodyEnd = rbraceIndex + 1;
+  }
+
+  /// Token indices [begin, end) of a skipped body, braces included
+  std::uint32_t GetSkippedBodyBeginUnsafe() const noexcept {
+    sona_assert(HasSkippedBody());
+    return m_SkippedBodyBegin;
+  }
+
+  std::uint32_t GetSkippedBodyEndUnsafe() const noexcept {
+    sona_assert(HasSkippedBody());
+    return m_SkippedBodyEnd;
+  }
+
+  SourceRange const& GetKeywordRange() const noexcept {
     return m_FuncRange;
   }
 
-  SingleSourceRange const& GetNameRange() const noexcept {
+  SourceRange const& GetNameRange() const noexcept {
     return m_NameRange;
   }
 
 private:
   sona::strhdl_t m_Name;
-  std::vector<sona::owner<Type>> m_ParamTypes;
-  std::vector<sona::strhdl_t> m_ParamNames;
-  sona::owner<Type> m_RetType;
-  sona::optional<sona::owner<Stmt>> m_FuncBody;
-  SingleSourceRange m_FuncRange, m_NameRange;
+  sona::array_ref<NodePtr<Type>> m_ParamTypes;
+  sona::array_ref<sona::strhdl_t> m_ParamNames;
+  NodePtr<Type> m_RetType;
+  sona::optional<NodePtr<Stmt>> m_FuncBody;
+  SourceRange m_FuncRange, m_NameRange;
+  std::uint32_t m_SkippedBodyBegin = 0, m_SkippedBodyEnd = 0;
 };
 
 class VarDecl : public Decl {
 public:
-  VarDecl(sona::strhdl_t const& name, sona::owner<Type> type,
-          SingleSourceRange const& defRange,
-          SingleSourceRange const& nameRange)
+  VarDecl(sona::strhdl_t const& name, NodePtr<Type> type,
+          SourceRange const& defRange,
+          SourceRange const& nameRange)
     : Decl(NodeKind::CNK_VarDecl),
       m_Name(name), m_Type(std::move(type)),
       m_DefRange(defRange), m_NameRange(nameRange) {}
@@ -686,18 +726,18 @@ public:
     return m_Type.borrow();
   }
 
-  SingleSourceRange const& GetKeywordRange() const noexcept {
+  SourceRange const& GetKeywordRange() const noexcept {
     return m_DefRange;
   }
 
-  SingleSourceRange const& GetNameRange() const noexcept {
+  SourceRange const& GetNameRange() const noexcept {
     return m_NameRange;
   }
 
 private:
   sona::strhdl_t m_Name;
-  sona::owner<Type> m_Type;
-  SingleSourceRange m_DefRange, m_NameRange;
+  NodePtr<Type> m_Type;
+  SourceRange m_DefRange, m_NameRange;
 };
 
 class LiteralExpr : public Expr {
@@ -802,7 +842,7 @@ private:
 
 class SizeOfExpr : public Expr {
 public:
-  SizeOfExpr(sona::owner<Syntax::Expr> &&containedExpr,
+  SizeOfExpr(NodePtr<Syntax::Expr> &&containedExpr,
              SourceRange const& sizeOfRange)
     : Expr(NodeKind::CNK_SizeOfExpr),
       m_ContainedExpr(std::move(containedExpr)),
@@ -817,15 +857,15 @@ public:
   }
 
 private:
-  sona::owner<Syntax::Expr> m_ContainedExpr;
+  NodePtr<Syntax::Expr> m_ContainedExpr;
   SourceRange m_SizeOfRange;
 };
 
 class AlignOfExpr : public Expr {
 public:
-  AlignOfExpr(sona::owner<Syntax::Expr> &&containedExpr,
+  AlignOfExpr(NodePtr<Syntax::Expr> &&containedExpr,
               SourceRange const& alignOfRange)
-    : Expr(NodeKind::CNK_SizeOfExpr),
+    : Expr(NodeKind::CNK_AlignOfExpr),
       m_ContainedExpr(std::move(containedExpr)),
       m_AlignOfRange(alignOfRange) {}
 
@@ -838,16 +878,16 @@ public:
   }
 
 private:
-  sona::owner<Syntax::Expr> m_ContainedExpr;
+  NodePtr<Syntax::Expr> m_ContainedExpr;
   SourceRange m_AlignOfRange;
 };
 
 class FuncCallExpr : public Expr {
 public:
-  FuncCallExpr(sona::owner<Expr> &&callee,
-               std::vector<sona::owner<Expr>> &&args)
+  FuncCallExpr(NodePtr<Expr> &&callee,
+               sona::array_ref<NodePtr<Expr>> args)
     : Expr(NodeKind::CNK_FuncCallExpr),
-      m_Callee(std::move(callee)), m_Args(std::move(args)) {}
+      m_Callee(std::move(callee)), m_Args(args) {}
 
   sona::ref_ptr<Expr const> GetCallee() const noexcept {
     return m_Callee.borrow();
@@ -855,17 +895,17 @@ public:
 
   auto GetArgs() const noexcept {
     return sona::linq::from_container(m_Args).
-        transform([](sona::owner<Expr> const& e) { return e.borrow(); });
+        transform([](NodePtr<Expr> const& e) { return e.borrow(); });
   }
 
 private:
-  sona::owner<Expr> m_Callee;
-  std::vector<sona::owner<Expr>> m_Args;
+  NodePtr<Expr> m_Callee;
+  sona::array_ref<NodePtr<Expr>> m_Args;
 };
 
 class ArraySubscriptExpr : public Expr {
 public:
-  ArraySubscriptExpr(sona::owner<Expr> &&array, sona::owner<Expr> &&index)
+  ArraySubscriptExpr(NodePtr<Expr> &&array, NodePtr<Expr> &&index)
     : Expr(NodeKind::CNK_ArraySubscriptExpr),
       m_Array(std::move(array)), m_Index(std::move(index)) {}
 
@@ -878,13 +918,13 @@ public:
   }
 
 private:
-  sona::owner<Expr> m_Array;
-  sona::owner<Expr> m_Index;
+  NodePtr<Expr> m_Array;
+  NodePtr<Expr> m_Index;
 };
 
 class MemberAccessExpr : public Expr {
 public:
-  MemberAccessExpr(sona::owner<Syntax::Expr> &&baseExpr,
+  MemberAccessExpr(NodePtr<Syntax::Expr> &&baseExpr,
                    Syntax::Identifier &&member)
     : Expr(Node::CNK_MemberAccessExpr),
       m_BaseExpr(std::move(baseExpr)), m_Member(std::move(member)) {}
@@ -898,13 +938,13 @@ public:
   }
 
 private:
-  sona::owner<Syntax::Expr> m_BaseExpr;
+  NodePtr<Syntax::Expr> m_BaseExpr;
   Syntax::Identifier m_Member;
 };
 
 class UnaryAlgebraicExpr : public Expr {
 public:
-  UnaryAlgebraicExpr(UnaryOperator op, sona::owner<Syntax::Expr> &&baseExpr,
+  UnaryAlgebraicExpr(UnaryOperator op, NodePtr<Syntax::Expr> &&baseExpr,
                      SourceRange opRange)
     : Expr(Node::CNK_UnaryAlgebraicExpr),
       m_Operator(op), m_BaseExpr(std::move(baseExpr)),
@@ -920,14 +960,14 @@ public:
 
 private:
   UnaryOperator m_Operator;
-  sona::owner<Syntax::Expr> m_BaseExpr;
+  NodePtr<Syntax::Expr> m_BaseExpr;
   SourceRange m_OpRange;
 };
 
 class BinaryExpr : public Expr {
 public:
-  BinaryExpr(BinaryOperator op, sona::owner<Syntax::Expr> &&lhs,
-             sona::owner<Syntax::Expr> &&rhs, SourceRange const& opRange)
+  BinaryExpr(BinaryOperator op, NodePtr<Syntax::Expr> &&lhs,
+             NodePtr<Syntax::Expr> &&rhs, SourceRange const& opRange)
     : Expr(Node::CNK_BinaryExpr),
       m_Operator(op), m_LeftHandSide(std::move(lhs)),
       m_RightHandSide(std::move(rhs)), m_OpRange(opRange) {}
@@ -948,14 +988,14 @@ public:
 
 private:
   BinaryOperator m_Operator;
-  sona::owner<Syntax::Expr> m_LeftHandSide, m_RightHandSide;
+  NodePtr<Syntax::Expr> m_LeftHandSide, m_RightHandSide;
   SourceRange m_OpRange;
 };
 
 class AssignExpr : public Expr {
 public:
-  AssignExpr(AssignOperator op, sona::owner<Syntax::Expr> &&lhs,
-             sona::owner<Syntax::Expr> &&rhs, SourceRange const& opRange)
+  AssignExpr(AssignOperator op, NodePtr<Syntax::Expr> &&lhs,
+             NodePtr<Syntax::Expr> &&rhs, SourceRange const& opRange)
     : Expr(Node::CNK_AssignExpr),
       m_Operator(op), m_LeftHandSide(std::move(lhs)),
       m_RightHandSide(std::move(rhs)), m_OpRange(opRange) {}
@@ -976,14 +1016,14 @@ public:
 
 private:
   AssignOperator m_Operator;
-  sona::owner<Syntax::Expr> m_LeftHandSide, m_RightHandSide;
+  NodePtr<Syntax::Expr> m_LeftHandSide, m_RightHandSide;
   SourceRange m_OpRange;
 };
 
 class CastExpr : public Expr {
 public:
-  CastExpr(CastOperator castop, sona::owner<Syntax::Expr> &&castedExpr,
-           sona::owner<Syntax::Type> &&destType,
+  CastExpr(CastOperator castop, NodePtr<Syntax::Expr> &&castedExpr,
+           NodePtr<Syntax::Type> &&destType,
            SourceRange const& castOpRange)
     : Expr(Node::CNK_CastExpr),
       m_CastOp(castop), m_CastedExpr(std::move(castedExpr)),
@@ -1005,40 +1045,129 @@ public:
 
 private:
   CastOperator m_CastOp;
-  sona::owner<Syntax::Expr> m_CastedExpr;
-  sona::owner<Syntax::Type> m_DestType;
+  NodePtr<Syntax::Expr> m_CastedExpr;
+  NodePtr<Syntax::Type> m_DestType;
   SourceRange m_CastOpRange;
 };
 
 class MixFixExpr : public Expr {};
 
+class EmptyStmt : public Stmt {
+public:
+  EmptyStmt(SourceRange const& semiRange)
+    : Stmt(NodeKind::CNK_EmptyStmt), m_SemiRange(semiRange) {}
+
+  SourceRange const& GetSemiRange() const noexcept { return m_SemiRange; }
+
+private:
+  SourceRange m_SemiRange;
+};
+
+class ExprStmt : public Stmt {
+public:
+  ExprStmt(NodePtr<Expr> &&expr)
+    : Stmt(NodeKind::CNK_ExprStmt), m_Expr(std::move(expr)) {}
+
+  sona::ref_ptr<Expr const> GetExpr() const noexcept {
+    return m_Expr.borrow();
+  }
+
+private:
+  NodePtr<Expr> m_Expr;
+};
+
+class ReturnStmt : public Stmt {
+public:
+  ReturnStmt(NodePtr<Expr> &&returnValue, SourceRange const& returnRange)
+    : Stmt(NodeKind::CNK_ReturnStmt),
+      m_ReturnValue(std::move(returnValue)), m_ReturnRange(returnRange) {}
+
+  bool HasReturnValue() const noexcept {
+    return m_ReturnValue.borrow() != nullptr;
+  }
+
+  sona::ref_ptr<Expr const> GetReturnValueUnsafe() const noexcept {
+    sona_assert(HasReturnValue());
+    return m_ReturnValue.borrow();
+  }
+
+  SourceRange const& GetReturnRange() const noexcept {
+    return m_ReturnRange;
+  }
+
+private:
+  NodePtr<Expr> m_ReturnValue;
+  SourceRange m_ReturnRange;
+};
+
+class CompoundStmt : public Stmt {
+public:
+  CompoundStmt(sona::array_ref<NodePtr<Stmt>> stmts,
+               SourceRange const& lbraceRange,
+               SourceRange const& rbraceRange)
+    : Stmt(NodeKind::CNK_CompoundStmt), m_Stmts(stmts),
+      m_LBraceRange(lbraceRange), m_RBraceRange(rbraceRange) {}
+
+  auto GetStmts() const noexcept {
+    return sona::linq::from_container(m_Stmts).
+        transform([](NodePtr<Stmt> const& s) { return s.borrow(); });
+  }
+
+  SourceRange const& GetLBraceRange() const noexcept {
+    return m_LBraceRange;
+  }
+
+  SourceRange const& GetRBraceRange() const noexcept {
+    return m_RBraceRange;
+  }
+
+private:
+  sona::array_ref<NodePtr<Stmt>> m_Stmts;
+  SourceRange m_LBraceRange, m_RBraceRange;
+};
+
+/// Owns the SyntaxArena all nodes of its tree are allocated from, the tree
+/// goes away in one piece with the TransUnit
 class TransUnit : public Node {
 public:
   TransUnit() : Node(NodeKind::CNK_TransUnit) {}
 
-  void Declare(sona::owner<Decl> &&decl) {
+  SyntaxArena& GetArena() noexcept { return m_Arena; }
+
+  /// One more arena for the unit, so that threads parsing parts of it each
+  /// allocate from one of their own
+  /// @note not to be called while other threads use the arenas
+  SyntaxArena& AddArena() {
+    m_MoreArenas.emplace_back();
+    return m_MoreArenas.back();
+  }
+
+  void Declare(NodePtr<Decl> &&decl) {
     m_Decls.push_back(std::move(decl));
   }
 
-  void DoImport(sona::owner<Import> &&import) {
+  void DoImport(NodePtr<Import> &&import) {
     m_Imports.push_back(std::move(import));
   }
 
   auto GetDecls() const noexcept {
     return sona::linq::from_container(m_Decls).
-        transform([](sona::owner<Decl> const& decl)
+        transform([](NodePtr<Decl> const& decl)
           { return decl.borrow(); } );
   }
 
   auto GetImports() const noexcept {
     return sona::linq::from_container(m_Imports).
-        transform([](sona::owner<Import> const& decl)
+        transform([](NodePtr<Import> const& decl)
           { return decl.borrow(); } );
   }
 
 private:
-  std::vector<sona::owner<Decl>> m_Decls;
-  std::vector<sona::owner<Import>> m_Imports;
+  SyntaxArena m_Arena;
+  /// A deque, for arenas to stay put when more are added
+  std::deque<SyntaxArena> m_MoreArenas;
+  std::vector<NodePtr<Decl>> m_Decls;
+  std::vector<NodePtr<Import>> m_Imports;
 };
 
 } // namespace Syntax;
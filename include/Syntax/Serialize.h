@@ -0,0 +1,39 @@
+#ifndef SERIALIZE_H
+#define SERIALIZE_H
+
+#include "Syntax/Concrete.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace ckx {
+namespace Syntax {
+
+/// Bumped whenever the layout of a serialized tree changes, old images are
+/// then rejected instead of misread
+constexpr std::uint32_t CSTFormatVersion = 5;
+
+/// Appends the binary image of unit to out. Every interned string the tree
+/// refers to is written once, to a string table in front of the nodes,
+/// which then refer to strings by their index in the table. Source ranges
+/// are written relative to fileStart, the start of the file the tree was
+/// parsed from, each as a delta from the range written before it. Counts, indices and offsets are LEB128 varints; other
+/// numbers are written in host byte order: images are a cache local to
+/// one machine.
+void SerializeTransUnit(TransUnit const& unit, SourceLocation fileStart,
+                        std::string &out);
+
+/// Rebuilds the tree serialized at [data, data + size) in a fresh unit.
+/// The image is only read, it may be unmapped once this returns. Source
+/// ranges are placed in the file starting at fileStart.
+/// @return nullptr if the image is truncated, malformed or of another
+/// format version
+sona::owner<TransUnit> DeserializeTransUnit(char const* data,
+                                            std::size_t size,
+                                            SourceLocation fileStart);
+
+} // namespace Syntax
+} // namespace ckx
+
+#endif // SERIALIZE_H
@@ -0,0 +1,105 @@
+#ifndef SYNTAXARENA_H
+#define SYNTAXARENA_H
+
+#include "sona/arena.h"
+#include "sona/array_ref.h"
+#include "sona/pointer_plus.h"
+
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace ckx {
+namespace Syntax {
+
+/// Links a concrete syntax tree node to a child allocated from the same
+/// SyntaxArena. It moves like sona::owner but never deletes, the arena
+/// releases every node at once.
+template <typename T> class NodePtr {
+public:
+  NodePtr(std::nullptr_t = nullptr) noexcept : m_Ptr(nullptr) {}
+  explicit NodePtr(T *ptr) noexcept : m_Ptr(ptr) {}
+
+  NodePtr(NodePtr const&) = delete;
+  NodePtr(NodePtr &&that) noexcept : m_Ptr(that.m_Ptr) {
+    that.m_Ptr = nullptr;
+  }
+
+  template <typename U, typename = std::enable_if_t<
+                          std::is_convertible<U*, T*>::value>>
+  NodePtr(NodePtr<U> &&that) noexcept : m_Ptr(std::move(that).get()) {}
+
+  NodePtr& operator=(NodePtr const&) = delete;
+  NodePtr& operator=(NodePtr &&that) noexcept {
+    m_Ptr = that.m_Ptr;
+    that.m_Ptr = nullptr;
+    return *this;
+  }
+
+  sona::ref_ptr<T> borrow() noexcept { return sona::ref_ptr<T>(m_Ptr); }
+  sona::ref_ptr<T const> borrow() const noexcept {
+    return sona::ref_ptr<T const>(m_Ptr);
+  }
+
+  template <typename U>
+  NodePtr<U> cast_unsafe() && noexcept {
+    return NodePtr<U>(static_cast<U*>(std::move(*this).get()));
+  }
+
+  T* get() && noexcept {
+    T *ret = m_Ptr;
+    m_Ptr = nullptr;
+    return ret;
+  }
+
+private:
+  T *m_Ptr;
+};
+
+/// Bump allocator for one concrete syntax tree. Nodes and the arrays of
+/// their children are carved out of large blocks and are never destroyed
+/// one by one: freeing the arena frees the whole tree. Whatever lives here
+/// must therefore hold no memory of its own outside the arena.
+///
+/// An arena is used by one thread at a time.
+class SyntaxArena {
+public:
+  SyntaxArena() = default;
+  SyntaxArena(SyntaxArena const&) = delete;
+  SyntaxArena& operator=(SyntaxArena const&) = delete;
+
+  template <typename T, typename ...Args>
+  NodePtr<T> New(Args&& ...args) {
+    void *mem = m_Arena.allocate(sizeof(T), alignof(T));
+    return NodePtr<T>(new (mem) T(std::forward<Args>(args)...));
+  }
+
+  /// Moves the elements of a scratch vector into the arena
+  template <typename T>
+  sona::array_ref<T> CopyArray(std::vector<T> &&elems) {
+    if (elems.empty()) {
+      return sona::array_ref<T>();
+    }
+    T *mem = static_cast<T*>(m_Arena.allocate(sizeof(T) * elems.size(),
+                                              alignof(T)));
+    std::uninitialized_copy(std::make_move_iterator(elems.begin()),
+                            std::make_move_iterator(elems.end()), mem);
+    return sona::array_ref<T>(mem, elems.size());
+  }
+
+  std::size_t GetBytesReserved() const noexcept {
+    return m_Arena.bytes_reserved();
+  }
+
+private:
+  sona::arena m_Arena;
+};
+
+} // namespace Syntax
+} // namespace ckx
+
+#endif // SYNTAXARENA_H
@@ -0,0 +1,50 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace sona {
+
+/// A bump allocator carving memory out of large blocks. Nothing allocated
+/// ever moves, and nothing is freed before the arena itself goes away.
+class arena {
+public:
+  static constexpr std::size_t default_block_size = 64 * 1024;
+
+  explicit arena(std::size_t block_size = default_block_size) noexcept
+    : block_size(block_size) {}
+
+  arena(arena const&) = delete;
+  arena& operator=(arena const&) = delete;
+  ~arena();
+
+  void* allocate(std::size_t size,
+                 std::size_t align = alignof(std::max_align_t)) {
+    std::size_t padding =
+        (align - reinterpret_cast<std::uintptr_t>(cur) % align) % align;
+    if (static_cast<std::size_t>(end - cur) < size + padding) {
+      return allocate_slow(size, align);
+    }
+    char *ret = cur + padding;
+    cur = ret + size;
+    return ret;
+  }
+
+  /// Bytes taken from the system so far, including unused block tails
+  std::size_t bytes_reserved() const noexcept { return reserved; }
+
+private:
+  void* allocate_slow(std::size_t size, std::size_t align);
+
+  std::vector<char*> blocks;
+  char *cur = nullptr;
+  char *end = nullptr;
+  std::size_t block_size;
+  std::size_t reserved = 0;
+};
+
+} // namespace sona
+
+#endif // ARENA_H
@@ -0,0 +1,47 @@
+#ifndef ARRAY_REF_H
+#define ARRAY_REF_H
+
+#include "sona/util.h"
+
+#include <cstddef>
+#include <vector>
+
+namespace sona {
+
+/// A read-only view of contiguous elements that live elsewhere, in an arena
+/// or in a std::vector that outlives the view. Copying it copies no element.
+template <typename T> class array_ref {
+public:
+  using value_type = T;
+  using iterator = T const*;
+  using const_iterator = T const*;
+  using size_type = std::size_t;
+
+  array_ref() noexcept : first(nullptr), count(0) {}
+  array_ref(T const* first, std::size_t count) noexcept
+    : first(first), count(count) {}
+  array_ref(std::vector<T> const& vec) noexcept
+    : first(vec.data()), count(vec.size()) {}
+
+  iterator begin() const noexcept { return first; }
+  iterator end() const noexcept { return first + count; }
+
+  std::size_t size() const noexcept { return count; }
+  bool empty() const noexcept { return count == 0; }
+
+  T const& operator[](std::size_t idx) const noexcept {
+    sona_assert(idx < count);
+    return first[idx];
+  }
+
+  T const& front() const noexcept { return (*this)[0]; }
+  T const& back() const noexcept { return (*this)[count - 1]; }
+
+private:
+  T const *first;
+  std::size_t count;
+};
+
+} // namespace sona
+
+#endif // ARRAY_REF_H
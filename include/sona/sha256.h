@@ -0,0 +1,18 @@
+#ifndef SHA256_H
+#define SHA256_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace sona {
+
+using sha256_digest = std::array<std::uint8_t, 32>;
+
+/// SHA-256 of the content, for keys two different contents must never
+/// share, where the 64 bits of hash_bytes may collide
+sha256_digest sha256(char const* data, std::size_t len) noexcept;
+
+} // namespace sona
+
+#endif // SHA256_H
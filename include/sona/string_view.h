@@ -0,0 +1,62 @@
+#ifndef STRING_VIEW_H
+#define STRING_VIEW_H
+
+#include <cstddef>
+#include <cstring>
+#include <ostream>
+#include <string>
+
+namespace sona {
+
+/// A non-owning slice of characters, a poor man's C++17 std::string_view
+class string_view {
+public:
+  using size_type = std::size_t;
+  using const_iterator = char const*;
+
+  constexpr string_view() noexcept : ptr(nullptr), len(0) {}
+  constexpr string_view(char const* ptr, size_type len) noexcept
+    : ptr(ptr), len(len) {}
+  string_view(char const* cstr) noexcept
+    : ptr(cstr), len(std::strlen(cstr)) {}
+  string_view(std::string const& str) noexcept
+    : ptr(str.data()), len(str.size()) {}
+
+  constexpr char const* data() const noexcept { return ptr; }
+  constexpr size_type size() const noexcept { return len; }
+  constexpr bool empty() const noexcept { return len == 0; }
+
+  constexpr const_iterator begin() const noexcept { return ptr; }
+  constexpr const_iterator end() const noexcept { return ptr + len; }
+
+  constexpr char operator[](size_type idx) const noexcept { return ptr[idx]; }
+
+  std::string to_string() const { return std::string(ptr, len); }
+
+  friend bool operator==(string_view lhs, string_view rhs) noexcept {
+    return lhs.len == rhs.len
+           && (lhs.len == 0 || std::memcmp(lhs.ptr, rhs.ptr, lhs.len) == 0);
+  }
+
+  friend bool operator!=(string_view lhs, string_view rhs) noexcept {
+    return !(lhs == rhs);
+  }
+
+  friend bool operator<(string_view lhs, string_view rhs) noexcept {
+    size_type common = lhs.len < rhs.len ? lhs.len : rhs.len;
+    int cmp = common == 0 ? 0 : std::memcmp(lhs.ptr, rhs.ptr, common);
+    return cmp < 0 || (cmp == 0 && lhs.len < rhs.len);
+  }
+
+  friend std::ostream& operator<<(std::ostream& os, string_view view) {
+    return os.write(view.ptr, static_cast<std::streamsize>(view.len));
+  }
+
+private:
+  char const *ptr;
+  size_type len;
+};
+
+} // namespace sona
+
+#endif // STRING_VIEW_H
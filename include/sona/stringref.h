@@ -1,74 +1,179 @@
 #ifndef STRINGREF_H
 #define STRINGREF_H
 
-#include <string>
+#include <atomic>
 #include <cstddef>
-#include <unordered_map>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "sona/arena.h"
+#include "sona/string_view.h"
 
 namespace sona {
 
 namespace impl_stc89c52 {
-std::unordered_map<std::string, int>& glob_container() noexcept;
-}
 
-class strhdl_t {
+/// 64-bit hash of the content, after wyhash. Stable across runs and
+/// platforms, unlike std::hash.
+std::uint64_t hash_bytes(char const* str, std::size_t len) noexcept;
+
+/// Every distinct string interned so far, numbered in order of arrival
+/// and shared by all threads of the process. The text lives in arenas and
+/// no entry is ever erased, so each string is allocated once however often
+/// handles to it come and go. Its hash is computed once on the way in and
+/// kept next to it.
+///
+/// Interning goes through a small per-thread cache first, then locks one
+/// of num_shards shards picked by the hash, so threads interning different
+/// strings rarely contend. Entries sit in chunks that never move, and
+/// resolving an id takes no lock at all.
+class string_pool {
 public:
-  using string_set = std::unordered_map<std::string, int>;
-
-  strhdl_t(std::string const& str) {
-    auto it = impl_stc89c52::glob_container().find(str);
-    if (it != impl_stc89c52::glob_container().end()) {
-      pv = &(*it);
-      pv->second++;
-      return;
-    }
+  static constexpr unsigned num_shards = 64;
 
-    pv = &(*(impl_stc89c52::glob_container().emplace(str, 1).first));
-  }
+  string_pool(string_pool const&) = delete;
+  string_pool& operator=(string_pool const&) = delete;
+  ~string_pool();
+
+  std::uint32_t intern(string_view str);
 
-  strhdl_t(strhdl_t const& that) : pv(that.pv) {
-    that.pv->second++;
+  string_view lookup(std::uint32_t id) const noexcept {
+    return get_entry(id).str;
   }
 
-  strhdl_t(const char* cstr) : strhdl_t(std::string(cstr)) {}
+  std::uint64_t hash_of(std::uint32_t id) const noexcept {
+    return get_entry(id).hash;
+  }
 
-  strhdl_t& operator= (strhdl_t const& that) noexcept {
-    pv = that.pv;
-    that.pv->second++;
-    return *this;
+  std::size_t size() const noexcept {
+    return next_id.load(std::memory_order_relaxed);
   }
 
-  ~strhdl_t() {
-    pv->second--;
-    if (pv->second == 0) {
-      impl_stc89c52::glob_container().erase(pv->first);
+private:
+  friend string_pool& glob_pool() noexcept;
+  string_pool();
+
+  struct entry {
+    string_view str;
+    std::uint64_t hash;
+  };
+
+  struct shard {
+    std::mutex lock;
+    arena text { 16 * 1024 };
+    std::size_t count = 0;
+    /// Open addressing with linear probing, id + 1 per slot and 0 for none
+    std::vector<std::uint32_t> slots;
+  };
+
+  /// Chunk k holds ids [2^(k+10) - 1024, 2^(k+11) - 1024)
+  static constexpr unsigned first_chunk_bits = 10;
+  static constexpr unsigned num_chunks = 32 - first_chunk_bits + 1;
+
+  static unsigned chunk_of(std::uint32_t id, std::size_t &index) noexcept {
+    std::uint64_t biased = std::uint64_t(id) + (1u << first_chunk_bits);
+#ifdef __GNUC__
+    unsigned top = 63 - static_cast<unsigned>(__builtin_clzll(biased));
+#else
+    unsigned top = 0;
+    while ((biased >> top) > 1) {
+      top++;
     }
+#endif
+    index = static_cast<std::size_t>(biased - (std::uint64_t(1) << top));
+    return top - first_chunk_bits;
+  }
+
+  entry const& get_entry(std::uint32_t id) const noexcept {
+    std::size_t index;
+    unsigned chunk = chunk_of(id, index);
+    return chunks[chunk].load(std::memory_order_acquire)[index];
+  }
+
+  std::uint32_t insert(shard &sh, string_view str, std::uint64_t hash);
+  entry& new_entry(std::uint32_t id);
+  void grow(shard &sh);
+
+  shard shards[num_shards];
+  std::atomic<std::uint32_t> next_id;
+  std::mutex chunk_lock;
+  std::atomic<entry*> chunks[num_chunks];
+};
+
+string_pool& glob_pool() noexcept;
+
+/// The order of strhdl_t: by content hash, by text for equal hashes
+inline bool hash_order_less(std::uint64_t h1, string_view s1,
+                            std::uint64_t h2, string_view s2) noexcept {
+  return h1 != h2 ? h1 < h2 : s1 < s2;
+}
+
+} // namespace impl_stc89c52
+
+/// Also good for keying on-disk caches by content
+using impl_stc89c52::hash_bytes;
+
+/// An interned string: a 32-bit symbol id, copied, compared and hashed as
+/// an integer
+class strhdl_t {
+public:
+  strhdl_t(std::string const& str)
+    : sid(impl_stc89c52::glob_pool().intern(string_view(str))) {}
+
+  strhdl_t(const char* cstr)
+    : sid(impl_stc89c52::glob_pool().intern(string_view(cstr))) {}
+
+  explicit strhdl_t(string_view view)
+    : sid(impl_stc89c52::glob_pool().intern(view)) {}
+
+  string_view get() const noexcept {
+    return impl_stc89c52::glob_pool().lookup(sid);
   }
 
-  std::string const& get() const noexcept {
-    return pv->first;
+  /// Dense, starting at 0 in order of interning
+  std::uint32_t id() const noexcept { return sid; }
+
+  /// hash_bytes of the string, cached when it was interned
+  std::uint64_t content_hash() const noexcept {
+    return impl_stc89c52::glob_pool().hash_of(sid);
   }
 
-  friend bool operator== (strhdl_t const& r1, strhdl_t const& r2) {
-    return r1.pv == r2.pv;
+  friend bool operator== (strhdl_t r1, strhdl_t r2) noexcept {
+    return r1.sid == r2.sid;
   }
 
-  friend bool operator!= (strhdl_t const& r1, strhdl_t const& r2) {
-    return r1.pv == r2.pv;
+  friend bool operator!= (strhdl_t r1, strhdl_t r2) noexcept {
+    return r1.sid != r2.sid;
   }
 
+  /// The cached content hash, a load rather than a pass over the text
   std::size_t hash() const noexcept {
-    return std::hash<std::string>()(pv->first);
+    return static_cast<std::size_t>(content_hash());
   }
 
-  friend bool operator< (strhdl_t const& s1, strhdl_t const& s2) {
-    return s1.pv->first < s2.pv->first;
+  /// Orders by content hash and only compares text on a collision. Not
+  /// alphabetical, but it depends on the strings alone, never on the order
+  /// they were interned in.
+  friend bool operator< (strhdl_t s1, strhdl_t s2) noexcept {
+    if (s1.sid == s2.sid) {
+      return false;
+    }
+    return impl_stc89c52::hash_order_less(s1.content_hash(), s1.get(),
+                                          s2.content_hash(), s2.get());
   }
 
 private:
-  typename string_set::value_type *pv;
+  std::uint32_t sid;
 };
 
+static_assert(std::is_trivially_copyable<strhdl_t>::value
+              && sizeof(strhdl_t) == sizeof(std::uint32_t),
+              "strhdl_t should be a bare symbol id");
+
 } // namespace sona
 
 namespace std {
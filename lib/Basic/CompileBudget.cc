@@ -0,0 +1,93 @@
+#include "Basic/CompileBudget.h"
+
+#include "sona/util.h"
+
+namespace ckx {
+
+constexpr std::uint32_t CompileBudget::TimeCheckInterval;
+
+namespace {
+
+/// @return false unless arg is prefix followed by a decimal number
+bool ParseNumberOption(std::string const& arg, char const* prefix,
+                       std::uint64_t &value) {
+  std::string::size_type prefixLength = std::char_traits<char>::length(prefix);
+  if (arg.size() <= prefixLength || arg.compare(0, prefixLength, prefix) != 0) {
+    return false;
+  }
+
+  std::uint64_t ret = 0;
+  for (std::string::size_type i = prefixLength; i < arg.size(); i++) {
+    if (arg[i] < '0' || arg[i] > '9') {
+      return false;
+    }
+    ret = ret * 10 + static_cast<std::uint64_t>(arg[i] - '0');
+  }
+  value = ret;
+  return true;
+}
+
+} // namespace
+
+void CompileBudget::SetMaxTime(std::chrono::milliseconds maxTime) noexcept {
+  m_MaxTime = maxTime;
+  m_Deadline = std::chrono::steady_clock::now() + maxTime;
+}
+
+bool CompileBudget::TimeExceeded() const noexcept {
+  if (m_MaxTime.count() == 0
+      || (m_TimeChecks.fetch_add(1, std::memory_order_relaxed) + 1)
+         % TimeCheckInterval != 0) {
+    return false;
+  }
+  return std::chrono::steady_clock::now() > m_Deadline;
+}
+
+bool CompileBudget::Exhaust(Resource resource) noexcept {
+  sona_assert(resource != R_None);
+  Resource expected = R_None;
+  return m_ExhaustedBy.compare_exchange_strong(expected, resource,
+                                               std::memory_order_relaxed);
+}
+
+char const* CompileBudget::GetResourceName(Resource resource) noexcept {
+  switch (resource) {
+  case R_Errors: return "errors";
+  case R_Tokens: return "tokens";
+  case R_Depth: return "levels of nesting";
+  case R_Time: return "milliseconds";
+  case R_None: break;
+  }
+  sona_unreachable();
+  return nullptr;
+}
+
+std::uint64_t CompileBudget::GetLimit(Resource resource) const noexcept {
+  switch (resource) {
+  case R_Tokens: return m_MaxTokens;
+  case R_Depth: return m_MaxDepth;
+  case R_Time: return static_cast<std::uint64_t>(m_MaxTime.count());
+  case R_Errors: case R_None: break;
+  }
+  sona_unreachable();
+  return 0;
+}
+
+bool ParseBudgetOption(std::string const& arg, CompileBudget &budget) {
+  std::uint64_t value;
+  if (ParseNumberOption(arg, "--max-tokens=", value)) {
+    budget.SetMaxTokens(static_cast<std::size_t>(value));
+    return true;
+  }
+  if (ParseNumberOption(arg, "--max-depth=", value)) {
+    budget.SetMaxDepth(static_cast<std::size_t>(value));
+    return true;
+  }
+  if (ParseNumberOption(arg, "--max-time=", value)) {
+    budget.SetMaxTime(std::chrono::milliseconds(value));
+    return true;
+  }
+  return false;
+}
+
+} // namespace ckx
@@ -1,192 +1,630 @@
 #include "Basic/Diagnose.h"
-#include <sstream>
+#include <algorithm>
 #include <iostream>
+#include <string>
 #include <cmath>
-#include <iomanip>
 
 namespace ckx {
 namespace Diag {
 
-std::string
-Format(DiagMessageTemplate messageTemplate,
-       std::vector<sona::strhdl_t> const& paramStrings) {
-  char const *templateStr = nullptr;
-  switch (messageTemplate) {
-  #define DIAG_TEMPLATE(ID, STR) \
-  case DMT_##ID: templateStr = STR; break;
-  #include "Basic/Diags.def"
-  default:
-    sona_unreachable1("unhandled diag kind");
-  }
-
-  auto iter = paramStrings.begin();
-  std::stringstream sstream;
+namespace {
+
+char const* const TemplateStrings[] = {
+#define DIAG_TEMPLATE(ID, STR) STR,
+#include "Basic/Diags.def"
+};
+
+static_assert(sizeof(TemplateStrings) / sizeof(TemplateStrings[0]) == DMT_End,
+              "Diags.def and DiagMessageTemplate out of sync");
+
+void FormatInto(std::string &out, DiagMessageTemplate messageTemplate,
+                std::string const* paramBegin,
+                std::string const* paramEnd) {
+  sona_assert(messageTemplate < DMT_End);
+  char const *templateStr = TemplateStrings[messageTemplate];
   for (size_t idx = 0; templateStr[idx] != '\0';) {
     if (templateStr[idx] == '{' && templateStr[idx+1] == '}') {
       idx += 2;
-      if (iter == paramStrings.end()) {
+      if (paramBegin == paramEnd) {
         sona_unreachable1("not enough param string provided");
       }
-      sstream << (*iter).get();
-      ++iter;
+      out += *paramBegin;
+      ++paramBegin;
     }
     else {
-      sstream << templateStr[idx];
+      out.push_back(templateStr[idx]);
       ++idx;
     }
   }
 
-  if (iter != paramStrings.end()) {
+  if (paramBegin != paramEnd) {
     sona_unreachable1("redundant param string provided");
   }
+}
+
+} // namespace
 
+std::string
+Format(DiagMessageTemplate messageTemplate,
+       std::initializer_list<DiagParam> params) {
+  std::vector<std::string> paramStrings;
+  for (DiagParam param : params) {
+    paramStrings.push_back(param.GetView().to_string());
+  }
   std::string ret;
-  std::getline(sstream, ret);
+  FormatInto(ret, messageTemplate, paramStrings.data(),
+             paramStrings.data() + paramStrings.size());
   return ret;
 }
 
+bool ParseFormatOption(std::string const& arg, DiagnosticFormat &format) {
+  if (arg == "--diagnostics-format=text") {
+    format = DF_Text;
+    return true;
+  }
+  if (arg == "--diagnostics-format=json") {
+    format = DF_JSON;
+    return true;
+  }
+  return false;
+}
+
+bool ParseErrorLimitOption(std::string const& arg, std::size_t &limit) {
+  static char const prefix[] = "--error-limit=";
+  constexpr std::size_t prefixLength = sizeof(prefix) - 1;
+  if (arg.size() <= prefixLength || arg.compare(0, prefixLength, prefix) != 0) {
+    return false;
+  }
+
+  std::size_t value = 0;
+  for (std::size_t i = prefixLength; i < arg.size(); i++) {
+    if (arg[i] < '0' || arg[i] > '9') {
+      return false;
+    }
+    value = value * 10 + static_cast<std::size_t>(arg[i] - '0');
+  }
+  limit = value;
+  return true;
+}
+
+namespace {
+
+std::atomic<std::uint64_t> NextEngineID { 1 };
+
+} // namespace
+
+thread_local DiagnosticEngine::BufferCache DiagnosticEngine::t_LastBuffer =
+  { 0, nullptr };
+
+DiagnosticEngine::DiagnosticEngine(SourceManager const& sourceManager,
+                                   FileID fileID)
+  : m_FileName(fileID.IsValid() ? sourceManager.GetFileName(fileID) : ""),
+    m_SourceManager(sourceManager),
+    m_EngineID(NextEngineID.fetch_add(1, std::memory_order_relaxed)) {}
+
+DiagnosticEngine::DiagnosticEngine(std::string const& fileName,
+                                   std::vector<std::string> const& codeLines)
+  : m_FileName(fileName), m_CodeLines(&codeLines),
+    m_EngineID(NextEngineID.fetch_add(1, std::memory_order_relaxed)) {}
+
 DiagnosticEngine::DiagnosticInfo&
 DiagnosticEngine::Diag(DiagnosticInfoRank rank,
                        std::string &&message, SourceRange const& range) {
-  m_PendingDiags.push_back(DiagnosticInfo(rank));
-  DiagnosticInfo& theInfo = m_PendingDiags.back();
-  theInfo.AddDesc(std::move(message), range);
-  return theInfo;
+  return NewDiag(rank, range).AddDesc(std::move(message), range);
+}
+
+DiagnosticEngine::DiagnosticInfo&
+DiagnosticEngine::Diag(DiagnosticInfoRank rank,
+                       DiagMessageTemplate messageTemplate,
+                       std::initializer_list<DiagParam> params,
+                       SourceRange const& range) {
+  return NewDiag(rank, range).AddDesc(messageTemplate, params, range);
+}
+
+DiagnosticEngine::ThreadBuffer& DiagnosticEngine::GetThreadBuffer() {
+  if (t_LastBuffer.EngineID == m_EngineID) {
+    return *t_LastBuffer.Buffer;
+  }
+
+  std::thread::id self = std::this_thread::get_id();
+  std::lock_guard<std::mutex> guard(m_BuffersLock);
+  ThreadBuffer *buffer = nullptr;
+  for (ThreadBuffer &candidate : m_Buffers) {
+    if (candidate.Owner == self) {
+      buffer = &candidate;
+      break;
+    }
+  }
+  if (buffer == nullptr) {
+    m_Buffers.emplace_back(self);
+    buffer = &m_Buffers.back();
+  }
+  t_LastBuffer = BufferCache { m_EngineID, buffer };
+  return *buffer;
+}
+
+DiagnosticEngine::DiagnosticInfo&
+DiagnosticEngine::NewDiag(DiagnosticInfoRank rank, SourceRange const& range) {
+  ThreadBuffer &buffer = GetThreadBuffer();
+  /// Whatever phases report while winding down only follows from running
+  /// out of budget
+  bool dropped = m_Budget.IsExhausted(), reachesLimit = false;
+  if (!dropped && m_ErrorLimit != 0) {
+    if (rank == DIR_Error) {
+      std::size_t numErrors =
+          m_NumErrors.fetch_add(1, std::memory_order_relaxed) + 1;
+      dropped = numErrors > m_ErrorLimit;
+      reachesLimit = numErrors == m_ErrorLimit;
+    }
+    else {
+      dropped = ErrorLimitReached();
+    }
+  }
+
+  if (dropped) {
+    m_NumDropped.fetch_add(1, std::memory_order_relaxed);
+    /// Records nothing of what the caller chains onto it, so that no
+    /// argument gets copied
+    return buffer.DroppedDiag;
+  }
+
+  if (reachesLimit) {
+    DiagnosticInfo limitNote(DIR_Note);
+    limitNote.AddDesc(DMT_NoteTooManyErrors,
+                      { std::to_string(m_ErrorLimit) },
+                      range);
+    {
+      std::lock_guard<std::mutex> guard(m_BuffersLock);
+      m_LimitNote = std::move(limitNote);
+      m_LimitNotePending = true;
+    }
+    m_Budget.Exhaust(CompileBudget::R_Errors);
+  }
+
+  buffer.Diags.push_back(DiagnosticInfo(rank));
+  buffer.Diags.back().m_Tag = buffer.Tag;
+  return buffer.Diags.back();
+}
+
+void DiagnosticEngine::ForgetDiag(DiagnosticInfo const& info) noexcept {
+  if (m_ErrorLimit != 0 && info.m_Rank == DIR_Error) {
+    m_NumErrors.fetch_sub(1, std::memory_order_relaxed);
+  }
+}
+
+void DiagnosticEngine::DetachThread() {
+  std::thread::id self = std::this_thread::get_id();
+  std::lock_guard<std::mutex> guard(m_BuffersLock);
+  for (ThreadBuffer &buffer : m_Buffers) {
+    if (buffer.Owner == self) {
+      buffer.Owner = std::thread::id();
+    }
+  }
+  if (t_LastBuffer.EngineID == m_EngineID) {
+    t_LastBuffer = BufferCache { 0, nullptr };
+  }
+}
+
+void DiagnosticEngine::ExhaustBudget(CompileBudget::Resource resource,
+                                     SourceRange const& range) {
+  if (!m_Budget.Exhaust(resource)) {
+    return;
+  }
+
+  ThreadBuffer &buffer = GetThreadBuffer();
+  buffer.Diags.push_back(DiagnosticInfo(DIR_Error));
+  buffer.Diags.back().AddDesc(
+    DMT_ErrBudgetExhausted, {
+      std::to_string(m_Budget.GetLimit(resource)),
+      CompileBudget::GetResourceName(resource)
+    },
+    range);
 }
 
 bool DiagnosticEngine::HasPendingError() const noexcept {
-  for (DiagnosticInfo const& info : m_PendingDiags) {
-    if (info.m_Rank == DiagnosticInfoRank::DIR_Error) {
-      return true;
+  std::lock_guard<std::mutex> guard(m_BuffersLock);
+  for (ThreadBuffer const& buffer : m_Buffers) {
+    for (DiagnosticInfo const& info : buffer.Diags) {
+      if (info.m_Rank == DiagnosticInfoRank::DIR_Error) {
+        return true;
+      }
     }
   }
   return false;
 }
 
 bool DiagnosticEngine::HasPendingDiags() const noexcept {
-  return m_PendingDiags.size() != 0;
+  std::lock_guard<std::mutex> guard(m_BuffersLock);
+  for (ThreadBuffer const& buffer : m_Buffers) {
+    if (!buffer.Diags.empty()) {
+      return true;
+    }
+  }
+  return m_LimitNotePending;
 }
 
-void DiagnosticEngine::EmitDiags() {
-  for (DiagnosticInfo const& info : m_PendingDiags) {
-    info.Dump(m_FileName, m_CodeLines);
+void DiagnosticEngine::RenderDiags(std::string &out) const {
+  if (m_SourceManager != nullptr) {
+    RenderDiags(m_SourceManager.get(), out);
+    return;
+  }
+  if (!HasPendingDiags()) {
+    return;
   }
+
+  /// The lines become the one file of a manager of their own, which lays
+  /// it out where lexers outside of any manager put their tokens
+  std::string text;
+  if (m_CodeLines != nullptr) {
+    for (std::string const& line : *m_CodeLines) {
+      text += line;
+      text.push_back('\n');
+    }
+  }
+  SourceManager lineManager;
+  lineManager.AddFile(m_FileName, SourceBuffer::FromString(std::move(text)));
+  RenderDiags(lineManager, out);
+}
+
+void DiagnosticEngine::RenderDiags(SourceManager const& sourceManager,
+                                   std::string &out) const {
+  std::lock_guard<std::mutex> guard(m_BuffersLock);
+  /// Every buffer is in recording order already, so the buffers are merged
+  /// rather than sorted: each step renders whichever of their next
+  /// diagnostics renders first. What one thread recorded keeps its order.
+  std::vector<std::size_t> next(m_Buffers.size(), 0);
+  for (;;) {
+    DiagnosticInfo const* first = nullptr;
+    std::size_t firstBuffer = 0;
+    for (std::size_t i = 0; i < m_Buffers.size(); i++) {
+      std::vector<DiagnosticInfo> const& diags = m_Buffers[i].Diags;
+      if (next[i] == diags.size()) {
+        continue;
+      }
+      if (first == nullptr || diags[next[i]].RendersBefore(*first)) {
+        first = &diags[next[i]];
+        firstBuffer = i;
+      }
+    }
+    if (first == nullptr) {
+      break;
+    }
+    RenderDiag(*first, sourceManager, out);
+    ++next[firstBuffer];
+  }
+  if (m_LimitNotePending) {
+    RenderDiag(m_LimitNote, sourceManager, out);
+  }
+}
+
+void DiagnosticEngine::RenderDiag(DiagnosticInfo const& info,
+                                  SourceManager const& sourceManager,
+                                  std::string &out) const {
+  if (m_Format == DF_JSON) {
+    info.RenderJSON(*this, sourceManager, out);
+  }
+  else {
+    info.RenderText(*this, sourceManager, out);
+  }
+}
+
+void DiagnosticEngine::EmitDiags() {
+  m_RenderBuffer.clear();
+  RenderDiags(m_RenderBuffer);
+  std::cerr.write(m_RenderBuffer.data(),
+                  static_cast<std::streamsize>(m_RenderBuffer.size()));
+  std::cerr.flush();
   ClearDiags();
 }
 
 void DiagnosticEngine::ClearDiags() noexcept {
-  m_PendingDiags.clear();
+  std::lock_guard<std::mutex> guard(m_BuffersLock);
+  for (ThreadBuffer &buffer : m_Buffers) {
+    buffer.Diags.clear();
+  }
+  m_LimitNotePending = false;
+}
+
+std::string const&
+DiagnosticEngine::GetFileName(SourceManager const& sourceManager,
+                              SourceLocation loc) const noexcept {
+  FileID fileID = sourceManager.GetFileID(loc);
+  if (fileID.IsValid()) {
+    return sourceManager.GetFileName(fileID);
+  }
+  return m_FileName;
 }
 
 DiagnosticEngine::DiagnosticInfo&
 DiagnosticEngine::DiagnosticInfo::AddDesc(std::string &&message,
                                           SourceRange const& range) {
-  AddSubDiagnose(SDK_Desc, std::move(message), range);
+  AddSubDiagnose(SDK_Desc, Message { DMT_End, {}, std::move(message) }, range);
+  return *this;
+}
+
+DiagnosticEngine::DiagnosticInfo&
+DiagnosticEngine::DiagnosticInfo::AddDesc(
+    DiagMessageTemplate messageTemplate,
+    std::initializer_list<DiagParam> params, SourceRange const& range) {
+  AddSubDiagnose(SDK_Desc, messageTemplate, params, range);
   return *this;
 }
 
 DiagnosticEngine::DiagnosticInfo&
 DiagnosticEngine::DiagnosticInfo::AddNote(std::string &&message,
                                           SourceRange const& range) {
-  AddSubDiagnose(SDK_Note, std::move(message), range);
+  AddSubDiagnose(SDK_Note, Message { DMT_End, {}, std::move(message) }, range);
+  return *this;
+}
+
+DiagnosticEngine::DiagnosticInfo&
+DiagnosticEngine::DiagnosticInfo::AddNote(
+    DiagMessageTemplate messageTemplate,
+    std::initializer_list<DiagParam> params, SourceRange const& range) {
+  AddSubDiagnose(SDK_Note, messageTemplate, params, range);
   return *this;
 }
 
 DiagnosticEngine::DiagnosticInfo&
 DiagnosticEngine::DiagnosticInfo::AddFixit(std::string &&message,
                                            SourceRange const& range) {
-  AddSubDiagnose(SDK_Fixit, std::move(message), range);
+  AddSubDiagnose(SDK_Fixit, Message { DMT_End, {}, std::move(message) }, range);
+  return *this;
+}
+
+DiagnosticEngine::DiagnosticInfo&
+DiagnosticEngine::DiagnosticInfo::AddFixit(
+    DiagMessageTemplate messageTemplate,
+    std::initializer_list<DiagParam> params, SourceRange const& range) {
+  AddSubDiagnose(SDK_Fixit, messageTemplate, params, range);
   return *this;
 }
 
 void DiagnosticEngine::DiagnosticInfo::AddSubDiagnose(
-    SubDiagnoseKind sdk, std::string&& desc, SourceRange const& range) {
+    SubDiagnoseKind sdk, Message &&message, SourceRange const& range) {
+  if (m_Dropped) {
+    return;
+  }
   m_SDKs.push_back(sdk);
-  m_Messages.push_back(std::move(desc));
+  m_Messages.push_back(std::move(message));
   m_SourceRanges.push_back(range);
 }
 
-static void PrintSourceCode(const std::vector<std::string>& codeLines,
-                            SourceRange const& range) {
-  using std::cerr;
-  using std::endl;
-  using std::setw;
-  using std::setfill;
+void DiagnosticEngine::DiagnosticInfo::AddSubDiagnose(
+    SubDiagnoseKind sdk, DiagMessageTemplate messageTemplate,
+    std::initializer_list<DiagParam> params, SourceRange const& range) {
+  if (m_Dropped) {
+    return;
+  }
+  std::vector<std::string> paramStrings;
+  paramStrings.reserve(params.size());
+  for (DiagParam param : params) {
+    paramStrings.push_back(param.GetView().to_string());
+  }
+  AddSubDiagnose(sdk,
+                 Message { messageTemplate, std::move(paramStrings),
+                           std::string() },
+                 range);
+}
 
-  /// the range was not implemented
-  if (range.GetStartCol() == 0 && range.GetEndCol() == 0
-      && range.GetStartLine() == 0) {
-    cerr << "  <not-available> | Sorry, source info not implemented yet."
-         << endl << endl;
+void DiagnosticEngine::DiagnosticInfo::Message::AppendTo(
+    std::string &out) const {
+  if (Template == DMT_End) {
+    out += Text;
     return;
   }
+  FormatInto(out, Template, Params.data(), Params.data() + Params.size());
+}
 
-  sona_assert(codeLines.size() >= range.GetStartLine() - 1);
-  cerr << " " << setw(5) << setfill('0') << range.GetStartLine()
-       << " | " << codeLines[range.GetStartLine() - 1] << endl;
+namespace {
 
-  for (size_t i = 0; i < 9; i++) {
-    cerr.put(' ');
+char const* RankLabel(DiagnosticInfoRank rank) noexcept {
+  switch (rank) {
+  case DIR_Error: return "error";
+  case DIR_Warning0: case DIR_Warning1: case DIR_Warning2: return "warning";
+  case DIR_Note: return "note";
   }
+  sona_unreachable();
+  return nullptr;
+}
 
-  for (size_t i = 0; i < range.GetStartCol()-1; i++) {
-    cerr.put(' ');
+void AppendNumber(std::string &out, std::uint64_t value,
+                  std::size_t minDigits = 1) {
+  char digits[20];
+  std::size_t numDigits = 0;
+  do {
+    digits[numDigits++] = static_cast<char>('0' + value % 10);
+    value /= 10;
+  } while (value != 0);
+  if (minDigits > numDigits) {
+    out.append(minDigits - numDigits, '0');
   }
-  for (size_t i = range.GetStartCol()-1; i < range.GetEndCol()-1; i++) {
-    cerr.put('^');
+  while (numDigits != 0) {
+    out.push_back(digits[--numDigits]);
   }
+}
+
+/// Where a range starts and ends, for humans. A range that does not
+/// decode, because it is invalid or lies outside of the files, has line 0.
+struct PresumedRange {
+  std::uint32_t Line = 0, Col = 0, EndLine = 0, EndCol = 0;
+};
 
-  cerr << endl;
+PresumedRange DecodeRange(SourceManager const& sourceManager,
+                          SourceRange const& range) {
+  PresumedRange ret;
+  FileID fileID = sourceManager.GetFileID(range.GetBegin());
+  if (fileID.IsInvalid()) {
+    return ret;
+  }
+  PresumedLoc begin = sourceManager.GetPresumedLoc(range.GetBegin());
+  ret.Line = ret.EndLine = begin.Line;
+  ret.Col = ret.EndCol = begin.Col;
+  if (sourceManager.GetFileID(range.GetEnd()) == fileID
+      && !(range.GetEnd() < range.GetBegin())) {
+    PresumedLoc end = sourceManager.GetPresumedLoc(range.GetEnd());
+    ret.EndLine = end.Line;
+    ret.EndCol = end.Col;
+  }
+  return ret;
+}
+
+void AppendLocation(std::string &out, std::string const& fileName,
+                    PresumedRange const& range) {
+  out += fileName;
+  out += ":(";
+  AppendNumber(out, range.Line);
+  out.push_back(',');
+  AppendNumber(out, range.Col);
+  out += "): ";
 }
 
-void
-DiagnosticEngine::DiagnosticInfo::Dump(
-    const std::string& fileName,
-    const std::vector<std::string>& codeLines) const noexcept {
-  using std::cerr;
-  using std::endl;
+void AppendSourceCode(std::string &out, SourceManager const& sourceManager,
+                      SourceRange const& range,
+                      PresumedRange const& presumed) {
+  if (presumed.Line == 0) {
+    out += "  <not-available> | Sorry, source info not implemented yet.\n\n";
+    return;
+  }
 
-  cerr << fileName << ':'
-       << "(" << m_SourceRanges.front().GetStartLine() << ','
-       << m_SourceRanges.front().GetStartCol() << "): ";
+  sona::string_view codeLine =
+      sourceManager.GetLine(sourceManager.GetFileID(range.GetBegin()),
+                            presumed.Line);
+  out.push_back(' ');
+  AppendNumber(out, presumed.Line, 5);
+  out += " | ";
+  out.append(codeLine.data(), codeLine.size());
+  out.push_back('\n');
 
-  switch (m_Rank) {
-  case DIR_Error:
-    cerr << "error: "; break;
-  case DIR_Warning0: case DIR_Warning1: case DIR_Warning2:
-    cerr << "warning: "; break;
-  case DIR_Note:
-    cerr << "note: "; break;
+  /// A range running on to later lines is marked up to the end of this one
+  std::uint32_t endCol = presumed.EndCol;
+  if (presumed.EndLine != presumed.Line) {
+    endCol = static_cast<std::uint32_t>(
+               1 + codeLine.size()
+               + 7 * std::count(codeLine.begin(), codeLine.end(), '\t'));
   }
+  out.append(9 + presumed.Col - 1, ' ');
+  if (endCol > presumed.Col) {
+    out.append(endCol - presumed.Col, '^');
+  }
+  out.push_back('\n');
+}
 
-  cerr << m_Messages.front();
-  cerr << endl;
+void AppendJSONString(std::string &out, sona::string_view str) {
+  static char const hexDigits[] = "0123456789abcdef";
+  out.push_back('"');
+  for (char ch : str) {
+    switch (ch) {
+    case '"': out += "\\\""; break;
+    case '\\': out += "\\\\"; break;
+    case '\n': out += "\\n"; break;
+    case '\r': out += "\\r"; break;
+    case '\t': out += "\\t"; break;
+    default:
+      if (static_cast<unsigned char>(ch) < 0x20) {
+        out += "\\u00";
+        out.push_back(hexDigits[(ch >> 4) & 0xF]);
+        out.push_back(hexDigits[ch & 0xF]);
+      }
+      else {
+        out.push_back(ch);
+      }
+    }
+  }
+  out.push_back('"');
+}
+
+void AppendJSONRange(std::string &out, PresumedRange const& range) {
+  out += "\"line\":";
+  AppendNumber(out, range.Line);
+  out += ",\"column\":";
+  AppendNumber(out, range.Col);
+  out += ",\"end_line\":";
+  AppendNumber(out, range.EndLine);
+  out += ",\"end_column\":";
+  AppendNumber(out, range.EndCol);
+}
 
-  PrintSourceCode(codeLines, m_SourceRanges.front());
+} // namespace
 
-  for (size_t i = 1; i < m_SDKs.size(); i++) {
-    cerr << fileName << ':'
-         << "(" << m_SourceRanges[i].GetStartLine() << ','
-         << m_SourceRanges[i].GetStartCol() << "): ";
+bool DiagnosticEngine::DiagnosticInfo::RendersBefore(
+    DiagnosticInfo const& other) const {
+  SourceLocation loc = m_SourceRanges.front().GetBegin();
+  SourceLocation otherLoc = other.m_SourceRanges.front().GetBegin();
+  if (loc != otherLoc) {
+    return loc < otherLoc;
+  }
+
+  Message const& message = m_Messages.front();
+  Message const& otherMessage = other.m_Messages.front();
+  if (message.Template != otherMessage.Template) {
+    return message.Template < otherMessage.Template;
+  }
+  if (message.Params != otherMessage.Params) {
+    return message.Params < otherMessage.Params;
+  }
+  if (message.Text != otherMessage.Text) {
+    return message.Text < otherMessage.Text;
+  }
+  return m_Rank < other.m_Rank;
+}
 
+void DiagnosticEngine::DiagnosticInfo::RenderText(
+    DiagnosticEngine const& engine, SourceManager const& sourceManager,
+    std::string &out) const {
+  for (std::size_t i = 0; i < m_SDKs.size(); i++) {
+    PresumedRange presumed = DecodeRange(sourceManager, m_SourceRanges[i]);
+    AppendLocation(out,
+                   engine.GetFileName(sourceManager,
+                                      m_SourceRanges[i].GetBegin()),
+                   presumed);
     switch (m_SDKs[i]) {
-    case SDK_Desc:
-      switch (m_Rank) {
-      case DIR_Error:
-        cerr << "error: "; break;
-      case DIR_Warning0: case DIR_Warning1: case DIR_Warning2:
-        cerr << "warning: "; break;
-      case DIR_Note:
-        cerr << "note: "; break;
-      }
-      break;
-    case SDK_Note: cerr << "note: "; break;
-    case SDK_Fixit: cerr << "fix hint: "; break;
+    case SDK_Desc: out += RankLabel(m_Rank); break;
+    case SDK_Note: out += "note"; break;
+    case SDK_Fixit: out += "fix hint"; break;
     }
+    out += ": ";
+    m_Messages[i].AppendTo(out);
+    out.push_back('\n');
+    AppendSourceCode(out, sourceManager, m_SourceRanges[i], presumed);
+  }
+}
 
-    cerr << m_Messages[i] << endl;
-    PrintSourceCode(codeLines, m_SourceRanges[i]);
+void DiagnosticEngine::DiagnosticInfo::RenderJSON(
+    DiagnosticEngine const& engine, SourceManager const& sourceManager,
+    std::string &out) const {
+  std::string message;
+  m_Messages.front().AppendTo(message);
+  out += "{\"file\":";
+  AppendJSONString(out,
+                   engine.GetFileName(sourceManager,
+                                      m_SourceRanges.front().GetBegin()));
+  out += ",\"severity\":\"";
+  out += RankLabel(m_Rank);
+  out += "\",";
+  AppendJSONRange(out, DecodeRange(sourceManager, m_SourceRanges.front()));
+  out += ",\"message\":";
+  AppendJSONString(out, message);
+  out += ",\"children\":[";
+  for (std::size_t i = 1; i < m_SDKs.size(); i++) {
+    if (i != 1) {
+      out.push_back(',');
+    }
+    out += "{\"kind\":\"";
+    switch (m_SDKs[i]) {
+    case SDK_Desc: out += RankLabel(m_Rank); break;
+    case SDK_Note: out += "note"; break;
+    case SDK_Fixit: out += "fix-it"; break;
+    }
+    out += "\",";
+    AppendJSONRange(out, DecodeRange(sourceManager, m_SourceRanges[i]));
+    message.clear();
+    m_Messages[i].AppendTo(message);
+    out += ",\"message\":";
+    AppendJSONString(out, message);
+    out.push_back('}');
   }
+  out += "]}\n";
 }
 
 } // namespace Diag
@@ -0,0 +1,63 @@
+#include "Basic/SourceBuffer.h"
+
+#include "sona/util.h"
+
+#include <limits>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace ckx {
+
+sona::owner<SourceBuffer>
+SourceBuffer::MapFile(std::string const& fileName) {
+  int fd = open(fileName.c_str(), O_RDONLY);
+  if (fd < 0) {
+    return nullptr;
+  }
+
+  struct stat st;
+  if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)
+      || static_cast<std::uint64_t>(st.st_size)
+           > std::numeric_limits<std::uint32_t>::max()) {
+    close(fd);
+    return nullptr;
+  }
+
+  SourceBuffer *ret = new SourceBuffer;
+  ret->m_BufferSize = static_cast<std::uint32_t>(st.st_size);
+  /// mmap refuses zero-length mappings, an empty file simply has no buffer
+  if (ret->m_BufferSize != 0) {
+    void *mapped = mmap(nullptr, ret->m_BufferSize, PROT_READ, MAP_PRIVATE,
+                        fd, 0);
+    if (mapped == MAP_FAILED) {
+      close(fd);
+      delete ret;
+      return nullptr;
+    }
+    madvise(mapped, ret->m_BufferSize, MADV_SEQUENTIAL);
+    ret->m_BufferStart = static_cast<char const*>(mapped);
+    ret->m_IsMapped = true;
+  }
+  close(fd);
+  return ret;
+}
+
+sona::owner<SourceBuffer> SourceBuffer::FromString(std::string &&source) {
+  sona_assert(source.size() <= std::numeric_limits<std::uint32_t>::max());
+  SourceBuffer *ret = new SourceBuffer;
+  ret->m_OwnedSource = std::move(source);
+  ret->m_BufferStart = ret->m_OwnedSource.data();
+  ret->m_BufferSize = static_cast<std::uint32_t>(ret->m_OwnedSource.size());
+  return ret;
+}
+
+SourceBuffer::~SourceBuffer() {
+  if (m_IsMapped) {
+    munmap(const_cast<char*>(m_BufferStart), m_BufferSize);
+  }
+}
+
+} // namespace ckx
@@ -0,0 +1,140 @@
+#include "Basic/SourceManager.h"
+
+#include "sona/util.h"
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+#if defined(__x86_64__) && defined(__GNUC__)
+#define CKX_LINESCAN_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace ckx {
+
+constexpr std::uint32_t SourceManager::FirstFileStart;
+
+namespace {
+
+/// Appends the offset following every '\n' in [begin, end), sixteen bytes
+/// at a time where SSE2 is available
+void CollectLineStarts(char const* begin, char const* end,
+                       std::vector<std::uint32_t> &lineStarts) {
+  char const *iter = begin;
+#ifdef CKX_LINESCAN_SSE2
+  __m128i const newline = _mm_set1_epi8('\n');
+  for (; end - iter >= 16; iter += 16) {
+    __m128i chunk = _mm_loadu_si128(reinterpret_cast<__m128i const*>(iter));
+    unsigned mask = static_cast<unsigned>(
+                      _mm_movemask_epi8(_mm_cmpeq_epi8(chunk, newline)));
+    while (mask != 0) {
+      std::uint32_t at = static_cast<std::uint32_t>(iter - begin)
+                         + static_cast<std::uint32_t>(__builtin_ctz(mask));
+      lineStarts.push_back(at + 1);
+      mask &= mask - 1;
+    }
+  }
+#endif
+  while (iter != end) {
+    void const *found = std::memchr(iter, '\n',
+                                    static_cast<std::size_t>(end - iter));
+    if (found == nullptr) {
+      break;
+    }
+    iter = static_cast<char const*>(found) + 1;
+    lineStarts.push_back(static_cast<std::uint32_t>(iter - begin));
+  }
+}
+
+} // namespace
+
+FileID SourceManager::OpenFile(std::string const& fileName) {
+  sona::owner<SourceBuffer> buffer = SourceBuffer::MapFile(fileName);
+  if (buffer.borrow() == nullptr) {
+    return FileID();
+  }
+  return AddFile(fileName, std::move(buffer));
+}
+
+FileID SourceManager::AddFile(std::string const& fileName,
+                              sona::owner<SourceBuffer> &&buffer) {
+  std::uint64_t end = std::uint64_t(m_NextFileStart)
+                      + buffer.borrow()->GetBufferSize() + 1;
+  if (end > std::numeric_limits<std::uint32_t>::max()) {
+    return FileID();
+  }
+
+  m_Files.emplace_back(fileName, std::move(buffer), m_NextFileStart);
+  m_FileStarts.push_back(m_NextFileStart);
+  m_NextFileStart = static_cast<std::uint32_t>(end);
+  return FileID(static_cast<std::uint32_t>(m_Files.size()));
+}
+
+SourceManager::FileEntry const&
+SourceManager::GetEntry(FileID fileID) const noexcept {
+  sona_assert(fileID.IsValid() && fileID.m_ID <= m_Files.size());
+  return m_Files[fileID.m_ID - 1];
+}
+
+FileID SourceManager::GetFileID(SourceLocation loc) const noexcept {
+  if (loc.IsInvalid() || loc.GetRawEncoding() >= m_NextFileStart) {
+    return FileID();
+  }
+  auto it = std::upper_bound(m_FileStarts.cbegin(), m_FileStarts.cend(),
+                             loc.GetRawEncoding());
+  return FileID(static_cast<std::uint32_t>(it - m_FileStarts.cbegin()));
+}
+
+std::uint32_t SourceManager::GetFileOffset(SourceLocation loc) const noexcept {
+  return loc.GetRawEncoding() - GetEntry(GetFileID(loc)).Start;
+}
+
+std::vector<std::uint32_t> const&
+SourceManager::GetLineStarts(FileEntry const& entry) const {
+  std::call_once(entry.LineTableOnce, [&entry] {
+    sona::ref_ptr<SourceBuffer const> buffer = entry.Buffer.borrow();
+    /// A guess at the average line length spares most reallocations
+    entry.LineStarts.reserve(buffer->GetBufferSize() / 32 + 1);
+    entry.LineStarts.push_back(0);
+    CollectLineStarts(buffer->GetBufferStart(), buffer->GetBufferEnd(),
+                      entry.LineStarts);
+  });
+  return entry.LineStarts;
+}
+
+std::uint32_t SourceManager::GetNumLines(FileID fileID) const {
+  return static_cast<std::uint32_t>(GetLineStarts(GetEntry(fileID)).size());
+}
+
+sona::string_view
+SourceManager::GetLine(FileID fileID, std::uint32_t line) const {
+  FileEntry const& entry = GetEntry(fileID);
+  std::vector<std::uint32_t> const& lineStarts = GetLineStarts(entry);
+  sona_assert(line >= 1 && line <= lineStarts.size());
+
+  std::uint32_t begin = lineStarts[line - 1];
+  std::uint32_t end = line < lineStarts.size()
+                      ? lineStarts[line] - 1
+                      : entry.Buffer.borrow()->GetBufferSize();
+  return sona::string_view(entry.Buffer.borrow()->GetBufferStart() + begin,
+                           end - begin);
+}
+
+PresumedLoc SourceManager::GetPresumedLoc(SourceLocation loc) const {
+  FileEntry const& entry = GetEntry(GetFileID(loc));
+  std::vector<std::uint32_t> const& lineStarts = GetLineStarts(entry);
+  std::uint32_t offset = loc.GetRawEncoding() - entry.Start;
+
+  auto it = std::upper_bound(lineStarts.cbegin(), lineStarts.cend(), offset);
+  std::uint32_t line = static_cast<std::uint32_t>(it - lineStarts.cbegin());
+  char const *lineBegin =
+      entry.Buffer.borrow()->GetBufferStart() + lineStarts[line - 1];
+  char const *pos = entry.Buffer.borrow()->GetBufferStart() + offset;
+  std::uint32_t col =
+      static_cast<std::uint32_t>(1 + (pos - lineBegin)
+                                 + 7 * std::count(lineBegin, pos, '\t'));
+  return PresumedLoc { &entry.FileName, line, col };
+}
+
+} // namespace ckx
@@ -1,6 +1,8 @@
 #include "Frontend/Lex.h"
 #include "Frontend/LexImpl.h"
 
+#include <limits>
+
 namespace ckx {
 namespace Frontend {
 
@@ -8,13 +10,76 @@ Lexer::Lexer(std::string &&sourceCode, Diag::DiagnosticEngine &diag)
   : m_LexerImpl(new LexerImpl(std::move(sourceCode), diag)) {
 }
 
-std::vector<Token> Lexer::GetAndReset() noexcept {
+Lexer::Lexer(sona::ref_ptr<SourceBuffer const> buffer,
+             Diag::DiagnosticEngine &diag)
+  : m_LexerImpl(new LexerImpl(buffer, diag)) {
+}
+
+Lexer::Lexer(SourceManager const& sourceManager, FileID fileID,
+             Diag::DiagnosticEngine &diag)
+  : m_LexerImpl(new LexerImpl(sourceManager.GetBuffer(fileID), diag)) {
+  m_LexerImpl.borrow()->SetFileStart(
+      sourceManager.GetLocForStartOfFile(fileID));
+}
+
+TokenBuffer Lexer::GetAndReset() noexcept {
   return m_LexerImpl.borrow()->GetAndReset();
 }
 
+TokenBuffer Lexer::LexInParallel(unsigned numThreads) {
+  return m_LexerImpl.borrow()->LexInParallel(numThreads);
+}
+
+Token Lexer::NextToken() {
+  return m_LexerImpl.borrow()->NextToken();
+}
+
 Lexer::~Lexer() {}
 
-std::vector<Token> LexerImpl::GetAndReset() noexcept {
+IncrementalLexer::IncrementalLexer(std::string &&sourceCode,
+                                   Diag::DiagnosticEngine &diag)
+  : m_Source(std::move(sourceCode)),
+    m_LexerImpl(new LexerImpl(sona::string_view(m_Source), diag)),
+    m_Tokens(m_LexerImpl.borrow()->GetAndReset()) {
+}
+
+sona::string_view IncrementalLexer::GetSource() const noexcept {
+  return sona::string_view(m_Source);
+}
+
+TokenBuffer const& IncrementalLexer::GetTokens() const noexcept {
+  return m_Tokens;
+}
+
+std::size_t IncrementalLexer::ApplyEdit(std::uint32_t offset,
+                                        std::uint32_t removedLength,
+                                        sona::string_view insertedText) {
+  sona_assert(offset + removedLength <= m_Source.size());
+  std::size_t newSize = m_Source.size() - removedLength + insertedText.size();
+  sona_assert(newSize <= std::numeric_limits<std::uint32_t>::max());
+
+  sona::string_view oldSource = GetSource();
+  if (newSize <= m_Source.capacity()) {
+    m_Source.replace(offset, removedLength,
+                     insertedText.data(), insertedText.size());
+  }
+  else {
+    /// Out of room, leave some for the edits to come
+    std::string text;
+    text.reserve(newSize * 2);
+    text.append(m_Source, 0, offset);
+    text.append(insertedText.data(), insertedText.size());
+    text.append(m_Source, offset + removedLength, std::string::npos);
+    m_Source.swap(text);
+  }
+  return m_LexerImpl.borrow()->Relex(m_Tokens, oldSource, GetSource(),
+                                     offset, removedLength);
+}
+
+IncrementalLexer::~IncrementalLexer() {}
+
+TokenBuffer LexerImpl::GetAndReset() noexcept {
+  LexAllTokens();
   return std::move(m_TokenStream);
 }
 
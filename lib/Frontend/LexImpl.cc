@@ -1,29 +1,409 @@
 #include "Frontend/Lex.h"
 #include "Frontend/LexImpl.h"
+#include "Frontend/LexNumber.h"
+#include "Frontend/LexScan.h"
+#include "Frontend/TokenTables.h"
 
-#include <sstream>
+#include <algorithm>
+#include <array>
 #include <cctype>
-#include <cmath>
+#include <cstring>
+#include <iterator>
+#include <limits>
+#include <thread>
 
 namespace ckx {
 namespace Frontend {
 
 void LexerImpl::LexAllTokens() {
-  while (CurChar() != '\0') {
-    switch (CurChar()) {
-    case 'a': case 'b': case 'c': case 'd': case 'e': case 'f':
-    case 'h': case 'i': case 'n': case 'q': case 'r': case 's':
-    case 't': case 'u':  case 'v':
-      LexIdOrKeyword();
+  while (!m_ReachedEOI) {
+    LexNextToken();
+  }
+}
+
+void LexerImpl::LexUntil(std::uint32_t end) {
+  do {
+    LexNextToken();
+  } while (!m_ReachedEOI
+           && m_TokenStream.GetOffset(m_TokenStream.size() - 1) < end);
+}
+
+namespace {
+
+/// Below this, threads cost more than they save
+constexpr std::uint32_t MinChunkSize = 256 * 1024;
+
+/// Where the lexer stands with respect to char and string literals, the
+/// only tokens a newline may be part of
+enum LiteralState : std::uint8_t {
+  LS_Code, LS_Str, LS_StrEscape, LS_Char, LS_CharEscape, LS_CharEnd,
+  LS_NumStates
+};
+
+using LiteralStateMap = std::array<LiteralState, LS_NumStates>;
+
+/// Mirrors LexChar and LexString, including their error recovery: a char
+/// literal missing its closing quote simply ends
+LiteralState StepLiteralState(LiteralState state, char ch) noexcept {
+  switch (state) {
+  case LS_Code:
+    return ch == '"' ? LS_Str : (ch == '\'' ? LS_Char : LS_Code);
+  case LS_Str:
+    return ch == '"' ? LS_Code : (ch == '\\' ? LS_StrEscape : LS_Str);
+  case LS_StrEscape:
+    return LS_Str;
+  case LS_Char:
+    return ch == '\\' ? LS_CharEscape : LS_CharEnd;
+  case LS_CharEscape:
+    return LS_CharEnd;
+  case LS_CharEnd:
+    return ch == '\'' ? LS_Code : StepLiteralState(LS_Code, ch);
+  default:
+    sona_unreachable();
+  }
+  return LS_Code;
+}
+
+/// @return the state at end for every state at begin
+LiteralStateMap
+ScanLiteralStates(char const* begin, char const* end) noexcept {
+  LiteralStateMap states;
+  for (std::size_t i = 0; i < LS_NumStates; i++) {
+    states[i] = static_cast<LiteralState>(i);
+  }
+
+  /// Once every state is in code or in a string, only quotes and
+  /// backslashes can change them
+  bool settled = false;
+  for (char const *iter = begin; iter != end; ++iter) {
+    char ch = *iter;
+    if (settled && ch != '"' && ch != '\'' && ch != '\\') {
+      continue;
+    }
+    settled = true;
+    for (LiteralState &state : states) {
+      state = StepLiteralState(state, ch);
+      settled = settled && (state == LS_Code || state == LS_Str);
+    }
+  }
+  return states;
+}
+
+template <typename Fn> void ParallelFor(std::size_t count, Fn const& fn) {
+  std::vector<std::thread> workers;
+  for (std::size_t i = 1; i < count; i++) {
+    workers.emplace_back(fn, i);
+  }
+  fn(0);
+  for (std::thread &worker : workers) {
+    worker.join();
+  }
+}
+
+} // namespace
+
+TokenBuffer LexerImpl::LexInParallel(unsigned numThreads) {
+  sona_assert(m_Index == 0 && m_TokenStream.empty());
+
+  std::vector<std::uint32_t> chunkStarts { 0 };
+  std::size_t wanted = std::min<std::size_t>(numThreads,
+                                             m_SourceSize / MinChunkSize);
+  for (std::size_t i = 1; i < wanted; i++) {
+    std::uint32_t target = static_cast<std::uint32_t>(
+        static_cast<std::uint64_t>(m_SourceSize) * i / wanted);
+    target = std::max(target, chunkStarts.back());
+    void const *newLine = std::memchr(m_Source + target, '\n',
+                                      m_SourceSize - target);
+    if (newLine == nullptr) {
+      break;
+    }
+    std::uint32_t start = static_cast<std::uint32_t>(
+        static_cast<char const*>(newLine) - m_Source) + 1;
+    if (start < m_SourceSize) {
+      chunkStarts.push_back(start);
+    }
+  }
+  std::size_t numChunks = chunkStarts.size();
+  chunkStarts.push_back(m_SourceSize);
+  if (numChunks == 1) {
+    return GetAndReset();
+  }
+
+  /// One pass over every chunk, in parallel, tells for each literal state
+  /// at its start which state it ends in. Chaining these from the start of
+  /// the file finds the true state at every chunk start without lexing
+  /// anything.
+  std::vector<LiteralStateMap> endStates(numChunks);
+  ParallelFor(numChunks, [&](std::size_t i) {
+    endStates[i] = ScanLiteralStates(m_Source + chunkStarts[i],
+                                     m_Source + chunkStarts[i + 1]);
+  });
+
+  /// A chunk starting inside a literal moves on to the first line start
+  /// behind it, or is dropped if the literal runs through the whole chunk
+  std::vector<std::uint32_t> starts;
+  LiteralState state = LS_Code;
+  for (std::size_t i = 0; i < numChunks; i++) {
+    std::uint32_t start = chunkStarts[i];
+    if (state != LS_Code) {
+      LiteralState s = state;
+      for (; start < chunkStarts[i + 1]; start++) {
+        s = StepLiteralState(s, m_Source[start]);
+        if (m_Source[start] == '\n' && s == LS_Code) {
+          ++start;
+          break;
+        }
+      }
+    }
+    if (start < chunkStarts[i + 1]) {
+      starts.push_back(start);
+    }
+    state = endStates[i][state];
+  }
+  numChunks = starts.size();
+  starts.push_back(m_SourceSize);
+
+  /// Chunk starts are now token boundaries of the serial lexer, up to
+  /// whatever the literal scan misses (a stray NUL ends lexing early, for
+  /// one), so the tokens and diagnostics of every chunk are checked
+  /// against the chunk before it all the same. Every chunk records into
+  /// m_Diag from its own thread, front to back, and tags its diagnostics
+  /// with the chunk and the token they come from.
+  std::vector<sona::owner<LexerImpl>> chunkLexers;
+  for (std::size_t i = 0; i < numChunks; i++) {
+    chunkLexers.emplace_back(
+        new LexerImpl(sona::string_view(m_Source, m_SourceSize), m_Diag));
+    chunkLexers.back().borrow()->m_Index = starts[i];
+    chunkLexers.back().borrow()->m_DiagTag =
+        static_cast<std::uint64_t>(i + 1) << 32;
+    chunkLexers.back().borrow()->SetFileStart(m_TokenStream.GetFileStart());
+  }
+  ParallelFor(numChunks, [&](std::size_t i) {
+    chunkLexers[i].borrow()->LexUntil(starts[i + 1]);
+    if (i != 0) {
+      m_Diag.DetachThread();
+    }
+  });
+
+  /// The last token of the active chunk is held back until the next chunk
+  /// has a token starting at the same offset. From there on both lex the
+  /// same text the same way, and the next chunk takes over. Until then the
+  /// active chunk keeps lexing, serially. Every chunk contributes one run
+  /// of its tokens, possibly an empty one.
+  std::vector<std::pair<std::size_t, std::size_t>> runs(numChunks);
+  std::size_t active = 0, activeFirst = 0;
+  for (std::size_t i = 1; i < numChunks; i++) {
+    TokenBuffer const& next = chunkLexers[i].borrow()->m_TokenStream;
+    for (;;) {
+      TokenBuffer const& held = chunkLexers[active].borrow()->m_TokenStream;
+      std::uint32_t heldOffset = held.GetOffset(held.size() - 1);
+      std::size_t match = next.LowerBound(heldOffset);
+      if (match == next.size()) {
+        break;
+      }
+      if (next.GetOffset(match) == heldOffset) {
+        runs[active] = std::make_pair(activeFirst, held.size() - 1);
+        active = i;
+        activeFirst = match;
+        break;
+      }
+      if (held.GetTokenKind(held.size() - 1) == Token::TK_EOI) {
+        break;
+      }
+      chunkLexers[active].borrow()->LexNextToken();
+    }
+  }
+  m_Diag.SetThreadTag(0);
+  runs[active] = std::make_pair(
+      activeFirst, chunkLexers[active].borrow()->m_TokenStream.size());
+
+  TokenBuffer ret;
+  ret.SetFileStart(m_TokenStream.GetFileStart());
+  ret.SetSource(sona::string_view(m_Source, m_SourceSize));
+  for (std::size_t i = 0; i < numChunks; i++) {
+    ret.Append(chunkLexers[i].borrow()->m_TokenStream,
+               runs[i].first, runs[i].second);
+  }
+  sona_assert(ret.GetTokenKind(ret.size() - 1) == Token::TK_EOI);
+
+  /// Where in the token limit cuts off only the serial lexer knows, it
+  /// lexes the file again with none of the diagnostics of the chunks kept
+  if (m_Diag.GetBudget().TokensExceeded(ret.size())) {
+    m_Diag.DiscardTagged([](std::uint64_t) { return true; });
+    return GetAndReset();
+  }
+
+  /// A chunk keeps the diagnostics of the tokens it contributes, and of
+  /// the text skipped behind them: those coming from offsets at or past
+  /// its first token and before the first token of the next chunk
+  /// contributing any. The first to contribute keeps all before it.
+  std::vector<std::uint32_t> keepBegin(numChunks, 0), keepEnd(numChunks, 0);
+  std::uint32_t end = std::numeric_limits<std::uint32_t>::max();
+  std::size_t firstContributing = numChunks;
+  for (std::size_t i = numChunks; i-- != 0;) {
+    if (runs[i].first == runs[i].second) {
+      continue;
+    }
+    TokenBuffer const& tokens = chunkLexers[i].borrow()->m_TokenStream;
+    keepBegin[i] = tokens.GetOffset(runs[i].first);
+    keepEnd[i] = end;
+    end = keepBegin[i];
+    firstContributing = i;
+  }
+  keepBegin[firstContributing] = 0;
+  m_Diag.DiscardTagged([&](std::uint64_t tag) {
+    std::size_t chunk = static_cast<std::size_t>(tag >> 32) - 1;
+    std::uint32_t offset = static_cast<std::uint32_t>(tag);
+    return offset < keepBegin[chunk] || offset >= keepEnd[chunk];
+  });
+
+  /// Out of budget the serial lexer has stopped somewhere, and so has
+  /// the compile
+  if (m_Diag.GetBudget().IsExhausted()) {
+    return GetAndReset();
+  }
+
+  m_ChunkDecodedStrings.reserve(numChunks);
+  for (auto &lexer : chunkLexers) {
+    m_ChunkDecodedStrings.push_back(
+        std::move(lexer.borrow()->m_DecodedStrings));
+  }
+  m_Index = m_SourceSize;
+  m_ReachedEOI = true;
+  return ret;
+}
+
+Token LexerImpl::NextToken() {
+  sona_assert(m_TokenStream.empty());
+  if (m_ReachedEOI) {
+    m_TokenStream.EmplaceToken(Token::TK_EOI, CurCharRange());
+  }
+  else {
+    LexNextToken();
+  }
+  Token ret = m_TokenStream[0];
+  m_TokenStream.clear();
+  return ret;
+}
+
+namespace {
+
+/// LexNumber reads an 'e', its sign and the digit after them before
+/// deciding whether an exponent follows
+constexpr std::uint32_t NumberLookahead = 3;
+
+/// How far past its end the lexer may look to finish a token. Identifiers
+/// read one character further, operators as far as the DFA of Tokens.def
+/// walks.
+constexpr std::uint32_t MaxLookahead =
+    std::max(NumberLookahead,
+             static_cast<std::uint32_t>(SymbolTable.GetMaxLookahead()));
+
+} // namespace
+
+std::size_t LexerImpl::Relex(TokenBuffer &tokens,
+                             sona::string_view oldSource,
+                             sona::string_view newSource,
+                             std::uint32_t offset,
+                             std::uint32_t removedLength) {
+  sona_assert(!tokens.empty());
+  sona_assert(offset + removedLength <= oldSource.size());
+
+  std::uint32_t oldEditEnd = offset + removedLength;
+  std::int64_t delta = static_cast<std::int64_t>(newSource.size())
+                       - static_cast<std::int64_t>(oldSource.size());
+  std::uint32_t newEditEnd = static_cast<std::uint32_t>(oldEditEnd + delta);
+
+  /// The token the edit falls into or right behind may change, and so may
+  /// any token whose lookahead reaches the edit. Tokens have no context
+  /// beyond that, lexing can restart at the start of any earlier token.
+  std::size_t first = tokens.LowerBound(offset);
+  if (first != 0) {
+    --first;
+  }
+  while (first != 0 && tokens.GetOffset(first) + MaxLookahead >= offset) {
+    --first;
+  }
+
+  /// Text slicing the source is found through the token, so it follows
+  /// the source wherever the edit put it
+  tokens.SetSource(newSource);
+  m_TokenStream.SetSource(newSource);
+
+  m_Source = newSource.data();
+  m_SourceSize = static_cast<std::uint32_t>(newSource.size());
+  m_ReachedEOI = false;
+  m_TokenStream.clear();
+  m_NumTokens = first;
+  m_Index = first == 0 ? 0 : tokens.GetOffset(first);
+
+  /// Once a new token starts behind the edit exactly where an old one did,
+  /// both see the same text from there on and the old tokens are reused.
+  /// The end of input resynchronizes at the latest.
+  std::size_t last = first;
+  for (;;) {
+    LexNextToken();
+    if (m_ReachedEOI) {
+      /// Possibly early, at a NUL byte or once out of budget, so nothing
+      /// old behind the edit is kept: the new end of input replaces it all
+      last = tokens.size() - 1;
       break;
+    }
+
+    std::size_t lexed = m_TokenStream.size() - 1;
+    std::uint32_t newStart = m_TokenStream.GetOffset(lexed);
+    if (newStart < newEditEnd) {
+      continue;
+    }
 
-    case 'g': case 'j': case 'k': case 'l': case 'm': case 'o': case 'p':
-    case 'w': case 'x': case 'y': case 'z':
+    std::int64_t oldStart = newStart - delta;
+    while (last < tokens.size() && tokens.GetOffset(last) < oldStart) {
+      ++last;
+    }
+    if (last < tokens.size() && tokens.GetOffset(last) == oldStart) {
+      break;
+    }
+  }
+
+  /// The resynchronizing token is kept from the new run, its old copy goes
+  for (std::size_t i = first; i <= last; i++) {
+    if (tokens.GetTokenKind(i) == Token::TK_LIT_STR) {
+      ReleaseDecoded(tokens[i].GetStrViewUnsafe().data());
+    }
+  }
+  tokens.Splice(first, last + 1, m_TokenStream);
+  tokens.ShiftTokens(first + m_TokenStream.size(), delta);
+
+  std::size_t numRelexed = m_TokenStream.size();
+  m_TokenStream.clear();
+  return numRelexed;
+}
+
+void LexerImpl::LexNextToken() {
+  std::size_t numTokens = m_TokenStream.size();
+  ++m_NumTokens;
+  while (m_TokenStream.size() == numTokens) {
+    if (CurChar() == '\0' || OutOfBudget()) {
+      m_TokenStart = m_Index;
+      m_TokenStream.EmplaceToken(Token::TK_EOI, CurCharRange());
+      m_ReachedEOI = true;
+      return;
+    }
+
+    m_TokenStart = m_Index;
+    if (m_DiagTag != 0) {
+      m_Diag.SetThreadTag(m_DiagTag | m_TokenStart);
+    }
+    switch (CurChar()) {
+    case 'a': case 'b': case 'c': case 'd': case 'e': case 'f': case 'g':
+    case 'h': case 'i': case 'j': case 'k': case 'l': case 'm': case 'n':
+    case 'o': case 'p': case 'q': case 'r': case 's': case 't': case 'u':
+    case 'v': case 'w': case 'x': case 'y': case 'z':
     case 'A': case 'B': case 'C': case 'D': case 'E': case 'F': case 'G':
-    case 'I': case 'J': case 'K': case 'L': case 'M': case 'N': case 'O':
-    case 'P': case 'Q': case 'R': case 'S': case 'T': case 'U': case 'V':
-    case 'W': case 'X': case 'Y': case 'Z':
-      LexIdentifier();
+    case 'H': case 'I': case 'J': case 'K': case 'L': case 'M': case 'N':
+    case 'O': case 'P': case 'Q': case 'R': case 'S': case 'T': case 'U':
+    case 'V': case 'W': case 'X': case 'Y': case 'Z':
+      LexIdOrKeyword();
       break;
 
     case '0':
@@ -51,166 +431,220 @@ void LexerImpl::LexAllTokens() {
       LexString();
       break;
 
-    case '{': case '}': case '(': case ')': case ',': case ';': case ':':
-    case '[': case ']': case '=': case '.': case '+': case '-': case '*':
-    case '&': case '<': case '>': case '!': case '~': case '^': case '/':
-    case '%': case '|':
-      LexSymbol();
-      break;
-
-    case ' ': case '\t': case '\v': case '\f': case '\n':
+    case ' ': case '\t': case '\v': case '\f': case '\n': case '\r':
       SkipWhitespace();
       break;
 
     default:
+      if (LexSymbol()) {
+        break;
+      }
+
       m_Diag.Diag(Diag::DIR_Error,
-                  Diag::Format(Diag::DMT_ErrUnexpectedChar,
-                               { std::to_string(CurChar()) }),
+                  Diag::DMT_ErrUnexpectedChar,
+                  { std::to_string(CurChar()) },
                   CurCharRange());
       NextChar();
     }
   }
+}
 
-  m_TokenStream.emplace_back(Token::TK_EOI, CurCharRange());
+bool LexerImpl::OutOfBudget() {
+  if (m_DiagTag == 0 && m_Diag.GetBudget().TokensExceeded(m_NumTokens)) {
+    m_Diag.ExhaustBudget(CompileBudget::R_Tokens, CurCharRange());
+  }
+  return m_Diag.CheckBudget(CurCharRange());
 }
 
 void LexerImpl::LexIdOrKeyword() {
-  static std::unordered_map<std::string, Token::TokenKind> KeywordMaps
-  {
-    #define TOKEN_KWD(name, rep) {rep, Token::TK_KW_##name},
-    #include "Frontend/Tokens.def"
-    {"$(40490fd0)$", Token::TK_INVALID}
-  };
-
-  std::uint16_t col1 = GetCol();
-  std::string str = ScanIdString();
-
-  auto it = KeywordMaps.find(str);
-  if (it != KeywordMaps.cend()) {
-    m_TokenStream.emplace_back(it->second,
-                               SourceRange(GetLine(), col1, GetCol()), str);
+  char const *idStart = CurCharPtr();
+  SkipIdString();
+  std::size_t length = static_cast<std::size_t>(CurCharPtr() - idStart);
+
+  Token::TokenKind keyword = KeywordTable.Classify(idStart, length);
+  if (keyword != Token::TK_INVALID) {
+    m_TokenStream.EmplaceToken(keyword, TokenRange());
     return;
   }
 
-  m_TokenStream.emplace_back(Token::TK_ID,
-                             SourceRange(GetLine(), col1, GetCol()), str);
+  m_TokenStream.EmplaceToken(Token::TK_ID, TokenRange(),
+                             sona::string_view(idStart, length));
 }
 
 void LexerImpl::LexNumber() {
-  std::uint16_t col1 = GetCol();
-  int64_t integralPart = ScanInt();
+  char const *litStart = CurCharPtr();
+  char const *intEnd = ScanDigitRunInline(litStart, SourceEnd());
+  SkipTo(intEnd);
 
   if (CurChar() != '.' && CurChar() != 'E' && CurChar() != 'e') {
-    m_TokenStream.emplace_back(Token::TK_LIT_INT,
-                               SourceRange(GetLine(), col1, GetCol()),
-                               integralPart);
+    std::uint64_t value;
+    bool fits = DecodeDecimal(litStart, intEnd, value);
+    FinishIntLiteral(litStart, fits, value);
     return;
   }
 
-  double floatingPart = static_cast<double>(integralPart);
+  char const *fracBegin = intEnd, *fracEnd = intEnd;
   if (CurChar() == '.') {
-    if (!isdigit(PeekOneChar())) {
-      m_Diag.Diag(Diag::DIR_Error, Diag::Format(Diag::DMT_ErrExpectedDigit, {}),
-                  SourceRange(GetLine(), GetCol(), GetCol() + 1));
-      m_TokenStream.emplace_back(Token::TK_LIT_FLOAT,
-                                 SourceRange(GetLine(), col1, GetCol()),
-                                 floatingPart);
+    if (!std::isdigit(PeekOneChar())) {
+      m_Diag.Diag(Diag::DIR_Error, Diag::DMT_ErrExpectedDigit, {},
+                  CurCharRange());
+      FinishFloatLiteral(litStart, intEnd, fracBegin, fracEnd, 0);
       return;
     }
 
     NextChar();
-    double r = static_cast<double>(ScanInt());
-    while (r > 1) {
-      r = r / 10;
-    }
-    floatingPart += r;
+    fracBegin = CurCharPtr();
+    fracEnd = ScanDigitRunInline(fracBegin, SourceEnd());
+    SkipTo(fracEnd);
   }
 
+  std::int64_t exponent = 0;
   if (CurChar() == 'e' || CurChar() == 'E') {
-    if (!isdigit(PeekOneChar())) {
+    bool negative = PeekOneChar() == '-';
+    char const *expBegin =
+        CurCharPtr() + ((negative || PeekOneChar() == '+') ? 2 : 1);
+    if (expBegin >= SourceEnd()
+        || !std::isdigit(static_cast<unsigned char>(*expBegin))) {
       m_Diag.Diag(Diag::DIR_Error,
-                  Diag::Format(Diag::DMT_ErrExpectedDigit, {}),
-                  SourceRange(GetLine(), GetCol(), GetCol() + 1));
-      m_TokenStream.emplace_back(Token::TK_LIT_FLOAT,
-                                 SourceRange(GetLine(), col1, GetCol()),
-                                 floatingPart);
+                  Diag::DMT_ErrExpectedDigit, {},
+                  CurCharRange());
+      FinishFloatLiteral(litStart, intEnd, fracBegin, fracEnd, 0);
       return;
     }
 
-    NextChar();
-    uint64_t exp = ScanInt();
-    floatingPart *= std::pow(10, exp);
+    char const *expEnd = ScanDigitRunInline(expBegin, SourceEnd());
+    SkipTo(expEnd);
+    /// Saturates far beyond where any double over- or underflows
+    for (char const *iter = expBegin; iter != expEnd; ++iter) {
+      if (exponent < 100000000) {
+        exponent = exponent * 10 + (*iter - '0');
+      }
+    }
+    if (negative) {
+      exponent = -exponent;
+    }
   }
 
-  m_TokenStream.emplace_back(Token::TK_LIT_FLOAT,
-                             SourceRange(GetLine(), col1, GetCol()),
-                             floatingPart);
+  FinishFloatLiteral(litStart, intEnd, fracBegin, fracEnd, exponent);
 }
 
 void LexerImpl::LexBinNumber() {
   sona_assert(CurChar() == '0' &&
-              (PeekOneChar() == 'x' || PeekOneChar() == 'X'));
-  std::uint16_t col1 = GetCol();
+              (PeekOneChar() == 'b' || PeekOneChar() == 'B'));
+  char const *litStart = CurCharPtr();
   NextChar();
   NextChar();
 
-  int64_t value = 0;
-  while (CurChar() == '0' || CurChar() == '1') {
-    value *= 2;
-    value += CurChar() - '0';
-  }
-
-  if (isalnum(CurChar()) || CurChar() == '_') {
-    m_Diag.Diag(Diag::DIR_Error,
-                Diag::Format(
-                  Diag::DMT_ErrUnexpectedCharInContext,
-                  { std::to_string(CurChar()), "binary number" }),
-                CurCharRange());
-    while (CurChar() != '\0' && (isdigit(CurChar()) || isalpha(CurChar()))) {
-      NextChar();
-    }
+  char const *digitStart = CurCharPtr();
+  char const *digitEnd = digitStart;
+  while (digitEnd != SourceEnd() && (*digitEnd == '0' || *digitEnd == '1')) {
+    ++digitEnd;
   }
+  SkipTo(digitEnd);
 
-  m_TokenStream.emplace_back(Token::TK_LIT_INT,
-                             SourceRange(GetLine(), col1, GetCol()), value);
+  std::uint64_t value = 0;
+  bool fits = DecodeBinary(digitStart, digitEnd, value);
+  SkipJunkAfterNumber(digitStart == digitEnd, "binary number");
+  FinishIntLiteral(litStart, fits, value);
 }
 
 void LexerImpl::LexHexNumber() {
   sona_assert(CurChar() == '0' &&
-              (PeekOneChar() == 'b' || PeekOneChar() == 'B'));
-  std::uint16_t col1 = GetCol();
+              (PeekOneChar() == 'x' || PeekOneChar() == 'X'));
+  char const *litStart = CurCharPtr();
   NextChar();
   NextChar();
 
-  int64_t value = 0;
-  while (isxdigit(CurChar())) {
-    value *= 16;
-    if (isalpha(CurChar())) {
-      value += (std::toupper(CurChar()) - 'A') + 10;
-    }
-    else {
-      value += CurChar() - '0';
-    }
+  char const *digitStart = CurCharPtr();
+  char const *digitEnd = digitStart;
+  while (digitEnd != SourceEnd()
+         && std::isxdigit(static_cast<unsigned char>(*digitEnd))) {
+    ++digitEnd;
+  }
+  SkipTo(digitEnd);
+
+  std::uint64_t value = 0;
+  bool fits = DecodeHex(digitStart, digitEnd, value);
+  SkipJunkAfterNumber(digitStart == digitEnd, "hex number");
+  FinishIntLiteral(litStart, fits, value);
+}
+
+void LexerImpl::SkipJunkAfterNumber(bool noDigits, char const* context) {
+  if (noDigits) {
+    m_Diag.Diag(Diag::DIR_Error, Diag::DMT_ErrExpectedDigit, {},
+                CurCharRange());
+  }
+
+  if (CurChar() == 'u' || CurChar() == 'U') {
+    return;
   }
 
-  if (isalpha(CurChar()) || CurChar() == '_') {
+  if (std::isalnum(CurChar()) || CurChar() == '_') {
     m_Diag.Diag(Diag::DIR_Error,
-                Diag::Format(
-                  Diag::DMT_ErrUnexpectedCharInContext,
-                  { std::to_string(CurChar()), "hex number" }),
+                Diag::DMT_ErrUnexpectedCharInContext,
+                { std::string(1, CurChar()), context },
                 CurCharRange());
-    while (CurChar() != '\0' && (isdigit(CurChar()) || isalpha(CurChar()))) {
+    while (std::isalnum(CurChar())) {
       NextChar();
     }
   }
+}
+
+void LexerImpl::FinishIntLiteral(char const* litStart, bool fits,
+                                 std::uint64_t value) {
+  bool isUnsigned = CurChar() == 'u' || CurChar() == 'U';
+  if (isUnsigned) {
+    NextChar();
+  }
+
+  SourceRange range = TokenRange();
+  std::uint64_t limit =
+      isUnsigned ? std::numeric_limits<std::uint64_t>::max()
+                 : static_cast<std::uint64_t>(
+                       std::numeric_limits<std::int64_t>::max());
+  if (!fits || value > limit) {
+    m_Diag.Diag(Diag::DIR_Error,
+                Diag::DMT_ErrLiteralOutOfRange, {
+                  "integral",
+                  sona::string_view(litStart, static_cast<std::size_t>(
+                                        CurCharPtr() - litStart)),
+                  isUnsigned ? "uint64" : "int64"
+                },
+                range);
+    value = limit;
+  }
 
-  m_TokenStream.emplace_back(Token::TK_LIT_INT,
-                             SourceRange(GetLine(), col1, GetCol()), value);
+  if (isUnsigned) {
+    m_TokenStream.EmplaceToken(Token::TK_LIT_UINT, range, value);
+  }
+  else {
+    m_TokenStream.EmplaceToken(Token::TK_LIT_INT, range,
+                               static_cast<std::int64_t>(value));
+  }
+}
+
+void LexerImpl::FinishFloatLiteral(char const* litStart,
+                                   char const* intEnd,
+                                   char const* fracBegin,
+                                   char const* fracEnd,
+                                   std::int64_t exponent) {
+  SourceRange range = TokenRange();
+  double value;
+  if (!DecodeFloat(litStart, intEnd, fracBegin, fracEnd, exponent, value)) {
+    m_Diag.Diag(Diag::DIR_Error,
+                Diag::DMT_ErrLiteralOutOfRange, {
+                  "floating",
+                  sona::string_view(litStart, static_cast<std::size_t>(
+                                        CurCharPtr() - litStart)),
+                  "double"
+                },
+                range);
+  }
+  m_TokenStream.EmplaceToken(Token::TK_LIT_FLOAT, range, value);
 }
 
 void LexerImpl::LexChar() {
   sona_assert(CurChar() == '\'');
-  std::uint16_t col1 = GetCol();
   NextChar();
   char ch = '\0';
   if (CurChar() == '\\') {
@@ -227,313 +661,179 @@ void LexerImpl::LexChar() {
     case '\\': ch = '\\'; NextChar(); NextChar(); break;
     default:
       m_Diag.Diag(Diag::DIR_Warning0,
-                  Diag::Format(Diag::DMT_WarnInvalidConversion,
-                               { std::to_string(PeekOneChar()) }),
-                  SourceRange(GetLine(), GetCol()+1, GetCol()+2));
+                  Diag::DMT_WarnInvalidConversion,
+                  { std::to_string(PeekOneChar()) },
+                  RangeAt(m_Index + 1, m_Index + 2));
       ch = CurChar();
-      NextChar(); NextChar();
+      SkipEscape();
     }
   }
-  else {
+  else if (CurChar() != '\0') {
     ch = CurChar();
     NextChar();
   }
 
   if (CurChar() != '\'') {
     m_Diag.Diag(Diag::DIR_Error,
-                Diag::Format(Diag::DMT_ErrExpectedCharGot,
-                             {std::to_string(CurChar()), "'"}),
-                SourceRange(GetLine(), GetCol(), GetCol()));
+                Diag::DMT_ErrExpectedCharGot,
+                {std::to_string(CurChar()), "'"},
+                RangeAt(m_Index, m_Index));
   }
   else {
     NextChar();
   }
 
-  m_TokenStream.emplace_back(Token::TK_LIT_CHAR,
-                             SourceRange(GetLine(), col1, GetCol()), ch);
+  m_TokenStream.EmplaceToken(Token::TK_LIT_CHAR, TokenRange(), ch);
 }
 
 void LexerImpl::LexString() {
   sona_assert(CurChar() == '"');
-  std::uint16_t col1 = GetCol();
   NextChar();
 
-  std::string str;
-  while (CurChar() != '\0' && CurChar() != '"') {
-    if (CurChar() == '\\') {
-      switch (PeekOneChar()) {
-      case 'a': str.push_back('\a'); NextChar(); NextChar(); break;
-      case 'b': str.push_back('\b'); NextChar(); NextChar(); break;
-      case 'n': str.push_back('\n'); NextChar(); NextChar(); break;
-      case 'r': str.push_back('\r'); NextChar(); NextChar(); break;
-      case 'v': str.push_back('\v'); NextChar(); NextChar(); break;
-      case 't': str.push_back('\t'); NextChar(); NextChar(); break;
-      case 'f': str.push_back('\f'); NextChar(); NextChar(); break;
-      case '"': str.push_back('"');  NextChar(); NextChar(); break;
-      case '0': str.push_back('\0'); NextChar(); NextChar(); break;
-      case '\\': str.push_back('\\'); NextChar(); NextChar(); break;
-      default:
-        m_Diag.Diag(Diag::DIR_Warning0,
-                    Diag::Format(Diag::DMT_WarnInvalidConversion,
-                                 { std::to_string(PeekOneChar()) }),
-                    SourceRange(GetLine(), GetCol()+1, GetCol()+2));
-        str.push_back(CurChar());
-        str.push_back(PeekOneChar());
-        NextChar(); NextChar();
+  char const *textStart = CurCharPtr();
+  while (CurChar() != '\0' && CurChar() != '"' && CurChar() != '\\') {
+    NextChar();
+  }
+
+  sona::string_view text(textStart,
+                         static_cast<std::size_t>(CurCharPtr() - textStart));
+  if (CurChar() == '\\') {
+    std::string str(textStart, CurCharPtr());
+    while (CurChar() != '\0' && CurChar() != '"') {
+      if (CurChar() == '\\') {
+        switch (PeekOneChar()) {
+        case 'a': str.push_back('\a'); NextChar(); NextChar(); break;
+        case 'b': str.push_back('\b'); NextChar(); NextChar(); break;
+        case 'n': str.push_back('\n'); NextChar(); NextChar(); break;
+        case 'r': str.push_back('\r'); NextChar(); NextChar(); break;
+        case 'v': str.push_back('\v'); NextChar(); NextChar(); break;
+        case 't': str.push_back('\t'); NextChar(); NextChar(); break;
+        case 'f': str.push_back('\f'); NextChar(); NextChar(); break;
+        case '"': str.push_back('"');  NextChar(); NextChar(); break;
+        case '0': str.push_back('\0'); NextChar(); NextChar(); break;
+        case '\\': str.push_back('\\'); NextChar(); NextChar(); break;
+        default:
+          m_Diag.Diag(Diag::DIR_Warning0,
+                      Diag::DMT_WarnInvalidConversion,
+                      { std::to_string(PeekOneChar()) },
+                      RangeAt(m_Index + 1, m_Index + 2));
+          str.push_back(CurChar());
+          str.push_back(PeekOneChar());
+          SkipEscape();
+        }
+        continue;
       }
-      continue;
-    }
 
-    str.push_back(CurChar());
-    NextChar();
+      str.push_back(CurChar());
+      NextChar();
+    }
+    text = KeepDecoded(std::move(str));
   }
 
   if (CurChar() == '\0') {
     m_Diag.Diag(Diag::DIR_Error,
-                Diag::Format(Diag::DMT_ErrUnexpectedChar, {"EOF", "string"}),
+                Diag::DMT_ErrUnexpectedCharInContext,
+                {"EOF", "string"},
                 CurCharRange());
   }
   else /* if (CurChar() == '"') */ {
     NextChar();
   }
 
-  m_TokenStream.emplace_back(Token::TK_LIT_STR,
-                             SourceRange(GetLine(), col1, GetCol()), str);
+  m_TokenStream.EmplaceToken(Token::TK_LIT_STR, TokenRange(), text);
 }
 
-void LexerImpl::LexSymbol() {
-  switch (CurChar()) {
-  case '{':
-    m_TokenStream.emplace_back(Token::TK_SYM_LBRACE, CurCharRange()); break;
-
-  case '}':
-    m_TokenStream.emplace_back(Token::TK_SYM_RBRACE, CurCharRange()); break;
-
-  case '[':
-    m_TokenStream.emplace_back(Token::TK_SYM_LBRACKET, CurCharRange()); break;
-
-  case ']':
-    m_TokenStream.emplace_back(Token::TK_SYM_RBRACKET, CurCharRange()); break;
-
-  case '(':
-    m_TokenStream.emplace_back(Token::TK_SYM_LPAREN, CurCharRange()); break;
-
-  case ')':
-    m_TokenStream.emplace_back(Token::TK_SYM_RPAREN, CurCharRange()); break;
-
-  case '<':
-    switch (PeekOneChar()) {
-    case '<':
-      NextChar();
-      m_TokenStream.emplace_back(Token::TK_SYM_LTLT, CurCharRange());
-      break;
-
-    case '=':
-      NextChar();
-      m_TokenStream.emplace_back(Token::TK_SYM_LTEQ, CurCharRange());
-      break;
-
-    default:
-      m_TokenStream.emplace_back(Token::TK_SYM_LT, CurCharRange());
-    }
-    break;
-
-  case '>':
-    switch (PeekOneChar()) {
-    case '>':
-      NextChar();
-      m_TokenStream.emplace_back(Token::TK_SYM_GTGT, CurCharRange());
-      break;
-
-    case '=':
-      NextChar();
-      m_TokenStream.emplace_back(Token::TK_SYM_GTEQ, CurCharRange());
-      break;
-
-    default:
-      m_TokenStream.emplace_back(Token::TK_SYM_GT, CurCharRange());
-    }
-    break;
-
-  case ',':
-    m_TokenStream.emplace_back(Token::TK_SYM_COMMA, CurCharRange()); break;
-
-  case ';':
-    m_TokenStream.emplace_back(Token::TK_SYM_SEMI, CurCharRange()); break;
-
-  case '~':
-    m_TokenStream.emplace_back(Token::TK_SYM_WAVE, CurCharRange()); break;
-
-  case '=':
-    if (PeekOneChar() == '=') {
-      NextChar();
-      m_TokenStream.emplace_back(Token::TK_SYM_EQEQ, CurCharRange());
-    }
-    else {
-      m_TokenStream.emplace_back(Token::TK_SYM_EQ, CurCharRange());
-    }
-    break;
-
-  case '!':
-    if (PeekOneChar() == '=') {
-      NextChar();
-      m_TokenStream.emplace_back(Token::TK_SYM_EXCEQ, CurCharRange());
-    }
-    else {
-      m_TokenStream.emplace_back(Token::TK_SYM_EXCLAIM, CurCharRange());
-    }
-    break;
-
-  case '.':
-    m_TokenStream.emplace_back(Token::TK_SYM_DOT, CurCharRange()); break;
-
-  case '+':
-    if (PeekOneChar() == '+') {
-      NextChar();
-      m_TokenStream.emplace_back(Token::TK_SYM_DPLUS, CurCharRange());
-    }
-    else {
-      m_TokenStream.emplace_back(Token::TK_SYM_PLUS, CurCharRange());
-    }
-    break;
-
-  case '-':
-    if (PeekOneChar() == '-') {
-      NextChar();
-      m_TokenStream.emplace_back(Token::TK_SYM_DMINUS, CurCharRange());
-    }
-    else {
-      m_TokenStream.emplace_back(Token::TK_SYM_MINUS, CurCharRange());
-    }
-    break;
-
-  case '&':
-    if (PeekOneChar() == '&') {
-      NextChar();
-      m_TokenStream.emplace_back(Token::TK_SYM_DAMP, CurCharRange());
-    }
-    else {
-      m_TokenStream.emplace_back(Token::TK_SYM_AMP, CurCharRange());
-    }
-    break;
-
-  case '|':
-    if (PeekOneChar() == '|') {
-      NextChar();
-      m_TokenStream.emplace_back(Token::TK_SYM_DPIPE, CurCharRange());
-    }
-    else {
-      m_TokenStream.emplace_back(Token::TK_SYM_PIPE, CurCharRange());
-    }
-    break;
-
-  case '^':
-    if (PeekOneChar() == '^') {
-      NextChar();
-      m_TokenStream.emplace_back(Token::TK_SYM_DTIP, CurCharRange());
-    }
-    else {
-      m_TokenStream.emplace_back(Token::TK_SYM_TIP, CurCharRange());
-    }
-    break;
-
-  case ':':
-    if (PeekOneChar() == ':') {
-      NextChar();
-      m_TokenStream.emplace_back(Token::TK_SYM_DCOLON, CurCharRange());
-    }
-    else {
-      m_TokenStream.emplace_back(Token::TK_SYM_COLON, CurCharRange());
-    }
-    break;
-
-  case '*':
-    m_TokenStream.emplace_back(Token::TK_SYM_ASTER, CurCharRange()); break;
-
-  case '/':
-    m_TokenStream.emplace_back(Token::TK_SYM_SLASH, CurCharRange()); break;
-
-  case '%':
-    m_TokenStream.emplace_back(Token::TK_SYM_PERCENT, CurCharRange()); break;
+bool LexerImpl::LexSymbol() {
+  Token::TokenKind kind = Token::TK_INVALID;
+  std::size_t length = SymbolTable.Match(CurCharPtr(), SourceEnd(), kind);
+  if (length == 0) {
+    return false;
   }
 
-  NextChar();
+  SkipTo(CurCharPtr() + length);
+  m_TokenStream.EmplaceToken(kind, TokenRange());
+  return true;
 }
 
 void LexerImpl::SkipWhitespace() {
-  while (isblank(CurChar()) || CurChar() == '\n') {
-    NextChar();
-  }
+  char const *runStart = CurCharPtr();
+  SkipTo(ScanWhitespaceRunInline(runStart, SourceEnd()));
 }
 
-std::string LexerImpl::ScanIdString() {
-  std::stringstream stream;
-  while (std::isdigit(CurChar()) || std::isalpha(CurChar())
-         || CurChar() == '_' || CurChar() == '$') {
-    stream.put(CurChar());
+void LexerImpl::SkipEscape() noexcept {
+  sona_assert(CurChar() == '\\');
+  NextChar();
+  if (CurChar() != '\0') {
     NextChar();
   }
+}
 
-  while (CurChar() == '!' || CurChar() == '?') {
-    stream.put(CurChar());
-    NextChar();
+void LexerImpl::SkipIdString() {
+  char const *idEnd = ScanIdContinueRunInline(CurCharPtr(), SourceEnd());
+  while (idEnd != SourceEnd() && (*idEnd == '!' || *idEnd == '?')) {
+    ++idEnd;
   }
+  SkipTo(idEnd);
+}
 
-  std::string ret;
-  stream >> ret;
-  return ret;
+char LexerImpl::CurChar() const noexcept {
+  return m_Index < m_SourceSize ? m_Source[m_Index] : '\0';
 }
 
-std::uint64_t LexerImpl::ScanInt() {
-  std::uint64_t ret = 0;
-  while (std::isdigit(CurChar())) {
-    ret *= 10;
-    ret += CurChar() - '0'; NextChar();
-  }
-  return ret;
+void LexerImpl::NextChar() noexcept {
+  sona_assert(CurChar() != '\0');
+  ++m_Index;
 }
 
-void LexerImpl::LexIdentifier() {
-  std::uint16_t col1 = GetCol();
-  std::string str = ScanIdString();
-  m_TokenStream.emplace_back(Token::TK_ID,
-                             SourceRange(GetLine(), col1, GetCol()), str);
+void LexerImpl::SkipTo(char const* runEnd) noexcept {
+  m_Index = static_cast<std::uint32_t>(runEnd - m_Source);
 }
 
-char LexerImpl::CurChar() const noexcept {
-  return m_SourceCode[m_Index];
+char LexerImpl::PeekOneChar() const noexcept {
+  sona_assert(CurChar() != '\0');
+  return m_Index + 1 < m_SourceSize ? m_Source[m_Index + 1] : '\0';
 }
 
-void LexerImpl::NextChar() noexcept {
-  sona_assert(m_SourceCode[m_Index] != '\0');
-  if (CurChar() == '\n') {
-    ++m_Line;
-    m_Col = 1;
-  }
-  else if (CurChar() == '\t') {
-    m_Col += 8;
+sona::string_view LexerImpl::KeepDecoded(std::string &&str) {
+  std::size_t slot;
+  if (!m_FreeDecoded.empty()) {
+    slot = m_FreeDecoded.back();
+    m_FreeDecoded.pop_back();
+    m_DecodedStrings[slot] = std::move(str);
   }
   else {
-    ++m_Col;
+    slot = m_DecodedStrings.size();
+    m_DecodedStrings.push_back(std::move(str));
   }
-  ++m_Index;
+  m_DecodedSlots.emplace(m_DecodedStrings[slot].data(), slot);
+  return m_DecodedStrings[slot];
 }
 
-char LexerImpl::PeekOneChar() const noexcept {
-  sona_assert(m_SourceCode[m_Index] != '\0');
-  return m_SourceCode[m_Index + 1];
+void LexerImpl::ReleaseDecoded(char const* text) {
+  auto it = m_DecodedSlots.find(text);
+  if (it == m_DecodedSlots.end()) {
+    return;
+  }
+  std::string().swap(m_DecodedStrings[it->second]);
+  m_FreeDecoded.push_back(it->second);
+  m_DecodedSlots.erase(it);
 }
 
-SourceRange LexerImpl::CurCharRange() const noexcept {
-  return SourceRange(GetLine(), GetCol(), GetCol()+1);
+SourceLocation LexerImpl::GetLoc(std::uint32_t offset) const noexcept {
+  return m_TokenStream.GetFileStart().GetLocWithOffset(offset);
 }
 
-uint16_t LexerImpl::GetLine() const noexcept {
-  return m_Line;
+SourceRange LexerImpl::RangeAt(std::uint32_t begin,
+                               std::uint32_t end) const noexcept {
+  return SourceRange(GetLoc(begin), GetLoc(end));
 }
 
-uint16_t LexerImpl::GetCol() const noexcept {
-  return m_Col;
+SourceRange LexerImpl::TokenRange() const noexcept {
+  return RangeAt(m_TokenStart, m_Index);
+}
+
+SourceRange LexerImpl::CurCharRange() const noexcept {
+  return RangeAt(m_Index, m_Index + 1);
 }
 
 } // namespace Frontend
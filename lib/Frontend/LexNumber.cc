@@ -0,0 +1,305 @@
+#include "Frontend/LexNumber.h"
+
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <string>
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+#define CKX_SWAR_DIGITS
+#endif
+
+namespace ckx {
+namespace Frontend {
+
+namespace {
+
+/// Eight digits at once, most significant first: subtract '0' from every
+/// byte, then combine neighbouring lanes pairwise (2, 4, 8 digits) with
+/// three multiplications.
+std::uint32_t ParseEightDigits(char const* str) noexcept {
+#ifdef CKX_SWAR_DIGITS
+  std::uint64_t val;
+  std::memcpy(&val, str, sizeof(val));
+  val -= 0x3030303030303030ULL;
+  val = (val * 10) + (val >> 8);
+  val = (((val & 0x000000FF000000FFULL) * 0x000F424000000064ULL)
+         + (((val >> 16) & 0x000000FF000000FFULL) * 0x0000271000000001ULL))
+        >> 32;
+  return static_cast<std::uint32_t>(val);
+#else
+  std::uint32_t ret = 0;
+  for (int i = 0; i < 8; i++) {
+    ret = ret * 10 + static_cast<std::uint32_t>(str[i] - '0');
+  }
+  return ret;
+#endif
+}
+
+/// Appends [begin, end) to value, the caller makes sure it cannot overflow
+std::uint64_t
+AccumulateDigits(char const* begin, char const* end,
+                 std::uint64_t value) noexcept {
+  while (end - begin >= 8) {
+    value = value * 100000000 + ParseEightDigits(begin);
+    begin += 8;
+  }
+  for (; begin != end; ++begin) {
+    value = value * 10 + static_cast<std::uint64_t>(*begin - '0');
+  }
+  return value;
+}
+
+/// Any 19 decimal digits fit in an uint64_t
+constexpr std::ptrdiff_t MaxExactDigits = 19;
+
+char const* SkipLeadingZeros(char const* begin, char const* end) noexcept {
+  while (begin != end && *begin == '0') {
+    ++begin;
+  }
+  return begin;
+}
+
+unsigned LeadingZeros(std::uint64_t x) noexcept {
+#ifdef __GNUC__
+  return static_cast<unsigned>(__builtin_clzll(x));
+#else
+  unsigned ret = 0;
+  while ((x & (std::uint64_t(1) << 63)) == 0) {
+    x <<= 1;
+    ret++;
+  }
+  return ret;
+#endif
+}
+
+void FullMultiply(std::uint64_t a, std::uint64_t b,
+                  std::uint64_t &high, std::uint64_t &low) noexcept {
+#ifdef __SIZEOF_INT128__
+  unsigned __int128 product = static_cast<unsigned __int128>(a) * b;
+  high = static_cast<std::uint64_t>(product >> 64);
+  low = static_cast<std::uint64_t>(product);
+#else
+  std::uint64_t aLo = a & 0xFFFFFFFFu, aHi = a >> 32;
+  std::uint64_t bLo = b & 0xFFFFFFFFu, bHi = b >> 32;
+  std::uint64_t p0 = aLo * bLo, p1 = aLo * bHi, p2 = aHi * bLo;
+  std::uint64_t mid = (p0 >> 32) + (p1 & 0xFFFFFFFFu) + (p2 & 0xFFFFFFFFu);
+  low = (mid << 32) | (p0 & 0xFFFFFFFFu);
+  high = aHi * bHi + (p1 >> 32) + (p2 >> 32) + (mid >> 32);
+#endif
+}
+
+std::uint64_t const Pow5Table[] = {
+#include "Pow5Table.inc"
+};
+
+constexpr std::int64_t SmallestPowerOfTen = -342;
+constexpr std::int64_t LargestPowerOfTen = 308;
+
+static_assert(sizeof(Pow5Table) / sizeof(Pow5Table[0])
+                == 2 * (LargestPowerOfTen - SmallestPowerOfTen + 1),
+              "Pow5Table.inc does not cover the double exponent range");
+
+double const ExactPowersOfTen[] = {
+  1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+  1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+constexpr int MantissaBits = 52;
+constexpr int MinimumExponent = -1023;
+constexpr int InfinitePower = 0x7FF;
+
+double AssembleDouble(std::uint64_t mantissa, int power2) noexcept {
+  std::uint64_t bits =
+      mantissa | (static_cast<std::uint64_t>(power2) << MantissaBits);
+  double ret;
+  std::memcpy(&ret, &bits, sizeof(ret));
+  return ret;
+}
+
+/// w * 10^q correctly rounded, after Eisel and Lemire, "Number Parsing at a
+/// Gigabyte per Second". The 128-bit product is always sufficient for an
+/// exact w (Mushtak and Lemire, "Fast Number Parsing Without Fallback").
+double EiselLemire(std::uint64_t w, std::int64_t q) noexcept {
+  if (w == 0 || q < SmallestPowerOfTen) {
+    return 0.0;
+  }
+  if (q > LargestPowerOfTen) {
+    return AssembleDouble(0, InfinitePower);
+  }
+
+  unsigned lz = LeadingZeros(w);
+  w <<= lz;
+
+  std::size_t index = static_cast<std::size_t>(2 * (q - SmallestPowerOfTen));
+  std::uint64_t high, low;
+  FullMultiply(w, Pow5Table[index], high, low);
+  constexpr std::uint64_t precisionMask = ~std::uint64_t(0)
+                                          >> (MantissaBits + 3);
+  if ((high & precisionMask) == precisionMask) {
+    std::uint64_t high2, low2;
+    FullMultiply(w, Pow5Table[index + 1], high2, low2);
+    low += high2;
+    if (high2 > low) {
+      high++;
+    }
+  }
+
+  int upperBit = static_cast<int>(high >> 63);
+  int shift = upperBit + 64 - MantissaBits - 3;
+  std::uint64_t mantissa = high >> shift;
+  /// floor(log2(10^q)) + 63, exact over the table range
+  int power2 = static_cast<int>((((152170 + 65536) * q) >> 16) + 63)
+               + upperBit - static_cast<int>(lz) - MinimumExponent;
+
+  if (power2 <= 0) {
+    /// subnormal, or zero once even the last bit is shifted out
+    if (-power2 + 1 >= 64) {
+      return 0.0;
+    }
+    mantissa >>= -power2 + 1;
+    mantissa += (mantissa & 1);
+    mantissa >>= 1;
+    power2 = (mantissa < (std::uint64_t(1) << MantissaBits)) ? 0 : 1;
+    return AssembleDouble(mantissa & ~(std::uint64_t(1) << MantissaBits),
+                          power2);
+  }
+
+  /// exactly halfway between two doubles, round to even instead of up
+  if (low <= 1 && q >= -4 && q <= 23 && (mantissa & 3) == 1
+      && (mantissa << shift) == high) {
+    mantissa &= ~std::uint64_t(1);
+  }
+
+  mantissa += (mantissa & 1);
+  mantissa >>= 1;
+  if (mantissa >= (std::uint64_t(2) << MantissaBits)) {
+    mantissa = std::uint64_t(1) << MantissaBits;
+    power2++;
+  }
+  mantissa &= ~(std::uint64_t(1) << MantissaBits);
+
+  if (power2 >= InfinitePower) {
+    return AssembleDouble(0, InfinitePower);
+  }
+  return AssembleDouble(mantissa, power2);
+}
+
+/// More significant digits than an uint64_t holds, rare enough to leave to
+/// the C library. The digits are passed without a decimal point, which
+/// keeps strtod clear of the current locale.
+double DecodeFloatSlow(char const* intBegin, char const* intEnd,
+                       char const* fracBegin, char const* fracEnd,
+                       std::int64_t exp10) {
+  std::string text(intBegin, intEnd);
+  text.append(fracBegin, fracEnd);
+  text.push_back('e');
+  text += std::to_string(exp10);
+  return std::strtod(text.c_str(), nullptr);
+}
+
+} // namespace
+
+bool DecodeDecimal(char const* begin, char const* end,
+                   std::uint64_t &value) noexcept {
+  begin = SkipLeadingZeros(begin, end);
+  std::ptrdiff_t numDigits = end - begin;
+  if (numDigits <= MaxExactDigits) {
+    value = AccumulateDigits(begin, end, 0);
+    return true;
+  }
+  if (numDigits > MaxExactDigits + 1) {
+    return false;
+  }
+
+  std::uint64_t head = AccumulateDigits(begin, end - 1, 0);
+  std::uint64_t last = static_cast<std::uint64_t>(end[-1] - '0');
+  if (head > (std::numeric_limits<std::uint64_t>::max() - last) / 10) {
+    return false;
+  }
+  value = head * 10 + last;
+  return true;
+}
+
+bool DecodeHex(char const* begin, char const* end,
+               std::uint64_t &value) noexcept {
+  begin = SkipLeadingZeros(begin, end);
+  if (end - begin > 16) {
+    return false;
+  }
+
+  value = 0;
+  for (; begin != end; ++begin) {
+    char ch = *begin;
+    std::uint64_t digit =
+        ch <= '9' ? static_cast<std::uint64_t>(ch - '0')
+                  : static_cast<std::uint64_t>((ch | 0x20) - 'a' + 10);
+    value = (value << 4) | digit;
+  }
+  return true;
+}
+
+bool DecodeBinary(char const* begin, char const* end,
+                  std::uint64_t &value) noexcept {
+  begin = SkipLeadingZeros(begin, end);
+  if (end - begin > 64) {
+    return false;
+  }
+
+  value = 0;
+  for (; begin != end; ++begin) {
+    value = (value << 1) | static_cast<std::uint64_t>(*begin - '0');
+  }
+  return true;
+}
+
+bool DecodeFloat(char const* intBegin, char const* intEnd,
+                 char const* fracBegin, char const* fracEnd,
+                 std::int64_t exponent, double &value) noexcept {
+  /// Normalize to w * 10^exp10 with no zeros at either end of w
+  while (fracEnd != fracBegin && fracEnd[-1] == '0') {
+    --fracEnd;
+  }
+  std::int64_t exp10 = exponent - (fracEnd - fracBegin);
+  if (fracBegin == fracEnd) {
+    while (intEnd != intBegin && intEnd[-1] == '0') {
+      --intEnd;
+      ++exp10;
+    }
+  }
+  intBegin = SkipLeadingZeros(intBegin, intEnd);
+  if (intBegin == intEnd) {
+    fracBegin = SkipLeadingZeros(fracBegin, fracEnd);
+  }
+
+  std::ptrdiff_t numDigits = (intEnd - intBegin) + (fracEnd - fracBegin);
+  if (numDigits == 0) {
+    value = 0.0;
+    return true;
+  }
+
+  if (numDigits > MaxExactDigits) {
+    value = DecodeFloatSlow(intBegin, intEnd, fracBegin, fracEnd, exp10);
+    return value != std::numeric_limits<double>::infinity();
+  }
+
+  std::uint64_t w =
+      AccumulateDigits(fracBegin, fracEnd,
+                       AccumulateDigits(intBegin, intEnd, 0));
+
+  /// Clinger's fast path: both w and 10^|exp10| are exact doubles, so one
+  /// correctly rounded IEEE operation gives the correctly rounded result
+  if (exp10 >= -22 && exp10 <= 22 && w <= (std::uint64_t(1) << 53)) {
+    double d = static_cast<double>(w);
+    value = exp10 < 0 ? d / ExactPowersOfTen[-exp10]
+                      : d * ExactPowersOfTen[exp10];
+    return true;
+  }
+
+  value = EiselLemire(w, exp10);
+  return value != std::numeric_limits<double>::infinity();
+}
+
+} // namespace Frontend
+} // namespace ckx
@@ -0,0 +1,245 @@
+#include "Frontend/LexScan.h"
+
+#include <atomic>
+
+#if defined(__x86_64__) && defined(__GNUC__)
+#define CKX_LEXSCAN_X86
+#include <immintrin.h>
+#define CKX_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+namespace ckx {
+namespace Frontend {
+
+namespace {
+
+struct WhitespaceClass {
+  static bool Test(unsigned char ch) noexcept {
+    return IsWhitespaceChar(ch);
+  }
+};
+
+struct DigitClass {
+  static bool Test(unsigned char ch) noexcept { return IsDigitChar(ch); }
+};
+
+struct IdContinueClass {
+  static bool Test(unsigned char ch) noexcept {
+    return IsIdContinueChar(ch);
+  }
+};
+
+template <typename CharClass>
+char const* ScalarRun(char const* begin, char const* end) noexcept {
+  while (begin != end && CharClass::Test(static_cast<unsigned char>(*begin))) {
+    ++begin;
+  }
+  return begin;
+}
+
+#ifdef CKX_LEXSCAN_X86
+
+/// Byte-wise unsigned (x <= bound), SSE2 only has signed comparisons
+__m128i LessEqU8(__m128i x, __m128i bound) noexcept {
+  return _mm_cmpeq_epi8(_mm_min_epu8(x, bound), x);
+}
+
+__m128i InRangeU8(__m128i x, char lo, char hi) noexcept {
+  return LessEqU8(_mm_sub_epi8(x, _mm_set1_epi8(lo)),
+                  _mm_set1_epi8(static_cast<char>(hi - lo)));
+}
+
+CKX_TARGET_AVX2
+__m256i LessEqU8(__m256i x, __m256i bound) noexcept {
+  return _mm256_cmpeq_epi8(_mm256_min_epu8(x, bound), x);
+}
+
+CKX_TARGET_AVX2
+__m256i InRangeU8(__m256i x, char lo, char hi) noexcept {
+  return LessEqU8(_mm256_sub_epi8(x, _mm256_set1_epi8(lo)),
+                  _mm256_set1_epi8(static_cast<char>(hi - lo)));
+}
+
+struct WhitespaceVec : WhitespaceClass {
+  static __m128i Classify(__m128i c) noexcept {
+    return _mm_or_si128(InRangeU8(c, '\t', '\r'),
+                        _mm_cmpeq_epi8(c, _mm_set1_epi8(' ')));
+  }
+
+  CKX_TARGET_AVX2 static __m256i Classify(__m256i c) noexcept {
+    return _mm256_or_si256(InRangeU8(c, '\t', '\r'),
+                           _mm256_cmpeq_epi8(c, _mm256_set1_epi8(' ')));
+  }
+};
+
+struct DigitVec : DigitClass {
+  static __m128i Classify(__m128i c) noexcept {
+    return InRangeU8(c, '0', '9');
+  }
+
+  CKX_TARGET_AVX2 static __m256i Classify(__m256i c) noexcept {
+    return InRangeU8(c, '0', '9');
+  }
+};
+
+struct IdContinueVec : IdContinueClass {
+  static __m128i Classify(__m128i c) noexcept {
+    __m128i alpha = InRangeU8(_mm_or_si128(c, _mm_set1_epi8(0x20)), 'a', 'z');
+    __m128i misc = _mm_or_si128(_mm_cmpeq_epi8(c, _mm_set1_epi8('_')),
+                                _mm_cmpeq_epi8(c, _mm_set1_epi8('$')));
+    return _mm_or_si128(_mm_or_si128(alpha, misc), InRangeU8(c, '0', '9'));
+  }
+
+  CKX_TARGET_AVX2 static __m256i Classify(__m256i c) noexcept {
+    __m256i alpha =
+        InRangeU8(_mm256_or_si256(c, _mm256_set1_epi8(0x20)), 'a', 'z');
+    __m256i misc = _mm256_or_si256(_mm256_cmpeq_epi8(c, _mm256_set1_epi8('_')),
+                                   _mm256_cmpeq_epi8(c, _mm256_set1_epi8('$')));
+    return _mm256_or_si256(_mm256_or_si256(alpha, misc),
+                           InRangeU8(c, '0', '9'));
+  }
+};
+
+template <typename CharClass>
+char const* SSE2Run(char const* begin, char const* end) noexcept {
+  while (end - begin >= 16) {
+    __m128i chunk = _mm_loadu_si128(reinterpret_cast<__m128i const*>(begin));
+    unsigned outOfClass =
+        static_cast<unsigned>(_mm_movemask_epi8(CharClass::Classify(chunk)))
+        ^ 0xFFFFu;
+    if (outOfClass != 0) {
+      return begin + __builtin_ctz(outOfClass);
+    }
+    begin += 16;
+  }
+  return ScalarRun<CharClass>(begin, end);
+}
+
+template <typename CharClass>
+CKX_TARGET_AVX2
+char const* AVX2Run(char const* begin, char const* end) noexcept {
+  while (end - begin >= 32) {
+    __m256i chunk =
+        _mm256_loadu_si256(reinterpret_cast<__m256i const*>(begin));
+    __m256i inClass = CharClass::Classify(chunk);
+    unsigned outOfClass =
+        ~static_cast<unsigned>(_mm256_movemask_epi8(inClass));
+    if (outOfClass != 0) {
+      return begin + __builtin_ctz(outOfClass);
+    }
+    begin += 32;
+  }
+  return SSE2Run<CharClass>(begin, end);
+}
+
+#endif // CKX_LEXSCAN_X86
+
+using RunFunction = char const* (*)(char const*, char const*);
+
+struct KernelTable {
+  ScanKernel Kernel;
+  RunFunction WhitespaceRun;
+  RunFunction IdContinueRun;
+  RunFunction DigitRun;
+};
+
+#ifdef CKX_LEXSCAN_X86
+constexpr KernelTable AVX2Kernels {
+  ScanKernel::SK_AVX2, &AVX2Run<WhitespaceVec>,
+  &AVX2Run<IdContinueVec>, &AVX2Run<DigitVec>
+};
+constexpr KernelTable SSE2Kernels {
+  ScanKernel::SK_SSE2, &SSE2Run<WhitespaceVec>,
+  &SSE2Run<IdContinueVec>, &SSE2Run<DigitVec>
+};
+#endif
+constexpr KernelTable ScalarKernels {
+  ScanKernel::SK_Scalar, &ScalarRun<WhitespaceClass>,
+  &ScalarRun<IdContinueClass>, &ScalarRun<DigitClass>
+};
+
+KernelTable const* GetKernelTable(ScanKernel kernel) noexcept {
+  switch (kernel) {
+#ifdef CKX_LEXSCAN_X86
+  case ScanKernel::SK_AVX2:
+    return &AVX2Kernels;
+  case ScanKernel::SK_SSE2:
+    return &SSE2Kernels;
+#endif
+  default:
+    return &ScalarKernels;
+  }
+}
+
+KernelTable const* SelectBestKernels() noexcept {
+  if (IsScanKernelSupported(ScanKernel::SK_AVX2)) {
+    return GetKernelTable(ScanKernel::SK_AVX2);
+  }
+  if (IsScanKernelSupported(ScanKernel::SK_SSE2)) {
+    return GetKernelTable(ScanKernel::SK_SSE2);
+  }
+  return GetKernelTable(ScanKernel::SK_Scalar);
+}
+
+/// Null until the first scan or SetScanKernel. Lexer threads read it while
+/// a benchmark may switch it, the tables themselves never change.
+std::atomic<KernelTable const*> CurrentKernels { nullptr };
+
+KernelTable const& GetKernels() noexcept {
+  KernelTable const* kernels =
+      CurrentKernels.load(std::memory_order_acquire);
+  if (kernels == nullptr) {
+    static KernelTable const* const bestKernels = SelectBestKernels();
+    CurrentKernels.compare_exchange_strong(kernels, bestKernels,
+                                           std::memory_order_acq_rel);
+    kernels = CurrentKernels.load(std::memory_order_acquire);
+  }
+  return *kernels;
+}
+
+} // namespace
+
+char const* ScanWhitespaceRun(char const* begin, char const* end) noexcept {
+  return GetKernels().WhitespaceRun(begin, end);
+}
+
+char const* ScanIdContinueRun(char const* begin, char const* end) noexcept {
+  return GetKernels().IdContinueRun(begin, end);
+}
+
+char const* ScanDigitRun(char const* begin, char const* end) noexcept {
+  return GetKernels().DigitRun(begin, end);
+}
+
+ScanKernel GetScanKernel() noexcept {
+  return GetKernels().Kernel;
+}
+
+bool IsScanKernelSupported(ScanKernel kernel) noexcept {
+  switch (kernel) {
+  case ScanKernel::SK_Scalar:
+    return true;
+#ifdef CKX_LEXSCAN_X86
+  case ScanKernel::SK_SSE2:
+    return true;
+  case ScanKernel::SK_AVX2: {
+    /// May run before the constructors that would otherwise initialize
+    /// the CPU model, which __builtin_cpu_supports reads
+    static bool const cpuInitialized = (__builtin_cpu_init(), true);
+    (void)cpuInitialized;
+    return __builtin_cpu_supports("avx2");
+  }
+#endif
+  default:
+    return false;
+  }
+}
+
+void SetScanKernel(ScanKernel kernel) noexcept {
+  if (IsScanKernelSupported(kernel)) {
+    CurrentKernels.store(GetKernelTable(kernel), std::memory_order_release);
+  }
+}
+
+} // namespace Frontend
+} // namespace ckx
@@ -9,21 +9,217 @@ Parser::Parser(Diag::DiagnosticEngine &diag)
 }
 
 sona::owner<Syntax::TransUnit>
-Parser::ParseTransUnit(sona::ref_ptr<std::vector<Token> const> tokenStream) {
+Parser::ParseTransUnit(sona::ref_ptr<TokenBuffer const> tokenStream) {
   return m_ParserImpl.borrow()->ParseTransUnit(tokenStream);
 }
 
-sona::owner<Syntax::Expr>
-Parser::ParseExpr(sona::ref_ptr<const std::vector<Token> > tokenStream) {
+sona::owner<Syntax::TransUnit>
+Parser::ParseTransUnit(sona::ref_ptr<TokenSource> tokenSource) {
+  return m_ParserImpl.borrow()->ParseTransUnit(tokenSource);
+}
+
+sona::owner<Syntax::TransUnit>
+Parser::ParseTransUnitInParallel(sona::ref_ptr<TokenBuffer const> tokenStream,
+                                 unsigned numThreads) {
+  return m_ParserImpl.borrow()->ParseTransUnitInParallel(tokenStream,
+                                                         numThreads);
+}
+
+Syntax::NodePtr<Syntax::Expr>
+Parser::ParseExpr(sona::ref_ptr<TokenBuffer const> tokenStream) {
   return m_ParserImpl.borrow()->ParseReplExpr(tokenStream);
 }
 
-sona::owner<Syntax::VarDecl>
-Parser::ParseVarDecl(sona::ref_ptr<const std::vector<Token> > tokenStream) {
+Syntax::NodePtr<Syntax::VarDecl>
+Parser::ParseVarDecl(sona::ref_ptr<TokenBuffer const> tokenStream) {
   return m_ParserImpl.borrow()->ParseReplVarDecl(tokenStream);
 }
 
+void Parser::SetSkipFuncBodies(bool skip) noexcept {
+  m_ParserImpl.borrow()->SetSkipFuncBodies(skip);
+}
+
+Syntax::NodePtr<Syntax::Stmt>
+Parser::ParseFuncBody(sona::ref_ptr<TokenBuffer const> tokenStream,
+                      sona::ref_ptr<Syntax::TransUnit> unit,
+                      sona::ref_ptr<Syntax::FuncDecl const> funcDecl) {
+  return m_ParserImpl.borrow()->ParseFuncBody(tokenStream, unit, funcDecl);
+}
+
 Parser::~Parser() {}
 
+namespace {
+
+/// Replays the tokens of a pending entry and notes whether the parser had
+/// already been handed the end of input when it reported its first error
+class EntryTokenSource final : public TokenSource {
+public:
+  EntryTokenSource(TokenBuffer const& tokens,
+                   Diag::DiagnosticEngine const& diag)
+    : m_Tokens(tokens), m_Diag(diag) {}
+
+  Token NextToken() override {
+    if (m_Index + 1 < m_Tokens.size()) {
+      return m_Tokens[m_Index++];
+    }
+    if (!m_ReachedEnd) {
+      m_ReachedEnd = true;
+      m_CleanAtEnd = !m_Diag.HasPendingDiags();
+    }
+    return m_Tokens[m_Tokens.size() - 1];
+  }
+
+  /// @return true if the errors are only about input not there yet
+  bool RanOutFirst() const noexcept { return m_ReachedEnd && m_CleanAtEnd; }
+
+private:
+  TokenBuffer const& m_Tokens;
+  Diag::DiagnosticEngine const& m_Diag;
+  std::size_t m_Index = 0;
+  bool m_ReachedEnd = false;
+  bool m_CleanAtEnd = false;
+};
+
+/// @return false for the tokens no entry ends with, parsing after them
+/// could only run out of input
+bool MayEndEntry(Token::TokenKind tokenKind) noexcept {
+  switch (tokenKind) {
+  case Token::TK_KW_def: case Token::TK_KW_sizeof: case Token::TK_KW_alignof:
+  case Token::TK_KW_static_cast: case Token::TK_KW_bitcast:
+  case Token::TK_KW_const_cast:
+  case Token::TK_SYM_LT: case Token::TK_SYM_LTEQ: case Token::TK_SYM_GTEQ:
+  case Token::TK_SYM_LTLT: case Token::TK_SYM_COLON: case Token::TK_SYM_DCOLON:
+  case Token::TK_SYM_DOT: case Token::TK_SYM_COMMA: case Token::TK_SYM_EQ:
+  case Token::TK_SYM_EQEQ: case Token::TK_SYM_EXCEQ:
+  case Token::TK_SYM_EXCLAIM: case Token::TK_SYM_WAVE:
+  case Token::TK_SYM_PLUS: case Token::TK_SYM_MINUS: case Token::TK_SYM_SLASH:
+  case Token::TK_SYM_PERCENT: case Token::TK_SYM_DAMP: case Token::TK_SYM_PIPE:
+  case Token::TK_SYM_DPIPE: case Token::TK_SYM_TIP: case Token::TK_SYM_DTIP:
+    return false;
+  default:
+    return true;
+  }
+}
+
+} // namespace
+
+IncrementalParser::IncrementalParser(Diag::DiagnosticEngine &diag,
+                                     std::vector<std::string> &lines)
+  : m_Diag(diag), m_Lines(lines), m_TryDiag("", m_NoLines),
+    m_ParserImpl(new ParserImpl(m_TryDiag)), m_Lexer("", diag) {
+  m_Lines.clear();
+}
+
+IncrementalParser::Status
+IncrementalParser::PushLine(sona::string_view line) {
+  if (m_EntryDone) {
+    StartEntry();
+  }
+
+  /// Every line ends with a line break, so the tokens of the lines before
+  /// stay as they are and only the end of input gets lexed again
+  m_Lines.push_back(line.to_string());
+  /// The lexer takes a NUL for the end of input, which would silently cut
+  /// the entry short
+  std::string::size_type nul = m_Lines.back().find('\0');
+  if (nul != std::string::npos) {
+    SourceLocation loc =
+        SourceLocation::FromRawEncoding(SourceManager::FirstFileStart)
+        .GetLocWithOffset(m_Lexer.GetSource().size() + nul);
+    m_Diag.Diag(Diag::DIR_Error, Diag::DMT_ErrUnexpectedChar, { "0" },
+                SourceRange(loc, loc.GetLocWithOffset(1)));
+    m_EntryDone = true;
+    return IPS_Error;
+  }
+
+  std::uint32_t end = static_cast<std::uint32_t>(m_Lexer.GetSource().size());
+  m_Lexer.ApplyEdit(end, 0, m_Lines.back() + "\n");
+  if (m_Diag.HasPendingError()) {
+    m_EntryDone = true;
+    return IPS_Error;
+  }
+
+  TokenBuffer const& tokens = m_Lexer.GetTokens();
+  for (; m_ScannedTokens + 1 < tokens.size(); m_ScannedTokens++) {
+    switch (tokens.GetTokenKind(m_ScannedTokens)) {
+    case Token::TK_SYM_LPAREN:
+    case Token::TK_SYM_LBRACKET:
+    case Token::TK_SYM_LBRACE:
+      m_Depth++;
+      break;
+    case Token::TK_SYM_RPAREN:
+    case Token::TK_SYM_RBRACKET:
+    case Token::TK_SYM_RBRACE:
+      m_Depth--;
+      break;
+    default:
+      break;
+    }
+  }
+
+  /// Every attempt parses the entry from its start, so only lines that
+  /// may end it are worth one
+  if (!IsPending() || m_Depth > 0
+      || !MayEndEntry(tokens.GetTokenKind(tokens.size() - 2))) {
+    return IPS_NeedMoreInput;
+  }
+  return TryParse(false);
+}
+
+IncrementalParser::Status IncrementalParser::Finish() {
+  sona_assert(IsPending());
+  return TryParse(true);
+}
+
+bool IncrementalParser::IsPending() const noexcept {
+  return !m_EntryDone && m_Lexer.GetTokens().size() > 1;
+}
+
+sona::ref_ptr<Syntax::Node const>
+IncrementalParser::GetEntry() const noexcept {
+  return m_Entry.borrow();
+}
+
+IncrementalParser::~IncrementalParser() {}
+
+void IncrementalParser::StartEntry() {
+  m_Lexer.ApplyEdit(0, static_cast<std::uint32_t>(
+                         m_Lexer.GetSource().size()), "");
+  m_Lines.clear();
+  /// The nodes of the last entry and of all attempts at it go with the
+  /// parser and its arena
+  m_Entry = nullptr;
+  m_ParserImpl = sona::owner<ParserImpl>(new ParserImpl(m_TryDiag));
+  m_ScannedTokens = 0;
+  m_Depth = 0;
+  m_EntryDone = false;
+}
+
+IncrementalParser::Status IncrementalParser::TryParse(bool atEnd) {
+  TokenBuffer const& tokens = m_Lexer.GetTokens();
+  EntryTokenSource source(tokens, m_TryDiag);
+  Syntax::NodePtr<Syntax::Node> entry =
+      m_ParserImpl.borrow()->ParseReplEntry(
+        sona::ref_ptr<TokenSource>(source));
+  bool failed = m_TryDiag.HasPendingDiags();
+  m_TryDiag.ClearDiags();
+
+  if (!failed) {
+    m_Entry = std::move(entry);
+    m_EntryDone = true;
+    return IPS_Complete;
+  }
+  if (!atEnd && source.RanOutFirst()) {
+    return IPS_NeedMoreInput;
+  }
+
+  /// Parsed once more for the diagnostics only, errors are rare enough
+  ParserImpl reporter(m_Diag);
+  EntryTokenSource again(tokens, m_Diag);
+  reporter.ParseReplEntry(sona::ref_ptr<TokenSource>(again));
+  m_EntryDone = true;
+  return IPS_Error;
+}
+
 } // namespace Frontend
 } // namespace ckx
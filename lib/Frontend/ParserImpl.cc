@@ -1,6 +1,10 @@
 #include "Frontend/ParserImpl.h"
 #include "sona/global_counter.h"
 
+#include <algorithm>
+#include <atomic>
+#include <thread>
+
 namespace ckx {
 namespace Frontend {
 
@@ -12,38 +16,266 @@ static std::string CreateAnonymousName() {
 
 sona::owner<Syntax::TransUnit>
 ParserImpl::ParseTransUnit(
-    sona::ref_ptr<std::vector<Token> const> tokenStream) {
+    sona::ref_ptr<TokenBuffer const> tokenStream) {
   SetParsingTokenStream(tokenStream);
+  return ParseTransUnit(m_TokenSource);
+}
+
+sona::owner<Syntax::TransUnit>
+ParserImpl::ParseTransUnit(sona::ref_ptr<TokenSource> tokenSource) {
+  SetTokenSource(tokenSource);
 
   sona::owner<Syntax::TransUnit> ret = new Syntax::TransUnit;
+  m_Arena = ret.borrow()->GetArena();
   while (CurrentToken().GetTokenKind() != Token::TK_EOI) {
-    sona::owner<Syntax::Decl> d = ParseDeclOrFndef();
-    if (d.borrow() == nullptr) {
+    Syntax::NodePtr<Syntax::Decl> d = ParseTopLevelDecl();
+    if (d.borrow() != nullptr) {
+      ret.borrow()->Declare(std::move(d));
+    }
+  }
+
+  m_Arena = m_OwnArena;
+  return ret;
+}
+
+namespace {
+
+/// Below this many declarations per thread, threads cost more than they
+/// save
+constexpr std::size_t MinDeclsPerThread = 256;
+
+/// Batches handed out per thread, so that threads done early take over
+/// the work of those running into long declarations
+constexpr std::size_t BatchesPerThread = 8;
+
+/// Indices of the tokens the serial parser starts top-level declarations
+/// at in well-formed input: declaration keywords outside of any braces,
+/// the class of an enum class excepted. The index of the TK_EOI token
+/// ends the list.
+std::vector<std::size_t> FindTopLevelDecls(TokenBuffer const& tokens) {
+  std::vector<std::size_t> ret { 0 };
+  std::size_t depth = 0;
+  for (std::size_t i = 0; i < tokens.size(); i++) {
+    switch (tokens.GetTokenKind(i)) {
+    case Token::TK_SYM_LBRACE:
+      ++depth;
+      break;
+    case Token::TK_SYM_RBRACE:
+      if (depth != 0) {
+        --depth;
+      }
+      break;
+    case Token::TK_KW_class:
+      if (depth == 0 && i != 0
+          && tokens.GetTokenKind(i - 1) != Token::TK_KW_enum) {
+        ret.push_back(i);
+      }
+      break;
+    case Token::TK_KW_def: case Token::TK_KW_enum:
+    case Token::TK_KW_func: case Token::TK_KW_using:
+      if (depth == 0 && i != 0) {
+        ret.push_back(i);
+      }
+      break;
+    case Token::TK_EOI:
+      ret.push_back(i);
+      return ret;
+    default:
+      break;
+    }
+  }
+  sona_unreachable();
+  return ret;
+}
+
+} // namespace
+
+sona::owner<Syntax::TransUnit>
+ParserImpl::ParseTransUnitInParallel(
+    sona::ref_ptr<TokenBuffer const> tokenStream, unsigned numThreads) {
+  std::vector<std::size_t> declStarts = FindTopLevelDecls(tokenStream.get());
+  std::size_t numDecls = declStarts.size() - 1;
+  std::size_t numWorkers = std::min<std::size_t>(
+                             numThreads, numDecls / MinDeclsPerThread);
+  if (numWorkers < 2 || m_Diag.GetBudget().IsExhausted()) {
+    return ParseTransUnit(tokenStream);
+  }
+
+  struct Batch {
+    std::size_t First, Last;
+    /// Where its parser stopped, past Last if the last declaration ran
+    /// over it
+    std::size_t End = 0;
+    bool Parsed = false;
+    std::vector<Syntax::NodePtr<Syntax::Decl>> Decls;
+  };
+  std::size_t numBatches = std::min(numWorkers * BatchesPerThread, numDecls);
+  std::vector<Batch> batches(numBatches);
+  for (std::size_t i = 0; i < numBatches; i++) {
+    batches[i].First = declStarts[numDecls * i / numBatches];
+    batches[i].Last = declStarts[numDecls * (i + 1) / numBatches];
+  }
+
+  /// Every worker parses with a parser and an arena of its own, taking the
+  /// next batch nobody took yet until none is left, so each works through
+  /// the source front to back. It records into the caller's engine, the
+  /// diagnostics of batch i tagged i + 1, and shares the caller's budget.
+  sona::owner<Syntax::TransUnit> ret = new Syntax::TransUnit;
+  std::vector<sona::owner<ParserImpl>> workerParsers;
+  std::vector<sona::ref_ptr<Syntax::SyntaxArena>> workerArenas;
+  for (std::size_t i = 0; i < numWorkers; i++) {
+    workerParsers.emplace_back(new ParserImpl(m_Diag));
+    workerParsers.back().borrow()->SetSkipFuncBodies(m_SkipFuncBodies);
+    workerArenas.push_back(i == 0 ? ret.borrow()->GetArena()
+                                  : ret.borrow()->AddArena());
+  }
+
+  std::atomic<std::size_t> nextBatch { 0 };
+  auto work = [&](std::size_t worker) {
+    for (std::size_t i = nextBatch++; i < numBatches; i = nextBatch++) {
+      if (m_Diag.GetBudget().IsExhausted()) {
+        break;
+      }
+      Batch &batch = batches[i];
+      m_Diag.SetThreadTag(i + 1);
+      batch.End = workerParsers[worker].borrow()->ParseDeclRange(
+                    tokenStream, batch.First, batch.Last,
+                    workerArenas[worker], batch.Decls);
+      batch.Parsed = true;
+    }
+    m_Diag.DetachThread();
+  };
+  /// The calling thread keeps out of the batches, its own buffer only gets
+  /// the declarations parsed again below, in order
+  std::vector<std::thread> threads;
+  for (std::size_t i = 0; i < numWorkers; i++) {
+    threads.emplace_back(work, i);
+  }
+  for (std::thread &thread : threads) {
+    thread.join();
+  }
+
+  /// A batch starting where the serial parser stands parses what it would
+  /// have parsed, up to where the batch ends. Error recovery may skip over
+  /// the start of the next batch, whose work is then wasted: the serial
+  /// parser takes over from there to the end of that batch. Out of budget
+  /// it stops at once, and all batches behind it go.
+  std::vector<bool> wasted(numBatches, false);
+  std::size_t serialIndex = 0;
+  for (std::size_t i = 0; i < numBatches; i++) {
+    Batch &batch = batches[i];
+    if (batch.Parsed && batch.First == serialIndex) {
+      serialIndex = batch.End;
       continue;
     }
-    if (d.borrow()->GetNodeKind() == Syntax::Node::CNK_VarDecl) {
-      ExpectAndConsume(Token::TK_SYM_SEMI);
+
+    wasted[i] = true;
+    batch.Decls.clear();
+    if (serialIndex >= batch.First && serialIndex < batch.Last) {
+      serialIndex = ParseDeclRange(tokenStream, serialIndex, batch.Last,
+                                   workerArenas[0], batch.Decls);
     }
-    ret.borrow()->Declare(std::move(d));
   }
+  m_Diag.DiscardTagged([&wasted](std::uint64_t tag) {
+    return wasted[tag - 1];
+  });
 
+  for (Batch &batch : batches) {
+    for (Syntax::NodePtr<Syntax::Decl> &decl : batch.Decls) {
+      ret.borrow()->Declare(std::move(decl));
+    }
+  }
   return ret;
 }
 
-sona::owner<Syntax::Expr>
-ParserImpl::ParseReplExpr(sona::ref_ptr<const std::vector<Token>> tokenStream) {
+std::size_t ParserImpl::ParseDeclRange(
+    sona::ref_ptr<TokenBuffer const> tokenStream,
+    std::size_t first, std::size_t last,
+    sona::ref_ptr<Syntax::SyntaxArena> arena,
+    std::vector<Syntax::NodePtr<Syntax::Decl>> &decls) {
+  TokenBufferSource source(tokenStream, first);
+  SetTokenSource(sona::ref_ptr<TokenSource>(source));
+  m_TokenIndex = first;
+  m_Arena = arena;
+  while (m_TokenIndex < last
+         && CurrentToken().GetTokenKind() != Token::TK_EOI) {
+    Syntax::NodePtr<Syntax::Decl> d = ParseTopLevelDecl();
+    if (d.borrow() != nullptr) {
+      decls.push_back(std::move(d));
+    }
+  }
+  m_Arena = m_OwnArena;
+  m_TokenSource = nullptr;
+  return m_TokenIndex;
+}
+
+Syntax::NodePtr<Syntax::Expr>
+ParserImpl::ParseReplExpr(sona::ref_ptr<TokenBuffer const> tokenStream) {
   SetParsingTokenStream(tokenStream);
   return ParseAssignExpr();
 }
 
-sona::owner<Syntax::VarDecl>
+Syntax::NodePtr<Syntax::VarDecl>
 ParserImpl::ParseReplVarDecl(
-    sona::ref_ptr<const std::vector<Token>> tokenStream) {
+    sona::ref_ptr<TokenBuffer const> tokenStream) {
   SetParsingTokenStream(tokenStream);
   return ParseVarDecl().cast_unsafe<Syntax::VarDecl>();
 }
 
-sona::owner<Syntax::Decl> ParserImpl::ParseDeclOrFndef() {
+Syntax::NodePtr<Syntax::Node>
+ParserImpl::ParseReplEntry(sona::ref_ptr<TokenSource> tokenSource) {
+  SetTokenSource(tokenSource);
+  Syntax::NodePtr<Syntax::Node> ret = nullptr;
+  if (CurrentToken().GetTokenKind() == Token::TK_KW_def) {
+    ret = ParseVarDecl();
+  }
+  else {
+    ret = ParseAssignExpr();
+  }
+
+  if (CurrentToken().GetTokenKind() == Token::TK_SYM_SEMI) {
+    ConsumeToken();
+  }
+  if (ret.borrow() != nullptr
+      && CurrentToken().GetTokenKind() != Token::TK_EOI) {
+    m_Diag.Diag(Diag::DIR_Error,
+                Diag::DMT_ErrExpectedGot, {
+                  PrettyPrintToken(CurrentToken()),
+                  "end of input"
+                },
+                CurrentToken().GetSourceRange());
+  }
+  m_TokenSource = nullptr;
+  return ret;
+}
+
+Syntax::NodePtr<Syntax::Stmt>
+ParserImpl::ParseFuncBody(sona::ref_ptr<TokenBuffer const> tokenStream,
+                          sona::ref_ptr<Syntax::TransUnit> unit,
+                          sona::ref_ptr<Syntax::FuncDecl const> funcDecl) {
+  std::size_t first = funcDecl->GetSkippedBodyBeginUnsafe();
+  sona_assert(funcDecl->GetSkippedBodyEndUnsafe() <= tokenStream->size());
+  sona_assert(tokenStream->GetTokenKind(first) == Token::TK_SYM_LBRACE);
+
+  m_OwnedTokenSource = new TokenBufferSource(tokenStream, first);
+  SetTokenSource(m_OwnedTokenSource.borrow());
+  m_TokenIndex = first;
+  m_Arena = unit->GetArena();
+  Syntax::NodePtr<Syntax::Stmt> ret = ParseCompoundStmt();
+  m_Arena = m_OwnArena;
+  return ret;
+}
+
+Syntax::NodePtr<Syntax::Decl> ParserImpl::ParseTopLevelDecl() {
+  Syntax::NodePtr<Syntax::Decl> d = ParseDeclOrFndef();
+  if (d.borrow() != nullptr
+      && d.borrow()->GetNodeKind() == Syntax::Node::CNK_VarDecl) {
+    ExpectAndConsume(Token::TK_SYM_SEMI);
+  }
+  return d;
+}
+
+Syntax::NodePtr<Syntax::Decl> ParserImpl::ParseDeclOrFndef() {
   switch (CurrentToken().GetTokenKind()) {
   case Token::TK_KW_def: return ParseVarDecl();
   case Token::TK_KW_class: return ParseClassDecl();
@@ -58,17 +290,16 @@ sona::owner<Syntax::Decl> ParserImpl::ParseDeclOrFndef() {
 
   default:
     m_Diag.Diag(Diag::DIR_Error,
-                Diag::Format(
-                  Diag::DMT_ErrExpectedGot,
-                  { PrettyPrintTokenKind(CurrentToken().GetTokenKind()),
-                    "declaration" }),
+                Diag::DMT_ErrExpectedGot,
+                { PrettyPrintTokenKind(CurrentToken().GetTokenKind()),
+                  "declaration" },
                 CurrentToken().GetSourceRange());
     ConsumeToken();
     return nullptr;
   }
 }
 
-sona::owner<Syntax::Decl> ParserImpl::ParseVarDecl() {
+Syntax::NodePtr<Syntax::Decl> ParserImpl::ParseVarDecl() {
   sona_assert(CurrentToken().GetTokenKind() == Token::TK_KW_def);
   SourceRange defRange = CurrentToken().GetSourceRange();
   ConsumeToken();
@@ -83,12 +314,17 @@ sona::owner<Syntax::Decl> ParserImpl::ParseVarDecl() {
 
   ExpectAndConsume(Token::TK_SYM_COLON);
 
-  sona::owner<Syntax::Type> type = ParseType();
-  return new Syntax::VarDecl(name, std::move(type), defRange, nameRange);
+  Syntax::NodePtr<Syntax::Type> type = ParseType();
+  return m_Arena->New<Syntax::VarDecl>(name, std::move(type),
+                                       defRange, nameRange);
 }
 
-sona::owner<Syntax::Decl> ParserImpl::ParseClassDecl() {
+Syntax::NodePtr<Syntax::Decl> ParserImpl::ParseClassDecl() {
   sona_assert(CurrentToken().GetTokenKind() == Token::TK_KW_class);
+  NestingScope nesting(*this);
+  if (TooDeep()) {
+    return nullptr;
+  }
   SourceRange classRange = CurrentToken().GetSourceRange();
   ConsumeToken();
 
@@ -103,17 +339,19 @@ sona::owner<Syntax::Decl> ParserImpl::ParseClassDecl() {
   if (!ExpectAndConsume(Token::TK_SYM_LBRACE)) {
     if (CurrentToken().GetTokenKind() == Token::TK_SYM_SEMI) {
       m_Diag.Diag(Diag::DIR_Note,
-                  Diag::Format(Diag::DMT_NoteNoForwardDecl, {}),
+                  Diag::DMT_NoteNoForwardDecl, {},
                   CurrentToken().GetSourceRange());
       ConsumeToken();
-      return new Syntax::ClassDecl(name, {}, classRange, nameRange);
+      return m_Arena->New<Syntax::ClassDecl>(
+               name, sona::array_ref<Syntax::NodePtr<Syntax::Decl>>(),
+               classRange, nameRange);
     }
     else {
       return nullptr;
     }
   }
 
-  std::vector<sona::owner<Syntax::Decl>> decls;
+  std::vector<Syntax::NodePtr<Syntax::Decl>> decls;
 
   while (CurrentToken().GetTokenKind() != Token::TK_EOI
          && CurrentToken().GetTokenKind() != Token::TK_SYM_RBRACE) {
@@ -133,10 +371,10 @@ sona::owner<Syntax::Decl> ParserImpl::ParseClassDecl() {
       break;
     default:
       m_Diag.Diag(Diag::DIR_Error,
-                  Diag::Format(Diag::DMT_ErrExpectedGot, {
-                                 PrettyPrintToken(CurrentToken()),
-                                 "field declaration"
-                               }),
+                  Diag::DMT_ErrExpectedGot, {
+                    PrettyPrintToken(CurrentToken()),
+                    "field declaration"
+                  },
                   CurrentToken().GetSourceRange());
       ConsumeToken();
       continue;
@@ -144,10 +382,12 @@ sona::owner<Syntax::Decl> ParserImpl::ParseClassDecl() {
   }
 
   ExpectAndConsume(Token::TK_SYM_RBRACE);
-  return new Syntax::ClassDecl(name, std::move(decls), classRange, nameRange);
+  return m_Arena->New<Syntax::ClassDecl>(name,
+                                         m_Arena->CopyArray(std::move(decls)),
+                                         classRange, nameRange);
 }
 
-sona::owner<Syntax::Decl> ParserImpl::ParseEnumDecl() {
+Syntax::NodePtr<Syntax::Decl> ParserImpl::ParseEnumDecl() {
   sona_assert(CurrentToken().GetTokenKind() == Token::TK_KW_enum);
   SourceRange enumRange = CurrentToken().GetSourceRange();
   ConsumeToken();
@@ -163,10 +403,12 @@ sona::owner<Syntax::Decl> ParserImpl::ParseEnumDecl() {
   if (!ExpectAndConsume(Token::TK_SYM_LBRACE)) {
     if (CurrentToken().GetTokenKind() == Token::TK_SYM_SEMI) {
       m_Diag.Diag(Diag::DIR_Note,
-                  Diag::Format(Diag::DMT_NoteNoForwardDecl, {}),
+                  Diag::DMT_NoteNoForwardDecl, {},
                   CurrentToken().GetSourceRange());
       ConsumeToken();
-      return new Syntax::EnumDecl(name, {}, enumRange, nameRange);
+      return m_Arena->New<Syntax::EnumDecl>(
+               name, sona::array_ref<Syntax::EnumDecl::Enumerator>(),
+               enumRange, nameRange);
     }
     else {
       return nullptr;
@@ -188,7 +430,7 @@ sona::owner<Syntax::Decl> ParserImpl::ParseEnumDecl() {
     if (!ExpectAndConsume(Token::TK_SYM_SEMI)) {
       if (CurrentToken().GetTokenKind() == Token::TK_SYM_COMMA) {
         m_Diag.Diag(Diag::DIR_Note,
-                    Diag::Format(Diag::DMT_NoteEnumeratorSep, {}),
+                    Diag::DMT_NoteEnumeratorSep, {},
                     CurrentToken().GetSourceRange());
         ConsumeToken();
       }
@@ -196,11 +438,12 @@ sona::owner<Syntax::Decl> ParserImpl::ParseEnumDecl() {
   }
 
   ExpectAndConsume(Token::TK_SYM_RBRACE);
-  return new Syntax::EnumDecl(name, std::move(enumerators),
-                              enumRange, nameRange);
+  return m_Arena->New<Syntax::EnumDecl>(
+           name, m_Arena->CopyArray(std::move(enumerators)),
+           enumRange, nameRange);
 }
 
-sona::owner<Syntax::Decl> ParserImpl::ParseADTDecl() {
+Syntax::NodePtr<Syntax::Decl> ParserImpl::ParseADTDecl() {
   sona_assert(CurrentToken().GetTokenKind() == Token::TK_KW_enum);
   sona_assert(PeekToken().GetTokenKind() == Token::TK_KW_class);
 
@@ -220,10 +463,12 @@ sona::owner<Syntax::Decl> ParserImpl::ParseADTDecl() {
   if (!ExpectAndConsume(Token::TK_SYM_LBRACE)) {
     if (CurrentToken().GetTokenKind() == Token::TK_SYM_SEMI) {
       m_Diag.Diag(Diag::DIR_Note,
-                  Diag::Format(Diag::DMT_NoteNoForwardDecl, {}),
+                  Diag::DMT_NoteNoForwardDecl, {},
                   CurrentToken().GetSourceRange());
       ConsumeToken();
-      return new Syntax::ADTDecl(name, {}, enumRange, classRange, nameRange);
+      return m_Arena->New<Syntax::ADTDecl>(
+               name, sona::array_ref<Syntax::ADTDecl::ValueConstructor>(),
+               enumRange, classRange, nameRange);
     }
     else {
       return nullptr;
@@ -247,11 +492,12 @@ sona::owner<Syntax::Decl> ParserImpl::ParseADTDecl() {
 
   ExpectAndConsume(Token::TK_SYM_RBRACE);
 
-  return new Syntax::ADTDecl(name, std::move(dataConstructors),
-                             enumRange, classRange, nameRange);
+  return m_Arena->New<Syntax::ADTDecl>(
+           name, m_Arena->CopyArray(std::move(dataConstructors)),
+           enumRange, classRange, nameRange);
 }
 
-sona::owner<Syntax::Decl> ParserImpl::ParseFuncDecl() {
+Syntax::NodePtr<Syntax::Decl> ParserImpl::ParseFuncDecl() {
   sona_assert(CurrentToken().GetTokenKind() == Token::TK_KW_func);
   SourceRange funcRange = CurrentToken().GetSourceRange();
   ConsumeToken();
@@ -269,48 +515,81 @@ sona::owner<Syntax::Decl> ParserImpl::ParseFuncDecl() {
   }
 
   std::vector<sona::strhdl_t> paramNames;
-  std::vector<sona::owner<Syntax::Type>> paramTypes;
+  std::vector<Syntax::NodePtr<Syntax::Type>> paramTypes;
 
-  while (CurrentToken().GetTokenKind() != Token::TK_EOI) {
-    if (!Expect(Token::TK_ID)) {
-      continue;
+  if (CurrentToken().GetTokenKind() != Token::TK_SYM_RPAREN) {
+    for (;;) {
+      if (!ParseFuncParam(paramNames, paramTypes)) {
+        /// A malformed parameter may have consumed nothing
+        SkipToAnyOf({ Token::TK_SYM_COMMA, Token::TK_SYM_RPAREN });
+      }
+      if (CurrentToken().GetTokenKind() != Token::TK_SYM_COMMA) {
+        break;
+      }
+      ConsumeToken();
     }
-    sona::strhdl_t paramName = CurrentToken().GetStrValueUnsafe();
-    ConsumeToken();
+  }
+  ExpectAndConsume(Token::TK_SYM_RPAREN);
 
-    if (!ExpectAndConsume(Token::TK_SYM_COLON)) {
-      continue;
-    }
+  if (!ExpectAndConsume(Token::TK_SYM_COLON)) {
+    return nullptr;
+  }
 
-    sona::owner<Syntax::Type> type = ParseType();
-    if (type.borrow() == nullptr) {
-      continue;
+  Syntax::NodePtr<Syntax::Type> retType = ParseType();
+  if (CurrentToken().GetTokenKind() != Token::TK_SYM_LBRACE) {
+    ExpectAndConsume(Token::TK_SYM_SEMI);
+    return m_Arena->New<Syntax::FuncDecl>(
+             name, m_Arena->CopyArray(std::move(paramTypes)),
+             m_Arena->CopyArray(std::move(paramNames)), std::move(retType),
+             sona::empty_optional(), funcRange, nameRange);
+  }
+
+  if (m_SkipFuncBodies) {
+    std::size_t lbraceIndex = m_TokenIndex;
+    std::size_t rbraceIndex;
+    bool complete = SkipFuncBody(rbraceIndex);
+    Syntax::NodePtr<Syntax::FuncDecl> ret = m_Arena->New<Syntax::FuncDecl>(
+        name, m_Arena->CopyArray(std::move(paramTypes)),
+        m_Arena->CopyArray(std::move(paramNames)), std::move(retType),
+        sona::empty_optional(), funcRange, nameRange);
+    if (complete) {
+      ret.borrow()->SetSkippedBody(static_cast<std::uint32_t>(lbraceIndex),
+                                   static_cast<std::uint32_t>(rbraceIndex));
     }
+    return ret;
+  }
 
-    paramNames.push_back(paramName);
-    paramTypes.push_back(std::move(type));
+  Syntax::NodePtr<Syntax::Stmt> body = ParseCompoundStmt();
+  return m_Arena->New<Syntax::FuncDecl>(
+           name, m_Arena->CopyArray(std::move(paramTypes)),
+           m_Arena->CopyArray(std::move(paramNames)), std::move(retType),
+           std::move(body), funcRange, nameRange);
+}
 
-    if (CurrentToken().GetTokenKind() == Token::TK_SYM_COMMA) {
-      ConsumeToken();
-    }
-    else {
-      ExpectAndConsume(Token::TK_SYM_RPAREN);
-      break;
-    }
+bool ParserImpl::ParseFuncParam(
+    std::vector<sona::strhdl_t> &paramNames,
+    std::vector<Syntax::NodePtr<Syntax::Type>> &paramTypes) {
+  if (!Expect(Token::TK_ID)) {
+    return false;
   }
+  sona::strhdl_t paramName = CurrentToken().GetStrValueUnsafe();
+  ConsumeToken();
 
   if (!ExpectAndConsume(Token::TK_SYM_COLON)) {
-    return nullptr;
+    return false;
   }
 
-  sona::owner<Syntax::Type> retType = ParseType();
-  ExpectAndConsume(Token::TK_SYM_SEMI);
-  return new Syntax::FuncDecl(name, std::move(paramTypes),
-                              std::move(paramNames), std::move(retType),
-                              sona::empty_optional(), funcRange, nameRange);
+  Syntax::NodePtr<Syntax::Type> type = ParseType();
+  if (type.borrow() == nullptr) {
+    return false;
+  }
+
+  paramNames.push_back(paramName);
+  paramTypes.push_back(std::move(type));
+  return true;
 }
 
-sona::owner<Syntax::Decl> ParserImpl::ParseUsingDecl() {
+Syntax::NodePtr<Syntax::Decl> ParserImpl::ParseUsingDecl() {
   sona_assert(CurrentToken().GetTokenKind() == Token::TK_KW_using);
   SourceRange usingRange = CurrentToken().GetSourceRange();
   ConsumeToken();
@@ -325,16 +604,14 @@ sona::owner<Syntax::Decl> ParserImpl::ParseUsingDecl() {
   if (!Expect(Token::TK_SYM_EQ)) {
     return nullptr;
   }
-  SourceLocation eqLoc =
-      SourceLocation(CurrentToken().GetSourceRange().GetStartLine(),
-                     CurrentToken().GetSourceRange().GetStartCol());
+  SourceRange eqRange = CurrentToken().GetSourceRange();
   ConsumeToken();
 
-  sona::owner<Syntax::Type> aliasee = ParseType();
+  Syntax::NodePtr<Syntax::Type> aliasee = ParseType();
   ExpectAndConsume(Token::TK_SYM_SEMI);
 
-  return new Syntax::UsingDecl(name, std::move(aliasee), usingRange,
-                               nameRange, eqLoc);
+  return m_Arena->New<Syntax::UsingDecl>(name, std::move(aliasee),
+                                         usingRange, nameRange, eqRange);
 }
 
 void ParserImpl::
@@ -382,14 +659,14 @@ void ParserImpl::ParseDataConstructor(
   }
 
   ConsumeToken();
-  sona::owner<Syntax::Type> underlyingType = ParseType();
+  Syntax::NodePtr<Syntax::Type> underlyingType = ParseType();
   if (underlyingType.borrow() == nullptr) {
     return;
   }
   if (!ExpectAndConsume(Token::TK_SYM_RPAREN)) {
     if (CurrentToken().GetTokenKind() == Token::TK_SYM_COMMA) {
       m_Diag.Diag(Diag::DIR_Note,
-                  Diag::Format(Diag::DMT_NoteOneTypeInValueCtor, {}),
+                  Diag::DMT_NoteOneTypeInValueCtor, {},
                   CurrentToken().GetSourceRange());
       dataConstructors.emplace_back(name, std::move(underlyingType), nameRange);
     }
@@ -405,8 +682,8 @@ void ParserImpl::ParseDataConstructor(
   dataConstructors.emplace_back(name, std::move(underlyingType), nameRange);
 }
 
-sona::owner<Syntax::Type> ParserImpl::ParseType() {
-  sona::owner<Syntax::Type> ret = nullptr;
+Syntax::NodePtr<Syntax::Type> ParserImpl::ParseType() {
+  Syntax::NodePtr<Syntax::Type> ret = nullptr;
   if (CurrentToken().GetTokenKind() == Token::TK_ID) {
     ret = ParseUserDefinedType();
   }
@@ -416,10 +693,10 @@ sona::owner<Syntax::Type> ParserImpl::ParseType() {
 
   if (ret.borrow() == nullptr) {
     m_Diag.Diag(Diag::DIR_Error,
-                Diag::Format(Diag::DMT_ErrExpectedGot, {
-                               PrettyPrintToken(CurrentToken()),
-                               "type"
-                             }),
+                Diag::DMT_ErrExpectedGot, {
+                  PrettyPrintToken(CurrentToken()),
+                  "type"
+                },
                 CurrentToken().GetSourceRange());
   }
 
@@ -460,19 +737,93 @@ sona::owner<Syntax::Type> ParserImpl::ParseType() {
 
   if (tySpecs.size() != 0) {
     sona_assert(tySpecs.size() == tySpecRanges.size())
-    ret = new Syntax::ComposedType(std::move(ret), std::move(tySpecs),
-                                   std::move(tySpecRanges));
+    ret = m_Arena->New<Syntax::ComposedType>(
+            std::move(ret), m_Arena->CopyArray(std::move(tySpecs)),
+            m_Arena->CopyArray(std::move(tySpecRanges)));
   }
 
   return ret;
 }
 
-sona::owner<Syntax::Expr> ParserImpl::ParseExpr() {
+Syntax::NodePtr<Syntax::Stmt> ParserImpl::ParseStmt() {
+  switch (CurrentToken().GetTokenKind()) {
+  case Token::TK_SYM_LBRACE:
+    return ParseCompoundStmt();
+
+  case Token::TK_SYM_SEMI: {
+    SourceRange semiRange = CurrentToken().GetSourceRange();
+    ConsumeToken();
+    return m_Arena->New<Syntax::EmptyStmt>(semiRange);
+  }
+
+  case Token::TK_KW_return:
+    return ParseReturnStmt();
+
+  default:
+    return ParseExprStmt();
+  }
+}
+
+Syntax::NodePtr<Syntax::Stmt> ParserImpl::ParseCompoundStmt() {
+  sona_assert(CurrentToken().GetTokenKind() == Token::TK_SYM_LBRACE);
+  NestingScope nesting(*this);
+  if (TooDeep()) {
+    return nullptr;
+  }
+  SourceRange lbraceRange = CurrentToken().GetSourceRange();
+  ConsumeToken();
+
+  std::vector<Syntax::NodePtr<Syntax::Stmt>> stmts;
+  while (CurrentToken().GetTokenKind() != Token::TK_EOI
+         && CurrentToken().GetTokenKind() != Token::TK_SYM_RBRACE) {
+    Syntax::NodePtr<Syntax::Stmt> stmt = ParseStmt();
+    if (stmt.borrow() != nullptr) {
+      stmts.push_back(std::move(stmt));
+    }
+  }
+
+  SourceRange rbraceRange = CurrentToken().GetSourceRange();
+  ExpectAndConsume(Token::TK_SYM_RBRACE);
+  return m_Arena->New<Syntax::CompoundStmt>(
+           m_Arena->CopyArray(std::move(stmts)), lbraceRange, rbraceRange);
+}
+
+Syntax::NodePtr<Syntax::Stmt> ParserImpl::ParseExprStmt() {
+  Syntax::NodePtr<Syntax::Expr> expr = ParseExpr();
+  /// Whatever follows a broken statement is skipped up to where the next
+  /// one may start, so that every statement parsed moves on
+  if (expr.borrow() == nullptr || !ExpectAndConsume(Token::TK_SYM_SEMI)) {
+    SkipToAnyOf({ Token::TK_SYM_SEMI, Token::TK_SYM_RBRACE });
+    if (CurrentToken().GetTokenKind() == Token::TK_SYM_SEMI) {
+      ConsumeToken();
+    }
+  }
+  if (expr.borrow() == nullptr) {
+    return nullptr;
+  }
+  return m_Arena->New<Syntax::ExprStmt>(std::move(expr));
+}
+
+Syntax::NodePtr<Syntax::Stmt> ParserImpl::ParseReturnStmt() {
+  sona_assert(CurrentToken().GetTokenKind() == Token::TK_KW_return);
+  SourceRange returnRange = CurrentToken().GetSourceRange();
+  ConsumeToken();
+
+  Syntax::NodePtr<Syntax::Expr> returnValue = nullptr;
+  if (CurrentToken().GetTokenKind() != Token::TK_SYM_SEMI) {
+    returnValue = ParseExpr();
+  }
+  ExpectAndConsume(Token::TK_SYM_SEMI);
+  return m_Arena->New<Syntax::ReturnStmt>(std::move(returnValue),
+                                          returnRange);
+}
+
+Syntax::NodePtr<Syntax::Expr> ParserImpl::ParseExpr() {
   return ParseAssignExpr();
 }
 
-sona::owner<Syntax::Expr> ParserImpl::ParseAssignExpr() {
-  sona::owner<Syntax::Expr> lhs =
+Syntax::NodePtr<Syntax::Expr> ParserImpl::ParseAssignExpr() {
+  Syntax::NodePtr<Syntax::Expr> lhs =
       ParseBinaryExpr(Syntax::PrecOf(Syntax::BinaryOperator::BOP_Eq));
   if (lhs.borrow() == nullptr) {
     return nullptr;
@@ -483,48 +834,53 @@ sona::owner<Syntax::Expr> ParserImpl::ParseAssignExpr() {
     SourceRange opRange = CurrentToken().GetSourceRange();
     ConsumeToken();
 
-    sona::owner<Syntax::Expr> rhs =
+    Syntax::NodePtr<Syntax::Expr> rhs =
         ParseBinaryExpr(Syntax::PrecOf(Syntax::BinaryOperator::BOP_Eq));
-    return new Syntax::AssignExpr(op, std::move(lhs), std::move(rhs), opRange);
+    return m_Arena->New<Syntax::AssignExpr>(op, std::move(lhs),
+                                            std::move(rhs), opRange);
   }
   else {
     return lhs;
   }
 }
 
-sona::owner<Syntax::Expr> ParserImpl::ParseLiteralExpr() {
-  sona::owner<Syntax::Expr> ret = nullptr;
+Syntax::NodePtr<Syntax::Expr> ParserImpl::ParseLiteralExpr() {
+  Syntax::NodePtr<Syntax::Expr> ret = nullptr;
   switch (CurrentToken().GetTokenKind()) {
   case Token::TK_KW_true:
-    ret = new Syntax::BoolLiteralExpr(true, CurrentToken().GetSourceRange());
+    ret = m_Arena->New<Syntax::BoolLiteralExpr>(
+            true, CurrentToken().GetSourceRange());
     break;
 
   case Token::TK_KW_false:
-    ret = new Syntax::BoolLiteralExpr(false, CurrentToken().GetSourceRange());
+    ret = m_Arena->New<Syntax::BoolLiteralExpr>(
+            false, CurrentToken().GetSourceRange());
     break;
 
   case Token::TK_KW_nullptr:
-    ret = new Syntax::NullLiteralExpr(CurrentToken().GetSourceRange());
+    ret = m_Arena->New<Syntax::NullLiteralExpr>(
+            CurrentToken().GetSourceRange());
     break;
 
   case Token::TK_LIT_INT:
-    ret = new Syntax::IntLiteralExpr(
+    ret = m_Arena->New<Syntax::IntLiteralExpr>(
             CurrentToken().GetIntValueUnsafe(),
             CurrentToken().GetSourceRange());
     break;
   case Token::TK_LIT_UINT:
-    ret = new Syntax::UIntLiteralExpr(
+    ret = m_Arena->New<Syntax::UIntLiteralExpr>(
             CurrentToken().GetUIntValueUnsafe(),
             CurrentToken().GetSourceRange());
     break;
   case Token::TK_LIT_FLOAT:
-    ret = new Syntax::FloatLiteralExpr(
+    ret = m_Arena->New<Syntax::FloatLiteralExpr>(
             CurrentToken().GetFloatValueUnsafe(),
             CurrentToken().GetSourceRange());
     break;
   case Token::TK_LIT_STR:
-    return new Syntax::StringLiteralExpr(CurrentToken().GetStrValueUnsafe(),
-                                         CurrentToken().GetSourceRange());
+    ret = m_Arena->New<Syntax::StringLiteralExpr>(
+            CurrentToken().GetStrValueUnsafe(),
+            CurrentToken().GetSourceRange());
     break;
   default:
     sona_unreachable();
@@ -533,11 +889,16 @@ sona::owner<Syntax::Expr> ParserImpl::ParseLiteralExpr() {
   return ret;
 }
 
-sona::owner<Syntax::Expr> ParserImpl::ParseIdRefExpr() {
-  return new Syntax::IdRefExpr(ParseIdentifier());
+Syntax::NodePtr<Syntax::Expr> ParserImpl::ParseIdRefExpr() {
+  return m_Arena->New<Syntax::IdRefExpr>(ParseIdentifier());
 }
 
-sona::owner<Syntax::Expr> ParserImpl::ParseUnaryExpr() {
+Syntax::NodePtr<Syntax::Expr> ParserImpl::ParseUnaryExpr() {
+  NestingScope nesting(*this);
+  if (TooDeep()) {
+    return nullptr;
+  }
+
   switch (CurrentToken().GetTokenKind()) {
   case Token::TK_KW_sizeof:
     return ParseSizeofExpr();
@@ -558,6 +919,9 @@ sona::owner<Syntax::Expr> ParserImpl::ParseUnaryExpr() {
   case Token::TK_LIT_UINT:
   case Token::TK_LIT_FLOAT:
   case Token::TK_LIT_STR:
+  case Token::TK_KW_true:
+  case Token::TK_KW_false:
+  case Token::TK_KW_nullptr:
     return ParseLiteralExpr();
 
   case Token::TK_ID:
@@ -565,24 +929,25 @@ sona::owner<Syntax::Expr> ParserImpl::ParseUnaryExpr() {
 
   default:
     m_Diag.Diag(Diag::DIR_Error,
-                Diag::Format(Diag::DMT_ErrUnexpectedCharInContext, {
-                               PrettyPrintToken(CurrentToken()),
-                               "unary expression"}),
+                Diag::DMT_ErrUnexpectedCharInContext, {
+                  PrettyPrintToken(CurrentToken()),
+                  "unary expression"},
                 CurrentToken().GetSourceRange());
     return nullptr;
   }
 }
 
-sona::owner<Syntax::Expr> ParserImpl::ParseUnaryAlgebraicExpr() {
+Syntax::NodePtr<Syntax::Expr> ParserImpl::ParseUnaryAlgebraicExpr() {
   Syntax::UnaryOperator uop = TokenToUnary(CurrentToken().GetTokenKind());
   SourceRange uopRange = CurrentToken().GetSourceRange();
   ConsumeToken();
 
-  sona::owner<Syntax::Expr> e = ParseUnaryExpr();
-  return new Syntax::UnaryAlgebraicExpr(uop, std::move(e), uopRange);
+  Syntax::NodePtr<Syntax::Expr> e = ParseUnaryExpr();
+  return m_Arena->New<Syntax::UnaryAlgebraicExpr>(uop, std::move(e),
+                                                  uopRange);
 }
 
-sona::owner<Syntax::Expr> ParserImpl::ParseSizeofExpr() {
+Syntax::NodePtr<Syntax::Expr> ParserImpl::ParseSizeofExpr() {
   sona_assert(CurrentToken().GetTokenKind() == Token::TK_KW_sizeof);
   SourceRange sizeofRange = CurrentToken().GetSourceRange();
   ConsumeToken();
@@ -591,13 +956,14 @@ sona::owner<Syntax::Expr> ParserImpl::ParseSizeofExpr() {
     return nullptr;
   }
 
-  sona::owner<Syntax::Expr> containedExpr = ParseExpr();
+  Syntax::NodePtr<Syntax::Expr> containedExpr = ParseExpr();
   ExpectAndConsume(Token::TK_SYM_RPAREN);
 
-  return new Syntax::SizeOfExpr(std::move(containedExpr), sizeofRange);
+  return m_Arena->New<Syntax::SizeOfExpr>(std::move(containedExpr),
+                                          sizeofRange);
 }
 
-sona::owner<Syntax::Expr> ParserImpl::ParseAlignofExpr() {
+Syntax::NodePtr<Syntax::Expr> ParserImpl::ParseAlignofExpr() {
   sona_assert(CurrentToken().GetTokenKind() == Token::TK_KW_alignof);
   SourceRange alignofRange = CurrentToken().GetSourceRange();
   ConsumeToken();
@@ -606,13 +972,14 @@ sona::owner<Syntax::Expr> ParserImpl::ParseAlignofExpr() {
     return nullptr;
   }
 
-  sona::owner<Syntax::Expr> containedExpr = ParseExpr();
+  Syntax::NodePtr<Syntax::Expr> containedExpr = ParseExpr();
   ExpectAndConsume(Token::TK_SYM_RPAREN);
 
-  return new Syntax::SizeOfExpr(std::move(containedExpr), alignofRange);
+  return m_Arena->New<Syntax::AlignOfExpr>(std::move(containedExpr),
+                                           alignofRange);
 }
 
-sona::owner<Syntax::Expr> ParserImpl::ParseCastExpr() {
+Syntax::NodePtr<Syntax::Expr> ParserImpl::ParseCastExpr() {
   Syntax::CastOperator cop = TokenToCastOp(CurrentToken().GetTokenKind());
   SourceRange castOpRange = CurrentToken().GetSourceRange();
   ConsumeToken();
@@ -620,21 +987,21 @@ sona::owner<Syntax::Expr> ParserImpl::ParseCastExpr() {
   if (!ExpectAndConsume(Token::TK_SYM_LT)) {
     return nullptr;
   }
-  sona::owner<Syntax::Type> destType = ParseType();
+  Syntax::NodePtr<Syntax::Type> destType = ParseType();
   ExpectAndConsume(Token::TK_SYM_GT);
 
   if (!ExpectAndConsume(Token::TK_SYM_LPAREN)) {
     return nullptr;
   }
-  sona::owner<Syntax::Expr> castedExpr = ParseExpr();
+  Syntax::NodePtr<Syntax::Expr> castedExpr = ParseExpr();
   ExpectAndConsume(Token::TK_SYM_RPAREN);
 
-  return new Syntax::CastExpr(cop, std::move(castedExpr),
-                              std::move(destType), castOpRange);
+  return m_Arena->New<Syntax::CastExpr>(cop, std::move(castedExpr),
+                                        std::move(destType), castOpRange);
 }
 
-sona::owner<Syntax::Expr> ParserImpl::ParsePostfixExpr() {
-  sona::owner<Syntax::Expr> parsed = ParseUnaryExpr();
+Syntax::NodePtr<Syntax::Expr> ParserImpl::ParsePostfixExpr() {
+  Syntax::NodePtr<Syntax::Expr> parsed = ParseUnaryExpr();
 
   for (;;) {
     switch (CurrentToken().GetTokenKind()) {
@@ -650,16 +1017,18 @@ sona::owner<Syntax::Expr> ParserImpl::ParsePostfixExpr() {
   }
 }
 
-sona::owner<Syntax::Expr>
-ParserImpl::ParseFuncCallExpr(sona::owner<Syntax::Expr>&& parsedCallee) {
+Syntax::NodePtr<Syntax::Expr>
+ParserImpl::ParseFuncCallExpr(Syntax::NodePtr<Syntax::Expr>&& parsedCallee) {
   sona_assert(CurrentToken().GetTokenKind() == Token::TK_SYM_LPAREN);
   ConsumeToken();
 
-  std::vector<sona::owner<Syntax::Expr>> args;
+  std::vector<Syntax::NodePtr<Syntax::Expr>> args;
 
   if (CurrentToken().GetTokenKind() == Token::TK_SYM_RPAREN) {
     ConsumeToken();
-    return new Syntax::FuncCallExpr(std::move(parsedCallee), std::move(args));
+    return m_Arena->New<Syntax::FuncCallExpr>(
+             std::move(parsedCallee),
+             sona::array_ref<Syntax::NodePtr<Syntax::Expr>>());
   }
 
   for (;;) {
@@ -671,31 +1040,34 @@ ParserImpl::ParseFuncCallExpr(sona::owner<Syntax::Expr>&& parsedCallee) {
     ExpectAndConsume(Token::TK_SYM_COMMA);
   }
 
-  return new Syntax::FuncCallExpr(std::move(parsedCallee), std::move(args));
+  return m_Arena->New<Syntax::FuncCallExpr>(
+           std::move(parsedCallee), m_Arena->CopyArray(std::move(args)));
 }
 
-sona::owner<Syntax::Expr>
-ParserImpl::ParseArraySubscriptExpr(sona::owner<Syntax::Expr>&& arr) {
+Syntax::NodePtr<Syntax::Expr>
+ParserImpl::ParseArraySubscriptExpr(Syntax::NodePtr<Syntax::Expr>&& arr) {
   sona_assert(CurrentToken().GetTokenKind() == Token::TK_SYM_LBRACKET);
   ConsumeToken();
 
-  sona::owner<Syntax::Expr> index = ParseExpr();
+  Syntax::NodePtr<Syntax::Expr> index = ParseExpr();
   ExpectAndConsume(Token::TK_SYM_RBRACKET);
 
-  return new Syntax::ArraySubscriptExpr(std::move(arr), std::move(index));
+  return m_Arena->New<Syntax::ArraySubscriptExpr>(std::move(arr),
+                                                  std::move(index));
 }
 
-sona::owner<Syntax::Expr>
-ParserImpl::ParseMemberAccessExpr(sona::owner<Syntax::Expr>&& base) {
+Syntax::NodePtr<Syntax::Expr>
+ParserImpl::ParseMemberAccessExpr(Syntax::NodePtr<Syntax::Expr>&& base) {
   sona_assert(CurrentToken().GetTokenKind() == Token::TK_SYM_DOT);
   ConsumeToken();
   Syntax::Identifier member = ParseIdentifier();
-  return new Syntax::MemberAccessExpr(std::move(base), std::move(member));
+  return m_Arena->New<Syntax::MemberAccessExpr>(std::move(base),
+                                                std::move(member));
 }
 
-sona::owner<Syntax::Expr>
+Syntax::NodePtr<Syntax::Expr>
 ParserImpl::ParseBinaryExpr(std::uint16_t prevPrec) {
-  sona::owner<Syntax::Expr> e0 = ParseUnaryExpr();
+  Syntax::NodePtr<Syntax::Expr> e0 = ParseUnaryExpr();
   if (e0.borrow() == nullptr) {
     return nullptr;
   }
@@ -707,15 +1079,21 @@ ParserImpl::ParseBinaryExpr(std::uint16_t prevPrec) {
     SourceRange opRange = CurrentToken().GetSourceRange();
     ConsumeToken();
 
-    sona::owner<Syntax::Expr> e1 = ParseBinaryExpr(Syntax::PrecOf(op) + 1);
-    e0 = new Syntax::BinaryExpr(op, std::move(e0), std::move(e1), opRange);
+    Syntax::NodePtr<Syntax::Expr> e1 = ParseBinaryExpr(Syntax::PrecOf(op) + 1);
+    e0 = m_Arena->New<Syntax::BinaryExpr>(op, std::move(e0), std::move(e1),
+                                          opRange);
     op = TokenToBinary(CurrentToken().GetTokenKind());
   }
 
   return e0;
 }
 
-sona::owner<Syntax::Type> ParserImpl::ParseBuiltinType() {
+Syntax::NodePtr<Syntax::Type> ParserImpl::ParseBuiltinType() {
+  /// NoType cannot be written, it only borrows TK_EOI in BuiltinTypes.def
+  if (CurrentToken().GetTokenKind() == Token::TK_EOI) {
+    return nullptr;
+  }
+
   Syntax::BuiltinType::BuiltinTypeId btid;
   switch (CurrentToken().GetTokenKind()) {
   #define BUILTIN_TYPE(name, size, isint, \
@@ -725,32 +1103,38 @@ sona::owner<Syntax::Type> ParserImpl::ParseBuiltinType() {
   #include "Syntax/BuiltinTypes.def"
 
   default:
-    sona_unreachable();
+    /// Not a type at all, ParseType reports it
     return nullptr;
   }
 
   SourceRange range = CurrentToken().GetSourceRange();
   ConsumeToken();
 
-  return new Syntax::BuiltinType(btid, range);
+  return m_Arena->New<Syntax::BuiltinType>(btid, range);
 }
 
-sona::owner<Syntax::Type> ParserImpl::ParseUserDefinedType() {
+Syntax::NodePtr<Syntax::Type> ParserImpl::ParseUserDefinedType() {
   sona_assert(CurrentToken().GetTokenKind() == Token::TK_ID);
   Syntax::Identifier id = ParseIdentifier();
-  return new Syntax::UserDefinedType(std::move(id), id.GetIdSourceRange());
+  SourceRange range = id.GetIdSourceRange();
+  return m_Arena->New<Syntax::UserDefinedType>(std::move(id), range);
 }
 
 Syntax::Identifier ParserImpl::ParseIdentifier() {
   sona_assert(CurrentToken().GetTokenKind() == Token::TK_ID);
 
-  std::vector<sona::strhdl_t> parsedParts;
-  std::vector<SourceRange> parsedPartRanges;
-
-  parsedParts.push_back(CurrentToken().GetStrValueUnsafe());
-  parsedPartRanges.push_back(CurrentToken().GetSourceRange());
+  sona::strhdl_t firstPart = CurrentToken().GetStrValueUnsafe();
+  SourceRange firstPartRange = CurrentToken().GetSourceRange();
   ConsumeToken();
 
+  /// Most names are not qualified and need no array at all
+  if (CurrentToken().GetTokenKind() != Token::TK_SYM_DOT) {
+    return Syntax::Identifier(firstPart, firstPartRange);
+  }
+
+  std::vector<sona::strhdl_t> parsedParts { firstPart };
+  std::vector<SourceRange> parsedPartRanges { firstPartRange };
+
   for (;;) {
     if (CurrentToken().GetTokenKind() != Token::TK_SYM_DOT) {
       break;
@@ -771,14 +1155,23 @@ Syntax::Identifier ParserImpl::ParseIdentifier() {
   parsedParts.pop_back();
   parsedPartRanges.pop_back();
 
-  return Syntax::Identifier(std::move(parsedParts),idItself,
-                            std::move(parsedPartRanges), idItselfRange);
+  return Syntax::Identifier(m_Arena->CopyArray(std::move(parsedParts)),
+                            idItself,
+                            m_Arena->CopyArray(std::move(parsedPartRanges)),
+                            idItselfRange);
 }
 
 void ParserImpl::
-SetParsingTokenStream(sona::ref_ptr<std::vector<Token> const> tokenStream) {
-  m_ParsingTokenStream = tokenStream;
-  m_Index = 0;
+SetParsingTokenStream(sona::ref_ptr<TokenBuffer const> tokenStream) {
+  m_OwnedTokenSource = new TokenBufferSource(tokenStream);
+  SetTokenSource(m_OwnedTokenSource.borrow());
+}
+
+void ParserImpl::SetTokenSource(sona::ref_ptr<TokenSource> tokenSource) {
+  m_TokenSource = tokenSource;
+  m_LookaheadStart = 0;
+  m_LookaheadCount = 0;
+  m_TokenIndex = 0;
 }
 
 sona::optional<std::pair<sona::strhdl_t, SourceRange>>
@@ -786,7 +1179,7 @@ ParserImpl::ExpectTagId() {
   if (!Expect(Token::TK_ID)) {
     if (CurrentToken().GetTokenKind() == Token::TK_SYM_LBRACE) {
       m_Diag.Diag(Diag::DIR_Note,
-                  Diag::Format(Diag::DMT_NoteNoAnonymousDecl, {}),
+                  Diag::DMT_NoteNoAnonymousDecl, {},
                   CurrentToken().GetSourceRange());
       sona::strhdl_t name = CreateAnonymousName();
       SourceRange range = CurrentToken().GetSourceRange();
@@ -803,16 +1196,58 @@ ParserImpl::ExpectTagId() {
   return std::make_pair(name, range);
 }
 
-Token const& ParserImpl::CurrentToken() const noexcept {
-  return m_ParsingTokenStream.get()[m_Index];
+void ParserImpl::FillLookahead(size_t count) const noexcept {
+  sona_assert(count <= LookaheadCapacity);
+  while (m_LookaheadCount < count) {
+    size_t slot = (m_LookaheadStart + m_LookaheadCount) % LookaheadCapacity;
+    m_Lookahead[slot] = m_OutOfBudget ? m_BudgetEOI
+                                      : m_TokenSource.get().NextToken();
+    m_LookaheadCount++;
+  }
 }
 
-Token const& ParserImpl::PeekToken(size_t peekCount) const noexcept {
-  return m_ParsingTokenStream.get()[m_Index + peekCount];
+bool ParserImpl::OutOfBudget() const {
+  if (m_OutOfBudget) {
+    return true;
+  }
+
+  SourceRange range = CurrentToken().GetSourceRange();
+  if (!m_Diag.CheckBudget(range)) {
+    return false;
+  }
+  m_OutOfBudget = true;
+  m_BudgetEOI = Token(Token::TK_EOI, range);
+  m_LookaheadStart = 0;
+  m_LookaheadCount = 0;
+  return true;
+}
+
+bool ParserImpl::TooDeep() const {
+  if (!m_Diag.GetBudget().DepthExceeded(m_Depth)) {
+    return false;
+  }
+  m_Diag.ExhaustBudget(CompileBudget::R_Depth,
+                       CurrentToken().GetSourceRange());
+  OutOfBudget();
+  return true;
+}
+
+Token ParserImpl::CurrentToken() const noexcept {
+  FillLookahead(1);
+  return m_Lookahead[m_LookaheadStart];
+}
+
+Token ParserImpl::PeekToken(size_t peekCount) const noexcept {
+  FillLookahead(peekCount + 1);
+  return m_Lookahead[(m_LookaheadStart + peekCount) % LookaheadCapacity];
 }
 
 void ParserImpl::ConsumeToken() noexcept {
-  m_Index++;
+  FillLookahead(1);
+  m_LookaheadStart = (m_LookaheadStart + 1) % LookaheadCapacity;
+  m_LookaheadCount--;
+  m_TokenIndex++;
+  OutOfBudget();
 }
 
 bool ParserImpl::Expect(Token::TokenKind tokenKind) const noexcept {
@@ -821,12 +1256,13 @@ bool ParserImpl::Expect(Token::TokenKind tokenKind) const noexcept {
   }
 
   m_Diag.Diag(Diag::DIR_Error,
-              Diag::Format(Diag::DMT_ErrExpectedGot, {
-                             PrettyPrintToken(CurrentToken()),
-                             PrettyPrintTokenKind(tokenKind)
-                           }),
+              Diag::DMT_ErrExpectedGot, {
+                PrettyPrintToken(CurrentToken()),
+                PrettyPrintTokenKind(tokenKind)
+              },
               CurrentToken().GetSourceRange());
-
+  /// Recovery loops that consume nothing end with the error limit
+  OutOfBudget();
   return false;
 }
 
@@ -838,7 +1274,7 @@ bool ParserImpl::ExpectAndConsume(Token::TokenKind tokenKind) noexcept {
   return got;
 }
 
-sona::strhdl_t ParserImpl::PrettyPrintToken(Token const& token) const {
+std::string ParserImpl::PrettyPrintToken(Token const& token) const {
   switch (token.GetTokenKind()) {
 #define TOKEN_KWD(name, rep) \
   case Token::TK_KW_##name: return "'" + std::string(rep) + "'";
@@ -847,7 +1283,7 @@ sona::strhdl_t ParserImpl::PrettyPrintToken(Token const& token) const {
 #include "Frontend/Tokens.def"
 
   case Token::TK_ID:
-    return "identifier '" + token.GetStrValueUnsafe().get() + "'";
+    return "identifier '" + token.GetStrViewUnsafe().to_string() + "'";
   case Token::TK_LIT_INT:
     return "intergral literal '"
            + std::to_string(token.GetIntValueUnsafe()) + "'";
@@ -856,7 +1292,7 @@ sona::strhdl_t ParserImpl::PrettyPrintToken(Token const& token) const {
            + std::to_string(token.GetUIntValueUnsafe()) + "'";
   case Token::TK_LIT_STR:
     return "string literal \""
-           + token.GetStrValueUnsafe().get() + "\"";
+           + token.GetStrViewUnsafe().to_string() + "\"";
   case Token::TK_EOI:
     return "end of input";
   default:
@@ -885,6 +1321,31 @@ template <typename Cond> void ParserImpl::SkipUntil(Cond cond) {
   }
 }
 
+bool ParserImpl::SkipFuncBody(std::size_t &rbraceIndex) {
+  sona_assert(CurrentToken().GetTokenKind() == Token::TK_SYM_LBRACE);
+  std::size_t depth = 0;
+  for (;;) {
+    switch (CurrentToken().GetTokenKind()) {
+    case Token::TK_SYM_LBRACE:
+      depth++;
+      break;
+    case Token::TK_SYM_RBRACE:
+      if (--depth == 0) {
+        rbraceIndex = m_TokenIndex;
+        ConsumeToken();
+        return true;
+      }
+      break;
+    case Token::TK_EOI:
+      Expect(Token::TK_SYM_RBRACE);
+      return false;
+    default:
+      break;
+    }
+    ConsumeToken();
+  }
+}
+
 Syntax::UnaryOperator
 TokenToUnary(Frontend::Token::TokenKind token) noexcept {
   using namespace Syntax;
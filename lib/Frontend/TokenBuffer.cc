@@ -0,0 +1,179 @@
+#include "Frontend/TokenBuffer.h"
+
+#include <algorithm>
+
+namespace ckx {
+namespace Frontend {
+
+constexpr std::uint32_t TokenBuffer::NoPayload;
+constexpr std::size_t TokenBuffer::NoGap;
+
+std::size_t TokenBuffer::LowerBound(std::uint32_t offset) const noexcept {
+  std::size_t lo = 0, hi = size();
+  while (lo < hi) {
+    std::size_t mid = lo + (hi - lo) / 2;
+    if (GetOffset(mid) < offset) {
+      lo = mid + 1;
+    }
+    else {
+      hi = mid;
+    }
+  }
+  return lo;
+}
+
+Token::Payload
+TokenBuffer::PackPayload(Token::TokenKind kind, SourceRange range,
+                         Token::Payload payload) const noexcept {
+  if (kind != Token::TK_ID && kind != Token::TK_LIT_STR) {
+    return payload;
+  }
+
+  /// Decoded string literals live elsewhere and stay where they are
+  std::uintptr_t pos = reinterpret_cast<std::uintptr_t>(payload.Text.Ptr);
+  std::uintptr_t begin = reinterpret_cast<std::uintptr_t>(m_Source.data());
+  if (m_Source.data() == nullptr || pos < begin
+      || pos > begin + m_Source.size()) {
+    return payload;
+  }
+
+  std::uint32_t tokenStart = range.GetBegin().GetRawEncoding()
+                             - m_FileStart.GetRawEncoding();
+  payload.Text.Skip = static_cast<std::uint32_t>(pos - begin) - tokenStart;
+  payload.Text.Ptr = nullptr;
+  return payload;
+}
+
+Token::Payload
+TokenBuffer::UnpackPayload(std::size_t idx,
+                           Token::Payload payload) const noexcept {
+  Token::TokenKind kind = GetTokenKind(idx);
+  if ((kind == Token::TK_ID || kind == Token::TK_LIT_STR)
+      && payload.Text.Ptr == nullptr) {
+    payload.Text.Ptr = m_Source.data() + GetOffset(idx) + payload.Text.Skip;
+    payload.Text.Skip = 0;
+  }
+  return payload;
+}
+
+std::uint32_t TokenBuffer::NewPayload(Token::Payload const& payload) {
+  if (!m_FreePayloads.empty()) {
+    std::uint32_t slot = m_FreePayloads.back();
+    m_FreePayloads.pop_back();
+    m_Payloads[slot] = payload;
+    return slot;
+  }
+  m_Payloads.push_back(payload);
+  return static_cast<std::uint32_t>(m_Payloads.size() - 1);
+}
+
+void TokenBuffer::MoveGap(std::size_t idx) {
+  sona_assert(idx <= size());
+  if (m_GapBegin == NoGap) {
+    m_GapBegin = size();
+  }
+
+  /// Tokens crossing the gap take on or give up the pending shift
+  while (m_GapBegin > idx) {
+    --m_GapBegin;
+    std::size_t to = m_GapBegin + m_GapSize;
+    m_Kinds[to] = m_Kinds[m_GapBegin];
+    m_Ranges[to] = Shift(m_Ranges[m_GapBegin], -m_TailShift);
+    m_PayloadIndices[to] = m_PayloadIndices[m_GapBegin];
+  }
+  while (m_GapBegin < idx) {
+    std::size_t from = m_GapBegin + m_GapSize;
+    m_Kinds[m_GapBegin] = m_Kinds[from];
+    m_Ranges[m_GapBegin] = Shift(m_Ranges[from], m_TailShift);
+    m_PayloadIndices[m_GapBegin] = m_PayloadIndices[from];
+    ++m_GapBegin;
+  }
+}
+
+void TokenBuffer::GrowGap(std::size_t size) {
+  sona_assert(m_GapBegin != NoGap);
+  if (m_GapSize >= size) {
+    return;
+  }
+
+  /// Grown in proportion to the buffer, so that a run of insertions
+  /// moves the tokens behind the gap only now and then
+  std::size_t grow = size - m_GapSize + this->size() / 16 + 16;
+  std::size_t gapEnd = m_GapBegin + m_GapSize;
+  m_Kinds.insert(m_Kinds.begin() + static_cast<std::ptrdiff_t>(gapEnd),
+                 grow, 0);
+  m_Ranges.insert(m_Ranges.begin() + static_cast<std::ptrdiff_t>(gapEnd),
+                  grow, SourceRange());
+  m_PayloadIndices.insert(
+      m_PayloadIndices.begin() + static_cast<std::ptrdiff_t>(gapEnd),
+      grow, NoPayload);
+  m_GapSize += grow;
+}
+
+void TokenBuffer::CloseGap() {
+  MoveGap(size());
+  m_Kinds.resize(m_GapBegin);
+  m_Ranges.resize(m_GapBegin);
+  m_PayloadIndices.resize(m_GapBegin);
+  m_GapBegin = NoGap;
+  m_GapSize = 0;
+  m_TailShift = 0;
+}
+
+void TokenBuffer::Append(TokenBuffer const& other,
+                         std::size_t first, std::size_t last) {
+  sona_assert(first <= last && last <= other.size());
+  if (m_GapBegin != NoGap) {
+    CloseGap();
+  }
+  m_Kinds.reserve(m_Kinds.size() + (last - first));
+  m_Ranges.reserve(m_Ranges.size() + (last - first));
+  m_PayloadIndices.reserve(m_PayloadIndices.size() + (last - first));
+  for (std::size_t i = first; i < last; i++) {
+    std::size_t from = other.Phys(i);
+    m_Kinds.push_back(other.m_Kinds[from]);
+    m_Ranges.push_back(other.GetSourceRange(i));
+    std::uint32_t payloadIdx = other.m_PayloadIndices[from];
+    m_PayloadIndices.push_back(
+        payloadIdx == NoPayload ? NoPayload
+                                : NewPayload(other.m_Payloads[payloadIdx]));
+  }
+}
+
+void TokenBuffer::Splice(std::size_t first, std::size_t last,
+                         TokenBuffer const& replacement) {
+  sona_assert(first <= last && last <= size());
+
+  /// The tokens replaced join the gap, their payload slots go free
+  MoveGap(first);
+  for (std::size_t i = first; i < last; i++) {
+    std::uint32_t payloadIdx = m_PayloadIndices[i + m_GapSize];
+    if (payloadIdx != NoPayload) {
+      m_FreePayloads.push_back(payloadIdx);
+    }
+  }
+  m_GapSize += last - first;
+
+  /// Payloads are copied as stored: text relative to its token stays so
+  GrowGap(replacement.size());
+  for (std::size_t i = 0; i < replacement.size(); i++) {
+    std::size_t from = replacement.Phys(i);
+    m_Kinds[m_GapBegin] = replacement.m_Kinds[from];
+    m_Ranges[m_GapBegin] = replacement.GetSourceRange(i);
+    std::uint32_t payloadIdx = replacement.m_PayloadIndices[from];
+    m_PayloadIndices[m_GapBegin] =
+        payloadIdx == NoPayload
+          ? NoPayload
+          : NewPayload(replacement.m_Payloads[payloadIdx]);
+    ++m_GapBegin;
+    --m_GapSize;
+  }
+}
+
+void TokenBuffer::ShiftTokens(std::size_t first, std::int64_t offsetDelta) {
+  MoveGap(first);
+  m_TailShift += offsetDelta;
+}
+
+} // namespace Frontend
+} // namespace ckx
@@ -0,0 +1,17 @@
+#include "Frontend/TokenSource.h"
+
+namespace ckx {
+namespace Frontend {
+
+Token TokenBufferSource::NextToken() {
+  TokenBuffer const& tokens = m_Tokens.get();
+  sona_assert(!tokens.empty()
+              && tokens.GetTokenKind(tokens.size() - 1) == Token::TK_EOI);
+  if (m_Index + 1 < tokens.size()) {
+    return tokens[m_Index++];
+  }
+  return tokens[tokens.size() - 1];
+}
+
+} // namespace Frontend
+} // namespace ckx
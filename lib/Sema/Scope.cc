@@ -26,15 +26,15 @@ Scope::Scope(std::shared_ptr<Scope> parentScope, Scope::ScopeFlags scopeFlags)
 }
 
 void Scope::AddVarDecl(sona::ref_ptr<const AST::VarDecl> varDecl) {
-  m_Variables.emplace(varDecl->GetVarName(), varDecl);
+  m_Variables.TryEmplace(varDecl->GetVarName(), varDecl);
 }
 
 void Scope::AddType(sona::strhdl_t const& typeName, AST::QualType type) {
-  m_Types.emplace(typeName, type);
+  m_Types.TryEmplace(typeName, type);
 }
 
 void Scope::AddFunction(sona::ref_ptr<const AST::FuncDecl> funcDecl) {
-  m_Functions.emplace(funcDecl->GetName(), funcDecl);
+  m_Functions.TryEmplace(funcDecl->GetName()).first->push_back(funcDecl);
 }
 
 sona::ref_ptr<AST::VarDecl const>
@@ -63,33 +63,25 @@ AST::QualType Scope::LookupType(const sona::strhdl_t &name) const noexcept {
 
 AST::QualType
 Scope::LookupTypeLocally(const sona::strhdl_t& name) const noexcept {
-  auto it = m_Types.find(name);
-  if (it != m_Types.cend()) {
-    return it->second;
-  }
-  return AST::QualType(nullptr);
+  AST::QualType const* type = m_Types.Find(name);
+  return type != nullptr ? *type : AST::QualType(nullptr);
 }
 
 sona::ref_ptr<const AST::VarDecl>
 Scope::LookupVarDeclLocally(const sona::strhdl_t& name) const noexcept {
-  auto it = m_Variables.find(name);
-  if (it != m_Variables.cend()) {
-    return it->second;
-  }
-  return nullptr;
+  sona::ref_ptr<AST::VarDecl const> const* varDecl = m_Variables.Find(name);
+  return varDecl != nullptr ? *varDecl : nullptr;
 }
 
 sona::iterator_range<Scope::FunctionSet::const_iterator>
 Scope::GetAllFuncsLocal(const sona::strhdl_t &name) const noexcept {
-  auto it = m_Functions.find(name);
-  if (it == m_Functions.cend()) {
-    return sona::iterator_range<FunctionSet::const_iterator>(it, it);
+  FunctionSet const* funcs = m_Functions.Find(name);
+  if (funcs == nullptr) {
+    return sona::iterator_range<FunctionSet::const_iterator>(
+             FunctionSet::const_iterator(), FunctionSet::const_iterator());
   }
-
-  auto it2 = it;
-  ++it2;
-  for (; it2 != m_Functions.cend() && it2->first == name; ++it2);
-  return sona::iterator_range<FunctionSet::const_iterator>(it, it2);
+  return sona::iterator_range<FunctionSet::const_iterator>(funcs->cbegin(),
+                                                           funcs->cend());
 }
 
 sona::iterator_range<Scope::FunctionSet::const_iterator>
@@ -103,9 +95,9 @@ Scope::GetAllFuncs(const sona::strhdl_t &name) const noexcept {
 
 void Scope::ReplaceVarDecl(const sona::strhdl_t& denotingName,
                            sona::ref_ptr<const AST::VarDecl> varDecl) {
-  auto it = m_Variables.find(denotingName);
-  sona_assert(it != m_Variables.end());
-  it->second = varDecl;
+  sona::ref_ptr<AST::VarDecl const> *slot = m_Variables.Find(denotingName);
+  sona_assert(slot != nullptr);
+  *slot = varDecl;
 }
 
 } // namespace Sema
@@ -143,14 +143,14 @@ AST::QualType SemaCommon::ResolveBuiltinTypeImpl(
 
 sona::ref_ptr<AST::DeclContext const>
 SemaCommon::ChooseDeclContext(std::shared_ptr<Scope> scope,
-                              std::vector<sona::strhdl_t> const& nns,
+                              sona::array_ref<sona::strhdl_t> nns,
                               bool shouldDiag,
-                              std::vector<SingleSourceRange> const& nnsRanges) {
+                              sona::array_ref<SourceRange> nnsRanges) {
   AST::QualType topLevelType = scope->LookupType(nns.front());
   if (topLevelType.GetUnqualTy() == nullptr) {
     if (shouldDiag) {
       m_Diag.Diag(Diag::DIR_Error,
-                  Diag::Format(Diag::DMT_ErrNotDeclared, {nns.front()}),
+                  Diag::DMT_ErrNotDeclared, {nns.front()},
                   nnsRanges.front());
     }
     return nullptr;
@@ -159,7 +159,7 @@ SemaCommon::ChooseDeclContext(std::shared_ptr<Scope> scope,
   if (topLevelType.GetUnqualTy()->GetTypeId()
       != AST::Type::TypeId::TI_UserDefined) {
     m_Diag.Diag(Diag::DIR_Error,
-                Diag::Format(Diag::DMT_ErrNotScope, {nns.front()}),
+                Diag::DMT_ErrNotScope, {nns.front()},
                 nnsRanges.front());
     return nullptr;
   }
@@ -169,7 +169,7 @@ SemaCommon::ChooseDeclContext(std::shared_ptr<Scope> scope,
   if (udType->GetUserDefinedTypeId()
       == AST::UserDefinedType::UDTypeId::UTI_Using) {
     m_Diag.Diag(Diag::DIR_Error,
-                Diag::Format(Diag::DMT_ErrNotScope, {nns.front()}),
+                Diag::DMT_ErrNotScope, {nns.front()},
                 nnsRanges.front());
     return nullptr;
   }
@@ -185,14 +185,14 @@ SemaCommon::ChooseDeclContext(std::shared_ptr<Scope> scope,
     context->LookupDeclContexts((*it).first, collectedDecls);
     if (collectedDecls.size() < 1) {
       m_Diag.Diag(Diag::DIR_Error,
-                  Diag::Format(Diag::DMT_ErrNotScope, {(*it).first}),
+                  Diag::DMT_ErrNotScope, {(*it).first},
                   (*it).second);
       return nullptr;
     }
     if (collectedDecls.size() > 1) {
       m_Diag.Diag(Diag::DIR_Error,
-                  Diag::Format(Diag::DMT_ErrAmbiguousScope,
-                               {(*it).first, (*(it - 1)).first}), (*it).second);
+                  Diag::DMT_ErrAmbiguousScope,
+                  {(*it).first, (*(it - 1)).first}, (*it).second);
     }
     context = collectedDecls.front()->CastAsDeclContext();
   }
@@ -207,8 +207,8 @@ SemaCommon::LookupType(std::shared_ptr<Scope> scope,
     AST::QualType ret = scope->LookupType(identifier.GetIdentifier());
     if (ret.GetUnqualTy() == nullptr && shouldDiag) {
       m_Diag.Diag(Diag::DIR_Error,
-                  Diag::Format(Diag::DMT_ErrNotDeclared,
-                               { identifier.GetIdentifier() }),
+                  Diag::DMT_ErrNotDeclared,
+                  { identifier.GetIdentifier() },
                   identifier.GetIdSourceRange());
     }
     return ret;
@@ -227,8 +227,8 @@ SemaCommon::LookupType(std::shared_ptr<Scope> scope,
   if (collectedDecls.size() < 1) {
     if (shouldDiag) {
       m_Diag.Diag(Diag::DIR_Error,
-                  Diag::Format(Diag::DMT_ErrNotDeclared,
-                               { identifier.GetIdentifier() }),
+                  Diag::DMT_ErrNotDeclared,
+                  { identifier.GetIdentifier() },
                   identifier.GetIdSourceRange());
     }
     return AST::QualType(nullptr);
@@ -237,8 +237,8 @@ SemaCommon::LookupType(std::shared_ptr<Scope> scope,
   if (collectedDecls.size() > 1) {
     if (shouldDiag) {
       m_Diag.Diag(Diag::DIR_Error,
-                  Diag::Format(Diag::DMT_ErrAmbiguous,
-                               { identifier.GetIdentifier() }),
+                  Diag::DMT_ErrAmbiguous,
+                  { identifier.GetIdentifier() },
                   identifier.GetIdSourceRange());
     }
     return AST::QualType(nullptr);
@@ -26,6 +26,9 @@ SemaPhase0::ActOnTransUnit(sona::ref_ptr<Syntax::TransUnit> transUnit) {
   PushDeclContext(transUnitDecl.borrow().cast_unsafe<AST::DeclContext>());
   PushScope();
   for (sona::ref_ptr<Syntax::Decl const> decl : transUnit->GetDecls()) {
+    if (m_Diag.CheckBudget(decl->GetRepresentingRange())) {
+      break;
+    }
     transUnitDecl.borrow()->AddDecl(ActOnDecl(decl).first);
   }
   return transUnitDecl;
@@ -47,14 +50,17 @@ void SemaPhase0::PostSubstituteDepends() {
 
   for (sona::ref_ptr<IncompleteDecl>
        incomplete : r1.concat_with(r2).concat_with(r3).concat_with(r4)) {
+    if (m_Diag.CheckBudget(incomplete->GetRepresentingRange())) {
+      return;
+    }
     std::shared_ptr<Scope> inScope = incomplete->GetEnclosingScope();
     for (auto &dep : incomplete->GetDependencies()) {
       if (dep.IsDependByname()) {
         AST::QualType type = LookupType(inScope, dep.GetIdUnsafe(), true);
         if (type.GetUnqualTy() == nullptr) {
           m_Diag.Diag(Diag::DIR_Error,
-                      Diag::Format(Diag::DMT_ErrNotDeclared,
-                      {dep.GetIdUnsafe().GetIdentifier()}),
+                      Diag::DMT_ErrNotDeclared,
+                      {dep.GetIdUnsafe().GetIdentifier()},
                       dep.GetIdUnsafe().GetIdSourceRange());
           continue;
         }
@@ -82,8 +88,8 @@ SemaPhase0::FindTranslationOrder() {
     }
     if (temporaries.find(decl) != temporaries.cend()) {
       m_Diag.Diag(Diag::DIR_Error,
-                  Diag::Format(Diag::DMT_ErrCircularDepend,
-                               {decl->GetName()}),
+                  Diag::DMT_ErrCircularDepend,
+                  {decl->GetName()},
                   decl->GetRepresentingRange());
       return false;
     }
@@ -124,7 +130,8 @@ SemaPhase0::FindTranslationOrder() {
                       { return static_cast<IncompleteDecl*>(&(p.second)); });
   for (sona::ref_ptr<IncompleteDecl> incomplete :
        r1.concat_with(r2).concat_with(r3).concat_with(r4)) {
-    if (!VisitIncompleteDecl(incomplete)) {
+    if (m_Diag.CheckBudget(incomplete->GetRepresentingRange())
+        || !VisitIncompleteDecl(incomplete)) {
       return transOrder;
     }
   }
@@ -218,6 +225,9 @@ ResolveComposedType(sona::ref_ptr<Syntax::ComposedType const> cty) {
               .zip_with(
                sona::linq::from_container(cty->GetTypeSpecRanges()));
     for (const auto &p : r) {
+      if (m_Diag.CheckBudget(p.second)) {
+        break;
+      }
       switch (p.first) {
       case Syntax::ComposedType::CTS_Pointer:
         ret = m_ASTContext.CreatePointerType(ret);
@@ -231,7 +241,7 @@ ResolveComposedType(sona::ref_ptr<Syntax::ComposedType const> cty) {
       case Syntax::ComposedType::CTS_Const:
         if (ret.IsConst()) {
           m_Diag.Diag(Diag::DIR_Error,
-                      Diag::Format(Diag::DMT_ErrDuplicateQual, {"const"}),
+                      Diag::DMT_ErrDuplicateQual, {"const"},
                       p.second);
         }
         else {
@@ -241,7 +251,7 @@ ResolveComposedType(sona::ref_ptr<Syntax::ComposedType const> cty) {
       case Syntax::ComposedType::CTS_Volatile:
         if (ret.IsVolatile()) {
           m_Diag.Diag(Diag::DIR_Error,
-                      Diag::Format(Diag::DMT_ErrDuplicateQual, {"volatile"}),
+                      Diag::DMT_ErrDuplicateQual, {"volatile"},
                       p.second);
         }
         else {
@@ -251,7 +261,7 @@ ResolveComposedType(sona::ref_ptr<Syntax::ComposedType const> cty) {
       case Syntax::ComposedType::CTS_Restrict:
         if (ret.IsRestrict()) {
           m_Diag.Diag(Diag::DIR_Error,
-                      Diag::Format(Diag::DMT_ErrDuplicateQual, {"restrict"}),
+                      Diag::DMT_ErrDuplicateQual, {"restrict"},
                       p.second);
         }
         else {
@@ -282,7 +292,7 @@ SemaPhase0::ActOnVarDecl(sona::ref_ptr<Syntax::VarDecl const> decl) {
     auto prevType = GetCurrentScope()->LookupTypeLocally(decl->GetName());
     if (prevType.GetUnqualTy() != nullptr) {
       m_Diag.Diag(Diag::DIR_Error,
-                  Diag::Format(Diag::DMT_ErrRedefinition, { decl->GetName() }),
+                  Diag::DMT_ErrRedefinition, { decl->GetName() },
                   decl->GetNameRange());
       return std::make_pair(nullptr, false);
     }
@@ -320,8 +330,8 @@ SemaPhase0::ActOnClassDecl(sona::ref_ptr<Syntax::ClassDecl const> decl) {
     auto prevType = GetCurrentScope()->LookupTypeLocally(decl->GetName());
     if (prevType.GetUnqualTy() != nullptr) {
       m_Diag.Diag(Diag::DIR_Error,
-                  Diag::Format(Diag::DMT_ErrRedefinition,
-                               { decl->GetName() }),
+                  Diag::DMT_ErrRedefinition,
+                  { decl->GetName() },
                   decl->GetNameRange());
       return std::make_pair(nullptr, false);
     }
@@ -368,8 +378,8 @@ SemaPhase0::ActOnADTDecl(sona::ref_ptr<Syntax::ADTDecl const> decl) {
     auto prevType = GetCurrentScope()->LookupTypeLocally(decl->GetName());
     if (prevType.GetUnqualTy() != nullptr) {
       m_Diag.Diag(Diag::DIR_Error,
-                  Diag::Format(Diag::DMT_ErrRedefinition,
-                               { decl->GetName() }),
+                  Diag::DMT_ErrRedefinition,
+                  { decl->GetName() },
                   decl->GetNameRange());
       return std::make_pair(nullptr, false);
     }
@@ -519,8 +529,8 @@ SemaPhase0::ActOnUsingDecl(sona::ref_ptr<Syntax::UsingDecl const> decl) {
     auto prevType = GetCurrentScope()->LookupTypeLocally(decl->GetName());
     if (prevType.GetUnqualTy() != nullptr) {
       m_Diag.Diag(Diag::DIR_Error,
-                  Diag::Format(Diag::DMT_ErrRedefinition,
-                               { decl->GetName() }),
+                  Diag::DMT_ErrRedefinition,
+                  { decl->GetName() },
                   decl->GetNameRange());
       return std::make_pair(nullptr, false);
     }
@@ -563,8 +573,8 @@ SemaPhase0::ActOnEnumDecl(sona::ref_ptr<Syntax::EnumDecl const> decl) {
     auto prevType = GetCurrentScope()->LookupTypeLocally(decl->GetName());
     if (prevType.GetUnqualTy() != nullptr) {
       m_Diag.Diag(Diag::DIR_Error,
-                  Diag::Format(Diag::DMT_ErrRedefinition,
-                               { decl->GetName() }),
+                  Diag::DMT_ErrRedefinition,
+                  { decl->GetName() },
                   decl->GetNameRange());
       return std::make_pair(nullptr, false);
     }
@@ -580,7 +590,7 @@ SemaPhase0::ActOnEnumDecl(sona::ref_ptr<Syntax::EnumDecl const> decl) {
   for (Syntax::EnumDecl::Enumerator const& e : decl->GetEnumerators()) {
     if (collectedNames.find(e.GetName()) != collectedNames.cend()) {
       m_Diag.Diag(Diag::DIR_Error,
-                  Diag::Format(Diag::DMT_ErrRedeclaration, { e.GetName() }),
+                  Diag::DMT_ErrRedeclaration, { e.GetName() },
                   e.GetNameRange());
       continue;
     }
@@ -14,6 +14,9 @@ SemaPhase1::SemaPhase1(AST::ASTContext &astContext,
 void SemaPhase1::PostTranslateIncompletes(
     std::vector<sona::ref_ptr<IncompleteDecl>> incompletes) {
   for (auto incomplete : incompletes) {
+    if (m_Diag.CheckBudget(incomplete->GetRepresentingRange())) {
+      return;
+    }
     switch (incomplete->GetType()) {
     case IncompleteDecl::IDT_Var:
       PostTranslateIncompleteVar(incomplete.cast_unsafe<IncompleteVarDecl>());
@@ -82,6 +85,10 @@ SemaPhase1::ResolveType(std::shared_ptr<Scope> scope,
 sona::owner<AST::Expr>
 SemaPhase1::ActOnExpr(std::shared_ptr<Scope> scope,
                       sona::ref_ptr<const Syntax::Expr> expr) {
+  /// Checked per node, a single declaration may hold any number of them
+  if (m_Diag.CheckBudget(expr->GetRepresentingRange())) {
+    return nullptr;
+  }
   switch (expr->GetNodeKind()) {
 #define CST_EXPR(name) \
   case Syntax::Node::CNK_##name: \
@@ -13,8 +13,8 @@ SemaPhase1::ActOnIdRefExpr(std::shared_ptr<Scope> scope,
       scope->LookupVarDecl(expr->GetId().GetIdentifier());
   if (varDecl == nullptr) {
     m_Diag.Diag(Diag::DIR_Error,
-                Diag::Format(Diag::DMT_ErrVarUndeclared,
-                             { expr->GetId().GetIdentifier() }),
+                Diag::DMT_ErrVarUndeclared,
+                { expr->GetId().GetIdentifier() },
                 expr->GetId().GetIdSourceRange());
     return nullptr;
   }
@@ -106,13 +106,13 @@ SemaPhase1::ActOnAssignExpr(std::shared_ptr<Scope> scope,
 
   if (lhs.borrow()->GetValueCat() != AST::Expr::VC_LValue) {
     m_Diag.Diag(Diag::DIR_Error,
-                Diag::Format(Diag::DMT_ErrAssignToNonLValue, {}),
+                Diag::DMT_ErrAssignToNonLValue, {},
                 expr->GetOpRange());
     return nullptr;
   }
   if (lhs.borrow()->GetExprType().IsConst()) {
     m_Diag.Diag(Diag::DIR_Error,
-                Diag::Format(Diag::DMT_ErrAssignToConst, {}),
+                Diag::DMT_ErrAssignToConst, {},
                 expr->GetOpRange());
     return nullptr;
   }
@@ -123,7 +123,7 @@ SemaPhase1::ActOnAssignExpr(std::shared_ptr<Scope> scope,
                           lhs.borrow()->GetExprType().DeQual(), true);
     if (rhs.borrow() == nullptr) {
       m_Diag.Diag(Diag::DIR_Error,
-                  Diag::Format(Diag::DMT_ErrAssignIncompType, {}),
+                  Diag::DMT_ErrAssignIncompType, {},
                   expr->GetOpRange());
       return nullptr;
     }
@@ -272,10 +272,10 @@ SemaPhase1::ActOnAlgebraic(sona::ref_ptr<const Syntax::BinaryExpr> concrete,
     }
     else {
       m_Diag.Diag(Diag::DIR_Error,
-                  Diag::Format(Diag::DMT_ErrCannotApplyBinaryOp,
-                               {RepresentationOf(bop),
-                                "<not-implemented>", "<not-implemented>"}),
-                  SourceRange(0, 0, 0));
+                  Diag::DMT_ErrCannotApplyBinaryOp,
+                  {RepresentationOf(bop),
+                   "<not-implemented>", "<not-implemented>"},
+                  SourceRange());
       return nullptr;
     }
 
@@ -296,13 +296,13 @@ SemaPhase1::ActOnAlgebraic(sona::ref_ptr<const Syntax::BinaryExpr> concrete,
       if (lhsPointerTy->GetPointee().GetUnqualTy()
           != rhsPointerTy->GetPointee().GetUnqualTy()) {
         m_Diag.Diag(Diag::DIR_Error,
-                    Diag::Format(Diag::DMT_ErrCannotApplyBinaryOp,
-                                 {RepresentationOf(bop),
-                                  "<not-implemented>", "<not-implemented>"}),
-                    SourceRange(0, 0, 0));
+                    Diag::DMT_ErrCannotApplyBinaryOp,
+                    {RepresentationOf(bop),
+                     "<not-implemented>", "<not-implemented>"},
+                    SourceRange());
         m_Diag.Diag(Diag::DIR_Note,
                     "pointer arithmetic requires same base type",
-                    SourceRange(0, 0, 0));
+                    SourceRange());
         return nullptr;
       }
       return new AST::BinaryExpr(AST::BinaryExpr::BOP_Sub,
@@ -319,10 +319,10 @@ SemaPhase1::ActOnAlgebraic(sona::ref_ptr<const Syntax::BinaryExpr> concrete,
     }
     else {
       m_Diag.Diag(Diag::DIR_Error,
-                  Diag::Format(Diag::DMT_ErrCannotApplyBinaryOp,
-                               {RepresentationOf(bop),
-                                "<not-implemented>", "<not-implemented>"}),
-                  SourceRange(0, 0, 0));
+                  Diag::DMT_ErrCannotApplyBinaryOp,
+                  {RepresentationOf(bop),
+                   "<not-implemented>", "<not-implemented>"},
+                  SourceRange());
       return nullptr;
     }
 
@@ -353,10 +353,10 @@ SemaPhase1::ActOnNumeric(sona::ref_ptr<const Syntax::BinaryExpr> concrete,
   if (bop == Syntax::BinaryOperator::BOP_Mod
       && !rhsBuiltinTy->IsIntegral()) {
     m_Diag.Diag(Diag::DIR_Error,
-                Diag::Format(Diag::DMT_ErrCannotApplyBinaryOp,
-                             {RepresentationOf(bop),
-                              "<not-implemented>", "<not-implemented>"}),
-                SourceRange(0, 0, 0));
+                Diag::DMT_ErrCannotApplyBinaryOp,
+                {RepresentationOf(bop),
+                 "<not-implemented>", "<not-implemented>"},
+                SourceRange());
     return nullptr;
   }
 
@@ -365,10 +365,10 @@ SemaPhase1::ActOnNumeric(sona::ref_ptr<const Syntax::BinaryExpr> concrete,
   AST::QualType commonType1(commonType.cast_unsafe<AST::Type const>());
   if (commonType == nullptr) {
     m_Diag.Diag(Diag::DIR_Error,
-                Diag::Format(Diag::DMT_ErrCannotApplyBinaryOp,
-                             {RepresentationOf(bop),
-                              "<not-implemented>", "<not-implemented>"}),
-                SourceRange(0, 0, 0));
+                Diag::DMT_ErrCannotApplyBinaryOp,
+                {RepresentationOf(bop),
+                 "<not-implemented>", "<not-implemented>"},
+                SourceRange());
     return nullptr;
   }
   lhs = TryImplicitCast(concrete->GetLeftHandSide(),
@@ -389,8 +389,8 @@ SemaPhase1::ActOnLogic(sona::ref_ptr<const Syntax::BinaryExpr> concrete,
   AST::QualType rhsTy = rhs.borrow()->GetExprType();
   if (!lhsTy.GetUnqualTy()->IsBuiltin() || !rhsTy.GetUnqualTy()->IsBuiltin()) {
     m_Diag.Diag(Diag::DIR_Error,
-                Diag::Format(Diag::DMT_ErrOpRequiresType,
-                             { RepresentationOf(bop), "boolean" }),
+                Diag::DMT_ErrOpRequiresType,
+                { RepresentationOf(bop), "boolean" },
                 concrete->GetOpRange());
     return nullptr;
   }
@@ -402,8 +402,8 @@ SemaPhase1::ActOnLogic(sona::ref_ptr<const Syntax::BinaryExpr> concrete,
   if (lhsBuiltinType->GetBtid() != AST::BuiltinType::BTI_Bool
       || rhsBuiltinType->GetBtid() != AST::BuiltinType::BTI_Bool) {
     m_Diag.Diag(Diag::DIR_Error,
-                Diag::Format(Diag::DMT_ErrOpRequiresType,
-                             { RepresentationOf(bop), "boolean" }),
+                Diag::DMT_ErrOpRequiresType,
+                { RepresentationOf(bop), "boolean" },
                 concrete->GetOpRange());
     return nullptr;
   }
@@ -425,8 +425,8 @@ SemaPhase1::ActOnBitwise(sona::ref_ptr<const Syntax::BinaryExpr> concrete,
   AST::QualType rhsTy = rhs.borrow()->GetExprType();
   if (!lhsTy.GetUnqualTy()->IsBuiltin() || !rhsTy.GetUnqualTy()->IsBuiltin()) {
     m_Diag.Diag(Diag::DIR_Error,
-                Diag::Format(Diag::DMT_ErrOpRequiresType,
-                             { RepresentationOf(bop), "unsigned" }),
+                Diag::DMT_ErrOpRequiresType,
+                { RepresentationOf(bop), "unsigned" },
                 concrete->GetOpRange());
     return nullptr;
   }
@@ -437,8 +437,8 @@ SemaPhase1::ActOnBitwise(sona::ref_ptr<const Syntax::BinaryExpr> concrete,
       rhsTy.GetUnqualTy().cast_unsafe<AST::BuiltinType const>();
   if (!lhsBuiltinType->IsUnsigned() || !rhsBuiltinType->IsUnsigned()) {
     m_Diag.Diag(Diag::DIR_Error,
-                Diag::Format(Diag::DMT_ErrOpRequiresType,
-                             { RepresentationOf(bop), "unsigned" }),
+                Diag::DMT_ErrOpRequiresType,
+                { RepresentationOf(bop), "unsigned" },
                 concrete->GetOpRange());
     return nullptr;
   }
@@ -476,12 +476,12 @@ SemaPhase1::ActOnBitwiseShift(sona::ref_ptr<const Syntax::BinaryExpr> concrete,
   AST::QualType rhsTy = rhs.borrow()->GetExprType();
   if (!lhsTy.GetUnqualTy()->IsBuiltin() || !rhsTy.GetUnqualTy()->IsBuiltin()) {
     m_Diag.Diag(Diag::DIR_Error,
-                Diag::Format(Diag::DMT_ErrCannotApplyBinaryOp,
-                             {RepresentationOf(bop),
-                              "<not-implemented>", "<not-implemented>"}),
-                SourceRange(0, 0, 0));
+                Diag::DMT_ErrCannotApplyBinaryOp,
+                {RepresentationOf(bop),
+                 "<not-implemented>", "<not-implemented>"},
+                SourceRange());
     m_Diag.Diag(Diag::DIR_Note, "bitwise shifting requires unsigned types",
-                SourceRange(0, 0, 0));
+                SourceRange());
     return nullptr;
   }
 
@@ -491,12 +491,12 @@ SemaPhase1::ActOnBitwiseShift(sona::ref_ptr<const Syntax::BinaryExpr> concrete,
       rhsTy.GetUnqualTy().cast_unsafe<AST::BuiltinType const>();
   if (!lhsBuiltinType->IsUnsigned() || !rhsBuiltinType->IsUnsigned()) {
     m_Diag.Diag(Diag::DIR_Error,
-                Diag::Format(Diag::DMT_ErrCannotApplyBinaryOp,
-                             {RepresentationOf(bop),
-                              "<not-implemented>", "<not-implemented>"}),
-                SourceRange(0, 0, 0));
+                Diag::DMT_ErrCannotApplyBinaryOp,
+                {RepresentationOf(bop),
+                 "<not-implemented>", "<not-implemented>"},
+                SourceRange());
     m_Diag.Diag(Diag::DIR_Note, "bitwise shifting requires unsigned types",
-                SourceRange(0, 0, 0));
+                SourceRange());
     return nullptr;
   }
 
@@ -522,10 +522,10 @@ SemaPhase1::ActOnCompare(sona::ref_ptr<const Syntax::BinaryExpr> concrete,
           CommonNumericType(lhsBuiltinType, rhsBuiltinType);
       if (commonType == nullptr) {
         m_Diag.Diag(Diag::DIR_Error,
-                    Diag::Format(Diag::DMT_ErrCannotApplyBinaryOp,
-                                 {RepresentationOf(bop),
-                                  "<not-implemented>", "<not-implemented>"}),
-                    SourceRange(0, 0, 0));
+                    Diag::DMT_ErrCannotApplyBinaryOp,
+                    {RepresentationOf(bop),
+                     "<not-implemented>", "<not-implemented>"},
+                    SourceRange());
         return nullptr;
       }
       sona::ref_ptr<AST::Type const> commonType1 =
@@ -556,13 +556,13 @@ SemaPhase1::ActOnCompare(sona::ref_ptr<const Syntax::BinaryExpr> concrete,
     if (lhsPtrType->GetPointee().GetUnqualTy()
         != rhsPtrType->GetPointee().GetUnqualTy()) {
       m_Diag.Diag(Diag::DIR_Error,
-                  Diag::Format(Diag::DMT_ErrCannotApplyBinaryOp,
-                               {RepresentationOf(bop),
-                                "<not-implemented>", "<not-implemented>"}),
-                  SourceRange(0, 0, 0));
+                  Diag::DMT_ErrCannotApplyBinaryOp,
+                  {RepresentationOf(bop),
+                   "<not-implemented>", "<not-implemented>"},
+                  SourceRange());
       m_Diag.Diag(Diag::DIR_Note,
                   "pointer arithmetic requires same base type",
-                  SourceRange(0, 0, 0));
+                  SourceRange());
       return nullptr;
     }
     return new AST::BinaryExpr(
@@ -604,7 +604,7 @@ SemaPhase1::ActOnUnaryAlgebraicExpr(
                                 pointeeType, AST::Expr::VC_LValue);
     }
     m_Diag.Diag(Diag::DIR_Error,
-                Diag::Format(Diag::DMT_ErrOpRequiresType, {"*", "pointer"}),
+                Diag::DMT_ErrOpRequiresType, {"*", "pointer"},
                 expr->GetOpRange());
     break;
   case Syntax::UnaryOperator::UOP_LogicNot:
@@ -620,7 +620,7 @@ SemaPhase1::ActOnUnaryAlgebraicExpr(
                                   AST::Expr::VC_RValue);
       }
       m_Diag.Diag(Diag::DIR_Error,
-                  Diag::Format(Diag::DMT_ErrOpRequiresType, {"!", "boolean"}),
+                  Diag::DMT_ErrOpRequiresType, {"!", "boolean"},
                   expr->GetOpRange());
     }
     break;
@@ -635,8 +635,8 @@ SemaPhase1::ActOnUnaryAlgebraicExpr(
                                   baseExprTy, AST::Expr::VC_RValue);
       }
       m_Diag.Diag(Diag::DIR_Error,
-                  Diag::Format(Diag::DMT_ErrOpRequiresType,
-                               {"-", "signed numeric"}),
+                  Diag::DMT_ErrOpRequiresType,
+                  {"-", "signed numeric"},
                   expr->GetOpRange());
     }
     break;
@@ -650,7 +650,7 @@ SemaPhase1::ActOnUnaryAlgebraicExpr(
                                   baseExprTy, AST::Expr::VC_RValue);
       }
       m_Diag.Diag(Diag::DIR_Error,
-                  Diag::Format(Diag::DMT_ErrOpRequiresType, {"+", "numeric"}),
+                  Diag::DMT_ErrOpRequiresType, {"+", "numeric"},
                   expr->GetOpRange());
     }
     break;
@@ -670,8 +670,8 @@ SemaPhase1::ActOnUnaryAlgebraicExpr(
                                 baseExprTy, AST::Expr::VC_RValue);
     }
     m_Diag.Diag(Diag::DIR_Error,
-                Diag::Format(Diag::DMT_ErrOpRequiresType,
-                             {"++", "integral or pointer"}),
+                Diag::DMT_ErrOpRequiresType,
+                {"++", "integral or pointer"},
                 expr->GetOpRange());
     break;
   case Syntax::UnaryOperator::UOP_SelfDecr:
@@ -690,8 +690,8 @@ SemaPhase1::ActOnUnaryAlgebraicExpr(
                                 baseExprTy, AST::Expr::VC_RValue);
     }
     m_Diag.Diag(Diag::DIR_Error,
-                Diag::Format(Diag::DMT_ErrOpRequiresType,
-                             {"--", "integral or pointer"}),
+                Diag::DMT_ErrOpRequiresType,
+                {"--", "integral or pointer"},
                 expr->GetOpRange());
     break;
   case Syntax::UnaryOperator::UOP_AddrOf:
@@ -701,7 +701,7 @@ SemaPhase1::ActOnUnaryAlgebraicExpr(
                                 AST::Expr::VC_RValue);
     }
     m_Diag.Diag(Diag::DIR_Error,
-                Diag::Format(Diag::DMT_ErrAddressOfRValue, {}),
+                Diag::DMT_ErrAddressOfRValue, {},
                 expr->GetOpRange());
     break;
   case Syntax::UnaryOperator::UOP_BitReverse:
@@ -715,8 +715,8 @@ SemaPhase1::ActOnUnaryAlgebraicExpr(
       }
     }
     m_Diag.Diag(Diag::DIR_Error,
-                Diag::Format(Diag::DMT_ErrOpRequiresType,
-                             {"~", "unsigned int"}),
+                Diag::DMT_ErrOpRequiresType,
+                {"~", "unsigned int"},
                 expr->GetOpRange());
     break;
   case Syntax::UnaryOperator::UOP_Invalid: ;
@@ -729,6 +729,9 @@ sona::owner<AST::Expr>
 SemaPhase1::ActOnCastExpr(std::shared_ptr<Scope> scope,
                           sona::ref_ptr<Syntax::CastExpr const> expr) {
   sona::owner<AST::Expr> castedExpr = ActOnExpr(scope, expr->GetCastedExpr());
+  if (castedExpr.borrow() == nullptr) {
+    return nullptr;
+  }
   AST::QualType destType = ResolveType(scope, expr->GetDestType());
   switch (expr->GetOperator()) {
   case Syntax::CastOperator::COP_ConstCast: {
@@ -751,7 +754,7 @@ SemaPhase1::ActOnStaticCast(sona::ref_ptr<Syntax::CastExpr const> concrete,
                             AST::QualType destType) {
   if (castedExpr.borrow()->GetExprType() == destType) {
     m_Diag.Diag(Diag::DIR_Warning0,
-                Diag::Format(Diag::DMT_WarnRedundantStatcCast, {}),
+                Diag::DMT_WarnRedundantStatcCast, {},
                 concrete->GetCastOpRange());
     return std::move(castedExpr);
   }
@@ -761,7 +764,7 @@ SemaPhase1::ActOnStaticCast(sona::ref_ptr<Syntax::CastExpr const> concrete,
                       std::move(castedExpr), destType);
   if (implicitCastResult.borrow() != nullptr) {
     m_Diag.Diag(Diag::DIR_Warning0,
-                Diag::Format(Diag::DMT_WarnRedundantStatcCast, {}),
+                Diag::DMT_WarnRedundantStatcCast, {},
                 concrete->GetCastOpRange());
     return implicitCastResult;
   }
@@ -787,9 +790,9 @@ SemaPhase1::ActOnStaticCast(sona::ref_ptr<Syntax::CastExpr const> concrete,
   }
 
   m_Diag.Diag(Diag::DIR_Error,
-              Diag::Format(Diag::DMT_ErrCannotStaticCast,
-                           {"<not-implemented>", "<not-implementd>"}),
-              SourceRange(0, 0, 0));
+              Diag::DMT_ErrCannotStaticCast,
+              {"<not-implemented>", "<not-implementd>"},
+              SourceRange());
   return nullptr;
 }
 
@@ -881,9 +884,9 @@ SemaPhase1::TryImplicitCast(sona::ref_ptr<const Syntax::Expr> concrete,
 
   if (shouldDiag) {
     m_Diag.Diag(Diag::DIR_Error,
-                Diag::Format(Diag::DMT_ErrCannotImplicitCast,
-                { "<not-implemented>", "<not-implemented>" }),
-                /** @todo */ SourceRange(0, 0, 0));
+                Diag::DMT_ErrCannotImplicitCast,
+                { "<not-implemented>", "<not-implemented>" },
+                /** @todo */ SourceRange());
   }
 
   return nullptr;
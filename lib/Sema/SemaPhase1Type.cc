@@ -14,6 +14,9 @@ SemaPhase1::ResolveComposedType(std::shared_ptr<Scope> scope,
             .zip_with(
              sona::linq::from_container(cty->GetTypeSpecRanges()));
   for (const auto& p : r) {
+    if (m_Diag.CheckBudget(p.second)) {
+      break;
+    }
     switch (p.first) {
     case Syntax::ComposedType::CTS_Pointer:
       ret = m_ASTContext.CreatePointerType(ret);
@@ -27,7 +30,7 @@ SemaPhase1::ResolveComposedType(std::shared_ptr<Scope> scope,
     case Syntax::ComposedType::CTS_Const:
       if (ret.IsConst()) {
         m_Diag.Diag(Diag::DIR_Error,
-                    Diag::Format(Diag::DMT_ErrDuplicateQual, {"const"}),
+                    Diag::DMT_ErrDuplicateQual, {"const"},
                     p.second);
       }
       else {
@@ -37,7 +40,7 @@ SemaPhase1::ResolveComposedType(std::shared_ptr<Scope> scope,
     case Syntax::ComposedType::CTS_Volatile:
       if (ret.IsVolatile()) {
         m_Diag.Diag(Diag::DIR_Error,
-                    Diag::Format(Diag::DMT_ErrDuplicateQual, {"volatile"}),
+                    Diag::DMT_ErrDuplicateQual, {"volatile"},
                     p.second);
       }
       else {
@@ -47,7 +50,7 @@ SemaPhase1::ResolveComposedType(std::shared_ptr<Scope> scope,
     case Syntax::ComposedType::CTS_Restrict:
       if (ret.IsRestrict()) {
         m_Diag.Diag(Diag::DIR_Error,
-                    Diag::Format(Diag::DMT_ErrDuplicateQual, {"restrict"}),
+                    Diag::DMT_ErrDuplicateQual, {"restrict"},
                     p.second);
       }
       else {
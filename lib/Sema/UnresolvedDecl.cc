@@ -15,7 +15,7 @@ void IncompleteDecl::AddValueDepend(sona::ref_ptr<AST::Decl> decl,
 }
 
 std::string IncompleteVarDecl::ToString() const {
-  return "incomplete variable: " + GetConcrete()->GetName().get();
+  return "incomplete variable: " + GetConcrete()->GetName().get().to_string();
 }
 
 std::string IncompleteTagDecl::ToString() const {
@@ -24,19 +24,19 @@ std::string IncompleteTagDecl::ToString() const {
   case AST::Decl::DK_Class: {
     sona::ref_ptr<AST::ClassDecl const> classDecl =
         GetHalfway().cast_unsafe<AST::ClassDecl const>();
-    ret += classDecl->GetName().get();
+    ret += classDecl->GetName().get().to_string();
     break;
   }
   case AST::Decl::DK_Enum: {
     sona::ref_ptr<AST::EnumDecl const> enumDecl =
         GetHalfway().cast_unsafe<AST::EnumDecl const>();
-    ret += enumDecl->GetName().get();
+    ret += enumDecl->GetName().get().to_string();
     break;
   }
   case AST::Decl::DK_ADT: {
     sona::ref_ptr<AST::ADTDecl const> adtDecl =
         GetHalfway().cast_unsafe<AST::ADTDecl const>();
-    ret += adtDecl->GetName().get();
+    ret += adtDecl->GetName().get().to_string();
     break;
   }
   default:
@@ -46,17 +46,17 @@ std::string IncompleteTagDecl::ToString() const {
 }
 
 std::string IncompleteUsingDecl::ToString() const {
-  return "incomplete using: " + GetHalfway()->GetName().get();
+  return "incomplete using: " + GetHalfway()->GetName().get().to_string();
 }
 
 std::string IncompleteValueCtorDecl::ToString() const {
   return "incomplete ADT constructor: "
          + GetHalfway().cast_unsafe<AST::ValueCtorDecl const>()
-                       ->GetConstructorName().get();
+                       ->GetConstructorName().get().to_string();
 }
 
 std::string IncompleteFuncDecl::ToString() const {
-  return "incomplete function: " + m_FuncDecl->GetName().get();
+  return "incomplete function: " + m_FuncDecl->GetName().get().to_string();
 }
 
 } // namespace Sema
@@ -0,0 +1,121 @@
+#include "Syntax/CSTCache.h"
+
+#include "Basic/Version.h"
+#include "Syntax/Serialize.h"
+#include "sona/sha256.h"
+#include "sona/stringref.h"
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace ckx {
+namespace Syntax {
+
+namespace {
+
+/// The key, the size and the SHA-256 of the source come before the
+/// serialized tree. The key only names the file, the digest tells a
+/// source whose key collides from a hit.
+constexpr std::size_t EntryHeaderSize = 8 + 4 + 32;
+
+} // namespace
+
+CSTCache::CSTCache(std::string const& directory) : m_Directory(directory) {
+  if (m_Directory.empty()) {
+    m_Directory = ".";
+  }
+}
+
+std::uint64_t CSTCache::ComputeKey(SourceBuffer const& source) noexcept {
+  std::uint64_t parts[3] = {
+    sona::hash_bytes(source.GetBufferStart(), source.GetBufferSize()),
+    sona::hash_bytes(CompilerVersion, sizeof(CompilerVersion) - 1),
+    CSTFormatVersion
+  };
+  return sona::hash_bytes(reinterpret_cast<char const*>(parts),
+                          sizeof(parts));
+}
+
+std::string CSTCache::GetCachePath(SourceBuffer const& source) const {
+  char name[32];
+  std::snprintf(name, sizeof(name), "%016llx.cst",
+                static_cast<unsigned long long>(ComputeKey(source)));
+  return m_Directory + "/" + name;
+}
+
+sona::owner<TransUnit> CSTCache::Load(SourceBuffer const& source,
+                                      SourceLocation fileStart) const {
+  sona::owner<SourceBuffer> entry =
+      SourceBuffer::MapFile(GetCachePath(source));
+  if (entry.borrow() == nullptr
+      || entry.borrow()->GetBufferSize() < EntryHeaderSize) {
+    return nullptr;
+  }
+
+  char const *data = entry.borrow()->GetBufferStart();
+  std::uint64_t key;
+  std::uint32_t sourceSize;
+  std::memcpy(&key, data, 8);
+  std::memcpy(&sourceSize, data + 8, 4);
+  if (key != ComputeKey(source) || sourceSize != source.GetBufferSize()) {
+    return nullptr;
+  }
+  sona::sha256_digest digest =
+      sona::sha256(source.GetBufferStart(), source.GetBufferSize());
+  if (std::memcmp(data + 12, digest.data(), digest.size()) != 0) {
+    return nullptr;
+  }
+  return DeserializeTransUnit(data + EntryHeaderSize,
+                              entry.borrow()->GetBufferSize()
+                                - EntryHeaderSize,
+                              fileStart);
+}
+
+bool CSTCache::Store(SourceBuffer const& source, SourceLocation fileStart,
+                     TransUnit const& unit) const {
+  if (mkdir(m_Directory.c_str(), 0755) != 0 && errno != EEXIST) {
+    return false;
+  }
+
+  std::uint64_t key = ComputeKey(source);
+  std::uint32_t sourceSize = source.GetBufferSize();
+  std::string image;
+  image.append(reinterpret_cast<char const*>(&key), sizeof(key));
+  image.append(reinterpret_cast<char const*>(&sourceSize),
+               sizeof(sourceSize));
+  sona::sha256_digest digest =
+      sona::sha256(source.GetBufferStart(), source.GetBufferSize());
+  image.append(reinterpret_cast<char const*>(digest.data()), digest.size());
+  SerializeTransUnit(unit, fileStart, image);
+
+  std::string path = GetCachePath(source);
+  std::string tempPath = path + "." + std::to_string(getpid()) + ".tmp";
+  std::FILE *file = std::fopen(tempPath.c_str(), "wb");
+  if (file == nullptr) {
+    return false;
+  }
+  bool written = std::fwrite(image.data(), 1, image.size(), file)
+                   == image.size();
+  written = std::fclose(file) == 0 && written;
+  if (!written || std::rename(tempPath.c_str(), path.c_str()) != 0) {
+    std::remove(tempPath.c_str());
+    return false;
+  }
+  return true;
+}
+
+bool ParseCSTCacheOption(std::string const& arg, std::string &directory) {
+  static char const prefix[] = "--cst-cache=";
+  if (arg.compare(0, sizeof(prefix) - 1, prefix) != 0) {
+    return false;
+  }
+  directory = arg.substr(sizeof(prefix) - 1);
+  return true;
+}
+
+} // namespace Syntax
+} // namespace ckx
@@ -4,5 +4,80 @@
 namespace ckx {
 namespace Syntax {
 
+SourceRange Type::GetRepresentingRange() const noexcept {
+  switch (GetNodeKind()) {
+  case CNK_BuiltinType:
+    return static_cast<BuiltinType const*>(this)->GetSourceRange();
+  case CNK_UserDefinedType:
+    return static_cast<UserDefinedType const*>(this)->GetSourceRange();
+  case CNK_TemplatedType:
+    return static_cast<TemplatedType const*>(this)->GetRootType()
+             ->GetSourceRange();
+  case CNK_ComposedType:
+    return static_cast<ComposedType const*>(this)->GetRootType()
+             ->GetRepresentingRange();
+  default:
+    sona_unreachable();
+  }
+  return SourceRange();
+}
+
+SourceRange Expr::GetRepresentingRange() const noexcept {
+  switch (GetNodeKind()) {
+  case CNK_IntLiteralExpr: case CNK_UIntLiteralExpr:
+  case CNK_CharLiteralExpr: case CNK_StringLiteralExpr:
+  case CNK_BoolLiteralExpr: case CNK_FloatLiteralExpr:
+  case CNK_NullLiteralExpr:
+    return static_cast<LiteralExpr const*>(this)->GetRange();
+  case CNK_IdRefExpr:
+    return static_cast<IdRefExpr const*>(this)->GetId().GetIdSourceRange();
+  case CNK_ArraySubscriptExpr:
+    return static_cast<ArraySubscriptExpr const*>(this)->GetArrayPart()
+             ->GetRepresentingRange();
+  case CNK_FuncCallExpr:
+    return static_cast<FuncCallExpr const*>(this)->GetCallee()
+             ->GetRepresentingRange();
+  case CNK_MemberAccessExpr:
+    return static_cast<MemberAccessExpr const*>(this)->GetMember()
+             .GetIdSourceRange();
+  case CNK_CastExpr:
+    return static_cast<CastExpr const*>(this)->GetCastOpRange();
+  case CNK_UnaryAlgebraicExpr:
+    return static_cast<UnaryAlgebraicExpr const*>(this)->GetOpRange();
+  case CNK_SizeOfExpr:
+    return static_cast<SizeOfExpr const*>(this)->GetSizeOfRange();
+  case CNK_AlignOfExpr:
+    return static_cast<AlignOfExpr const*>(this)->GetAlignOfLocation();
+  case CNK_BinaryExpr:
+    return static_cast<BinaryExpr const*>(this)->GetOpRange();
+  case CNK_AssignExpr:
+    return static_cast<AssignExpr const*>(this)->GetOpRange();
+  default:
+    /// Mixfix expressions are not parsed yet
+    sona_unreachable();
+  }
+  return SourceRange();
+}
+
+SourceRange Decl::GetRepresentingRange() const noexcept {
+  switch (GetNodeKind()) {
+  case CNK_TemplatedDecl:
+    return static_cast<TemplatedDecl const*>(this)->GetTemplateSourceRange();
+  case CNK_ForwardDecl:
+    return static_cast<ForwardDecl const*>(this)->GetNameSourceRange();
+  case CNK_ClassDecl: case CNK_EnumDecl: case CNK_ADTDecl:
+    return static_cast<TagDecl const*>(this)->GetNameRange();
+  case CNK_UsingDecl:
+    return static_cast<UsingDecl const*>(this)->GetNameRange();
+  case CNK_FuncDecl:
+    return static_cast<FuncDecl const*>(this)->GetNameRange();
+  case CNK_VarDecl:
+    return static_cast<VarDecl const*>(this)->GetNameRange();
+  default:
+    sona_unreachable();
+  }
+  return SourceRange();
+}
+
 } // namespace Syntax
 } // namespace ckx
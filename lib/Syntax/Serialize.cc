@@ -0,0 +1,1185 @@
+#include "Syntax/Serialize.h"
+
+#include "sona/stringref.h"
+
+#include <cstring>
+#include <limits>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+namespace ckx {
+namespace Syntax {
+
+namespace {
+
+/// Magic, format version, string count and hash of everything after the
+/// header, which catches truncated and damaged images before any node is
+/// built
+constexpr char ImageMagic[8] = { 'C', 'K', 'X', 'C', 'S', 'T', '\0', '\0' };
+constexpr std::size_t HeaderSize = sizeof(ImageMagic) + 4 + 4 + 8;
+
+/// Written in place of the kind of an absent node
+constexpr std::uint8_t NoNode = 0xFF;
+
+constexpr std::size_t NumNodeKinds = 0
+#define CST_TRANSUNIT(name) + 1
+#define CST_MISC(name) + 1
+#define CST_TYPE(name) + 1
+#define CST_DECL(name) + 1
+#define CST_STMT(name) + 1
+#define CST_EXPR(name) + 1
+#include "Syntax/Nodes.def"
+    ;
+static_assert(NumNodeKinds < NoNode, "node kinds no longer fit in a byte");
+
+enum FuncBodyState : std::uint8_t { FBS_None, FBS_Parsed, FBS_Skipped };
+
+class CSTWriter {
+public:
+  explicit CSTWriter(std::string &out,
+                     SourceLocation fileStart = SourceLocation())
+    : m_Out(out), m_FileStart(fileStart) {}
+
+  void WriteUnit(TransUnit const& unit) {
+    WriteNodeList(unit.GetImports());
+    WriteNodeList(unit.GetDecls());
+  }
+
+  std::vector<sona::strhdl_t> const& GetStrings() const noexcept {
+    return m_Strings;
+  }
+
+  void WriteStringTable(std::vector<sona::strhdl_t> const& strings) {
+    for (sona::strhdl_t str : strings) {
+      sona::string_view text = str.get();
+      WriteCount(text.size());
+      m_Out.append(text.data(), text.size());
+    }
+  }
+
+private:
+  template <typename T> void WriteRaw(T value) {
+    static_assert(std::is_trivially_copyable<T>::value,
+                  "only plain values are written as they are");
+    m_Out.append(reinterpret_cast<char const*>(&value), sizeof(T));
+  }
+
+  /// LEB128: seven bits a byte, most numbers of a tree are small
+  void WriteVar(std::uint32_t value) {
+    while (value >= 0x80) {
+      m_Out.push_back(static_cast<char>((value & 0x7F) | 0x80));
+      value >>= 7;
+    }
+    m_Out.push_back(static_cast<char>(value));
+  }
+
+  void WriteCount(std::size_t count) {
+    WriteVar(static_cast<std::uint32_t>(count));
+  }
+
+  void WriteStr(sona::strhdl_t str) {
+    auto it = m_StringIndices.find(str.id());
+    if (it == m_StringIndices.end()) {
+      it = m_StringIndices.emplace(
+             str.id(), static_cast<std::uint32_t>(m_Strings.size())).first;
+      m_Strings.push_back(str);
+    }
+    WriteVar(it->second);
+  }
+
+  /// How far the range begins from where the range written before it
+  /// began, zigzag encoded and plus one so that 0 is left for an invalid
+  /// range, and its length. Ranges are written close to the one before
+  /// them most of the time, and then take a byte or two instead of three
+  /// or four.
+  void WriteRange(SourceRange const& range) {
+    if (range.IsInvalid() || range.GetBegin() < m_FileStart) {
+      WriteVar(0);
+      return;
+    }
+    std::uint32_t begin = range.GetBegin().GetRawEncoding()
+                          - m_FileStart.GetRawEncoding();
+    std::int64_t delta = static_cast<std::int64_t>(begin) - m_PrevBegin;
+    m_PrevBegin = begin;
+    WriteVar(static_cast<std::uint32_t>(delta < 0 ? -2 * delta - 1
+                                                  : 2 * delta) + 1);
+    WriteVar(range.GetEnd().GetRawEncoding()
+             - range.GetBegin().GetRawEncoding());
+  }
+
+  void WriteId(Identifier const& id) {
+    WriteCount(id.GetNestedNameSpecifiers().size());
+    for (sona::strhdl_t nns : id.GetNestedNameSpecifiers()) {
+      WriteStr(nns);
+    }
+    WriteCount(id.GetNNSSourceRanges().size());
+    for (SourceRange const& range : id.GetNNSSourceRanges()) {
+      WriteRange(range);
+    }
+    WriteStr(id.GetIdentifier());
+    WriteRange(id.GetIdSourceRange());
+  }
+
+  template <typename T> void WriteNode(sona::ref_ptr<T const> node) {
+    WriteAnyNode(node.operator->());
+  }
+
+  template <typename Range> void WriteNodeList(Range const& nodes) {
+    WriteCount(nodes.size());
+    for (auto node : nodes) {
+      WriteNode(node);
+    }
+  }
+
+  void WriteAnyNode(Node const* node);
+
+  /// One for every kind of Nodes.def, a kind added there fails to compile
+  /// until it can be written
+#define CST_TRANSUNIT(name) void Write##name(Node const* node);
+#define CST_MISC(name) void Write##name(Node const* node);
+#define CST_TYPE(name) void Write##name(Node const* node);
+#define CST_DECL(name) void Write##name(Node const* node);
+#define CST_STMT(name) void Write##name(Node const* node);
+#define CST_EXPR(name) void Write##name(Node const* node);
+#include "Syntax/Nodes.def"
+
+  std::string &m_Out;
+  SourceLocation m_FileStart;
+  std::uint32_t m_PrevBegin = 0;
+  std::unordered_map<std::uint32_t, std::uint32_t> m_StringIndices;
+  std::vector<sona::strhdl_t> m_Strings;
+};
+
+void CSTWriter::WriteAnyNode(Node const* node) {
+  if (node == nullptr) {
+    WriteRaw(NoNode);
+    return;
+  }
+  WriteRaw(static_cast<std::uint8_t>(node->GetNodeKind()));
+
+  switch (node->GetNodeKind()) {
+#define CST_KIND(name) \
+  case Node::CNK_##name: \
+    Write##name(node); \
+    break;
+#define CST_TRANSUNIT(name) CST_KIND(name)
+#define CST_MISC(name) CST_KIND(name)
+#define CST_TYPE(name) CST_KIND(name)
+#define CST_DECL(name) CST_KIND(name)
+#define CST_STMT(name) CST_KIND(name)
+#define CST_EXPR(name) CST_KIND(name)
+#include "Syntax/Nodes.def"
+#undef CST_KIND
+  }
+}
+
+void CSTWriter::WriteAttributeList(Node const* node) {
+  AttributeList const* list = static_cast<AttributeList const*>(node);
+  WriteCount(list->GetAttributes().size());
+  for (AttributeList::Attribute const& attribute : list->GetAttributes()) {
+    WriteStr(attribute.GetAttributeName());
+    WriteRaw(static_cast<std::uint8_t>(attribute.HasAttributeValue()));
+    if (attribute.HasAttributeValue()) {
+      WriteStr(attribute.GetAttributeValueUnsafe());
+    }
+    WriteRange(attribute.GetNameRange());
+    WriteRange(attribute.GetValueRange());
+  }
+}
+
+void CSTWriter::WriteImport(Node const* node) {
+  Import const* import = static_cast<Import const*>(node);
+  WriteId(import->GetImportedIdentifier());
+  WriteRange(import->GetImportSourceRange());
+  WriteRaw(static_cast<std::uint8_t>(import->IsWeak()));
+  if (import->IsWeak()) {
+    WriteRange(import->GetWeakSourceRangeUnsafe());
+  }
+}
+
+void CSTWriter::WriteExport(Node const* node) {
+  Export const* exp = static_cast<Export const*>(node);
+  WriteNode(exp->GetExportedDecl());
+  WriteRange(exp->GetExportSourceRange());
+}
+
+void CSTWriter::WriteBuiltinType(Node const* node) {
+  BuiltinType const* type = static_cast<BuiltinType const*>(node);
+  WriteVar(static_cast<std::uint32_t>(type->GetBuiltinTypeId()));
+  WriteRange(type->GetSourceRange());
+}
+
+void CSTWriter::WriteUserDefinedType(Node const* node) {
+  UserDefinedType const* type = static_cast<UserDefinedType const*>(node);
+  WriteId(type->GetName());
+  WriteRange(type->GetSourceRange());
+}
+
+void CSTWriter::WriteTemplatedType(Node const* node) {
+  TemplatedType const* type = static_cast<TemplatedType const*>(node);
+  WriteNode(type->GetRootType());
+  WriteCount(type->GetTemplateArgs().size());
+  for (TemplatedType::TemplateArg const& arg : type->GetTemplateArgs()) {
+    WriteRaw(static_cast<std::uint8_t>(arg.contains_t1()));
+    if (arg.contains_t1()) {
+      WriteNode(arg.as_t1().borrow());
+    }
+    else {
+      WriteNode(arg.as_t2().borrow());
+    }
+  }
+}
+
+void CSTWriter::WriteComposedType(Node const* node) {
+  ComposedType const* type = static_cast<ComposedType const*>(node);
+  WriteNode(type->GetRootType());
+  WriteCount(type->GetTypeSpecifiers().size());
+  for (ComposedType::TypeSpecifier spec : type->GetTypeSpecifiers()) {
+    WriteRaw(static_cast<std::uint8_t>(spec));
+  }
+  WriteCount(type->GetTypeSpecRanges().size());
+  for (SourceRange const& range : type->GetTypeSpecRanges()) {
+    WriteRange(range);
+  }
+}
+
+void CSTWriter::WriteTemplatedDecl(Node const* node) {
+  TemplatedDecl const* decl = static_cast<TemplatedDecl const*>(node);
+  WriteCount(decl->GetTemplateParams().size());
+  for (TemplatedDecl::TemplateParam const& param
+         : decl->GetTemplateParams()) {
+    WriteRaw(static_cast<std::uint8_t>(param.contains_t1()));
+    if (param.contains_t1()) {
+      WriteStr(param.as_t1());
+    }
+    else {
+      WriteNode(param.as_t2().borrow());
+    }
+  }
+  WriteNode(decl->GetUnderlyingDecl());
+  WriteRange(decl->GetTemplateSourceRange());
+}
+
+void CSTWriter::WriteForwardDecl(Node const* node) {
+  ForwardDecl const* decl = static_cast<ForwardDecl const*>(node);
+  WriteRaw(static_cast<std::uint8_t>(decl->GetFDK()));
+  WriteStr(decl->GetName());
+  WriteRange(decl->GetKeywordSourceRange());
+  WriteRange(decl->GetNameSourceRange());
+}
+
+void CSTWriter::WriteClassDecl(Node const* node) {
+  ClassDecl const* decl = static_cast<ClassDecl const*>(node);
+  WriteStr(decl->GetName());
+  WriteNodeList(decl->GetSubDecls());
+  WriteRange(decl->GetKeywordRange());
+  WriteRange(decl->GetNameRange());
+}
+
+void CSTWriter::WriteEnumDecl(Node const* node) {
+  EnumDecl const* decl = static_cast<EnumDecl const*>(node);
+  WriteStr(decl->GetName());
+  WriteCount(decl->GetEnumerators().size());
+  for (EnumDecl::Enumerator const& e : decl->GetEnumerators()) {
+    WriteStr(e.GetName());
+    WriteRange(e.GetNameRange());
+    WriteRaw(static_cast<std::uint8_t>(e.HasValue()));
+    if (e.HasValue()) {
+      WriteRaw(e.GetValueUnsafe());
+      WriteRange(e.GetEqRangeUnsafe());
+      WriteRange(e.GetValueRangeUnsafe());
+    }
+  }
+  WriteRange(decl->GetEnumRange());
+  WriteRange(decl->GetNameRange());
+}
+
+void CSTWriter::WriteADTDecl(Node const* node) {
+  ADTDecl const* decl = static_cast<ADTDecl const*>(node);
+  WriteStr(decl->GetName());
+  WriteCount(decl->GetConstructors().size());
+  for (ADTDecl::ValueConstructor const& c : decl->GetConstructors()) {
+    WriteStr(c.GetName());
+    WriteNode(c.GetUnderlyingType());
+    WriteRange(c.GetNameRange());
+  }
+  WriteRange(decl->GetEnumRange());
+  WriteRange(decl->GetClassRange());
+  WriteRange(decl->GetNameRange());
+}
+
+void CSTWriter::WriteUsingDecl(Node const* node) {
+  UsingDecl const* decl = static_cast<UsingDecl const*>(node);
+  WriteStr(decl->GetName());
+  WriteNode(decl->GetAliasee());
+  WriteRange(decl->GetUsingRange());
+  WriteRange(decl->GetNameRange());
+  WriteRange(decl->GetEqRange());
+}
+
+void CSTWriter::WriteFuncDecl(Node const* node) {
+  FuncDecl const* decl = static_cast<FuncDecl const*>(node);
+  WriteStr(decl->GetName());
+  WriteNodeList(decl->GetParamTypes());
+  WriteCount(decl->GetParamNames().size());
+  for (sona::strhdl_t name : decl->GetParamNames()) {
+    WriteStr(name);
+  }
+  WriteNode(decl->GetReturnType());
+  if (decl->HasSkippedBody()) {
+    WriteRaw(FBS_Skipped);
+    WriteVar(decl->GetSkippedBodyBeginUnsafe());
+    WriteVar(decl->GetSkippedBodyEndUnsafe());
+  }
+  else if (decl->IsDefinition()) {
+    WriteRaw(FBS_Parsed);
+    WriteNode(decl->GetFuncBodyUnsafe());
+  }
+  else {
+    WriteRaw(FBS_None);
+  }
+  WriteRange(decl->GetKeywordRange());
+  WriteRange(decl->GetNameRange());
+}
+
+void CSTWriter::WriteVarDecl(Node const* node) {
+  VarDecl const* decl = static_cast<VarDecl const*>(node);
+  WriteStr(decl->GetName());
+  WriteNode(decl->GetType());
+  WriteRange(decl->GetKeywordRange());
+  WriteRange(decl->GetNameRange());
+}
+
+void CSTWriter::WriteEmptyStmt(Node const* node) {
+  WriteRange(static_cast<EmptyStmt const*>(node)->GetSemiRange());
+}
+
+void CSTWriter::WriteExprStmt(Node const* node) {
+  WriteNode(static_cast<ExprStmt const*>(node)->GetExpr());
+}
+
+void CSTWriter::WriteCompoundStmt(Node const* node) {
+  CompoundStmt const* stmt = static_cast<CompoundStmt const*>(node);
+  WriteNodeList(stmt->GetStmts());
+  WriteRange(stmt->GetLBraceRange());
+  WriteRange(stmt->GetRBraceRange());
+}
+
+void CSTWriter::WriteReturnStmt(Node const* node) {
+  ReturnStmt const* stmt = static_cast<ReturnStmt const*>(node);
+  WriteNode(stmt->HasReturnValue() ? stmt->GetReturnValueUnsafe()
+                                   : sona::ref_ptr<Expr const>(nullptr));
+  WriteRange(stmt->GetReturnRange());
+}
+
+void CSTWriter::WriteIntLiteralExpr(Node const* node) {
+  IntLiteralExpr const* expr = static_cast<IntLiteralExpr const*>(node);
+  WriteRaw(expr->GetValue());
+  WriteRange(expr->GetRange());
+}
+
+void CSTWriter::WriteUIntLiteralExpr(Node const* node) {
+  UIntLiteralExpr const* expr = static_cast<UIntLiteralExpr const*>(node);
+  WriteRaw(expr->GetValue());
+  WriteRange(expr->GetRange());
+}
+
+void CSTWriter::WriteCharLiteralExpr(Node const* node) {
+  CharLiteralExpr const* expr = static_cast<CharLiteralExpr const*>(node);
+  WriteRaw(expr->GetValue());
+  WriteRange(expr->GetRange());
+}
+
+void CSTWriter::WriteStringLiteralExpr(Node const* node) {
+  StringLiteralExpr const* expr =
+      static_cast<StringLiteralExpr const*>(node);
+  WriteStr(expr->GetValue());
+  WriteRange(expr->GetRange());
+}
+
+void CSTWriter::WriteBoolLiteralExpr(Node const* node) {
+  BoolLiteralExpr const* expr = static_cast<BoolLiteralExpr const*>(node);
+  WriteRaw(static_cast<std::uint8_t>(expr->GetValue()));
+  WriteRange(expr->GetRange());
+}
+
+void CSTWriter::WriteFloatLiteralExpr(Node const* node) {
+  FloatLiteralExpr const* expr = static_cast<FloatLiteralExpr const*>(node);
+  WriteRaw(expr->GetValue());
+  WriteRange(expr->GetRange());
+}
+
+void CSTWriter::WriteNullLiteralExpr(Node const* node) {
+  WriteRange(static_cast<NullLiteralExpr const*>(node)->GetRange());
+}
+
+void CSTWriter::WriteIdRefExpr(Node const* node) {
+  WriteId(static_cast<IdRefExpr const*>(node)->GetId());
+}
+
+void CSTWriter::WriteArraySubscriptExpr(Node const* node) {
+  ArraySubscriptExpr const* expr =
+      static_cast<ArraySubscriptExpr const*>(node);
+  WriteNode(expr->GetArrayPart());
+  WriteNode(expr->GetIndexPart());
+}
+
+void CSTWriter::WriteFuncCallExpr(Node const* node) {
+  FuncCallExpr const* expr = static_cast<FuncCallExpr const*>(node);
+  WriteNode(expr->GetCallee());
+  WriteNodeList(expr->GetArgs());
+}
+
+void CSTWriter::WriteMemberAccessExpr(Node const* node) {
+  MemberAccessExpr const* expr = static_cast<MemberAccessExpr const*>(node);
+  WriteNode(expr->GetBaseExpr());
+  WriteId(expr->GetMember());
+}
+
+void CSTWriter::WriteCastExpr(Node const* node) {
+  CastExpr const* expr = static_cast<CastExpr const*>(node);
+  WriteVar(static_cast<std::uint32_t>(expr->GetOperator()));
+  WriteNode(expr->GetCastedExpr());
+  WriteNode(expr->GetDestType());
+  WriteRange(expr->GetCastOpRange());
+}
+
+void CSTWriter::WriteUnaryAlgebraicExpr(Node const* node) {
+  UnaryAlgebraicExpr const* expr =
+      static_cast<UnaryAlgebraicExpr const*>(node);
+  WriteVar(static_cast<std::uint32_t>(expr->GetOperator()));
+  WriteNode(expr->GetBaseExpr());
+  WriteRange(expr->GetOpRange());
+}
+
+void CSTWriter::WriteSizeOfExpr(Node const* node) {
+  SizeOfExpr const* expr = static_cast<SizeOfExpr const*>(node);
+  WriteNode(expr->GetContainedExpr());
+  WriteRange(expr->GetSizeOfRange());
+}
+
+void CSTWriter::WriteAlignOfExpr(Node const* node) {
+  AlignOfExpr const* expr = static_cast<AlignOfExpr const*>(node);
+  WriteNode(expr->GetContainedExpr());
+  WriteRange(expr->GetAlignOfLocation());
+}
+
+void CSTWriter::WriteBinaryExpr(Node const* node) {
+  BinaryExpr const* expr = static_cast<BinaryExpr const*>(node);
+  WriteVar(static_cast<std::uint32_t>(expr->GetOperator()));
+  WriteNode(expr->GetLeftHandSide());
+  WriteNode(expr->GetRightHandSide());
+  WriteRange(expr->GetOpRange());
+}
+
+void CSTWriter::WriteAssignExpr(Node const* node) {
+  AssignExpr const* expr = static_cast<AssignExpr const*>(node);
+  WriteVar(static_cast<std::uint32_t>(expr->GetOperator()));
+  WriteNode(expr->GetLeftHandSide());
+  WriteNode(expr->GetRightHandSide());
+  WriteRange(expr->GetOpRange());
+}
+/// A unit is never the child of a node, and the remaining kinds have no
+/// node class yet
+void CSTWriter::WriteTransUnit(Node const*) { sona_unreachable(); }
+void CSTWriter::WriteIfStmt(Node const*) { sona_unreachable(); }
+void CSTWriter::WriteMatchStmt(Node const*) { sona_unreachable(); }
+void CSTWriter::WriteForStmt(Node const*) { sona_unreachable(); }
+void CSTWriter::WriteForEachStmt(Node const*) { sona_unreachable(); }
+void CSTWriter::WriteWhileStmt(Node const*) { sona_unreachable(); }
+void CSTWriter::WriteMixFixExpr(Node const*) { sona_unreachable(); }
+
+/// Which node kinds a child of type T may have
+template <typename T> struct NodeKinds;
+
+template <> struct NodeKinds<Node> {
+  static bool Contains(Node::NodeKind) noexcept { return true; }
+};
+
+template <> struct NodeKinds<Type> {
+  static bool Contains(Node::NodeKind kind) noexcept {
+    switch (kind) {
+#define CST_TYPE(name) case Node::CNK_##name:
+#include "Syntax/Nodes.def"
+      return true;
+    default:
+      return false;
+    }
+  }
+};
+
+template <> struct NodeKinds<Decl> {
+  static bool Contains(Node::NodeKind kind) noexcept {
+    switch (kind) {
+#define CST_DECL(name) case Node::CNK_##name:
+#include "Syntax/Nodes.def"
+      return true;
+    default:
+      return false;
+    }
+  }
+};
+
+template <> struct NodeKinds<Stmt> {
+  static bool Contains(Node::NodeKind kind) noexcept {
+    switch (kind) {
+#define CST_STMT(name) case Node::CNK_##name:
+#include "Syntax/Nodes.def"
+      return true;
+    default:
+      return false;
+    }
+  }
+};
+
+template <> struct NodeKinds<Expr> {
+  static bool Contains(Node::NodeKind kind) noexcept {
+    switch (kind) {
+#define CST_EXPR(name) case Node::CNK_##name:
+#include "Syntax/Nodes.def"
+      return true;
+    default:
+      return false;
+    }
+  }
+};
+
+template <> struct NodeKinds<UserDefinedType> {
+  static bool Contains(Node::NodeKind kind) noexcept {
+    return kind == Node::CNK_UserDefinedType;
+  }
+};
+
+template <> struct NodeKinds<Import> {
+  static bool Contains(Node::NodeKind kind) noexcept {
+    return kind == Node::CNK_Import;
+  }
+};
+
+/// Reads defensively: past the end of the image, or on anything the
+/// writer never produces, the reader fails and hands out zeros from then
+/// on. Arguments are read into locals one by one, in the order they were
+/// written, since the order function arguments are evaluated in is not.
+class CSTReader {
+public:
+  CSTReader(char const* begin, char const* end, SyntaxArena &arena,
+            SourceLocation fileStart = SourceLocation())
+    : m_Cur(begin), m_End(end), m_Arena(arena), m_FileStart(fileStart) {}
+
+  bool Failed() const noexcept { return m_Failed; }
+  bool AtEnd() const noexcept { return m_Cur == m_End; }
+
+  bool ReadStringTable(std::uint32_t numStrings) {
+    if (numStrings > static_cast<std::size_t>(m_End - m_Cur)) {
+      return false;
+    }
+    m_Strings.reserve(numStrings);
+    for (std::uint32_t i = 0; i < numStrings && !m_Failed; i++) {
+      std::uint32_t length = ReadVar();
+      if (length > static_cast<std::size_t>(m_End - m_Cur)) {
+        m_Failed = true;
+        break;
+      }
+      m_Strings.emplace_back(sona::string_view(m_Cur, length));
+      m_Cur += length;
+    }
+    return !m_Failed;
+  }
+
+  void ReadUnit(TransUnit &unit) {
+    std::uint32_t numImports = ReadCount();
+    for (std::uint32_t i = 0; i < numImports && !m_Failed; i++) {
+      unit.DoImport(ReadNode<Import>());
+    }
+    std::uint32_t numDecls = ReadCount();
+    for (std::uint32_t i = 0; i < numDecls && !m_Failed; i++) {
+      NodePtr<Decl> decl = ReadNode<Decl>();
+      if (decl.borrow() == nullptr) {
+        m_Failed = true;
+      }
+      unit.Declare(std::move(decl));
+    }
+  }
+
+  template <typename T> T ReadRaw() {
+    T ret = T();
+    if (m_Failed || static_cast<std::size_t>(m_End - m_Cur) < sizeof(T)) {
+      m_Failed = true;
+      return ret;
+    }
+    std::memcpy(&ret, m_Cur, sizeof(T));
+    m_Cur += sizeof(T);
+    return ret;
+  }
+
+private:
+  std::uint32_t ReadVar() {
+    std::uint32_t ret = 0;
+    for (unsigned shift = 0; shift < 35; shift += 7) {
+      std::uint8_t byte = ReadRaw<std::uint8_t>();
+      ret |= static_cast<std::uint32_t>(byte & 0x7F) << shift;
+      if ((byte & 0x80) == 0) {
+        return ret;
+      }
+    }
+    m_Failed = true;
+    return 0;
+  }
+
+  /// Every element takes one byte at least, which keeps a damaged count
+  /// from reserving memory the image cannot fill
+  std::uint32_t ReadCount() {
+    std::uint32_t count = ReadVar();
+    if (count > static_cast<std::size_t>(m_End - m_Cur)) {
+      m_Failed = true;
+      return 0;
+    }
+    return count;
+  }
+
+  sona::strhdl_t ReadStr() {
+    std::uint32_t index = ReadVar();
+    if (index >= m_Strings.size()) {
+      m_Failed = true;
+      return sona::strhdl_t("");
+    }
+    return m_Strings[index];
+  }
+
+  bool ReadBool() { return ReadRaw<std::uint8_t>() != 0; }
+
+  SourceRange ReadRange() {
+    std::uint32_t encoded = ReadVar();
+    if (encoded == 0) {
+      return SourceRange();
+    }
+    std::uint32_t zigzag = encoded - 1;
+    std::int64_t begin =
+        m_PrevBegin + ((zigzag & 1) != 0
+                         ? -static_cast<std::int64_t>(zigzag / 2) - 1
+                         : static_cast<std::int64_t>(zigzag / 2));
+    std::uint32_t length = ReadVar();
+    if (begin < 0 || begin > std::numeric_limits<std::uint32_t>::max()) {
+      m_Failed = true;
+      return SourceRange();
+    }
+    m_PrevBegin = static_cast<std::uint32_t>(begin);
+    SourceLocation loc = m_FileStart.GetLocWithOffset(m_PrevBegin);
+    return SourceRange(loc, loc.GetLocWithOffset(length));
+  }
+
+  Identifier ReadId() {
+    std::vector<sona::strhdl_t> nns;
+    std::uint32_t numNNS = ReadCount();
+    for (std::uint32_t i = 0; i < numNNS; i++) {
+      nns.push_back(ReadStr());
+    }
+    std::vector<SourceRange> nnsRanges;
+    std::uint32_t numRanges = ReadCount();
+    for (std::uint32_t i = 0; i < numRanges; i++) {
+      nnsRanges.push_back(ReadRange());
+    }
+    sona::strhdl_t id = ReadStr();
+    SourceRange idRange = ReadRange();
+    if (nns.empty() && nnsRanges.empty()) {
+      return Identifier(id, idRange);
+    }
+    return Identifier(m_Arena.CopyArray(std::move(nns)), id,
+                      m_Arena.CopyArray(std::move(nnsRanges)), idRange);
+  }
+
+  template <typename T> NodePtr<T> ReadNode() {
+    NodePtr<Node> node = ReadAnyNode();
+    if (node.borrow() != nullptr
+        && !NodeKinds<T>::Contains(node.borrow()->GetNodeKind())) {
+      m_Failed = true;
+      return nullptr;
+    }
+    return std::move(node).cast_unsafe<T>();
+  }
+
+  template <typename T> sona::array_ref<NodePtr<T>> ReadNodeList() {
+    std::vector<NodePtr<T>> nodes;
+    std::uint32_t count = ReadCount();
+    for (std::uint32_t i = 0; i < count && !m_Failed; i++) {
+      nodes.push_back(ReadNode<T>());
+    }
+    return m_Arena.CopyArray(std::move(nodes));
+  }
+
+  NodePtr<Node> ReadAnyNode();
+
+  /// One for every kind of Nodes.def, each reading what the writer of the
+  /// kind wrote
+#define CST_TRANSUNIT(name) NodePtr<Node> Read##name();
+#define CST_MISC(name) NodePtr<Node> Read##name();
+#define CST_TYPE(name) NodePtr<Node> Read##name();
+#define CST_DECL(name) NodePtr<Node> Read##name();
+#define CST_STMT(name) NodePtr<Node> Read##name();
+#define CST_EXPR(name) NodePtr<Node> Read##name();
+#include "Syntax/Nodes.def"
+
+  NodePtr<Node> Fail() noexcept {
+    m_Failed = true;
+    return nullptr;
+  }
+
+  char const *m_Cur, *m_End;
+  SyntaxArena &m_Arena;
+  SourceLocation m_FileStart;
+  /// Where the range read last began, what the next one is relative to
+  std::uint32_t m_PrevBegin = 0;
+  std::vector<sona::strhdl_t> m_Strings;
+  bool m_Failed = false;
+};
+
+NodePtr<Node> CSTReader::ReadAnyNode() {
+  std::uint8_t rawKind = ReadRaw<std::uint8_t>();
+  if (m_Failed || rawKind == NoNode) {
+    return nullptr;
+  }
+  if (rawKind >= NumNodeKinds) {
+    m_Failed = true;
+    return nullptr;
+  }
+
+  switch (static_cast<Node::NodeKind>(rawKind)) {
+#define CST_KIND(name) \
+  case Node::CNK_##name: \
+    return Read##name();
+#define CST_TRANSUNIT(name) CST_KIND(name)
+#define CST_MISC(name) CST_KIND(name)
+#define CST_TYPE(name) CST_KIND(name)
+#define CST_DECL(name) CST_KIND(name)
+#define CST_STMT(name) CST_KIND(name)
+#define CST_EXPR(name) CST_KIND(name)
+#include "Syntax/Nodes.def"
+#undef CST_KIND
+  }
+  return nullptr;
+}
+
+NodePtr<Node> CSTReader::ReadAttributeList() {
+  std::vector<AttributeList::Attribute> attributes;
+  std::uint32_t numAttributes = ReadCount();
+  for (std::uint32_t i = 0; i < numAttributes && !m_Failed; i++) {
+    sona::strhdl_t name = ReadStr();
+    if (!ReadBool()) {
+      SourceRange nameRange = ReadRange();
+      SourceRange valueRange = ReadRange();
+      attributes.emplace_back(name, nameRange, valueRange);
+      continue;
+    }
+    sona::strhdl_t value = ReadStr();
+    SourceRange nameRange = ReadRange();
+    SourceRange valueRange = ReadRange();
+    attributes.emplace_back(name, value, nameRange, valueRange);
+  }
+  return m_Arena.New<AttributeList>(m_Arena.CopyArray(std::move(attributes)));
+}
+
+NodePtr<Node> CSTReader::ReadImport() {
+  Identifier id = ReadId();
+  SourceRange importRange = ReadRange();
+  if (!ReadBool()) {
+    return m_Arena.New<Import>(std::move(id), importRange);
+  }
+  SourceRange weakRange = ReadRange();
+  return m_Arena.New<Import>(std::move(id), importRange,
+                             std::true_type(), weakRange);
+}
+
+NodePtr<Node> CSTReader::ReadExport() {
+  NodePtr<Decl> decl = ReadNode<Decl>();
+  SourceRange exportRange = ReadRange();
+  return m_Arena.New<Export>(std::move(decl), exportRange);
+}
+
+NodePtr<Node> CSTReader::ReadBuiltinType() {
+  auto btid = static_cast<BuiltinType::BuiltinTypeId>(
+                ReadVar());
+  SourceRange range = ReadRange();
+  return m_Arena.New<BuiltinType>(btid, range);
+}
+
+NodePtr<Node> CSTReader::ReadUserDefinedType() {
+  Identifier name = ReadId();
+  SourceRange range = ReadRange();
+  return m_Arena.New<UserDefinedType>(std::move(name), range);
+}
+
+NodePtr<Node> CSTReader::ReadTemplatedType() {
+  NodePtr<UserDefinedType> rootType = ReadNode<UserDefinedType>();
+  std::vector<TemplatedType::TemplateArg> args;
+  std::uint32_t numArgs = ReadCount();
+  for (std::uint32_t i = 0; i < numArgs && !m_Failed; i++) {
+    if (ReadBool()) {
+      args.emplace_back(ReadNode<Type>());
+    }
+    else {
+      args.emplace_back(ReadNode<Expr>());
+    }
+  }
+  return m_Arena.New<TemplatedType>(std::move(rootType),
+                                    m_Arena.CopyArray(std::move(args)));
+}
+
+NodePtr<Node> CSTReader::ReadComposedType() {
+  NodePtr<Type> rootType = ReadNode<Type>();
+  std::vector<ComposedType::TypeSpecifier> specs;
+  std::uint32_t numSpecs = ReadCount();
+  for (std::uint32_t i = 0; i < numSpecs; i++) {
+    specs.push_back(static_cast<ComposedType::TypeSpecifier>(
+                      ReadRaw<std::uint8_t>()));
+  }
+  std::vector<SourceRange> ranges;
+  std::uint32_t numRanges = ReadCount();
+  for (std::uint32_t i = 0; i < numRanges; i++) {
+    ranges.push_back(ReadRange());
+  }
+  return m_Arena.New<ComposedType>(std::move(rootType),
+                                   m_Arena.CopyArray(std::move(specs)),
+                                   m_Arena.CopyArray(std::move(ranges)));
+}
+
+NodePtr<Node> CSTReader::ReadTemplatedDecl() {
+  std::vector<TemplatedDecl::TemplateParam> params;
+  std::uint32_t numParams = ReadCount();
+  for (std::uint32_t i = 0; i < numParams && !m_Failed; i++) {
+    if (ReadBool()) {
+      params.emplace_back(ReadStr());
+    }
+    else {
+      params.emplace_back(ReadNode<Expr>());
+    }
+  }
+  NodePtr<Decl> underlyingDecl = ReadNode<Decl>();
+  SourceRange templateRange = ReadRange();
+  return m_Arena.New<TemplatedDecl>(m_Arena.CopyArray(std::move(params)),
+                                    std::move(underlyingDecl),
+                                    templateRange);
+}
+
+NodePtr<Node> CSTReader::ReadForwardDecl() {
+  auto fdk = static_cast<ForwardDecl::ForwardDeclKind>(
+               ReadRaw<std::uint8_t>());
+  sona::strhdl_t name = ReadStr();
+  SourceRange keywordRange = ReadRange();
+  SourceRange nameRange = ReadRange();
+  return m_Arena.New<ForwardDecl>(fdk, name, keywordRange, nameRange);
+}
+
+NodePtr<Node> CSTReader::ReadClassDecl() {
+  sona::strhdl_t name = ReadStr();
+  sona::array_ref<NodePtr<Decl>> subDecls = ReadNodeList<Decl>();
+  SourceRange keywordRange = ReadRange();
+  SourceRange nameRange = ReadRange();
+  return m_Arena.New<ClassDecl>(name, subDecls, keywordRange, nameRange);
+}
+
+NodePtr<Node> CSTReader::ReadEnumDecl() {
+  sona::strhdl_t name = ReadStr();
+  std::vector<EnumDecl::Enumerator> enumerators;
+  std::uint32_t numEnumerators = ReadCount();
+  for (std::uint32_t i = 0; i < numEnumerators && !m_Failed; i++) {
+    sona::strhdl_t enumeratorName = ReadStr();
+    SourceRange enumeratorRange = ReadRange();
+    if (!ReadBool()) {
+      enumerators.emplace_back(enumeratorName, enumeratorRange);
+      continue;
+    }
+    std::int64_t value = ReadRaw<std::int64_t>();
+    SourceRange eqRange = ReadRange();
+    SourceRange valueRange = ReadRange();
+    enumerators.emplace_back(enumeratorName, value, enumeratorRange,
+                             eqRange, valueRange);
+  }
+  SourceRange enumRange = ReadRange();
+  SourceRange nameRange = ReadRange();
+  return m_Arena.New<EnumDecl>(name,
+                               m_Arena.CopyArray(std::move(enumerators)),
+                               enumRange, nameRange);
+}
+
+NodePtr<Node> CSTReader::ReadADTDecl() {
+  sona::strhdl_t name = ReadStr();
+  std::vector<ADTDecl::ValueConstructor> constructors;
+  std::uint32_t numConstructors = ReadCount();
+  for (std::uint32_t i = 0; i < numConstructors && !m_Failed; i++) {
+    sona::strhdl_t constructorName = ReadStr();
+    NodePtr<Type> underlyingType = ReadNode<Type>();
+    SourceRange constructorRange = ReadRange();
+    constructors.emplace_back(constructorName, std::move(underlyingType),
+                              constructorRange);
+  }
+  SourceRange enumRange = ReadRange();
+  SourceRange classRange = ReadRange();
+  SourceRange nameRange = ReadRange();
+  return m_Arena.New<ADTDecl>(name,
+                              m_Arena.CopyArray(std::move(constructors)),
+                              enumRange, classRange, nameRange);
+}
+
+NodePtr<Node> CSTReader::ReadUsingDecl() {
+  sona::strhdl_t name = ReadStr();
+  NodePtr<Type> aliasee = ReadNode<Type>();
+  SourceRange usingRange = ReadRange();
+  SourceRange nameRange = ReadRange();
+  SourceRange eqRange = ReadRange();
+  return m_Arena.New<UsingDecl>(name, std::move(aliasee),
+                                usingRange, nameRange, eqRange);
+}
+
+NodePtr<Node> CSTReader::ReadFuncDecl() {
+  sona::strhdl_t name = ReadStr();
+  sona::array_ref<NodePtr<Type>> paramTypes = ReadNodeList<Type>();
+  std::vector<sona::strhdl_t> paramNames;
+  std::uint32_t numParamNames = ReadCount();
+  for (std::uint32_t i = 0; i < numParamNames; i++) {
+    paramNames.push_back(ReadStr());
+  }
+  NodePtr<Type> retType = ReadNode<Type>();
+
+  std::uint8_t bodyState = ReadRaw<std::uint8_t>();
+  NodePtr<Stmt> body = nullptr;
+  std::uint32_t skippedBegin = 0, skippedEnd = 0;
+  if (bodyState == FBS_Parsed) {
+    body = ReadNode<Stmt>();
+  }
+  else if (bodyState == FBS_Skipped) {
+    skippedBegin = ReadVar();
+    skippedEnd = ReadVar();
+    m_Failed = m_Failed || skippedBegin + 1 >= skippedEnd;
+  }
+  else if (bodyState != FBS_None) {
+    m_Failed = true;
+  }
+  SourceRange funcRange = ReadRange();
+  SourceRange nameRange = ReadRange();
+  if (m_Failed) {
+    return nullptr;
+  }
+
+  sona::optional<NodePtr<Stmt>> funcBody =
+      bodyState == FBS_Parsed
+        ? sona::optional<NodePtr<Stmt>>(std::move(body))
+        : sona::optional<NodePtr<Stmt>>(sona::empty_optional());
+  NodePtr<FuncDecl> ret = m_Arena.New<FuncDecl>(
+      name, paramTypes, m_Arena.CopyArray(std::move(paramNames)),
+      std::move(retType), std::move(funcBody), funcRange, nameRange);
+  if (bodyState == FBS_Skipped) {
+    ret.borrow()->SetSkippedBody(skippedBegin, skippedEnd - 1);
+  }
+  return ret;
+}
+
+NodePtr<Node> CSTReader::ReadVarDecl() {
+  sona::strhdl_t name = ReadStr();
+  NodePtr<Type> type = ReadNode<Type>();
+  SourceRange defRange = ReadRange();
+  SourceRange nameRange = ReadRange();
+  return m_Arena.New<VarDecl>(name, std::move(type), defRange, nameRange);
+}
+
+NodePtr<Node> CSTReader::ReadEmptyStmt() {
+  SourceRange semiRange = ReadRange();
+  return m_Arena.New<EmptyStmt>(semiRange);
+}
+
+NodePtr<Node> CSTReader::ReadExprStmt() {
+  NodePtr<Expr> expr = ReadNode<Expr>();
+  return m_Arena.New<ExprStmt>(std::move(expr));
+}
+
+NodePtr<Node> CSTReader::ReadCompoundStmt() {
+  sona::array_ref<NodePtr<Stmt>> stmts = ReadNodeList<Stmt>();
+  SourceRange lbraceRange = ReadRange();
+  SourceRange rbraceRange = ReadRange();
+  return m_Arena.New<CompoundStmt>(stmts, lbraceRange, rbraceRange);
+}
+
+NodePtr<Node> CSTReader::ReadReturnStmt() {
+  NodePtr<Expr> returnValue = ReadNode<Expr>();
+  SourceRange returnRange = ReadRange();
+  return m_Arena.New<ReturnStmt>(std::move(returnValue), returnRange);
+}
+
+NodePtr<Node> CSTReader::ReadIntLiteralExpr() {
+  std::int64_t value = ReadRaw<std::int64_t>();
+  SourceRange range = ReadRange();
+  return m_Arena.New<IntLiteralExpr>(value, range);
+}
+
+NodePtr<Node> CSTReader::ReadUIntLiteralExpr() {
+  std::uint64_t value = ReadRaw<std::uint64_t>();
+  SourceRange range = ReadRange();
+  return m_Arena.New<UIntLiteralExpr>(value, range);
+}
+
+NodePtr<Node> CSTReader::ReadCharLiteralExpr() {
+  char value = ReadRaw<char>();
+  SourceRange range = ReadRange();
+  return m_Arena.New<CharLiteralExpr>(value, range);
+}
+
+NodePtr<Node> CSTReader::ReadStringLiteralExpr() {
+  sona::strhdl_t value = ReadStr();
+  SourceRange range = ReadRange();
+  return m_Arena.New<StringLiteralExpr>(value, range);
+}
+
+NodePtr<Node> CSTReader::ReadBoolLiteralExpr() {
+  bool value = ReadBool();
+  SourceRange range = ReadRange();
+  return m_Arena.New<BoolLiteralExpr>(value, range);
+}
+
+NodePtr<Node> CSTReader::ReadFloatLiteralExpr() {
+  double value = ReadRaw<double>();
+  SourceRange range = ReadRange();
+  return m_Arena.New<FloatLiteralExpr>(value, range);
+}
+
+NodePtr<Node> CSTReader::ReadNullLiteralExpr() {
+  SourceRange range = ReadRange();
+  return m_Arena.New<NullLiteralExpr>(range);
+}
+
+NodePtr<Node> CSTReader::ReadIdRefExpr() {
+  Identifier id = ReadId();
+  return m_Arena.New<IdRefExpr>(std::move(id));
+}
+
+NodePtr<Node> CSTReader::ReadArraySubscriptExpr() {
+  NodePtr<Expr> array = ReadNode<Expr>();
+  NodePtr<Expr> index = ReadNode<Expr>();
+  return m_Arena.New<ArraySubscriptExpr>(std::move(array),
+                                         std::move(index));
+}
+
+NodePtr<Node> CSTReader::ReadFuncCallExpr() {
+  NodePtr<Expr> callee = ReadNode<Expr>();
+  sona::array_ref<NodePtr<Expr>> args = ReadNodeList<Expr>();
+  return m_Arena.New<FuncCallExpr>(std::move(callee), args);
+}
+
+NodePtr<Node> CSTReader::ReadMemberAccessExpr() {
+  NodePtr<Expr> base = ReadNode<Expr>();
+  Identifier member = ReadId();
+  return m_Arena.New<MemberAccessExpr>(std::move(base), std::move(member));
+}
+
+NodePtr<Node> CSTReader::ReadCastExpr() {
+  auto op = static_cast<CastOperator>(ReadVar());
+  NodePtr<Expr> castedExpr = ReadNode<Expr>();
+  NodePtr<Type> destType = ReadNode<Type>();
+  SourceRange opRange = ReadRange();
+  return m_Arena.New<CastExpr>(op, std::move(castedExpr),
+                               std::move(destType), opRange);
+}
+
+NodePtr<Node> CSTReader::ReadUnaryAlgebraicExpr() {
+  auto op = static_cast<UnaryOperator>(ReadVar());
+  NodePtr<Expr> base = ReadNode<Expr>();
+  SourceRange opRange = ReadRange();
+  return m_Arena.New<UnaryAlgebraicExpr>(op, std::move(base), opRange);
+}
+
+NodePtr<Node> CSTReader::ReadSizeOfExpr() {
+  NodePtr<Expr> containedExpr = ReadNode<Expr>();
+  SourceRange range = ReadRange();
+  return m_Arena.New<SizeOfExpr>(std::move(containedExpr), range);
+}
+
+NodePtr<Node> CSTReader::ReadAlignOfExpr() {
+  NodePtr<Expr> containedExpr = ReadNode<Expr>();
+  SourceRange range = ReadRange();
+  return m_Arena.New<AlignOfExpr>(std::move(containedExpr), range);
+}
+
+NodePtr<Node> CSTReader::ReadBinaryExpr() {
+  auto op = static_cast<BinaryOperator>(ReadVar());
+  NodePtr<Expr> lhs = ReadNode<Expr>();
+  NodePtr<Expr> rhs = ReadNode<Expr>();
+  SourceRange opRange = ReadRange();
+  return m_Arena.New<BinaryExpr>(op, std::move(lhs), std::move(rhs),
+                                 opRange);
+}
+
+NodePtr<Node> CSTReader::ReadAssignExpr() {
+  auto op = static_cast<AssignOperator>(ReadVar());
+  NodePtr<Expr> lhs = ReadNode<Expr>();
+  NodePtr<Expr> rhs = ReadNode<Expr>();
+  SourceRange opRange = ReadRange();
+  return m_Arena.New<AssignExpr>(op, std::move(lhs), std::move(rhs),
+                                 opRange);
+}
+/// Kinds the writer never produces
+NodePtr<Node> CSTReader::ReadTransUnit() { return Fail(); }
+NodePtr<Node> CSTReader::ReadIfStmt() { return Fail(); }
+NodePtr<Node> CSTReader::ReadMatchStmt() { return Fail(); }
+NodePtr<Node> CSTReader::ReadForStmt() { return Fail(); }
+NodePtr<Node> CSTReader::ReadForEachStmt() { return Fail(); }
+NodePtr<Node> CSTReader::ReadWhileStmt() { return Fail(); }
+NodePtr<Node> CSTReader::ReadMixFixExpr() { return Fail(); }
+
+} // namespace
+
+void SerializeTransUnit(TransUnit const& unit, SourceLocation fileStart,
+                        std::string &out) {
+  std::string nodes;
+  CSTWriter writer(nodes, fileStart);
+  writer.WriteUnit(unit);
+
+  std::string body;
+  CSTWriter(body).WriteStringTable(writer.GetStrings());
+  body += nodes;
+
+  std::uint32_t numStrings =
+      static_cast<std::uint32_t>(writer.GetStrings().size());
+  std::uint64_t bodyHash = sona::hash_bytes(body.data(), body.size());
+  out.reserve(out.size() + HeaderSize + body.size());
+  out.append(ImageMagic, sizeof(ImageMagic));
+  out.append(reinterpret_cast<char const*>(&CSTFormatVersion),
+             sizeof(CSTFormatVersion));
+  out.append(reinterpret_cast<char const*>(&numStrings), sizeof(numStrings));
+  out.append(reinterpret_cast<char const*>(&bodyHash), sizeof(bodyHash));
+  out += body;
+}
+
+sona::owner<TransUnit> DeserializeTransUnit(char const* data,
+                                            std::size_t size,
+                                            SourceLocation fileStart) {
+  if (size < HeaderSize
+      || std::memcmp(data, ImageMagic, sizeof(ImageMagic)) != 0) {
+    return nullptr;
+  }
+  std::uint32_t formatVersion, numStrings;
+  std::uint64_t bodyHash;
+  char const *header = data + sizeof(ImageMagic);
+  std::memcpy(&formatVersion, header, 4);
+  std::memcpy(&numStrings, header + 4, 4);
+  std::memcpy(&bodyHash, header + 8, 8);
+  char const *body = data + HeaderSize;
+  std::size_t bodySize = size - HeaderSize;
+  if (formatVersion != CSTFormatVersion
+      || sona::hash_bytes(body, bodySize) != bodyHash) {
+    return nullptr;
+  }
+
+  sona::owner<TransUnit> ret = new TransUnit;
+  CSTReader reader(body, body + bodySize, ret.borrow()->GetArena(),
+                   fileStart);
+  if (!reader.ReadStringTable(numStrings)) {
+    return nullptr;
+  }
+  reader.ReadUnit(ret.borrow().get());
+  if (reader.Failed() || !reader.AtEnd()) {
+    return nullptr;
+  }
+  return ret;
+}
+
+} // namespace Syntax
+} // namespace ckx
@@ -0,0 +1,32 @@
+#include "sona/arena.h"
+
+#include <cstdint>
+
+namespace sona {
+
+arena::~arena() {
+  for (char *block : blocks) {
+    delete[] block;
+  }
+}
+
+void* arena::allocate_slow(std::size_t size, std::size_t align) {
+  /// Large requests get a block of their own and leave the current one
+  /// alone, small ones start a fresh block
+  std::size_t needed = size + align - 1;
+  if (needed > block_size / 4) {
+    char *block = new char[needed];
+    blocks.push_back(block);
+    reserved += needed;
+    std::uintptr_t addr = reinterpret_cast<std::uintptr_t>(block);
+    return block + (align - addr % align) % align;
+  }
+
+  cur = new char[block_size];
+  end = cur + block_size;
+  blocks.push_back(cur);
+  reserved += block_size;
+  return allocate(size, align);
+}
+
+} // namespace sona
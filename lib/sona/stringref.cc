@@ -1,7 +1,209 @@
 #include "sona/stringref.h"
+#include "sona/util.h"
 
-std::unordered_map<std::string, int>&
-sona::impl_stc89c52::glob_container() noexcept {
-  static thread_local std::unordered_map<std::string, int> glob_container;
-  return glob_container;
+#include <cstring>
+#include <limits>
+
+namespace sona {
+namespace impl_stc89c52 {
+
+namespace {
+
+constexpr std::size_t initial_slots = 64;
+constexpr std::uint32_t empty_slot = 0;
+
+/// Recently interned strings of this thread, direct mapped by hash. A hit
+/// is confirmed against the pool, which needs no lock.
+constexpr std::size_t cache_size = 1024;
+
+struct cache_line {
+  std::uint64_t hash;
+  std::uint32_t id;
+};
+
+thread_local cache_line thread_cache[cache_size];
+
+constexpr std::uint64_t wy_secret0 = 0xA0761D6478BD642FULL;
+constexpr std::uint64_t wy_secret1 = 0xE7037ED1A0B428DBULL;
+
+void wy_mum(std::uint64_t &a, std::uint64_t &b) noexcept {
+#ifdef __SIZEOF_INT128__
+  unsigned __int128 product = static_cast<unsigned __int128>(a) * b;
+  a = static_cast<std::uint64_t>(product);
+  b = static_cast<std::uint64_t>(product >> 64);
+#else
+  std::uint64_t aLo = a & 0xFFFFFFFFu, aHi = a >> 32;
+  std::uint64_t bLo = b & 0xFFFFFFFFu, bHi = b >> 32;
+  std::uint64_t p0 = aLo * bLo, p1 = aLo * bHi, p2 = aHi * bLo;
+  std::uint64_t mid = (p0 >> 32) + (p1 & 0xFFFFFFFFu) + (p2 & 0xFFFFFFFFu);
+  std::uint64_t low = (mid << 32) | (p0 & 0xFFFFFFFFu);
+  b = aHi * bHi + (p1 >> 32) + (p2 >> 32) + (mid >> 32);
+  a = low;
+#endif
+}
+
+std::uint64_t wy_mix(std::uint64_t a, std::uint64_t b) noexcept {
+  wy_mum(a, b);
+  return a ^ b;
+}
+
+std::uint64_t read8(char const* p) noexcept {
+  std::uint64_t v;
+  std::memcpy(&v, p, sizeof(v));
+  return v;
+}
+
+std::uint64_t read4(char const* p) noexcept {
+  std::uint32_t v;
+  std::memcpy(&v, p, sizeof(v));
+  return v;
+}
+
+std::uint64_t read3(char const* p, std::size_t len) noexcept {
+  return (static_cast<std::uint64_t>(static_cast<unsigned char>(p[0])) << 16)
+         | (static_cast<std::uint64_t>(
+              static_cast<unsigned char>(p[len >> 1])) << 8)
+         | static_cast<unsigned char>(p[len - 1]);
+}
+
+} // namespace
+
+std::uint64_t hash_bytes(char const* str, std::size_t len) noexcept {
+  std::uint64_t seed = wy_mix(wy_secret0, wy_secret1);
+  std::uint64_t a, b;
+  if (len <= 16) {
+    if (len >= 4) {
+      std::size_t mid = (len >> 3) << 2;
+      a = (read4(str) << 32) | read4(str + mid);
+      b = (read4(str + len - 4) << 32) | read4(str + len - 4 - mid);
+    }
+    else if (len > 0) {
+      a = read3(str, len);
+      b = 0;
+    }
+    else {
+      a = b = 0;
+    }
+  }
+  else {
+    std::size_t rest = len;
+    char const* p = str;
+    while (rest > 16) {
+      seed = wy_mix(read8(p) ^ wy_secret1, read8(p + 8) ^ seed);
+      p += 16;
+      rest -= 16;
+    }
+    a = read8(p + rest - 16);
+    b = read8(p + rest - 8);
+  }
+  a ^= wy_secret1;
+  b ^= seed;
+  wy_mum(a, b);
+  return wy_mix(a ^ wy_secret0 ^ len, b ^ wy_secret1);
 }
+
+string_pool::string_pool() : next_id(0) {
+  for (shard &sh : shards) {
+    sh.slots.assign(initial_slots, empty_slot);
+  }
+  for (std::atomic<entry*> &chunk : chunks) {
+    chunk.store(nullptr, std::memory_order_relaxed);
+  }
+}
+
+string_pool::~string_pool() {
+  for (std::atomic<entry*> &chunk : chunks) {
+    delete[] chunk.load(std::memory_order_relaxed);
+  }
+}
+
+std::uint32_t string_pool::intern(string_view str) {
+  std::uint64_t h = hash_bytes(str.data(), str.size());
+  cache_line &line = thread_cache[h & (cache_size - 1)];
+  if (line.id != empty_slot && line.hash == h
+      && lookup(line.id - 1) == str) {
+    return line.id - 1;
+  }
+
+  shard &sh = shards[(h >> 32) % num_shards];
+  std::uint32_t id;
+  {
+    std::lock_guard<std::mutex> guard(sh.lock);
+    id = insert(sh, str, h);
+  }
+  line.hash = h;
+  line.id = id + 1;
+  return id;
+}
+
+std::uint32_t
+string_pool::insert(shard &sh, string_view str, std::uint64_t hash) {
+  std::size_t mask = sh.slots.size() - 1;
+  std::size_t idx = static_cast<std::size_t>(hash) & mask;
+  for (;; idx = (idx + 1) & mask) {
+    std::uint32_t slot = sh.slots[idx];
+    if (slot == empty_slot) {
+      break;
+    }
+    entry const& e = get_entry(slot - 1);
+    if (e.hash == hash && e.str == str) {
+      return slot - 1;
+    }
+  }
+
+  std::uint32_t id = next_id.fetch_add(1, std::memory_order_relaxed);
+  sona_assert(id < std::numeric_limits<std::uint32_t>::max());
+  char *text_copy = static_cast<char*>(sh.text.allocate(str.size() + 1, 1));
+  std::memcpy(text_copy, str.data(), str.size());
+  text_copy[str.size()] = '\0';
+
+  entry &e = new_entry(id);
+  e.str = string_view(text_copy, str.size());
+  e.hash = hash;
+  sh.slots[idx] = id + 1;
+  /// Keep the load factor below 1/2
+  if (++sh.count * 2 > sh.slots.size()) {
+    grow(sh);
+  }
+  return id;
+}
+
+string_pool::entry& string_pool::new_entry(std::uint32_t id) {
+  std::size_t index;
+  unsigned chunk = chunk_of(id, index);
+  entry *entries = chunks[chunk].load(std::memory_order_acquire);
+  if (entries == nullptr) {
+    std::lock_guard<std::mutex> guard(chunk_lock);
+    entries = chunks[chunk].load(std::memory_order_relaxed);
+    if (entries == nullptr) {
+      entries = new entry[std::size_t(1) << (chunk + first_chunk_bits)];
+      chunks[chunk].store(entries, std::memory_order_release);
+    }
+  }
+  return entries[index];
+}
+
+void string_pool::grow(shard &sh) {
+  std::vector<std::uint32_t> new_slots(sh.slots.size() * 2, empty_slot);
+  std::size_t mask = new_slots.size() - 1;
+  for (std::uint32_t slot : sh.slots) {
+    if (slot == empty_slot) {
+      continue;
+    }
+    std::size_t idx = static_cast<std::size_t>(get_entry(slot - 1).hash)
+                      & mask;
+    while (new_slots[idx] != empty_slot) {
+      idx = (idx + 1) & mask;
+    }
+    new_slots[idx] = slot;
+  }
+  sh.slots.swap(new_slots);
+}
+
+string_pool& glob_pool() noexcept {
+  static string_pool pool;
+  return pool;
+}
+
+} // namespace impl_stc89c52
+} // namespace sona
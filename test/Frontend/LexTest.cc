@@ -1,13 +1,26 @@
 #include "VKTestCXX.h"
+#include "Basic/SourceManager.h"
 #include "Frontend/Lex.h"
+#include "Frontend/LexNumber.h"
+#include "Frontend/LexScan.h"
 
 #include "sona/log.h"
+#include <cstdlib>
+#include <cstring>
 #include <string>
 
 using namespace sona;
 using namespace ckx;
 using namespace std;
 
+/// The range [begin, end) of a source lexed on its own
+static SourceRange RangeAt(uint32_t begin, uint32_t end) {
+  SourceLocation fileStart =
+      SourceLocation::FromRawEncoding(SourceManager::FirstFileStart);
+  return SourceRange(fileStart.GetLocWithOffset(begin),
+                     fileStart.GetLocWithOffset(end));
+}
+
 void test0() {
   VkTestSectionStart("Simple lexing test");
 
@@ -17,7 +30,7 @@ void test0() {
   Diag::DiagnosticEngine diag("a.c", lines);
   Frontend::Lexer lexer(move(file), diag);
 
-  vector<Frontend::Token> tokens = lexer.GetAndReset();
+  Frontend::TokenBuffer tokens = lexer.GetAndReset();
 
   VkAssertFalse(diag.HasPendingDiags());
   VkAssertEquals(8uL, tokens.size());
@@ -42,7 +55,7 @@ void test1() {
   Diag::DiagnosticEngine diag("a.c", lines);
   Frontend::Lexer lexer(move(file), diag);
 
-  vector<Frontend::Token> tokens = lexer.GetAndReset();
+  Frontend::TokenBuffer tokens = lexer.GetAndReset();
 
   VkAssertFalse(diag.HasPendingDiags());
   diag.EmitDiags();
@@ -70,7 +83,7 @@ void test2() {
 
   diag.EmitDiags();
 
-  vector<Frontend::Token> tokens = lexer.GetAndReset();
+  Frontend::TokenBuffer tokens = lexer.GetAndReset();
 
   VkAssertFalse(diag.HasPendingDiags());
   diag.EmitDiags();
@@ -98,7 +111,7 @@ void test3() {
 
   diag.EmitDiags();
 
-  vector<Frontend::Token> tokens = lexer.GetAndReset();
+  Frontend::TokenBuffer tokens = lexer.GetAndReset();
 
   VkAssertFalse(diag.HasPendingDiags());
 
@@ -126,7 +139,7 @@ void test4() {
 
   diag.EmitDiags();
 
-  vector<Frontend::Token> tokens = lexer.GetAndReset();
+  Frontend::TokenBuffer tokens = lexer.GetAndReset();
 
   VkAssertFalse(diag.HasPendingDiags());
 
@@ -141,6 +154,599 @@ void test4() {
   }
 }
 
+void test5() {
+  VkTestSectionStart("Lexing buffers larger than 64KiB");
+
+  string file = "";
+  for (size_t i = 0; i < 70000; i++) {
+    file += "def\n";
+  }
+  file += "abc";
+  vector<string> lines = { file };
+  SourceManager sourceManager;
+  sourceManager.AddFile("d.c", SourceBuffer::FromString(string(file)));
+
+  owner<SourceBuffer> buffer = SourceBuffer::FromString(move(file));
+  Diag::DiagnosticEngine diag("d.c", lines);
+  Frontend::Lexer lexer(buffer.borrow(), diag);
+
+  Frontend::TokenBuffer tokens = lexer.GetAndReset();
+
+  VkAssertFalse(diag.HasPendingDiags());
+  VkAssertEquals(70002uL, tokens.size());
+  VkAssertEquals(Frontend::Token::TK_ID, tokens[70000].GetTokenKind());
+  VkAssertEquals(280000u, tokens.GetOffset(70000));
+  VkAssertTrue(tokens[70000].GetSourceRange() == RangeAt(280000, 280003));
+  /// A source lexed on its own is laid out as the first file of a manager
+  PresumedLoc presumed =
+      sourceManager.GetPresumedLoc(tokens[70000].GetSourceRange().GetEnd());
+  VkAssertEquals(70001u, presumed.Line);
+  VkAssertEquals(4u, presumed.Col);
+}
+
+void test6() {
+  VkTestSectionStart("Vectorized scanning kernels agree with scalar ones");
+
+  string text;
+  for (size_t i = 0; i < 300; i++) {
+    text += string(i % 37, ' ') + "\t\n" + string(i % 41, 'a') + "_$Z9"
+            + string(i % 43, '7') + "#+\r\v\f" + char('\x80' + i % 64);
+  }
+  char const *begin = text.data(), *end = text.data() + text.size();
+
+  Frontend::ScanKernel kernels[] = {
+    Frontend::ScanKernel::SK_SSE2, Frontend::ScanKernel::SK_AVX2
+  };
+  Frontend::ScanKernel original = Frontend::GetScanKernel();
+  for (Frontend::ScanKernel kernel : kernels) {
+    if (!Frontend::IsScanKernelSupported(kernel)) {
+      continue;
+    }
+
+    size_t mismatches = 0;
+    for (char const *iter = begin; iter != end; ++iter) {
+      Frontend::SetScanKernel(Frontend::ScanKernel::SK_Scalar);
+      char const *ws = Frontend::ScanWhitespaceRun(iter, end);
+      char const *id = Frontend::ScanIdContinueRun(iter, end);
+      char const *digit = Frontend::ScanDigitRun(iter, end);
+      Frontend::SetScanKernel(kernel);
+      mismatches += (ws != Frontend::ScanWhitespaceRun(iter, end))
+                    + (id != Frontend::ScanIdContinueRun(iter, end))
+                    + (digit != Frontend::ScanDigitRun(iter, end))
+                    + (ws != Frontend::ScanWhitespaceRunInline(iter, end))
+                    + (id != Frontend::ScanIdContinueRunInline(iter, end))
+                    + (digit != Frontend::ScanDigitRunInline(iter, end));
+    }
+    VkAssertEquals(0uL, mismatches);
+  }
+  Frontend::SetScanKernel(original);
+}
+
+void test7() {
+  VkTestSectionStart("Identifiers resembling keywords");
+  string file = "int in defs de uint6 int16! nullptr_ nullptr_t? static_casts "
+                "Class func? g z";
+  vector<string> lines = { file };
+
+  Diag::DiagnosticEngine diag("e.c", lines);
+  Frontend::Lexer lexer(move(file), diag);
+
+  Frontend::TokenBuffer tokens = lexer.GetAndReset();
+
+  VkAssertFalse(diag.HasPendingDiags());
+  VkAssertEquals(14uL, tokens.size());
+  for (size_t i = 0; i < 13; i++) {
+    VkAssertEquals(Frontend::Token::TK_ID, tokens[i].GetTokenKind());
+  }
+  VkAssertEquals("nullptr_t?", tokens[7].GetStrValueUnsafe());
+}
+
+void test8() {
+  VkTestSectionStart("Identifier and string payloads slice the source");
+  SourceManager sourceManager;
+  FileID file = sourceManager.AddFile(
+      "f.c", SourceBuffer::FromString("def abc : \"plain\" \"esc\\tx\";"));
+  sona::ref_ptr<SourceBuffer const> buffer = sourceManager.GetBuffer(file);
+
+  Diag::DiagnosticEngine diag(sourceManager, file);
+  Frontend::Lexer lexer(buffer, diag);
+
+  Frontend::TokenBuffer tokens = lexer.GetAndReset();
+
+  VkAssertFalse(diag.HasPendingDiags());
+  VkAssertEquals(7uL, tokens.size());
+  char const *start = buffer->GetBufferStart();
+  VkAssertEquals(start + 4, tokens[1].GetStrViewUnsafe().data());
+  VkAssertEquals(3uL, tokens[1].GetStrViewUnsafe().size());
+  VkAssertEquals(start + 11, tokens[3].GetStrViewUnsafe().data());
+  VkAssertEquals("plain", tokens[3].GetStrValueUnsafe());
+  VkAssertEquals("esc\tx", tokens[4].GetStrValueUnsafe());
+}
+
+void test9() {
+  VkTestSectionStart("Token buffer round trip");
+  Frontend::TokenBuffer tokens;
+  tokens.EmplaceToken(Frontend::Token::TK_KW_def, RangeAt(0, 3));
+  tokens.EmplaceToken(Frontend::Token::TK_ID, RangeAt(4, 7),
+                      sona::string_view("abc"));
+  tokens.EmplaceToken(Frontend::Token::TK_SYM_SEMI, RangeAt(8, 9));
+  tokens.EmplaceToken(Frontend::Token::TK_LIT_INT, RangeAt(10, 12),
+                      std::int64_t(42));
+  tokens.EmplaceToken(Frontend::Token::TK_LIT_FLOAT, RangeAt(13, 16), 2.5);
+
+  VkAssertEquals(5uL, tokens.size());
+  VkAssertEquals(Frontend::Token::TK_SYM_SEMI, tokens.GetTokenKind(2));
+  VkAssertTrue(tokens.GetSourceRange(2) == RangeAt(8, 9));
+  VkAssertEquals(Frontend::Token::TK_KW_def, tokens[0].GetTokenKind());
+  VkAssertTrue(tokens[0].GetSourceRange() == RangeAt(0, 3));
+  VkAssertEquals("abc", tokens[1].GetStrValueUnsafe());
+  VkAssertEquals(42, tokens[3].GetIntValueUnsafe());
+  VkAssertTrue(tokens[3].GetSourceRange() == RangeAt(10, 12));
+  VkAssertEquals(2.5, tokens[4].GetFloatValueUnsafe());
+  VkAssertEquals(10u, tokens.GetOffset(3));
+  VkAssertEquals(3uL, tokens.LowerBound(9));
+}
+
+void test10() {
+  VkTestSectionStart("Pulling tokens lexes on demand");
+  string file = "def a @ b";
+  vector<string> lines = { file };
+
+  Diag::DiagnosticEngine diag("g.c", lines);
+  Frontend::Lexer lexer(move(file), diag);
+
+  VkAssertEquals(Frontend::Token::TK_KW_def, lexer.NextToken().GetTokenKind());
+  VkAssertEquals("a", lexer.NextToken().GetStrValueUnsafe());
+  VkAssertFalse(diag.HasPendingDiags());
+  VkAssertEquals("b", lexer.NextToken().GetStrValueUnsafe());
+  VkAssertTrue(diag.HasPendingError());
+  VkAssertEquals(Frontend::Token::TK_EOI, lexer.NextToken().GetTokenKind());
+  VkAssertEquals(Frontend::Token::TK_EOI, lexer.NextToken().GetTokenKind());
+}
+
+void test11() {
+  VkTestSectionStart("Integral literal ranges and suffixes");
+  string file = "0x7fffffffffffffff 0b101 0xFFu 18446744073709551615u "
+                "000000000000000000000042 9223372036854775808 "
+                "18446744073709551616u 0x10000000000000000u";
+  vector<string> lines = { file };
+
+  Diag::DiagnosticEngine diag("h.c", lines);
+  Frontend::Lexer lexer(move(file), diag);
+  Frontend::TokenBuffer tokens = lexer.GetAndReset();
+
+  VkAssertEquals(9uL, tokens.size());
+  VkAssertEquals(INT64_MAX, tokens[0].GetIntValueUnsafe());
+  VkAssertEquals(5, tokens[1].GetIntValueUnsafe());
+  VkAssertEquals(Frontend::Token::TK_LIT_UINT, tokens[2].GetTokenKind());
+  VkAssertEquals(255uL, tokens[2].GetUIntValueUnsafe());
+  VkAssertEquals(UINT64_MAX, tokens[3].GetUIntValueUnsafe());
+  VkAssertEquals(42, tokens[4].GetIntValueUnsafe());
+  VkAssertEquals(Frontend::Token::TK_LIT_INT, tokens[5].GetTokenKind());
+  VkAssertEquals(Frontend::Token::TK_LIT_UINT, tokens[6].GetTokenKind());
+  VkAssertEquals(Frontend::Token::TK_LIT_UINT, tokens[7].GetTokenKind());
+  VkAssertTrue(diag.HasPendingError());
+}
+
+void test12() {
+  VkTestSectionStart("Floating literals decode correctly rounded");
+  string file = "0.1 2.2250738585072014e-308 1.7976931348623157e308 "
+                "4.9e-324 1e-400 0.30000000000000004 1.8e308";
+  vector<string> lines = { file };
+
+  Diag::DiagnosticEngine diag("i.c", lines);
+  Frontend::Lexer lexer(move(file), diag);
+  Frontend::TokenBuffer tokens = lexer.GetAndReset();
+
+  VkAssertEquals(8uL, tokens.size());
+  VkAssertEquals(0.1, tokens[0].GetFloatValueUnsafe());
+  VkAssertEquals(2.2250738585072014e-308, tokens[1].GetFloatValueUnsafe());
+  VkAssertEquals(1.7976931348623157e308, tokens[2].GetFloatValueUnsafe());
+  VkAssertEquals(4.9e-324, tokens[3].GetFloatValueUnsafe());
+  VkAssertEquals(0.0, tokens[4].GetFloatValueUnsafe());
+  VkAssertEquals(0.30000000000000004, tokens[5].GetFloatValueUnsafe());
+  VkAssertTrue(diag.HasPendingError());
+
+  std::uint64_t seed = 0x2545F4914F6CDD1DULL;
+  auto next = [&seed] {
+    seed ^= seed << 13;
+    seed ^= seed >> 7;
+    seed ^= seed << 17;
+    return seed;
+  };
+
+  size_t mismatches = 0;
+  for (int i = 0; i < 200000; i++) {
+    string intPart = to_string(next() % 1000000000000ULL);
+    string fracPart = to_string(next());
+    fracPart.resize(next() % (fracPart.size() + 1));
+    std::int64_t exponent = static_cast<std::int64_t>(next() % 660) - 340;
+
+    string text = intPart + "." + fracPart + "e" + to_string(exponent);
+    double expected = std::strtod(text.c_str(), nullptr);
+    double got;
+    Frontend::DecodeFloat(intPart.data(), intPart.data() + intPart.size(),
+                          fracPart.data(), fracPart.data() + fracPart.size(),
+                          exponent, got);
+    mismatches += std::memcmp(&expected, &got, sizeof(double)) != 0;
+  }
+  VkAssertEquals(0uL, mismatches);
+}
+
+void test13() {
+  VkTestSectionStart("Operators lex with maximal munch");
+  string file = "<<= >>>= ::: ^^^ !== &&& ||| +++---";
+  vector<string> lines = { file };
+
+  Diag::DiagnosticEngine diag("j.c", lines);
+  Frontend::Lexer lexer(move(file), diag);
+  Frontend::TokenBuffer tokens = lexer.GetAndReset();
+
+  using T = Frontend::Token;
+  T::TokenKind expected[] = {
+    T::TK_SYM_LTLT, T::TK_SYM_EQ, T::TK_SYM_GTGT, T::TK_SYM_GTEQ,
+    T::TK_SYM_DCOLON, T::TK_SYM_COLON, T::TK_SYM_DTIP, T::TK_SYM_TIP,
+    T::TK_SYM_EXCEQ, T::TK_SYM_EQ, T::TK_SYM_DAMP, T::TK_SYM_AMP,
+    T::TK_SYM_DPIPE, T::TK_SYM_PIPE, T::TK_SYM_DPLUS, T::TK_SYM_PLUS,
+    T::TK_SYM_DMINUS, T::TK_SYM_MINUS, T::TK_EOI
+  };
+
+  VkAssertFalse(diag.HasPendingDiags());
+  VkAssertEquals(sizeof(expected) / sizeof(expected[0]), tokens.size());
+  size_t mismatches = 0;
+  for (size_t i = 0; i < tokens.size(); i++) {
+    mismatches += tokens.GetTokenKind(i) != expected[i];
+  }
+  VkAssertEquals(0uL, mismatches);
+  VkAssertTrue(tokens.GetSourceRange(2) == RangeAt(4, 6));
+}
+
+/// Kinds, offsets, ranges and values all agree
+static bool SameTokens(Frontend::TokenBuffer const& expected,
+                       Frontend::TokenBuffer const& actual) {
+  if (expected.size() != actual.size()) {
+    return false;
+  }
+
+  for (size_t i = 0; i < expected.size(); i++) {
+    Frontend::Token e = expected[i], a = actual[i];
+    SourceRange er = e.GetSourceRange(), ar = a.GetSourceRange();
+    bool same = e.GetTokenKind() == a.GetTokenKind()
+                && expected.GetOffset(i) == actual.GetOffset(i)
+                && er == ar;
+    if (same && (e.GetTokenKind() == Frontend::Token::TK_ID
+                 || e.GetTokenKind() == Frontend::Token::TK_LIT_STR)) {
+      same = e.GetStrViewUnsafe() == a.GetStrViewUnsafe();
+    }
+    else if (same && e.GetTokenKind() == Frontend::Token::TK_LIT_INT) {
+      same = e.GetIntValueUnsafe() == a.GetIntValueUnsafe();
+    }
+    else if (same && e.GetTokenKind() == Frontend::Token::TK_LIT_FLOAT) {
+      same = e.GetFloatValueUnsafe() == a.GetFloatValueUnsafe();
+    }
+    if (!same) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void test14() {
+  VkTestSectionStart("Incremental relexing matches a full pass");
+  string line = "def x : i32 = 0x1F + \"s\\t\" * 1.5e3;\n";
+  string file;
+  for (int i = 0; i < 1000; i++) {
+    file += line;
+  }
+  vector<string> lines;
+
+  Diag::DiagnosticEngine diag("k.c", lines);
+  Frontend::IncrementalLexer lexer(move(file), diag);
+  size_t numTokens = lexer.GetTokens().size();
+  uint32_t middle = 500 * static_cast<uint32_t>(line.size()) + 4;
+  VkAssertTrue(lexer.ApplyEdit(middle, 1, "yz") < 5);
+  VkAssertEquals(numTokens, lexer.GetTokens().size());
+  VkAssertEquals("yz", lexer.GetTokens()[500 * 11 + 1].GetStrValueUnsafe());
+
+  Frontend::IncrementalLexer tiny("x", diag);
+  tiny.ApplyEdit(1, 0, " yy");
+  tiny.ApplyEdit(0, 0, string(40, ' '));
+  VkAssertEquals(3uL, tiny.GetTokens().size());
+  VkAssertEquals("x", tiny.GetTokens()[0].GetStrValueUnsafe());
+  VkAssertEquals("yy", tiny.GetTokens()[1].GetStrValueUnsafe());
+  VkAssertEquals(42u, tiny.GetTokens().GetOffset(1));
+
+  /// A NUL byte ends the input however much text follows it
+  Frontend::IncrementalLexer nul(string("a \0 +\n", 6), diag);
+  nul.ApplyEdit(6, 0, "b\n");
+  Frontend::Lexer nulLexer(nul.GetSource().to_string(), diag);
+  VkAssertTrue(SameTokens(nulLexer.GetAndReset(), nul.GetTokens()));
+  VkAssertEquals(2uL, nul.GetTokens().size());
+
+  char const *fragments[] = {
+    "def ", "x", "1", "e", "+", "5", ".", "\"", "ab", "\n", " ", "\t",
+    "'", "<", "=", ">", ":", "\\", "0x", "u", "9"
+  };
+  size_t numFragments = sizeof(fragments) / sizeof(fragments[0]);
+  std::uint64_t seed = 0x9E3779B97F4A7C15ULL;
+  auto next = [&seed] {
+    seed ^= seed << 13;
+    seed ^= seed >> 7;
+    seed ^= seed << 17;
+    return seed;
+  };
+
+  string start;
+  for (int i = 0; i < 400; i++) {
+    start += fragments[next() % numFragments];
+  }
+  Frontend::IncrementalLexer incLexer(move(start), diag);
+
+  size_t mismatches = 0;
+  for (int i = 0; i < 2000; i++) {
+    size_t sourceSize = incLexer.GetSource().size();
+    uint32_t offset = static_cast<uint32_t>(next() % (sourceSize + 1));
+    uint32_t removed = static_cast<uint32_t>(
+        std::min<uint64_t>(next() % 5, sourceSize - offset));
+    string inserted;
+    for (uint64_t j = next() % 3; j != 0; j--) {
+      inserted += fragments[next() % numFragments];
+    }
+    incLexer.ApplyEdit(offset, removed, inserted);
+
+    Frontend::Lexer fullLexer(incLexer.GetSource().to_string(), diag);
+    Frontend::TokenBuffer expected = fullLexer.GetAndReset();
+    mismatches += !SameTokens(expected, incLexer.GetTokens());
+    diag.ClearDiags();
+  }
+  VkAssertEquals(0uL, mismatches);
+}
+
+void test15() {
+  VkTestSectionStart("Parallel lexing matches the serial lexer");
+  /// Long string literals spanning lines of code-like text, so that some
+  /// chunks start inside one and guess wrong
+  string file;
+  for (int i = 0; file.size() < 3 * 1024 * 1024; i++) {
+    string n = to_string(i);
+    file += "def field_" + n + " : int32 = " + n + " + 0x1F * 2.5e3;\n";
+    if (i % 37 == 0) {
+      file += "def text_" + n + " : string = \"esc\\t\n";
+      for (int j = 0; j < i % 300; j++) {
+        file += "  def inner_" + to_string(j) + " : int64;\n";
+      }
+      file += "\";\n";
+    }
+  }
+  vector<string> lines;
+
+  Diag::DiagnosticEngine serialDiag("l.c", lines);
+  Frontend::Lexer serialLexer(string(file), serialDiag);
+  Frontend::TokenBuffer expected = serialLexer.GetAndReset();
+
+  Diag::DiagnosticEngine diag("l.c", lines);
+  Frontend::Lexer lexer(string(file), diag);
+  Frontend::TokenBuffer tokens = lexer.LexInParallel(8);
+  VkAssertFalse(diag.HasPendingDiags());
+  VkAssertTrue(SameTokens(expected, tokens));
+
+  /// A NUL ends lexing early, chunks behind it must not leak through
+  string truncated = file;
+  truncated[truncated.find("\ndef", truncated.size() / 2) + 1] = '\0';
+  Frontend::Lexer truncatedSerial(string(truncated), serialDiag);
+  Frontend::Lexer truncatedLexer(move(truncated), diag);
+  VkAssertTrue(SameTokens(truncatedSerial.GetAndReset(),
+                          truncatedLexer.LexInParallel(8)));
+
+  /// The chunk lexing the end reports what is there
+  file += "@";
+  Frontend::Lexer faultyLexer(string(file), diag);
+  tokens = faultyLexer.LexInParallel(8);
+  VkAssertEquals(expected.size(), tokens.size());
+  VkAssertTrue(diag.HasPendingError());
+}
+
+void test16() {
+  VkTestSectionStart("Source manager slices lines on demand");
+  string longLine(100, 'x');
+  SourceManager sourceManager;
+  FileID file = sourceManager.AddFile(
+      "m.c", SourceBuffer::FromString("ab\n\n" + longLine + "\r\nlast"));
+
+  VkAssertEquals(4u, sourceManager.GetNumLines(file));
+  VkAssertEquals("ab", sourceManager.GetLine(file, 1).to_string());
+  VkAssertEquals("", sourceManager.GetLine(file, 2).to_string());
+  VkAssertEquals(longLine + "\r", sourceManager.GetLine(file, 3).to_string());
+  VkAssertEquals("last", sourceManager.GetLine(file, 4).to_string());
+
+  string many;
+  for (int i = 0; i < 1000; i++) {
+    many += to_string(i);
+    many += (i % 7 == 0) ? "\n\n" : "\n";
+  }
+  FileID manyFile =
+      sourceManager.AddFile("n.c", SourceBuffer::FromString(move(many)));
+  vector<string> expected;
+  for (int i = 0; i < 1000; i++) {
+    expected.push_back(to_string(i));
+    if (i % 7 == 0) {
+      expected.push_back("");
+    }
+  }
+  expected.push_back("");
+
+  VkAssertEquals(expected.size(), sourceManager.GetNumLines(manyFile));
+  bool allMatch = true;
+  for (size_t i = 0; i < expected.size(); i++) {
+    allMatch = allMatch
+               && sourceManager.GetLine(manyFile, static_cast<uint32_t>(i + 1))
+                    .to_string() == expected[i];
+  }
+  VkAssertTrue(allMatch);
+
+  FileID emptyFile =
+      sourceManager.AddFile("o.c", SourceBuffer::FromString(""));
+  VkAssertEquals(1u, sourceManager.GetNumLines(emptyFile));
+  VkAssertTrue(sourceManager.GetLine(emptyFile, 1).empty());
+}
+
+void test17() {
+  VkTestSectionStart("Token locations decode to their line and column");
+  SourceManager sourceManager;
+  FileID file0 = sourceManager.AddFile(
+      "p.c", SourceBuffer::FromString("def a : int8;\n\tdef b\t: int16;\n"));
+  FileID file1 = sourceManager.AddFile(
+      "q.c", SourceBuffer::FromString("\n\n  using c = a ;"));
+
+  VkAssertTrue(file0 != file1);
+  VkAssertEquals(sourceManager.GetLocForStartOfFile(file0)
+                   .GetLocWithOffset(31).GetRawEncoding(),
+                 sourceManager.GetLocForStartOfFile(file1).GetRawEncoding());
+
+  bool allDecoded = true;
+  for (FileID file : { file0, file1 }) {
+    vector<string> lines;
+    Diag::DiagnosticEngine diag(sourceManager, file);
+    Frontend::Lexer lexer(sourceManager, file, diag);
+    Frontend::TokenBuffer tokens = lexer.GetAndReset();
+    for (size_t i = 0; i < tokens.size(); i++) {
+      SourceLocation loc = tokens.GetSourceRange(i).GetBegin();
+      PresumedLoc presumed = sourceManager.GetPresumedLoc(loc);
+      allDecoded = allDecoded
+                   && sourceManager.GetFileID(loc) == file
+                   && sourceManager.GetFileOffset(loc) == tokens.GetOffset(i)
+                   && presumed.FileName == &sourceManager.GetFileName(file);
+    }
+  }
+  VkAssertTrue(allDecoded);
+
+  PresumedLoc tabbed = sourceManager.GetPresumedLoc(
+      sourceManager.GetLocForStartOfFile(file0).GetLocWithOffset(19));
+  VkAssertEquals(2u, tabbed.Line);
+  VkAssertEquals(13u, tabbed.Col);
+  VkAssertTrue(sourceManager.GetFileID(SourceLocation()).IsInvalid());
+
+  /// Literals running over a line break cover all of their text
+  string file = "def a : int8;\n\"two\nlines\" 'x";
+  vector<string> lines = { "def a : int8;", "\"two", "lines\" 'x" };
+  Diag::DiagnosticEngine diag("r.c", lines);
+  Frontend::Lexer lexer(move(file), diag);
+  Frontend::TokenBuffer tokens = lexer.GetAndReset();
+  VkAssertTrue(tokens.GetSourceRange(0) == RangeAt(0, 3));
+  VkAssertTrue(tokens.GetSourceRange(5) == RangeAt(14, 25));
+  VkAssertTrue(tokens.GetSourceRange(6) == RangeAt(26, 28));
+}
+
+void test18() {
+  VkTestSectionStart("Editing a token buffer around its gap");
+  using T = Frontend::Token;
+  string source = "aa bb cc dd ee";
+  Frontend::TokenBuffer tokens;
+  tokens.SetSource(source);
+  for (uint32_t offset = 0; offset < 15; offset += 3) {
+    tokens.EmplaceToken(T::TK_ID, RangeAt(offset, offset + 2),
+                        sona::string_view(source.data() + offset, 2));
+  }
+
+  /// "bb" becomes "bbb", the tokens behind it only get a pending shift
+  string edited = "aa bbb cc dd ee";
+  Frontend::TokenBuffer replacement;
+  replacement.SetSource(edited);
+  replacement.EmplaceToken(T::TK_ID, RangeAt(3, 6),
+                           sona::string_view(edited.data() + 3, 3));
+  tokens.SetSource(edited);
+  tokens.Splice(1, 2, replacement);
+  tokens.ShiftTokens(2, 1);
+  VkAssertEquals(5uL, tokens.size());
+  VkAssertEquals("bbb", tokens[1].GetStrValueUnsafe());
+  VkAssertEquals("dd", tokens[3].GetStrValueUnsafe());
+  VkAssertEquals(10u, tokens.GetOffset(3));
+  VkAssertTrue(tokens.GetSourceRange(4) == RangeAt(13, 15));
+
+  /// An edit in front of the last one moves the gap back
+  string again = "a bbb cc dd ee";
+  replacement.clear();
+  replacement.SetSource(again);
+  replacement.EmplaceToken(T::TK_ID, RangeAt(0, 1),
+                           sona::string_view(again.data(), 1));
+  tokens.SetSource(again);
+  tokens.Splice(0, 1, replacement);
+  tokens.ShiftTokens(1, -1);
+  uint32_t offsets[] = { 0, 2, 6, 9, 12 };
+  char const *texts[] = { "a", "bbb", "cc", "dd", "ee" };
+  bool allMatch = true;
+  for (size_t i = 0; i < 5; i++) {
+    allMatch = allMatch && tokens.GetOffset(i) == offsets[i]
+               && tokens[i].GetStrViewUnsafe() == texts[i]
+               && tokens[i].GetStrViewUnsafe().data()
+                    == again.data() + offsets[i];
+  }
+  VkAssertTrue(allMatch);
+  VkAssertEquals(3uL, tokens.LowerBound(7));
+
+  /// Appending closes the gap, what was pending is kept
+  tokens.EmplaceToken(T::TK_EOI, RangeAt(14, 15));
+  VkAssertEquals(6uL, tokens.size());
+  VkAssertEquals("ee", tokens[4].GetStrValueUnsafe());
+  VkAssertTrue(tokens.GetSourceRange(4) == RangeAt(12, 14));
+  VkAssertEquals(T::TK_EOI, tokens.GetTokenKind(5));
+}
+
+void test19() {
+  VkTestSectionStart("Parallel lexing records the diagnostics of a serial "
+                     "run");
+  /// An error at the start of every line, where chunks begin, so that
+  /// chunks lexing on past their end report it twice
+  string file;
+  for (int i = 0; file.size() < 3 * 1024 * 1024; i++) {
+    string n = to_string(i);
+    file += "@ def field_" + n + " : int32 = " + n + ";\n";
+    if (i % 13 == 0) {
+      file += "$ def bad_" + n + " : float = 1e99999 $ 0x;\n";
+    }
+    if (i % 29 == 0) {
+      file += "@ def text_" + n + " : string = \"\\q\n\";\n";
+    }
+  }
+  vector<string> lines;
+
+  Diag::DiagnosticEngine serialDiag("l.c", lines);
+  Frontend::Lexer serialLexer(string(file), serialDiag);
+  Frontend::TokenBuffer expected = serialLexer.GetAndReset();
+  string serialOutput;
+  serialDiag.RenderDiags(serialOutput);
+
+  Diag::DiagnosticEngine diag("l.c", lines);
+  Frontend::Lexer lexer(string(file), diag);
+  Frontend::TokenBuffer tokens = lexer.LexInParallel(8);
+  string output;
+  diag.RenderDiags(output);
+
+  VkAssertTrue(SameTokens(expected, tokens));
+  VkAssertTrue(serialDiag.HasPendingError());
+  VkAssertEquals(serialOutput.size(), output.size());
+  VkAssertTrue(serialOutput == output);
+
+  /// Running into the token limit, the serial lexer takes over and only
+  /// its diagnostics are left
+  Diag::DiagnosticEngine limitedSerialDiag("l.c", lines);
+  limitedSerialDiag.GetBudget().SetMaxTokens(100000);
+  Frontend::Lexer limitedSerial(string(file), limitedSerialDiag);
+  expected = limitedSerial.GetAndReset();
+  serialOutput.clear();
+  limitedSerialDiag.RenderDiags(serialOutput);
+
+  Diag::DiagnosticEngine limitedDiag("l.c", lines);
+  limitedDiag.GetBudget().SetMaxTokens(100000);
+  Frontend::Lexer limitedLexer(string(file), limitedDiag);
+  tokens = limitedLexer.LexInParallel(8);
+  output.clear();
+  limitedDiag.RenderDiags(output);
+
+  VkAssertTrue(SameTokens(expected, tokens));
+  VkAssertTrue(serialOutput == output);
+}
+
 int main() {
   VkTestStart();
 
@@ -149,6 +755,21 @@ int main() {
   test2();
   test3();
   test4();
+  test5();
+  test6();
+  test7();
+  test8();
+  test9();
+  test10();
+  test11();
+  test12();
+  test13();
+  test14();
+  test15();
+  test16();
+  test17();
+  test18();
+  test19();
 
   VkTestFinish();
 }
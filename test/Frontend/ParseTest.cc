@@ -1,14 +1,25 @@
 #include "VKTestCXX.h"
 #include "Frontend/Lex.h"
+#include "Frontend/Parser.h"
 #include "Frontend/ParserImpl.h"
 
+#include <algorithm>
 #include <iostream>
 #include <string>
+#include <thread>
 
 using namespace sona;
 using namespace ckx;
 using namespace std;
 
+/// The range [begin, end) of a source lexed on its own
+static SourceRange RangeAt(uint32_t begin, uint32_t end) {
+  SourceLocation fileStart =
+      SourceLocation::FromRawEncoding(SourceManager::FirstFileStart);
+  return SourceRange(fileStart.GetLocWithOffset(begin),
+                     fileStart.GetLocWithOffset(end));
+}
+
 class ParserTest : public Frontend::ParserImpl {
 public:
   ParserTest(Diag::DiagnosticEngine &diag) : ParserImpl(diag) {}
@@ -33,12 +44,12 @@ void test0() {
   Frontend::Lexer lexer(move(file), diag);
   ParserTest testContext(diag);
 
-  std::vector<Frontend::Token> tokens = lexer.GetAndReset();
+  Frontend::TokenBuffer tokens = lexer.GetAndReset();
 
   testContext.SetParsingTokenStream(tokens);
-  owner<Syntax::Decl> decl = testContext.ParseVarDecl();
+  Syntax::NodePtr<Syntax::Decl> decl = testContext.ParseVarDecl();
   testContext.ExpectAndConsume(Frontend::Token::TK_SYM_SEMI);
-  owner<Syntax::Decl> decl2 = testContext.ParseVarDecl();
+  Syntax::NodePtr<Syntax::Decl> decl2 = testContext.ParseVarDecl();
   testContext.ExpectAndConsume(Frontend::Token::TK_SYM_SEMI);
 
   VkAssertFalse(diag.HasPendingDiags());
@@ -85,16 +96,16 @@ void test1() {
   Frontend::Lexer lexer(move(file), diag);
   ParserTest testContext(diag);
 
-  std::vector<Frontend::Token> tokens = lexer.GetAndReset();
+  Frontend::TokenBuffer tokens = lexer.GetAndReset();
 
   testContext.SetParsingTokenStream(tokens);
-  owner<Syntax::Decl> decl = testContext.ParseFuncDecl();
+  Syntax::NodePtr<Syntax::Decl> decl = testContext.ParseFuncDecl();
   VkAssertNotEquals(nullptr, decl.borrow());
   VkAssertFalse(diag.HasPendingDiags());
 
   diag.EmitDiags();
 
-  owner<Syntax::FuncDecl> funcDecl =
+  Syntax::NodePtr<Syntax::FuncDecl> funcDecl =
       std::move(decl).cast_unsafe<Syntax::FuncDecl>();
   VkAssertEquals("f!", funcDecl.borrow()->GetName());
   VkAssertEquals(2uL, funcDecl.borrow()->GetParamNames().size());
@@ -112,17 +123,17 @@ void test2() {
   Frontend::Lexer lexer(move(file), diag);
   ParserTest testContext(diag);
 
-  std::vector<Frontend::Token> tokens = lexer.GetAndReset();
+  Frontend::TokenBuffer tokens = lexer.GetAndReset();
 
   testContext.SetParsingTokenStream(tokens);
-  owner<Syntax::Decl> decl = testContext.ParseClassDecl();
+  Syntax::NodePtr<Syntax::Decl> decl = testContext.ParseClassDecl();
   VkAssertEquals(Syntax::Node::CNK_ClassDecl,
                    decl.borrow()->GetNodeKind());
 
   VkAssertFalse(diag.HasPendingDiags());
   VkAssertNotEquals(nullptr, decl.borrow());
 
-  owner<Syntax::ClassDecl> classDecl =
+  Syntax::NodePtr<Syntax::ClassDecl> classDecl =
       std::move(decl).cast_unsafe<Syntax::ClassDecl>();
   VkAssertEquals("A", classDecl.borrow()->GetName());
   VkAssertEquals(2uL, classDecl.borrow()->GetSubDecls().size());
@@ -153,9 +164,9 @@ void test3() {
   Diag::DiagnosticEngine diag("a.c", lines);
   Frontend::Lexer lexer(move(file), diag);
   ParserTest testContext(diag);
-  std::vector<Frontend::Token> tokens = lexer.GetAndReset();
+  Frontend::TokenBuffer tokens = lexer.GetAndReset();
   testContext.SetParsingTokenStream(tokens);
-  owner<Syntax::Decl> decl = testContext.ParseEnumDecl();
+  Syntax::NodePtr<Syntax::Decl> decl = testContext.ParseEnumDecl();
   VkAssertEquals(Syntax::Node::CNK_EnumDecl,
                    decl.borrow()->GetNodeKind());
 
@@ -164,7 +175,7 @@ void test3() {
 
   diag.EmitDiags();
 
-  owner<Syntax::EnumDecl> enumDecl =
+  Syntax::NodePtr<Syntax::EnumDecl> enumDecl =
       std::move(decl).cast_unsafe<Syntax::EnumDecl>();
 
   VkAssertEquals("A", enumDecl.borrow()->GetName());
@@ -192,9 +203,9 @@ void test4() {
   Diag::DiagnosticEngine diag("a.c", lines);
   Frontend::Lexer lexer(move(file), diag);
   ParserTest testContext(diag);
-  std::vector<Frontend::Token> tokens = lexer.GetAndReset();
+  Frontend::TokenBuffer tokens = lexer.GetAndReset();
   testContext.SetParsingTokenStream(tokens);
-  sona::owner<Syntax::Expr> e = testContext.ParseLiteralExpr();
+  Syntax::NodePtr<Syntax::Expr> e = testContext.ParseLiteralExpr();
 
   VkAssertEquals(Syntax::Node::CNK_IntLiteralExpr,
                    e.borrow()->GetNodeKind());
@@ -202,7 +213,7 @@ void test4() {
 
   diag.EmitDiags();
 
-  sona::owner<Syntax::IntLiteralExpr> literalExpr =
+  Syntax::NodePtr<Syntax::IntLiteralExpr> literalExpr =
       std::move(e).cast_unsafe<Syntax::IntLiteralExpr>();
 
   VkAssertEquals(123123, literalExpr.borrow()->GetValue());
@@ -216,20 +227,555 @@ void test5() {
   Diag::DiagnosticEngine diag("a.c", lines);
   Frontend::Lexer lexer(move(file), diag);
   ParserTest testContext(diag);
-  std::vector<Frontend::Token> tokens = lexer.GetAndReset();
+  Frontend::TokenBuffer tokens = lexer.GetAndReset();
   testContext.SetParsingTokenStream(tokens);
-  sona::owner<Syntax::Decl> decl = testContext.ParseUsingDecl();
+  Syntax::NodePtr<Syntax::Decl> decl = testContext.ParseUsingDecl();
   VkAssertEquals(Syntax::Node::CNK_UsingDecl,
                    decl.borrow()->GetNodeKind());
 
   VkAssertFalse(diag.HasPendingDiags());
   VkAssertNotEquals(nullptr, decl.borrow());
 
-  sona::owner<Syntax::UsingDecl> usingDecl =
+  Syntax::NodePtr<Syntax::UsingDecl> usingDecl =
       std::move(decl).cast_unsafe<Syntax::UsingDecl>();
   VkAssertEquals("ty", usingDecl.borrow()->GetName());
   VkAssertEquals(Syntax::Type::NodeKind::CNK_BuiltinType,
                  usingDecl.borrow()->GetAliasee()->GetNodeKind());
+  VkAssertTrue(usingDecl.borrow()->GetEqRange() == RangeAt(9, 10));
+  VkAssertTrue(usingDecl.borrow()->GetRepresentingRange().GetBegin()
+               == RangeAt(6, 8).GetBegin());
+}
+
+void test6() {
+  VkTestSectionStart("Parsing while pulling tokens from the lexer");
+
+  string file = "class c { def a : int32; def b : float; }\n"
+                "def x : c;\n"
+                "using t = int32;\n";
+  vector<string> lines = { file };
+  Diag::DiagnosticEngine diag("a.c", lines);
+  Frontend::Lexer lexer(move(file), diag);
+  Frontend::Parser parser(diag);
+
+  sona::owner<Syntax::TransUnit> unit = parser.ParseTransUnit(lexer);
+
+  VkAssertFalse(diag.HasPendingDiags());
+  VkAssertEquals(3uL, unit.borrow()->GetDecls().size());
+}
+
+void test7() {
+  VkTestSectionStart("Rendering diagnostics as text and JSON");
+
+  string file = "def a : int8;\ndef \"b\" : int8;";
+  vector<string> lines = { "def a : int8;", "def \"b\" : int8;" };
+
+  Diag::DiagnosticEngine diag("h.c", lines);
+  Frontend::Lexer lexer(move(file), diag);
+  Frontend::Parser parser(diag);
+  sona::owner<Syntax::TransUnit> unit = parser.ParseTransUnit(lexer);
+  VkAssertTrue(diag.HasPendingError());
+
+  string text;
+  diag.RenderDiags(text);
+  string expectedHead =
+      "h.c:(2,5): error: Unexpected string literal \"b\", expected "
+      "identifier\n"
+      " 00002 | def \"b\" : int8;\n"
+      "             ^^^\n";
+  VkAssertEquals(expectedHead, text.substr(0, expectedHead.size()));
+
+  diag.SetFormat(Diag::DF_JSON);
+  string json;
+  diag.RenderDiags(json);
+  string expectedJSON =
+      "{\"file\":\"h.c\",\"severity\":\"error\",\"line\":2,\"column\":5,"
+      "\"end_line\":2,\"end_column\":8,\"message\":\"Unexpected string "
+      "literal \\\"b\\\", "
+      "expected identifier\",\"children\":[]}\n";
+  VkAssertEquals(expectedJSON, json.substr(0, expectedJSON.size()));
+  VkAssertEquals(count(text.begin(), text.end(), '\n'),
+                 3 * count(json.begin(), json.end(), '\n'));
+
+  diag.ClearDiags();
+}
+
+void test8() {
+  VkTestSectionStart("Lazy diagnostic messages and the error limit");
+
+  string file;
+  vector<string> lines;
+  for (int i = 0; i < 10; i++) {
+    file += "def \"b\" : int8;\n";
+    lines.push_back("def \"b\" : int8;");
+  }
+
+  Diag::DiagnosticEngine diag("l.c", lines);
+  diag.SetErrorLimit(3);
+  Frontend::Lexer lexer(move(file), diag);
+  Frontend::Parser parser(diag);
+  sona::owner<Syntax::TransUnit> unit = parser.ParseTransUnit(lexer);
+  VkAssertTrue(diag.ErrorLimitReached());
+  VkAssertTrue(diag.GetBudget().GetExhaustedBy()
+               == CompileBudget::R_Errors);
+
+  string text;
+  diag.RenderDiags(text);
+  size_t numErrors = 0;
+  for (size_t pos = text.find("error: "); pos != string::npos;
+       pos = text.find("error: ", pos + 1)) {
+    numErrors++;
+  }
+  VkAssertEquals(3uL, numErrors);
+  string note = "note: too many errors, stopping after 3 of them";
+  size_t notePos = text.find(note);
+  VkAssertTrue(notePos != string::npos);
+  VkAssertTrue(text.find(note, notePos + 1) == string::npos);
+
+  Diag::DiagnosticEngine lazy("m.c", lines);
+  lazy.Diag(Diag::DIR_Warning0, Diag::DMT_ErrRedefinition, {"b"},
+            RangeAt(4, 7))
+      .AddNote(Diag::DMT_NoteFirstDefined, {"b"}, RangeAt(20, 23));
+  string lazyText;
+  lazy.RenderDiags(lazyText);
+  string expectedLazy =
+      "m.c:(1,5): warning: "
+      + Diag::Format(Diag::DMT_ErrRedefinition, {"b"}) + "\n";
+  VkAssertEquals(expectedLazy, lazyText.substr(0, expectedLazy.size()));
+  VkAssertTrue(lazyText.find("note: 'b' first defined here:")
+               != string::npos);
+
+  Diag::DiagnosticEngine ordered("o.c", lines);
+  ordered.Diag(Diag::DIR_Error, Diag::DMT_ErrRedefinition, {"b"},
+               RangeAt(20, 23));
+  ordered.Diag(Diag::DIR_Note, Diag::DMT_NoteFirstDefined, {"b"},
+               SourceRange());
+  string orderedText;
+  ordered.RenderDiags(orderedText);
+  VkAssertTrue(orderedText.find("error: ") < orderedText.find("note: "));
+}
+
+void test9() {
+  VkTestSectionStart("Diagnostics of parallel workers merge like a serial run");
+
+  SourceManager sourceManager;
+  vector<FileID> files;
+  for (int i = 0; i < 4; i++) {
+    string source;
+    for (int j = 0; j <= i; j++) {
+      source += "def \"s" + to_string(j) + "\" : int8;\ndef ok : int8;\n";
+    }
+    files.push_back(sourceManager.AddFile(
+        "w" + to_string(i) + ".c", SourceBuffer::FromString(move(source))));
+  }
+
+  auto parseFile = [&sourceManager](Diag::DiagnosticEngine &diag,
+                                    FileID file) {
+    Frontend::Lexer lexer(sourceManager, file, diag);
+    Frontend::Parser parser(diag);
+    sona::owner<Syntax::TransUnit> unit = parser.ParseTransUnit(lexer);
+  };
+
+  Diag::DiagnosticEngine serialDiag(sourceManager, FileID());
+  for (FileID file : files) {
+    parseFile(serialDiag, file);
+  }
+  string serialText;
+  serialDiag.RenderDiags(serialText);
+
+  Diag::DiagnosticEngine parallelDiag(sourceManager, FileID());
+  vector<thread> workers;
+  for (FileID file : files) {
+    workers.emplace_back(parseFile, ref(parallelDiag), file);
+  }
+  for (thread &worker : workers) {
+    worker.join();
+  }
+  string parallelText;
+  parallelDiag.RenderDiags(parallelText);
+
+  VkAssertTrue(parallelDiag.HasPendingError());
+  VkAssertEquals(serialText, parallelText);
+  VkAssertEquals(0uL, serialText.find("w0.c:(1,5): error: "));
+  VkAssertTrue(serialText.find("w3.c:(7,5): error: ") != string::npos);
+}
+
+void test10() {
+  VkTestSectionStart("Running out of the compile budget");
+
+  string tokensFile;
+  string depthFile = "def x : int8;\n";
+  vector<string> lines;
+  for (int i = 0; i < 100; i++) {
+    tokensFile += "def x : int8;\n";
+    depthFile += "class c { ";
+    lines.push_back("def x : int8;");
+  }
+
+  Diag::DiagnosticEngine tokensDiag("t.c", lines);
+  tokensDiag.GetBudget().SetMaxTokens(50);
+  Frontend::Lexer tokensLexer(move(tokensFile), tokensDiag);
+  Frontend::Parser tokensParser(tokensDiag);
+  sona::owner<Syntax::TransUnit> tokensUnit =
+      tokensParser.ParseTransUnit(tokensLexer);
+  string tokensText;
+  tokensDiag.RenderDiags(tokensText);
+  VkAssertTrue(tokensDiag.GetBudget().GetExhaustedBy()
+               == CompileBudget::R_Tokens);
+  VkAssertEquals("t.c:(10,14): error: compile budget exhausted after 50 "
+                 "tokens, stopping now\n",
+                 tokensText.substr(0, tokensText.find('\n') + 1));
+  VkAssertEquals(10uL, tokensUnit.borrow()->GetDecls().size());
+
+  Diag::DiagnosticEngine depthDiag("d.c", lines);
+  depthDiag.GetBudget().SetMaxDepth(16);
+  Frontend::Lexer depthLexer(move(depthFile), depthDiag);
+  Frontend::Parser depthParser(depthDiag);
+  sona::owner<Syntax::TransUnit> depthUnit =
+      depthParser.ParseTransUnit(depthLexer);
+  string depthText;
+  depthDiag.RenderDiags(depthText);
+  VkAssertTrue(depthDiag.GetBudget().GetExhaustedBy()
+               == CompileBudget::R_Depth);
+  VkAssertEquals(3L, count(depthText.begin(), depthText.end(), '\n'));
+  VkAssertTrue(depthText.find("after 16 levels of nesting") != string::npos);
+
+  CompileBudget timeBudget;
+  timeBudget.SetMaxTime(chrono::milliseconds(1));
+  this_thread::sleep_for(chrono::milliseconds(2));
+  bool timeExceeded = false;
+  for (uint32_t i = 0; i < CompileBudget::TimeCheckInterval; i++) {
+    timeExceeded = timeExceeded || timeBudget.TimeExceeded();
+  }
+  VkAssertTrue(timeExceeded);
+}
+
+void test11() {
+  VkTestSectionStart("Allocating the syntax tree from its arena");
+
+  string file = "class A { def x : a.b.C *; }\n"
+                "func f(p : int8, q : x.y) : int8;\n";
+  vector<string> lines = { "class A { def x : a.b.C *; }",
+                           "func f(p : int8, q : x.y) : int8;" };
+  Diag::DiagnosticEngine diag("a.c", lines);
+  Frontend::Lexer lexer(move(file), diag);
+  Frontend::Parser parser(diag);
+  sona::owner<Syntax::TransUnit> unit = parser.ParseTransUnit(lexer);
+  VkAssertFalse(diag.HasPendingDiags());
+  VkAssertTrue(unit.borrow()->GetArena().GetBytesReserved() > 0);
+  VkAssertEquals(2uL, unit.borrow()->GetDecls().size());
+
+  ref_ptr<Syntax::ClassDecl const> classDecl =
+      (*unit.borrow()->GetDecls().begin())
+        .cast_unsafe<Syntax::ClassDecl const>();
+  ref_ptr<Syntax::VarDecl const> field =
+      (*classDecl->GetSubDecls().begin()).cast_unsafe<Syntax::VarDecl const>();
+  ref_ptr<Syntax::ComposedType const> fieldType =
+      field->GetType().cast_unsafe<Syntax::ComposedType const>();
+  VkAssertEquals(Syntax::Node::CNK_UserDefinedType,
+                 fieldType->GetRootType()->GetNodeKind());
+  Syntax::Identifier const& name =
+      fieldType->GetRootType().cast_unsafe<Syntax::UserDefinedType const>()
+        ->GetName();
+  VkAssertEquals(2uL, name.GetNestedNameSpecifiers().size());
+  VkAssertEquals("a", name.GetNestedNameSpecifiers()[0]);
+  VkAssertEquals("b", name.GetNestedNameSpecifiers()[1]);
+  VkAssertEquals(2uL, name.GetNNSSourceRanges().size());
+  VkAssertEquals("C", name.GetIdentifier());
+
+  ref_ptr<Syntax::FuncDecl const> funcDecl =
+      (*(unit.borrow()->GetDecls().begin() + 1))
+        .cast_unsafe<Syntax::FuncDecl const>();
+  VkAssertEquals(2uL, funcDecl->GetParamNames().size());
+  VkAssertEquals("q", funcDecl->GetParamNames()[1]);
+  VkAssertEquals(2uL, funcDecl->GetParamTypes().size());
+}
+
+void test12() {
+  VkTestSectionStart("Skipping function bodies and parsing them later");
+
+  string file = "func f(a : int8) : int8 {\n"
+                "  a = a + 1; { ; }\n"
+                "  return a * 2;\n"
+                "}\n"
+                "func h(b : int8) : int8;\n";
+  vector<string> lines;
+  Diag::DiagnosticEngine diag("a.c", lines);
+  Frontend::Lexer lexer(string(file), diag);
+  Frontend::TokenBuffer tokens = lexer.GetAndReset();
+
+  Frontend::Parser eagerParser(diag);
+  sona::owner<Syntax::TransUnit> eagerUnit =
+      eagerParser.ParseTransUnit(tokens);
+  ref_ptr<Syntax::FuncDecl const> eagerFunc =
+      (*eagerUnit.borrow()->GetDecls().begin())
+        .cast_unsafe<Syntax::FuncDecl const>();
+  VkAssertTrue(eagerFunc->IsDefinition());
+  VkAssertFalse(eagerFunc->HasSkippedBody());
+  VkAssertEquals(Syntax::Node::CNK_CompoundStmt,
+                 eagerFunc->GetFuncBodyUnsafe()->GetNodeKind());
+
+  Frontend::Parser skipParser(diag);
+  skipParser.SetSkipFuncBodies(true);
+  sona::owner<Syntax::TransUnit> unit = skipParser.ParseTransUnit(tokens);
+  VkAssertFalse(diag.HasPendingDiags());
+  VkAssertEquals(2uL, unit.borrow()->GetDecls().size());
+
+  ref_ptr<Syntax::FuncDecl const> f =
+      (*unit.borrow()->GetDecls().begin())
+        .cast_unsafe<Syntax::FuncDecl const>();
+  ref_ptr<Syntax::FuncDecl const> h =
+      (*(unit.borrow()->GetDecls().begin() + 1))
+        .cast_unsafe<Syntax::FuncDecl const>();
+  VkAssertTrue(f->IsDefinition());
+  VkAssertTrue(f->HasSkippedBody());
+  VkAssertFalse(h->IsDefinition());
+  VkAssertTrue(tokens.GetTokenKind(f->GetSkippedBodyBeginUnsafe())
+               == Frontend::Token::TK_SYM_LBRACE);
+  VkAssertTrue(tokens.GetTokenKind(f->GetSkippedBodyEndUnsafe() - 1)
+               == Frontend::Token::TK_SYM_RBRACE);
+  VkAssertTrue(tokens.GetTokenKind(f->GetSkippedBodyEndUnsafe())
+               == Frontend::Token::TK_KW_func);
+
+  /// Token indices are the same when pulling tokens from the lexer
+  Frontend::Lexer pullLexer(string(file), diag);
+  Frontend::Parser pullParser(diag);
+  pullParser.SetSkipFuncBodies(true);
+  sona::owner<Syntax::TransUnit> pullUnit =
+      pullParser.ParseTransUnit(pullLexer);
+  ref_ptr<Syntax::FuncDecl const> pullF =
+      (*pullUnit.borrow()->GetDecls().begin())
+        .cast_unsafe<Syntax::FuncDecl const>();
+  VkAssertEquals(f->GetSkippedBodyBeginUnsafe(),
+                 pullF->GetSkippedBodyBeginUnsafe());
+  VkAssertEquals(f->GetSkippedBodyEndUnsafe(),
+                 pullF->GetSkippedBodyEndUnsafe());
+
+  Syntax::NodePtr<Syntax::Stmt> body =
+      skipParser.ParseFuncBody(tokens, unit.borrow(), f);
+  VkAssertFalse(diag.HasPendingDiags());
+  VkAssertEquals(Syntax::Node::CNK_CompoundStmt,
+                 body.borrow()->GetNodeKind());
+  ref_ptr<Syntax::CompoundStmt const> compound =
+      body.borrow().cast_unsafe<Syntax::CompoundStmt const>();
+  VkAssertEquals(3uL, compound->GetStmts().size());
+  auto stmts = compound->GetStmts();
+  VkAssertEquals(Syntax::Node::CNK_ExprStmt, (*stmts.begin())->GetNodeKind());
+  VkAssertEquals(Syntax::Node::CNK_CompoundStmt,
+                 (*(stmts.begin() + 1))->GetNodeKind());
+  VkAssertEquals(Syntax::Node::CNK_ReturnStmt,
+                 (*(stmts.begin() + 2))->GetNodeKind());
+}
+
+void test13() {
+  VkTestSectionStart("Literal statements and a missing semicolon");
+  string file = "func f(p : int8) : int8 {\n"
+                "  \"s\"; true; nullptr;\n"
+                "  p = 1 p = 2;\n"
+                "  return p;\n"
+                "}\n";
+  vector<string> lines;
+  Diag::DiagnosticEngine diag("a.c", lines);
+  Frontend::Lexer lexer(string(file), diag);
+  Frontend::Parser parser(diag);
+  sona::owner<Syntax::TransUnit> unit = parser.ParseTransUnit(lexer);
+  VkAssertTrue(diag.HasPendingError());
+
+  ref_ptr<Syntax::FuncDecl const> f =
+      (*unit.borrow()->GetDecls().begin())
+        .cast_unsafe<Syntax::FuncDecl const>();
+  ref_ptr<Syntax::CompoundStmt const> body =
+      f->GetFuncBodyUnsafe().cast_unsafe<Syntax::CompoundStmt const>();
+  VkAssertEquals(5uL, body->GetStmts().size());
+  VkAssertEquals(Syntax::Node::CNK_ReturnStmt,
+                 (*(body->GetStmts().begin() + 4))->GetNodeKind());
+}
+
+static sona::strhdl_t TopLevelName(ref_ptr<Syntax::Decl const> decl) {
+  switch (decl->GetNodeKind()) {
+  case Syntax::Node::CNK_ClassDecl:
+    return decl.cast_unsafe<Syntax::ClassDecl const>()->GetName();
+  case Syntax::Node::CNK_FuncDecl:
+    return decl.cast_unsafe<Syntax::FuncDecl const>()->GetName();
+  case Syntax::Node::CNK_VarDecl:
+    return decl.cast_unsafe<Syntax::VarDecl const>()->GetName();
+  default:
+    return sona::strhdl_t("");
+  }
+}
+
+/// @return the number of top-level declarations the units differ in
+static size_t CountDifferentDecls(Syntax::TransUnit const& expected,
+                                  Syntax::TransUnit const& unit) {
+  vector<ref_ptr<Syntax::Decl const>> lhs, rhs;
+  for (ref_ptr<Syntax::Decl const> decl : expected.GetDecls()) {
+    lhs.push_back(decl);
+  }
+  for (ref_ptr<Syntax::Decl const> decl : unit.GetDecls()) {
+    rhs.push_back(decl);
+  }
+  size_t mismatches = max(lhs.size(), rhs.size()) - min(lhs.size(),
+                                                        rhs.size());
+  for (size_t i = 0; i < min(lhs.size(), rhs.size()); i++) {
+    if (lhs[i]->GetNodeKind() != rhs[i]->GetNodeKind()
+        || !(TopLevelName(lhs[i]) == TopLevelName(rhs[i]))) {
+      ++mismatches;
+    }
+  }
+  return mismatches;
+}
+
+void test14() {
+  VkTestSectionStart("Parallel parsing matches the serial parser");
+  string file;
+  for (int i = 0; i < 3000; i++) {
+    string n = to_string(i);
+    file += "class C" + n + " { def x : int32; class D { def y : T; } }\n"
+            "enum class A" + n + " { P(int8); Q(float); }\n"
+            "enum E" + n + " { R = 1; S; }\n"
+            "using U" + n + " = C" + n + " * const;\n"
+            "func f" + n + "(a : int8) : int8 { { a = a * 2; } return a; }\n"
+            "func g" + n + "(b : x.y) : int8;\n"
+            "def v" + n + " : C" + n + ";\n";
+  }
+  vector<string> lines;
+  Diag::DiagnosticEngine diag("p.c", lines);
+  Frontend::Lexer lexer(string(file), diag);
+  Frontend::TokenBuffer tokens = lexer.GetAndReset();
+
+  Frontend::Parser serialParser(diag);
+  sona::owner<Syntax::TransUnit> expected =
+      serialParser.ParseTransUnit(tokens);
+  Frontend::Parser parser(diag);
+  sona::owner<Syntax::TransUnit> unit =
+      parser.ParseTransUnitInParallel(tokens, 8);
+  VkAssertFalse(diag.HasPendingDiags());
+  VkAssertEquals(21000uL, unit.borrow()->GetDecls().size());
+  VkAssertEquals(0uL, CountDifferentDecls(expected.borrow().get(),
+                                          unit.borrow().get()));
+
+  /// Errors all over, some of which recovery skips across where the next
+  /// declarations seemed to start: the batches behind them are parsed
+  /// again, and only the diagnostics of the serial parser remain
+  string faulty = file;
+  faulty.insert(faulty.find("\nclass C1500") + 1,
+                "def bad int8; func h(a : int8) : int8 { a = ; }\n");
+  char const *errors[] = {
+    "func k(a : \n", "def w : int8 = 1 +\n", "def bad int8;\n"
+  };
+  for (int i = 2998; i > 0; i -= 2) {
+    faulty.insert(faulty.find("\nclass C" + to_string(i) + " ") + 1,
+                  errors[i % 3]);
+  }
+  Diag::DiagnosticEngine serialDiag("p.c", lines);
+  Frontend::Lexer serialLexer(string(faulty), serialDiag);
+  Frontend::TokenBuffer faultyTokens = serialLexer.GetAndReset();
+  Frontend::Parser faultySerialParser(serialDiag);
+  expected = faultySerialParser.ParseTransUnit(faultyTokens);
+
+  Diag::DiagnosticEngine parallelDiag("p.c", lines);
+  Frontend::Parser faultyParser(parallelDiag);
+  unit = faultyParser.ParseTransUnitInParallel(faultyTokens, 8);
+  string serialOut, parallelOut;
+  serialDiag.RenderDiags(serialOut);
+  parallelDiag.RenderDiags(parallelOut);
+  VkAssertTrue(parallelDiag.HasPendingError());
+  VkAssertEquals(serialOut, parallelOut);
+  VkAssertEquals(0uL, CountDifferentDecls(expected.borrow().get(),
+                                          unit.borrow().get()));
+
+  /// Workers run against the deadline of the caller
+  Diag::DiagnosticEngine lateDiag("p.c", lines);
+  lateDiag.GetBudget().SetMaxTime(chrono::milliseconds(1));
+  this_thread::sleep_for(chrono::milliseconds(2));
+  Frontend::Parser lateParser(lateDiag);
+  unit = lateParser.ParseTransUnitInParallel(tokens, 8);
+  VkAssertTrue(lateDiag.GetBudget().GetExhaustedBy()
+               == CompileBudget::R_Time);
+}
+
+void test15() {
+  VkTestSectionStart("Incremental parsing of REPL input");
+  using Frontend::IncrementalParser;
+  vector<string> lines;
+  Diag::DiagnosticEngine diag("<repl-input>", lines);
+  IncrementalParser parser(diag, lines);
+
+  VkAssertEquals(IncrementalParser::IPS_NeedMoreInput,
+                 parser.PushLine("static_cast<int64>(1 +"));
+  VkAssertTrue(parser.IsPending());
+  VkAssertEquals(IncrementalParser::IPS_Complete,
+                 parser.PushLine("  2) * 3"));
+  VkAssertFalse(parser.IsPending());
+  VkAssertEquals(Syntax::Node::CNK_BinaryExpr,
+                 parser.GetEntry()->GetNodeKind());
+  VkAssertEquals(2uL, lines.size());
+
+  VkAssertEquals(IncrementalParser::IPS_NeedMoreInput,
+                 parser.PushLine("4 *"));
+  VkAssertEquals(IncrementalParser::IPS_Complete, parser.PushLine("5"));
+  VkAssertEquals(2uL, lines.size());
+
+  VkAssertEquals(IncrementalParser::IPS_NeedMoreInput,
+                 parser.PushLine("def x :"));
+  VkAssertEquals(IncrementalParser::IPS_Complete,
+                 parser.PushLine("int32;"));
+  VkAssertEquals(Syntax::Node::CNK_VarDecl,
+                 parser.GetEntry()->GetNodeKind());
+  VkAssertFalse(diag.HasPendingDiags());
+
+  VkAssertEquals(IncrementalParser::IPS_Error, parser.PushLine("1 2"));
+  VkAssertTrue(diag.HasPendingError());
+  diag.ClearDiags();
+  VkAssertEquals(IncrementalParser::IPS_Error, parser.PushLine("1 + )"));
+  VkAssertTrue(diag.HasPendingError());
+  diag.ClearDiags();
+
+  VkAssertEquals(IncrementalParser::IPS_NeedMoreInput,
+                 parser.PushLine("sizeof(3"));
+  VkAssertEquals(IncrementalParser::IPS_Error, parser.Finish());
+  VkAssertTrue(diag.HasPendingError());
+  diag.ClearDiags();
+
+  VkAssertEquals(IncrementalParser::IPS_NeedMoreInput, parser.PushLine(""));
+  VkAssertFalse(parser.IsPending());
+  VkAssertEquals(IncrementalParser::IPS_Complete, parser.PushLine("7"));
+  VkAssertEquals(Syntax::Node::CNK_IntLiteralExpr,
+                 parser.GetEntry()->GetNodeKind());
+
+  VkAssertEquals(IncrementalParser::IPS_Error,
+                 parser.PushLine(sona::string_view("a \0 +", 5)));
+  string nulText;
+  diag.RenderDiags(nulText);
+  VkAssertEquals(0uL, nulText.find("<repl-input>:(1,3): error: "));
+  diag.ClearDiags();
+  VkAssertEquals(IncrementalParser::IPS_Complete, parser.PushLine("8"));
+}
+
+void test16() {
+  VkTestSectionStart("Recovering from malformed parameters");
+
+  /// No error limit and no budget, the parser alone has to get past them
+  string file = "func f(1 2 3) : int8;\n"
+                "func g() : int8;\n"
+                "func h(a : int8, 3, b : int8) : int8;\n";
+  vector<string> lines = { "func f(1 2 3) : int8;", "func g() : int8;",
+                           "func h(a : int8, 3, b : int8) : int8;" };
+  Diag::DiagnosticEngine diag("p.c", lines);
+  Frontend::Lexer lexer(move(file), diag);
+  Frontend::Parser parser(diag);
+  sona::owner<Syntax::TransUnit> unit = parser.ParseTransUnit(lexer);
+  VkAssertFalse(diag.GetBudget().IsExhausted());
+  VkAssertEquals(3uL, unit.borrow()->GetDecls().size());
+
+  string text;
+  diag.RenderDiags(text);
+  VkAssertEquals(0uL, text.find("p.c:(1,8): error: "));
+  VkAssertTrue(text.find("p.c:(3,18): error: ") != string::npos);
+
+  ref_ptr<Syntax::Decl const> h = *(unit.borrow()->GetDecls().begin() + 2);
+  VkAssertEquals(Syntax::Node::CNK_FuncDecl, h->GetNodeKind());
+  VkAssertEquals(2uL, h.cast_unsafe<Syntax::FuncDecl const>()
+                       ->GetParamNames().size());
 }
 
 int main() {
@@ -241,6 +787,17 @@ int main() {
   test3();
   test4();
   test5();
+  test6();
+  test7();
+  test8();
+  test9();
+  test10();
+  test11();
+  test12();
+  test13();
+  test14();
+  test15();
+  test16();
 
   VkTestFinish();
 }
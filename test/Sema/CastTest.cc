@@ -1,5 +1,9 @@
 #include "VKTestCXX.h"
 #include "Sema/SemaPhase1.h"
+#include "Syntax/Concrete.h"
+
+#include <chrono>
+#include <thread>
 
 using namespace sona;
 using namespace ckx;
@@ -10,6 +14,7 @@ public:
   using SemaPhase1::TryImplicitCast;
   using SemaPhase1::ActOnStaticCast;
   using SemaPhase1::ActOnConstCast;
+  using SemaPhase1::ActOnExpr;
 
   SemaPhase1Test(AST::ASTContext &astContext,
                  std::vector<sona::ref_ptr<AST::DeclContext>> &declContexts,
@@ -215,6 +220,34 @@ void test7() {
   VkTestSectionStart("explicit reference qualifier adjust");
 }
 
+void test8() {
+  VkTestSectionStart("Running out of time inside one expression");
+
+  AST::ASTContext astContext;
+  std::vector<sona::ref_ptr<AST::DeclContext>> declContexts;
+  Diag::DiagnosticEngine diag("<undefined>", {});
+  diag.GetBudget().SetMaxTime(chrono::milliseconds(1));
+  this_thread::sleep_for(chrono::milliseconds(5));
+
+  SemaPhase1Test semaTest(astContext, declContexts, diag);
+
+  /// More nodes than the budget reads the clock after, all in a single
+  /// expression
+  Syntax::SyntaxArena arena;
+  Syntax::NodePtr<Syntax::Expr> expr =
+      arena.New<Syntax::IntLiteralExpr>(1, SourceRange());
+  for (std::uint32_t i = 0; i < 4 * CompileBudget::TimeCheckInterval; i++) {
+    expr = arena.New<Syntax::UnaryAlgebraicExpr>(
+             Syntax::UnaryOperator::UOP_Negative, std::move(expr),
+             SourceRange());
+  }
+
+  sona::owner<AST::Expr> result = semaTest.ActOnExpr(nullptr, expr.borrow());
+  VkAssertEquals(nullptr, result.borrow());
+  VkAssertEquals(CompileBudget::R_Time, diag.GetBudget().GetExhaustedBy());
+  VkAssertTrue(diag.HasPendingError());
+}
+
 int main() {
   VkTestStart();
 
@@ -227,6 +260,7 @@ int main() {
 
   test6();
   test7();
+  test8();
 
   VkTestFinish();
 }
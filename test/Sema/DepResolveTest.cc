@@ -54,7 +54,7 @@ void test0() {
 
   Diag::DiagnosticEngine diag("a.c", lines);
   Frontend::Lexer lexer(move(file), diag);
-  std::vector<Frontend::Token> tokens = lexer.GetAndReset();
+  Frontend::TokenBuffer tokens = lexer.GetAndReset();
 
   Frontend::Parser parser(diag);
   sona::owner<Syntax::TransUnit> cst = parser.ParseTransUnit(tokens);
@@ -127,7 +127,7 @@ void test1() {
 
   Diag::DiagnosticEngine diag("a.c", lines);
   Frontend::Lexer lexer(move(file), diag);
-  std::vector<Frontend::Token> tokens = lexer.GetAndReset();
+  Frontend::TokenBuffer tokens = lexer.GetAndReset();
 
   Frontend::Parser parser(diag);
   sona::owner<Syntax::TransUnit> cst = parser.ParseTransUnit(tokens);
@@ -172,7 +172,7 @@ void test2() {
 
   Diag::DiagnosticEngine diag("a.c", lines);
   Frontend::Lexer lexer(move(file), diag);
-  std::vector<Frontend::Token> tokens = lexer.GetAndReset();
+  Frontend::TokenBuffer tokens = lexer.GetAndReset();
 
   Frontend::Parser parser(diag);
   sona::owner<Syntax::TransUnit> cst = parser.ParseTransUnit(tokens);
@@ -239,7 +239,7 @@ void test3() {
 
   Diag::DiagnosticEngine diag("a.c", lines);
   Frontend::Lexer lexer(move(file), diag);
-  std::vector<Frontend::Token> tokens = lexer.GetAndReset();
+  Frontend::TokenBuffer tokens = lexer.GetAndReset();
 
   Frontend::Parser parser(diag);
   sona::owner<Syntax::TransUnit> cst = parser.ParseTransUnit(tokens);
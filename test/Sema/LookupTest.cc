@@ -2,6 +2,8 @@
 #include "Frontend/Lex.h"
 #include "Frontend/Parser.h"
 #include "Sema/SemaPhase0.h"
+#include "Sema/Scope.h"
+#include "Sema/SymbolMap.h"
 
 #include <iostream>
 #include <string>
@@ -33,7 +35,7 @@ void test0() {
 
   Diag::DiagnosticEngine diag("a.c", lines);
   Frontend::Lexer lexer(move(file), diag);
-  std::vector<Frontend::Token> tokens = lexer.GetAndReset();
+  Frontend::TokenBuffer tokens = lexer.GetAndReset();
 
   Frontend::Parser parser(diag);
   sona::owner<Syntax::TransUnit> cst = parser.ParseTransUnit(tokens);
@@ -53,13 +55,13 @@ void test0() {
       sema0.LookupType(sema0.GetGlobalScope(),
                        Syntax::Identifier(std::vector<sona::strhdl_t>{"A"},
                                           "C", std::vector<SourceRange>{},
-                                          SourceRange(0, 0, 0)), false);
+                                          SourceRange()), false);
 
   AST::QualType BCType =
       sema0.LookupType(sema0.GetGlobalScope(),
                        Syntax::Identifier(std::vector<sona::strhdl_t>{"B"},
                                           "C", std::vector<SourceRange>{},
-                                          SourceRange(0, 0, 0)), false);
+                                          SourceRange()), false);
 
   VkAssertNotEquals(nullptr, ACType.GetUnqualTy());
   VkAssertNotEquals(nullptr, BCType.GetUnqualTy());
@@ -98,10 +100,104 @@ void test0() {
                            .cast_unsafe<AST::BuiltinType const>()->GetBtid());
 }
 
+void test1() {
+  VkTestSectionStart("Symbol maps");
+
+  Sema::SymbolMap<int> map;
+  VkAssertTrue(map.empty());
+  VkAssertEquals(nullptr, map.Find("never_bound"));
+
+  bool allInserted = true;
+  for (int i = 0; i < 1000; i++) {
+    allInserted = allInserted
+                  && map.TryEmplace(strhdl_t("sym" + to_string(i)), i).second;
+  }
+  VkAssertTrue(allInserted);
+  VkAssertEquals(1000u, map.size());
+
+  std::pair<int*, bool> again = map.TryEmplace("sym42", -1);
+  VkAssertFalse(again.second);
+  VkAssertEquals(42, *again.first);
+
+  bool allFound = true;
+  for (int i = 0; i < 1000; i++) {
+    int const* value = map.Find(strhdl_t("sym" + to_string(i)));
+    allFound = allFound && value != nullptr && *value == i;
+  }
+  VkAssertTrue(allFound);
+  VkAssertEquals(nullptr, map.Find("sym1000"));
+
+  int expected = 0;
+  bool inOrder = true;
+  for (auto const& entry : map) {
+    inOrder = inOrder && entry.second == expected++;
+  }
+  VkAssertTrue(inOrder);
+
+  AST::ASTContext astContext;
+  AST::QualType int8Type =
+      astContext.GetBuiltinType(AST::BuiltinType::BTI_Int8);
+  AST::QualType int16Type =
+      astContext.GetBuiltinType(AST::BuiltinType::BTI_Int16);
+
+  std::shared_ptr<Sema::Scope> outer = std::make_shared<Sema::Scope>();
+  std::shared_ptr<Sema::Scope> inner =
+      std::make_shared<Sema::Scope>(outer, Sema::Scope::SF_Block);
+  outer->AddType("T", int8Type);
+  outer->AddType("U", int8Type);
+  inner->AddType("T", int16Type);
+
+  VkAssertTrue(inner->LookupType("T") == int16Type);
+  VkAssertTrue(inner->LookupType("U") == int8Type);
+  VkAssertTrue(outer->LookupType("T") == int8Type);
+  VkAssertEquals(nullptr, inner->LookupTypeLocally("U").GetUnqualTy());
+  VkAssertEquals(0u, inner->GetAllFuncs("f").size());
+}
+
+void test2() {
+  VkTestSectionStart("Looking up function overloads");
+
+  AST::ASTContext astContext;
+  sona::ref_ptr<AST::Type const> int8Type =
+      astContext.GetBuiltinType(AST::BuiltinType::BTI_Int8).GetUnqualTy();
+  sona::ref_ptr<AST::Type const> int16Type =
+      astContext.GetBuiltinType(AST::BuiltinType::BTI_Int16).GetUnqualTy();
+
+  AST::FuncDecl f1(nullptr, "f", { int8Type }, { "a" }, int8Type);
+  AST::FuncDecl f2(nullptr, "f", { int16Type }, { "a" }, int16Type);
+  AST::FuncDecl g(nullptr, "g", {}, {}, int8Type);
+  AST::FuncDecl innerF(nullptr, "f", {}, {}, int8Type);
+
+  std::shared_ptr<Sema::Scope> outer = std::make_shared<Sema::Scope>();
+  std::shared_ptr<Sema::Scope> inner =
+      std::make_shared<Sema::Scope>(outer, Sema::Scope::SF_Block);
+  outer->AddFunction(&f1);
+  outer->AddFunction(&g);
+  outer->AddFunction(&f2);
+
+  /// Both overloads, in declaration order, from the scope and from within
+  auto overloads = outer->GetAllFuncs("f");
+  VkAssertEquals(2u, overloads.size());
+  VkAssertTrue(*overloads.begin() == &f1);
+  VkAssertTrue(*(overloads.begin() + 1) == &f2);
+  VkAssertEquals(2u, inner->GetAllFuncs("f").size());
+  VkAssertEquals(0u, inner->GetAllFuncsLocal("f").size());
+  VkAssertEquals(1u, inner->GetAllFuncs("g").size());
+
+  /// A function of the inner scope hides all overloads outside
+  inner->AddFunction(&innerF);
+  auto hiding = inner->GetAllFuncs("f");
+  VkAssertEquals(1u, hiding.size());
+  VkAssertTrue(*hiding.begin() == &innerF);
+  VkAssertEquals(2u, outer->GetAllFuncs("f").size());
+}
+
 int main() {
   VkTestStart();
 
   test0();
+  test1();
+  test2();
 
   VkTestFinish();
 }
@@ -56,7 +56,7 @@ void test0() {
 
   Diag::DiagnosticEngine diag("a.c", lines);
   Frontend::Lexer lexer(move(file), diag);
-  std::vector<Frontend::Token> tokens = lexer.GetAndReset();
+  Frontend::TokenBuffer tokens = lexer.GetAndReset();
 
   Frontend::Parser parser(diag);
   sona::owner<Syntax::TransUnit> cst = parser.ParseTransUnit(tokens);
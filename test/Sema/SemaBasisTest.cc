@@ -41,9 +41,9 @@ void test0() {
   ParserTest testParser(diag);
   SemaPhase0Test testSema(astContext, declContexts, diag);
 
-  std::vector<Frontend::Token> tokens = lexer.GetAndReset();
+  Frontend::TokenBuffer tokens = lexer.GetAndReset();
   testParser.SetParsingTokenStream(tokens);
-  owner<Syntax::Type> sty = testParser.ParseType();
+  Syntax::NodePtr<Syntax::Type> sty = testParser.ParseType();
 
   auto pair = testSema.ResolveType(sty.borrow());
   VkAssertTrue(pair.contains_t1());
@@ -0,0 +1,178 @@
+#include "VKTestCXX.h"
+#include "Frontend/Lex.h"
+#include "Frontend/Parser.h"
+#include "Syntax/CSTCache.h"
+#include "Syntax/Serialize.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+#include <unistd.h>
+
+using namespace sona;
+using namespace ckx;
+using namespace std;
+
+static char const* const Source =
+    "class Outer {\n"
+    "  def a : x.y.Z const * ;\n"
+    "  class Inner { def b : float; }\n"
+    "}\n"
+    "enum Color { Red = 1; Green; Blue = 4; }\n"
+    "enum class Shape { Circle(float); Square(int64); }\n"
+    "using Alias = Outer * * const;\n"
+    "def g : Outer;\n"
+    "func f(p : int32, q : a.b &&) : int64 {\n"
+    "  p = -p + sizeof(q) * static_cast<int64>(2.5);\n"
+    "  { ; \"text\"; true; nullptr; }\n"
+    "  return a.b.c - alignof(p);\n"
+    "}\n"
+    "func h(r : int8) : int8;\n";
+
+/// Where a source lexed on its own is laid out
+static SourceLocation const FileStart =
+    SourceLocation::FromRawEncoding(SourceManager::FirstFileStart);
+
+static owner<Syntax::TransUnit> ParseSource(string const& source,
+                                            bool skipFuncBodies) {
+  vector<string> lines;
+  Diag::DiagnosticEngine diag("s.c", lines);
+  Frontend::Lexer lexer(string(source), diag);
+  Frontend::Parser parser(diag);
+  parser.SetSkipFuncBodies(skipFuncBodies);
+  owner<Syntax::TransUnit> ret = parser.ParseTransUnit(lexer);
+  sona_assert(!diag.HasPendingDiags());
+  return ret;
+}
+
+void test0() {
+  VkTestSectionStart("Serialized trees read back the same");
+  for (bool skipFuncBodies : { false, true }) {
+    owner<Syntax::TransUnit> unit = ParseSource(Source, skipFuncBodies);
+    string image;
+    Syntax::SerializeTransUnit(unit.borrow().get(), FileStart, image);
+
+    owner<Syntax::TransUnit> loaded =
+        Syntax::DeserializeTransUnit(image.data(), image.size(),
+                                     FileStart);
+    VkAssertTrue(loaded.borrow() != nullptr);
+    VkAssertEquals(7uL, loaded.borrow()->GetDecls().size());
+
+    /// Writing the tree read back gives the very same bytes, which only
+    /// holds if every node, string and range made it through
+    string again;
+    Syntax::SerializeTransUnit(loaded.borrow().get(), FileStart, again);
+    VkAssertTrue(image == again);
+
+    ref_ptr<Syntax::FuncDecl const> f =
+        (*(loaded.borrow()->GetDecls().begin() + 5))
+          .cast_unsafe<Syntax::FuncDecl const>();
+    VkAssertEquals("f", f->GetName().get().to_string());
+    VkAssertEquals(skipFuncBodies, f->HasSkippedBody());
+    VkAssertTrue(f->IsDefinition());
+    if (!skipFuncBodies) {
+      /// alignof stays apart from sizeof
+      ref_ptr<Syntax::CompoundStmt const> body =
+          f->GetFuncBodyUnsafe().cast_unsafe<Syntax::CompoundStmt const>();
+      ref_ptr<Syntax::ReturnStmt const> ret =
+          (*(body->GetStmts().begin() + 2))
+            .cast_unsafe<Syntax::ReturnStmt const>();
+      ref_ptr<Syntax::BinaryExpr const> sub =
+          ret->GetReturnValueUnsafe().cast_unsafe<Syntax::BinaryExpr const>();
+      VkAssertEquals(Syntax::Node::CNK_AlignOfExpr,
+                     sub->GetRightHandSide()->GetNodeKind());
+    }
+
+    /// Ranges are kept relative to the file, a tree loaded for a file laid
+    /// out elsewhere moves along with it
+    owner<Syntax::TransUnit> moved =
+        Syntax::DeserializeTransUnit(image.data(), image.size(),
+                                     FileStart.GetLocWithOffset(100));
+    ref_ptr<Syntax::FuncDecl const> movedF =
+        (*(moved.borrow()->GetDecls().begin() + 5))
+          .cast_unsafe<Syntax::FuncDecl const>();
+    VkAssertEquals(f->GetNameRange().GetBegin().GetRawEncoding() + 100,
+                   movedF->GetNameRange().GetBegin().GetRawEncoding());
+    VkAssertEquals(f->GetNameRange().GetEnd().GetRawEncoding() + 100,
+                   movedF->GetNameRange().GetEnd().GetRawEncoding());
+  }
+}
+
+void test1() {
+  VkTestSectionStart("Damaged images are rejected");
+  owner<Syntax::TransUnit> unit = ParseSource(Source, false);
+  string image;
+  Syntax::SerializeTransUnit(unit.borrow().get(), FileStart, image);
+
+  string truncated = image.substr(0, image.size() - 3);
+  VkAssertTrue(Syntax::DeserializeTransUnit(truncated.data(),
+                                            truncated.size(),
+                                            FileStart).borrow()
+               == nullptr);
+
+  string flipped = image;
+  flipped[flipped.size() / 2] ^= 0x5A;
+  VkAssertTrue(Syntax::DeserializeTransUnit(flipped.data(),
+                                            flipped.size(),
+                                            FileStart).borrow()
+               == nullptr);
+
+  VkAssertTrue(Syntax::DeserializeTransUnit(image.data(), 4, FileStart)
+                 .borrow()
+               == nullptr);
+}
+
+void test2() {
+  VkTestSectionStart("Caching trees by source content");
+  char directory[] = "/tmp/ckx-cst-XXXXXX";
+  VkAssertTrue(mkdtemp(directory) != nullptr);
+  Syntax::CSTCache cache(string(directory) + "/cache");
+
+  owner<SourceBuffer> source = SourceBuffer::FromString(Source);
+  VkAssertTrue(cache.Load(source.borrow().get(), FileStart).borrow()
+               == nullptr);
+
+  owner<Syntax::TransUnit> unit = ParseSource(Source, false);
+  VkAssertTrue(cache.Store(source.borrow().get(), FileStart,
+                           unit.borrow().get()));
+  owner<Syntax::TransUnit> cached =
+      cache.Load(source.borrow().get(), FileStart);
+  VkAssertTrue(cached.borrow() != nullptr);
+  VkAssertEquals(7uL, cached.borrow()->GetDecls().size());
+
+  owner<SourceBuffer> edited =
+      SourceBuffer::FromString(string(Source) + "def z : int8;\n");
+  VkAssertTrue(cache.Load(edited.borrow().get(), FileStart).borrow()
+               == nullptr);
+  VkAssertFalse(cache.GetCachePath(source.borrow().get())
+                == cache.GetCachePath(edited.borrow().get()));
+
+  /// An entry whose key matches but whose digest does not, as if another
+  /// text had collided with this one, is a miss
+  string path = cache.GetCachePath(source.borrow().get());
+  owner<SourceBuffer> entry = SourceBuffer::MapFile(path);
+  string damaged(entry.borrow()->GetBufferStart(),
+                 entry.borrow()->GetBufferSize());
+  damaged[20] ^= 1;
+  FILE *file = fopen(path.c_str(), "wb");
+  VkAssertTrue(file != nullptr);
+  fwrite(damaged.data(), 1, damaged.size(), file);
+  fclose(file);
+  VkAssertTrue(cache.Load(source.borrow().get(), FileStart).borrow()
+               == nullptr);
+
+  unlink(cache.GetCachePath(source.borrow().get()).c_str());
+  rmdir((string(directory) + "/cache").c_str());
+  rmdir(directory);
+}
+
+int main() {
+  VkTestStart();
+
+  test0();
+  test1();
+  test2();
+
+  VkTestFinish();
+}
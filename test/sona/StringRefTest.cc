@@ -0,0 +1,222 @@
+#include "VKTestCXX.h"
+#include "sona/arena.h"
+#include "sona/sha256.h"
+#include "sona/stringref.h"
+
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace sona;
+using namespace std;
+
+void test0() {
+  VkTestSectionStart("Interned strings keep their symbol ids");
+
+  strhdl_t s1("alpha"), s2(string("alpha")), s3(string_view("alpha", 5));
+  VkAssertEquals(s1.id(), s2.id());
+  VkAssertEquals(s1.id(), s3.id());
+  VkAssertTrue(s1 == s2);
+
+  strhdl_t other("beta");
+  VkAssertNotEquals(s1.id(), other.id());
+  VkAssertTrue(s1 != other);
+
+  /// The text is stored once, every handle to it sees the same copy
+  char const *text = s1.get().data();
+  bool sameText = true;
+  for (int i = 0; i < 1000; i++) {
+    strhdl_t again("alpha");
+    sameText = sameText && again.get().data() == text;
+  }
+  VkAssertTrue(sameText);
+  VkAssertEquals(s1.id(), strhdl_t("alpha").id());
+  VkAssertEquals(string("alpha"), s1.get().to_string());
+}
+
+void test1() {
+  VkTestSectionStart("Interning across arena blocks");
+
+  /// Several times the block size of a shard, so every shard starts fresh
+  /// blocks while the strings interned before stay put
+  vector<strhdl_t> handles;
+  vector<char const*> texts;
+  for (int i = 0; i < 20000; i++) {
+    strhdl_t s(string("arena-growth-") + to_string(i));
+    handles.push_back(s);
+    texts.push_back(s.get().data());
+  }
+  string big(100000, 'x');
+  strhdl_t bigStr(big);
+
+  bool stable = true;
+  for (int i = 0; i < 20000; i++) {
+    string expected = string("arena-growth-") + to_string(i);
+    stable = stable && handles[i].get().data() == texts[i]
+             && handles[i].get() == string_view(expected)
+             && strhdl_t(expected) == handles[i];
+  }
+  VkAssertTrue(stable);
+  VkAssertEquals(big.size(), bigStr.get().size());
+  VkAssertTrue(bigStr.get() == string_view(big));
+
+  /// Requests fill a block, the first that does not fit starts another
+  /// one, and large requests get blocks of their own
+  arena a(1024);
+  char *first = static_cast<char*>(a.allocate(200, 1));
+  bool contiguous = true;
+  for (int i = 1; i < 5; i++) {
+    contiguous = contiguous
+                 && static_cast<char*>(a.allocate(200, 1)) == first + 200 * i;
+  }
+  VkAssertTrue(contiguous);
+  VkAssertEquals(1024uL, a.bytes_reserved());
+  char *next = static_cast<char*>(a.allocate(200, 1));
+  VkAssertTrue(next < first || next >= first + 1024);
+  VkAssertEquals(2048uL, a.bytes_reserved());
+  void *large = a.allocate(1000, 8);
+  VkAssertEquals(0uL, reinterpret_cast<uintptr_t>(large) % 8);
+  VkAssertTrue(static_cast<char*>(a.allocate(10, 1)) == next + 200);
+}
+
+void test2() {
+  VkTestSectionStart("Cached hashes and the order of interned strings");
+
+  vector<string> texts = { "", "a", "ab", "abc", "abcd", "identifier",
+                           "a somewhat longer string of text",
+                           string(100, 'q') };
+  bool hashesMatch = true;
+  vector<strhdl_t> handles;
+  for (string const& text : texts) {
+    strhdl_t s(text);
+    handles.push_back(s);
+    uint64_t expected = hash_bytes(text.data(), text.size());
+    hashesMatch = hashesMatch && s.content_hash() == expected
+                  && hash<strhdl_t>()(s) == static_cast<size_t>(expected);
+  }
+  VkAssertTrue(hashesMatch);
+
+  /// Irreflexive, asymmetric and transitive, and only equal strings are
+  /// incomparable
+  bool irreflexive = true, asymmetric = true, transitive = true;
+  bool total = true;
+  for (strhdl_t a : handles) {
+    irreflexive = irreflexive && !(a < a);
+    for (strhdl_t b : handles) {
+      asymmetric = asymmetric && !(a < b && b < a);
+      total = total && (a == b || a < b || b < a);
+      for (strhdl_t c : handles) {
+        transitive = transitive && (!(a < b && b < c) || a < c);
+      }
+    }
+  }
+  VkAssertTrue(irreflexive);
+  VkAssertTrue(asymmetric);
+  VkAssertTrue(transitive);
+  VkAssertTrue(total);
+
+  /// Strings sharing a hash fall back to their text
+  using impl_stc89c52::hash_order_less;
+  VkAssertTrue(hash_order_less(7, "abc", 7, "abd"));
+  VkAssertFalse(hash_order_less(7, "abd", 7, "abc"));
+  VkAssertFalse(hash_order_less(7, "abc", 7, "abc"));
+  VkAssertTrue(hash_order_less(6, "zzz", 7, "aaa"));
+  VkAssertFalse(hash_order_less(7, "aaa", 6, "zzz"));
+}
+
+void test3() {
+  VkTestSectionStart("Interning from many threads");
+
+  /// Every thread interns the shared names in an order of its own, plus
+  /// names only it sees, so the shards and the per-thread caches all get
+  /// hit from several threads at once
+  constexpr int numThreads = 8;
+  constexpr int numShared = 5000;
+  vector<vector<uint32_t>> sharedIds(numThreads,
+                                     vector<uint32_t>(numShared));
+  vector<vector<uint32_t>> ownIds(numThreads);
+  vector<thread> threads;
+  for (int t = 0; t < numThreads; t++) {
+    threads.emplace_back([t, &sharedIds, &ownIds] {
+      for (int round = 0; round < 3; round++) {
+        for (int i = 0; i < numShared; i++) {
+          int n = (i * 7919 + t * 613 + round * 101) % numShared;
+          uint32_t id = strhdl_t("shared-" + to_string(n)).id();
+          sharedIds[t][n] = id;
+        }
+      }
+      for (int i = 0; i < 1000; i++) {
+        ownIds[t].push_back(
+            strhdl_t("own-" + to_string(t) + "-" + to_string(i)).id());
+      }
+    });
+  }
+  for (thread &th : threads) {
+    th.join();
+  }
+
+  bool sameIds = true;
+  for (int i = 0; i < numShared; i++) {
+    uint32_t expected = strhdl_t("shared-" + to_string(i)).id();
+    for (int t = 0; t < numThreads; t++) {
+      sameIds = sameIds && sharedIds[t][i] == expected;
+    }
+  }
+  VkAssertTrue(sameIds);
+
+  bool ownIntact = true;
+  for (int t = 0; t < numThreads; t++) {
+    for (int i = 0; i < 1000; i++) {
+      strhdl_t s("own-" + to_string(t) + "-" + to_string(i));
+      ownIntact = ownIntact && s.id() == ownIds[t][i]
+                  && s.get() == string_view("own-" + to_string(t) + "-"
+                                            + to_string(i));
+    }
+  }
+  VkAssertTrue(ownIntact);
+}
+
+static string Hex(sha256_digest const& digest) {
+  static char const digits[] = "0123456789abcdef";
+  string ret;
+  for (uint8_t byte : digest) {
+    ret.push_back(digits[byte >> 4]);
+    ret.push_back(digits[byte & 0xF]);
+  }
+  return ret;
+}
+
+void test4() {
+  VkTestSectionStart("SHA-256 digests");
+
+  /// The test vectors of FIPS 180-2, which between them end in one and in
+  /// two padding blocks
+  VkAssertEquals(
+    string("e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855"),
+    Hex(sha256("", 0)));
+  VkAssertEquals(
+    string("ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad"),
+    Hex(sha256("abc", 3)));
+  string twoBlocks =
+      "abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq";
+  VkAssertEquals(
+    string("248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1"),
+    Hex(sha256(twoBlocks.data(), twoBlocks.size())));
+  string million(1000000, 'a');
+  VkAssertEquals(
+    string("cdc76e5c9914fb9281a1c7e284d73e67f1809a48a497200e046d39ccc7112cd0"),
+    Hex(sha256(million.data(), million.size())));
+}
+
+int main() {
+  VkTestStart();
+
+  test0();
+  test1();
+  test2();
+  test3();
+  test4();
+
+  VkTestFinish();
+}